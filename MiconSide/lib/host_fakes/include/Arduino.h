@@ -0,0 +1,39 @@
+/*
+  ============================================================================
+  Arduino core subset for host builds
+
+  millis() / delay() run on the fake RTOS clock; Serial prints to stdout.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+
+using std::max;
+using std::min;
+
+unsigned long millis(void);
+unsigned long micros(void);
+void delay(uint32_t ms);
+bool psramFound(void);
+
+class HardwareSerial
+{
+public:
+    void begin(unsigned long baud) {}
+    int printf(const char *fmt, ...) __attribute__((format(printf, 2, 3)));
+    size_t print(const char *str) { return fputs(str, stdout) < 0 ? 0 : strlen(str); }
+    size_t println(const char *str = "") { return print(str) + print("\n"); }
+    size_t write(const uint8_t *data, size_t len) { return fwrite(data, 1, len, stdout); }
+    void flush(void) { fflush(stdout); }
+};
+
+extern HardwareSerial Serial;
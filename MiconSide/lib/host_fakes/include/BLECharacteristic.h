@@ -0,0 +1,84 @@
+/*
+  ============================================================================
+  BLECharacteristic for host builds
+
+  Holds the value and records every notify(). write() plays the part of
+  the BLE host delivering a client write: it stores the value and calls
+  the callbacks' onWrite(), as the stack does on the device.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+class BLECharacteristic;
+
+class BLECharacteristicCallbacks
+{
+public:
+    typedef enum
+    {
+        SUCCESS_INDICATE,
+        SUCCESS_NOTIFY,
+        ERROR_INDICATE_DISABLED,
+        ERROR_NOTIFY_DISABLED,
+        ERROR_GATT,
+        ERROR_NO_CLIENT,
+        ERROR_INDICATE_TIMEOUT,
+        ERROR_INDICATE_FAILURE,
+    } Status;
+
+    virtual ~BLECharacteristicCallbacks() {}
+    virtual void onRead(BLECharacteristic *characteristic) {}
+    virtual void onWrite(BLECharacteristic *characteristic) {}
+    virtual void onNotify(BLECharacteristic *characteristic) {}
+    virtual void onStatus(BLECharacteristic *characteristic, Status status, uint32_t code) {}
+};
+
+class BLECharacteristic
+{
+public:
+    explicit BLECharacteristic(const char *uuid = "") : m_uuid(uuid), m_callbacks(NULL) {}
+
+    void setCallbacks(BLECharacteristicCallbacks *callbacks) { m_callbacks = callbacks; }
+
+    void setValue(const uint8_t *data, size_t len) { m_value.assign((const char *)data, len); }
+    void setValue(const std::string &value) { m_value = value; }
+    void setValue(const char *value) { m_value = value; }
+
+    std::string getValue(void) const { return m_value; }
+    uint8_t *getData(void) { return (uint8_t *)&m_value[0]; }
+    size_t getLength(void) const { return m_value.size(); }
+    const char *getUUID(void) const { return m_uuid; }
+
+    void notify(bool is_notification = true)
+    {
+        notifications.push_back(m_value);
+        if (m_callbacks)
+        {
+            m_callbacks->onNotify(this);
+            m_callbacks->onStatus(this, BLECharacteristicCallbacks::SUCCESS_NOTIFY, 0);
+        }
+    }
+
+    // Host side: a client write arriving from the stack
+    void write(const uint8_t *data, size_t len)
+    {
+        setValue(data, len);
+        if (m_callbacks)
+            m_callbacks->onWrite(this);
+    }
+    void write(const char *text) { write((const uint8_t *)text, strlen(text)); }
+
+    std::vector<std::string> notifications; // Every value sent with notify(), oldest first
+
+private:
+    const char *m_uuid;
+    BLECharacteristicCallbacks *m_callbacks;
+    std::string m_value;
+};
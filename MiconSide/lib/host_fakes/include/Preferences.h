@@ -0,0 +1,56 @@
+/*
+  ============================================================================
+  Preferences for host builds
+
+  Namespaces live in one in-memory store shared by every Preferences
+  object, like NVS. Each end() after a write counts as one NVS commit,
+  and writes can be made to fail to exercise retry paths.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+class Preferences
+{
+public:
+    Preferences();
+    ~Preferences();
+
+    // Read-only opens fail for a namespace that was never written, as with NVS
+    bool begin(const char *name, bool read_only = false, const char *partition_label = NULL);
+    void end(void);
+
+    bool clear(void);
+    bool remove(const char *key);
+    bool isKey(const char *key);
+
+    size_t putUChar(const char *key, uint8_t value);
+    size_t putUInt(const char *key, uint32_t value);
+    size_t putString(const char *key, const char *value);
+    size_t putBytes(const char *key, const void *value, size_t len);
+
+    uint8_t getUChar(const char *key, uint8_t def = 0);
+    uint32_t getUInt(const char *key, uint32_t def = 0);
+    size_t getString(const char *key, char *value, size_t max_len);
+    size_t getBytesLength(const char *key);
+    size_t getBytes(const char *key, void *buf, size_t max_len);
+
+private:
+    size_t put(const char *key, const void *value, size_t len);
+    const void *get(const char *key, size_t *len);
+
+    char m_name[16];
+    bool m_open;
+    bool m_read_only;
+    bool m_dirty;
+};
+
+// Test control: wipe every namespace and counter
+void fake_prefs_reset(void);
+// Writes fail (return 0) while set
+void fake_prefs_fail_writes(bool fail);
+// end() calls that followed at least one successful write or removal
+uint32_t fake_prefs_commits(void);
@@ -0,0 +1,53 @@
+/*
+  ============================================================================
+  Fake Flash (host builds)
+
+  esp_partition / esp_ota_ops over RAM with the layout of
+  partitions_ota_2m.csv: app0 (running) and app1 (next update slot).
+  Programming behaves like NOR flash (bits only go 1 -> 0, erase sets a
+  whole range to 0xFF, offsets must be sector aligned), and erase /
+  program can be given a latency that blocks the calling task on the
+  fake RTOS clock, so pipeline tests see realistic writer stalls.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_partition.h>
+
+#define FAKE_FLASH_SECTOR_SIZE 4096
+
+typedef struct
+{
+    uint32_t erase_sector_us; // Per 4 KB sector erased
+    uint32_t program_kb_us;   // Per 1 KB programmed
+    uint32_t read_kb_us;      // Per 1 KB read
+} fake_flash_timing_t;
+
+typedef struct
+{
+    uint32_t sectors_erased;
+    uint32_t writes;
+    uint64_t bytes_written;
+    uint64_t bytes_read;
+    uint32_t boot_switches;
+} fake_flash_stats_t;
+
+// Both slots erased, app0 running and selected for boot, no latency, no injected failure
+void fake_flash_reset(void);
+
+void fake_flash_set_timing(const fake_flash_timing_t *timing);
+
+// The next erase or write fails with err after `after` more successful ones
+void fake_flash_fail(esp_err_t err, uint32_t after);
+
+// esp_ota_set_boot_partition() result (the real one validates the image)
+void fake_flash_set_boot_result(esp_err_t err);
+
+// Raw contents of a partition (partition size bytes)
+uint8_t *fake_flash_data(const esp_partition_t *part);
+
+void fake_flash_get_stats(fake_flash_stats_t *out);
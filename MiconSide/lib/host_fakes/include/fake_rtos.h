@@ -0,0 +1,32 @@
+/*
+  ============================================================================
+  Fake RTOS (host builds)
+
+  FreeRTOS tasks, semaphores, task notifications and esp_timer on a
+  simulated clock. Each task is a thread, but only one thread runs at a
+  time: a task runs until it blocks, then control returns to the main
+  (test) thread. Blocking on the main thread advances the clock to the
+  next event (task wake-up or timer) and runs whatever became ready, so a
+  test sees the same interleavings as on the device, deterministically.
+  Ticks are milliseconds; time only moves when something waits.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+// Simulated time since start
+int64_t fake_rtos_now_us(void);
+
+// Main thread: let time pass, running tasks and timers as they come due
+void fake_rtos_advance_us(int64_t us);
+
+// Task: block for us (like a busy flash operation). Main thread: same as advance.
+void fake_rtos_sleep_us(int64_t us);
+
+// Time of the next task wake-up or timer, INT64_MAX if there is none
+int64_t fake_rtos_next_event_us(void);
+
+// Main thread: run every task that can make progress now
+void fake_rtos_run_ready(void);
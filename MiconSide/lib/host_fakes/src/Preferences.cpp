@@ -0,0 +1,170 @@
+#include "Preferences.h"
+
+#include <string.h>
+
+#include <map>
+#include <string>
+
+typedef std::map<std::string, std::string> fake_prefs_ns_t;
+
+static std::map<std::string, fake_prefs_ns_t> s_store;
+static bool s_fail_writes = false;
+static uint32_t s_commits = 0;
+
+void fake_prefs_reset(void)
+{
+    s_store.clear();
+    s_fail_writes = false;
+    s_commits = 0;
+}
+
+void fake_prefs_fail_writes(bool fail)
+{
+    s_fail_writes = fail;
+}
+
+uint32_t fake_prefs_commits(void)
+{
+    return s_commits;
+}
+
+Preferences::Preferences() : m_open(false), m_read_only(false), m_dirty(false)
+{
+    m_name[0] = '\0';
+}
+
+Preferences::~Preferences()
+{
+    end();
+}
+
+bool Preferences::begin(const char *name, bool read_only, const char *partition_label)
+{
+    if (m_open || strlen(name) >= sizeof(m_name))
+        return false;
+    if (read_only && !s_store.count(name))
+        return false;
+    strcpy(m_name, name);
+    s_store[name]; // A read-write open creates the namespace
+    m_open = true;
+    m_read_only = read_only;
+    m_dirty = false;
+    return true;
+}
+
+void Preferences::end(void)
+{
+    if (m_open && m_dirty)
+        s_commits++;
+    m_open = false;
+    m_dirty = false;
+}
+
+bool Preferences::clear(void)
+{
+    if (!m_open || m_read_only || s_fail_writes)
+        return false;
+    s_store[m_name].clear();
+    m_dirty = true;
+    return true;
+}
+
+bool Preferences::remove(const char *key)
+{
+    if (!m_open || m_read_only || s_fail_writes)
+        return false;
+    if (!s_store[m_name].erase(key))
+        return false;
+    m_dirty = true;
+    return true;
+}
+
+bool Preferences::isKey(const char *key)
+{
+    return m_open && s_store[m_name].count(key) > 0;
+}
+
+size_t Preferences::put(const char *key, const void *value, size_t len)
+{
+    if (!m_open || m_read_only || s_fail_writes || strlen(key) > 15)
+        return 0;
+    s_store[m_name][key].assign((const char *)value, len);
+    m_dirty = true;
+    return len;
+}
+
+const void *Preferences::get(const char *key, size_t *len)
+{
+    if (!m_open)
+        return NULL;
+    fake_prefs_ns_t &ns = s_store[m_name];
+    fake_prefs_ns_t::iterator it = ns.find(key);
+    if (it == ns.end())
+        return NULL;
+    *len = it->second.size();
+    return it->second.data();
+}
+
+size_t Preferences::putUChar(const char *key, uint8_t value)
+{
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putUInt(const char *key, uint32_t value)
+{
+    return put(key, &value, sizeof(value));
+}
+
+size_t Preferences::putString(const char *key, const char *value)
+{
+    // NVS stores the terminator, Preferences reports the string length
+    return put(key, value, strlen(value) + 1) ? strlen(value) : 0;
+}
+
+size_t Preferences::putBytes(const char *key, const void *value, size_t len)
+{
+    return put(key, value, len);
+}
+
+uint8_t Preferences::getUChar(const char *key, uint8_t def)
+{
+    size_t len = 0;
+    const void *value = get(key, &len);
+    return value && len == sizeof(uint8_t) ? *(const uint8_t *)value : def;
+}
+
+uint32_t Preferences::getUInt(const char *key, uint32_t def)
+{
+    size_t len = 0;
+    const void *value = get(key, &len);
+    uint32_t out = def;
+    if (value && len == sizeof(out))
+        memcpy(&out, value, sizeof(out));
+    return out;
+}
+
+size_t Preferences::getString(const char *key, char *value, size_t max_len)
+{
+    size_t len = 0;
+    const void *stored = get(key, &len);
+    if (!stored || len > max_len)
+        return 0;
+    memcpy(value, stored, len);
+    return len;
+}
+
+size_t Preferences::getBytesLength(const char *key)
+{
+    size_t len = 0;
+    return get(key, &len) ? len : 0;
+}
+
+size_t Preferences::getBytes(const char *key, void *buf, size_t max_len)
+{
+    size_t len = 0;
+    const void *stored = get(key, &len);
+    if (!stored || len > max_len)
+        return 0;
+    memcpy(buf, stored, len);
+    return len;
+}
@@ -0,0 +1,186 @@
+#include "fake_flash.h"
+#include "fake_rtos.h"
+
+#include <esp_ota_ops.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define FAKE_APP_SIZE 0x180000 // partitions_ota_2m.csv
+
+static const esp_partition_t s_app[2] = {
+    {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_0, 0x10000, FAKE_APP_SIZE, FAKE_FLASH_SECTOR_SIZE, "app0", false},
+    {ESP_PARTITION_TYPE_APP, ESP_PARTITION_SUBTYPE_APP_OTA_1, 0x190000, FAKE_APP_SIZE, FAKE_FLASH_SECTOR_SIZE, "app1", false},
+};
+
+static uint8_t *s_data[2] = {NULL, NULL};
+static int s_running = 0;
+static int s_boot = 0;
+static fake_flash_timing_t s_timing;
+static fake_flash_stats_t s_stats;
+static esp_err_t s_fail_err = ESP_OK;
+static uint32_t s_fail_after = 0;
+static esp_err_t s_boot_result = ESP_OK;
+
+static int fake_flash_index(const esp_partition_t *part)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (part == &s_app[i])
+            return i;
+    }
+    return -1;
+}
+
+static esp_err_t fake_flash_check(const esp_partition_t *part, size_t offset, size_t size)
+{
+    if (fake_flash_index(part) < 0)
+        return ESP_ERR_INVALID_ARG;
+    if (offset > part->size || size > part->size - offset)
+        return ESP_ERR_INVALID_SIZE;
+    return ESP_OK;
+}
+
+// Injected failure for the next erase / write, if one is due
+static esp_err_t fake_flash_injected(void)
+{
+    if (s_fail_err == ESP_OK)
+        return ESP_OK;
+    if (s_fail_after > 0)
+    {
+        s_fail_after--;
+        return ESP_OK;
+    }
+    esp_err_t err = s_fail_err;
+    s_fail_err = ESP_OK;
+    return err;
+}
+
+static void fake_flash_busy(uint32_t per_kb_us, size_t bytes)
+{
+    uint64_t us = (uint64_t)per_kb_us * bytes / 1024;
+    if (us)
+        fake_rtos_sleep_us((int64_t)us);
+}
+
+void fake_flash_reset(void)
+{
+    for (int i = 0; i < 2; i++)
+    {
+        if (!s_data[i])
+            s_data[i] = (uint8_t *)malloc(FAKE_APP_SIZE);
+        memset(s_data[i], 0xFF, FAKE_APP_SIZE);
+    }
+    s_running = 0;
+    s_boot = 0;
+    memset(&s_timing, 0, sizeof(s_timing));
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_fail_err = ESP_OK;
+    s_fail_after = 0;
+    s_boot_result = ESP_OK;
+}
+
+void fake_flash_set_timing(const fake_flash_timing_t *timing)
+{
+    s_timing = *timing;
+}
+
+void fake_flash_fail(esp_err_t err, uint32_t after)
+{
+    s_fail_err = err;
+    s_fail_after = after;
+}
+
+void fake_flash_set_boot_result(esp_err_t err)
+{
+    s_boot_result = err;
+}
+
+uint8_t *fake_flash_data(const esp_partition_t *part)
+{
+    int i = fake_flash_index(part);
+    return i < 0 ? NULL : s_data[i];
+}
+
+void fake_flash_get_stats(fake_flash_stats_t *out)
+{
+    *out = s_stats;
+}
+
+// ============================================================================
+// esp_partition / esp_ota_ops
+// ============================================================================
+
+esp_err_t esp_partition_read(const esp_partition_t *part, size_t offset, void *dst, size_t size)
+{
+    esp_err_t err = fake_flash_check(part, offset, size);
+    if (err != ESP_OK)
+        return err;
+    fake_flash_busy(s_timing.read_kb_us, size);
+    memcpy(dst, fake_flash_data(part) + offset, size);
+    s_stats.bytes_read += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_write(const esp_partition_t *part, size_t offset, const void *src, size_t size)
+{
+    esp_err_t err = fake_flash_check(part, offset, size);
+    if (err == ESP_OK)
+        err = fake_flash_injected();
+    if (err != ESP_OK)
+        return err;
+
+    // NOR flash: programming only clears bits, so an unerased target corrupts the data
+    fake_flash_busy(s_timing.program_kb_us, size);
+    uint8_t *dst = fake_flash_data(part) + offset;
+    for (size_t i = 0; i < size; i++)
+        dst[i] &= ((const uint8_t *)src)[i];
+    s_stats.writes++;
+    s_stats.bytes_written += size;
+    return ESP_OK;
+}
+
+esp_err_t esp_partition_erase_range(const esp_partition_t *part, size_t offset, size_t size)
+{
+    esp_err_t err = fake_flash_check(part, offset, size);
+    if (err == ESP_OK && (offset % FAKE_FLASH_SECTOR_SIZE || size % FAKE_FLASH_SECTOR_SIZE))
+        err = ESP_ERR_INVALID_ARG;
+    if (err == ESP_OK)
+        err = fake_flash_injected();
+    if (err != ESP_OK)
+        return err;
+
+    uint32_t sectors = size / FAKE_FLASH_SECTOR_SIZE;
+    if (s_timing.erase_sector_us)
+        fake_rtos_sleep_us((int64_t)s_timing.erase_sector_us * sectors);
+    memset(fake_flash_data(part) + offset, 0xFF, size);
+    s_stats.sectors_erased += sectors;
+    return ESP_OK;
+}
+
+const esp_partition_t *esp_ota_get_running_partition(void)
+{
+    return &s_app[s_running];
+}
+
+const esp_partition_t *esp_ota_get_boot_partition(void)
+{
+    return &s_app[s_boot];
+}
+
+const esp_partition_t *esp_ota_get_next_update_partition(const esp_partition_t *start_from)
+{
+    int from = start_from ? fake_flash_index(start_from) : s_running;
+    return from < 0 ? NULL : &s_app[1 - from];
+}
+
+esp_err_t esp_ota_set_boot_partition(const esp_partition_t *part)
+{
+    int i = fake_flash_index(part);
+    if (i < 0)
+        return ESP_ERR_INVALID_ARG;
+    if (s_boot_result != ESP_OK)
+        return s_boot_result;
+    s_boot = i;
+    s_stats.boot_switches++;
+    return ESP_OK;
+}
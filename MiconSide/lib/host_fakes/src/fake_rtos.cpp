@@ -0,0 +1,385 @@
+#include "fake_rtos.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <freertos/task.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <algorithm>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#define FAKE_NEVER INT64_MAX
+
+struct fake_task
+{
+    const char *name;
+    TaskFunction_t fn;
+    void *arg;
+    uint32_t notify;
+    bool blocked;
+    bool deleted;
+    std::function<bool()> ready; // While blocked: runnable once this holds ...
+    int64_t wake_us;             // ... or at this time
+};
+
+struct fake_sem
+{
+    int count;
+    int max;
+};
+
+struct esp_timer
+{
+    esp_timer_cb_t cb;
+    void *arg;
+    bool armed;
+    int64_t due_us;
+    int64_t period_us; // 0 = one-shot
+};
+
+// Only the thread s_running names (NULL = main) executes; the others wait on s_cv.
+// Never destroyed: parked task threads still wait on them while the process exits.
+static std::mutex &s_mutex = *new std::mutex;
+static std::condition_variable &s_cv = *new std::condition_variable;
+static fake_task *s_running = NULL;
+static thread_local fake_task *t_self = NULL;
+
+static std::vector<fake_task *> s_tasks;
+static std::vector<esp_timer *> s_timers;
+static int64_t s_now_us = 0;
+
+static int64_t fake_ticks_us(TickType_t ticks)
+{
+    return ticks == portMAX_DELAY ? FAKE_NEVER : (int64_t)ticks * 1000;
+}
+
+// Hand the CPU to next and wait until it comes back to the caller
+static void fake_switch_to(fake_task *next)
+{
+    std::unique_lock<std::mutex> lock(s_mutex);
+    fake_task *self = t_self;
+    s_running = next;
+    s_cv.notify_all();
+    s_cv.wait(lock, [self] { return s_running == self; });
+}
+
+static void fake_task_entry(fake_task *task)
+{
+    t_self = task;
+    {
+        std::unique_lock<std::mutex> lock(s_mutex);
+        s_cv.wait(lock, [task] { return s_running == task; });
+    }
+    task->fn(task->arg);
+    vTaskDelete(NULL); // FreeRTOS tasks must not return; treat it as a delete
+}
+
+static bool fake_task_runnable(fake_task *task)
+{
+    if (task->deleted)
+        return false;
+    if (!task->blocked)
+        return true;
+    return s_now_us >= task->wake_us || (task->ready && task->ready());
+}
+
+static void fake_fire_timers(void)
+{
+    bool fired = true;
+    while (fired)
+    {
+        fired = false;
+        for (size_t i = 0; i < s_timers.size(); i++)
+        {
+            esp_timer *timer = s_timers[i];
+            if (!timer->armed || timer->due_us > s_now_us)
+                continue;
+            if (timer->period_us)
+                timer->due_us += timer->period_us;
+            else
+                timer->armed = false;
+            timer->cb(timer->arg);
+            fired = true;
+        }
+    }
+}
+
+void fake_rtos_run_ready(void)
+{
+    if (t_self)
+        return; // Tasks never schedule; main picks them up when it gets the CPU back
+
+    bool ran = true;
+    while (ran)
+    {
+        ran = false;
+        for (size_t i = 0; i < s_tasks.size(); i++) // Tasks may be created meanwhile
+        {
+            if (fake_task_runnable(s_tasks[i]))
+            {
+                fake_switch_to(s_tasks[i]);
+                ran = true;
+            }
+        }
+    }
+}
+
+int64_t fake_rtos_next_event_us(void)
+{
+    int64_t next = FAKE_NEVER;
+    for (fake_task *task : s_tasks)
+    {
+        if (!task->deleted && task->blocked)
+            next = std::min(next, task->wake_us);
+    }
+    for (esp_timer *timer : s_timers)
+    {
+        if (timer->armed)
+            next = std::min(next, timer->due_us);
+    }
+    return next;
+}
+
+static void fake_set_time(int64_t us)
+{
+    s_now_us = std::max(s_now_us, us);
+    fake_fire_timers();
+}
+
+// Wait until ready() holds or timeout_us passes; returns ready()
+static bool fake_block(std::function<bool()> ready, int64_t timeout_us)
+{
+    if (ready())
+        return true;
+    if (timeout_us <= 0)
+        return false;
+    int64_t deadline = timeout_us == FAKE_NEVER ? FAKE_NEVER : s_now_us + timeout_us;
+
+    fake_task *self = t_self;
+    if (self)
+    {
+        self->ready = ready;
+        self->wake_us = deadline;
+        self->blocked = true;
+        fake_switch_to(NULL);
+        self->blocked = false;
+        self->ready = nullptr;
+        return ready();
+    }
+
+    // Main thread: time passes until something makes ready() true
+    for (;;)
+    {
+        fake_rtos_run_ready();
+        if (ready())
+            return true;
+        if (s_now_us >= deadline)
+            return false;
+        int64_t next = std::min(fake_rtos_next_event_us(), deadline);
+        if (next == FAKE_NEVER)
+        {
+            fprintf(stderr, "fake_rtos: main thread would block forever\n");
+            abort();
+        }
+        fake_set_time(next);
+    }
+}
+
+int64_t fake_rtos_now_us(void)
+{
+    return s_now_us;
+}
+
+void fake_rtos_advance_us(int64_t us)
+{
+    int64_t target = s_now_us + us;
+    for (;;)
+    {
+        fake_rtos_run_ready();
+        int64_t next = fake_rtos_next_event_us();
+        if (next > target)
+            break;
+        fake_set_time(next);
+    }
+    fake_set_time(target);
+}
+
+void fake_rtos_sleep_us(int64_t us)
+{
+    if (t_self)
+        fake_block([] { return false; }, us);
+    else
+        fake_rtos_advance_us(us);
+}
+
+// ============================================================================
+// Tasks
+// ============================================================================
+
+BaseType_t xTaskCreatePinnedToCore(TaskFunction_t fn, const char *name, uint32_t stack_depth, void *arg,
+                                   UBaseType_t priority, TaskHandle_t *created, BaseType_t core)
+{
+    fake_task *task = new fake_task();
+    task->name = name;
+    task->fn = fn;
+    task->arg = arg;
+    s_tasks.push_back(task);
+    if (created)
+        *created = task;
+
+    std::thread(fake_task_entry, task).detach();
+    fake_rtos_run_ready(); // Runs until it first blocks
+    return pdPASS;
+}
+
+void vTaskDelete(TaskHandle_t task)
+{
+    if (!task)
+        task = t_self;
+    if (!task)
+        return;
+    task->deleted = true;
+    if (task == t_self)
+    {
+        // Park the thread for good; it is never scheduled again
+        std::unique_lock<std::mutex> lock(s_mutex);
+        s_running = NULL;
+        s_cv.notify_all();
+        s_cv.wait(lock, [] { return false; });
+    }
+}
+
+void vTaskDelay(TickType_t ticks)
+{
+    fake_rtos_sleep_us(fake_ticks_us(ticks));
+}
+
+TickType_t xTaskGetTickCount(void)
+{
+    return (TickType_t)(s_now_us / 1000);
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void)
+{
+    return t_self;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task)
+{
+    task->notify++;
+    fake_rtos_run_ready();
+    return pdPASS;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clear_on_exit, TickType_t ticks)
+{
+    fake_task *self = t_self;
+    if (!self)
+    {
+        fprintf(stderr, "fake_rtos: ulTaskNotifyTake outside a task\n");
+        abort();
+    }
+    fake_block([self] { return self->notify > 0; }, fake_ticks_us(ticks));
+    uint32_t value = self->notify;
+    if (value)
+        self->notify = clear_on_exit ? 0 : value - 1;
+    return value;
+}
+
+// ============================================================================
+// Semaphores
+// ============================================================================
+
+SemaphoreHandle_t xSemaphoreCreateMutex(void)
+{
+    return new fake_sem{1, 1};
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void)
+{
+    return new fake_sem{0, 1};
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t sem)
+{
+    delete sem;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t sem, TickType_t ticks)
+{
+    if (!fake_block([sem] { return sem->count > 0; }, fake_ticks_us(ticks)))
+        return pdFALSE;
+    sem->count--;
+    return pdTRUE;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t sem)
+{
+    if (sem->count >= sem->max)
+        return pdFALSE;
+    sem->count++;
+    fake_rtos_run_ready();
+    return pdTRUE;
+}
+
+// ============================================================================
+// esp_timer
+// ============================================================================
+
+esp_err_t esp_timer_create(const esp_timer_create_args_t *args, esp_timer_handle_t *out)
+{
+    esp_timer *timer = new esp_timer();
+    timer->cb = args->callback;
+    timer->arg = args->arg;
+    s_timers.push_back(timer);
+    *out = timer;
+    return ESP_OK;
+}
+
+static esp_err_t fake_timer_start(esp_timer_handle_t timer, uint64_t us, bool periodic)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    timer->armed = true;
+    timer->due_us = s_now_us + (int64_t)us;
+    timer->period_us = periodic ? (int64_t)us : 0;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_start_once(esp_timer_handle_t timer, uint64_t timeout_us)
+{
+    return fake_timer_start(timer, timeout_us, false);
+}
+
+esp_err_t esp_timer_start_periodic(esp_timer_handle_t timer, uint64_t period_us)
+{
+    return fake_timer_start(timer, period_us, true);
+}
+
+esp_err_t esp_timer_stop(esp_timer_handle_t timer)
+{
+    if (!timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    timer->armed = false;
+    return ESP_OK;
+}
+
+esp_err_t esp_timer_delete(esp_timer_handle_t timer)
+{
+    if (timer->armed)
+        return ESP_ERR_INVALID_STATE;
+    s_timers.erase(std::find(s_timers.begin(), s_timers.end(), timer));
+    delete timer;
+    return ESP_OK;
+}
+
+int64_t esp_timer_get_time(void)
+{
+    return s_now_us;
+}
@@ -0,0 +1,25 @@
+#include "app_event.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+static TaskHandle_t s_task = NULL;
+
+void app_event_init(void)
+{
+    s_task = xTaskGetCurrentTaskHandle();
+}
+
+void app_event_post(uint32_t events)
+{
+    if (s_task)
+        xTaskNotify(s_task, events, eSetBits);
+}
+
+uint32_t app_event_wait(uint32_t timeout_ms)
+{
+    uint32_t events = 0;
+    TickType_t ticks = timeout_ms == APP_EVENT_WAIT_FOREVER ? portMAX_DELAY : pdMS_TO_TICKS(timeout_ms);
+    xTaskNotifyWait(0, 0xffffffffu, &events, ticks);
+    return events;
+}
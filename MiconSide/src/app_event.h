@@ -0,0 +1,38 @@
+/*
+  ============================================================================
+  Main Loop Events
+
+  BLE callbacks, the Wi-Fi event handler and the OTA writer task post
+  event bits to the loop task (FreeRTOS task notification, so posts
+  coalesce and never block). loop() sleeps in app_event_wait() until an
+  event arrives or its next deadline is due, instead of polling flags
+  behind delay().
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stdint.h>
+
+#define APP_EVENT_REBOOT (1u << 0)       // Reboot after REBOOT_DELAY_MS
+#define APP_EVENT_OTA_FINALIZE (1u << 1) // END accepted
+#define APP_EVENT_OTA_ABORT (1u << 2)    // ABORT received
+#define APP_EVENT_OTA_SUSPEND (1u << 3)  // BLE link lost mid-transfer
+#define APP_EVENT_OTA_PROGRESS (1u << 4) // Data received or a flash batch written
+#define APP_EVENT_BLE_LINK (1u << 5)     // BLE connected / disconnected / parameters changed
+#define APP_EVENT_WIFI (1u << 6)         // Wi-Fi state changed
+#define APP_EVENT_CONFIG (1u << 7)       // A setting changed (NVS commit pending)
+#define APP_EVENT_TELEMETRY (1u << 8)    // DebugStat period changed (TELEM)
+#define APP_EVENT_OTA_START (1u << 9)    // START parsed, waiting for the checks and flash setup
+#define APP_EVENT_BLE_CONNECTED (1u << 10) // Central connected (initial status is due)
+
+#define APP_EVENT_WAIT_FOREVER 0xffffffffu
+
+// Bind events to the calling task (call first thing in setup, i.e. from loopTask)
+void app_event_init(void);
+
+// Post events from any task; no-op before app_event_init()
+void app_event_post(uint32_t events);
+
+// Wait up to timeout_ms for events; returns (and clears) the posted bits, 0 on timeout
+uint32_t app_event_wait(uint32_t timeout_ms);
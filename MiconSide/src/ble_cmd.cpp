@@ -0,0 +1,248 @@
+#include "ble_cmd.h"
+
+#include <string.h>
+
+static bool ble_cmd_is_space(uint8_t c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool ble_cmd_add_field(ble_cmd_frame_t *frame, uint8_t tag, const uint8_t *value, size_t len)
+{
+    if (tag == 0 || len > 0xFF || frame->field_count >= BLE_CMD_MAX_FIELDS)
+        return false;
+
+    ble_cmd_field_t *field = &frame->fields[frame->field_count++];
+    field->tag = tag;
+    field->len = (uint8_t)len;
+    field->value = value;
+    return true;
+}
+
+static const ble_cmd_entry_t *ble_cmd_parse_binary(const ble_cmd_table_t *table, const uint8_t *data, size_t len,
+                                                   ble_cmd_frame_t *frame)
+{
+    const ble_cmd_entry_t *entry = NULL;
+    for (size_t i = 0; i < table->count && !entry; i++)
+    {
+        if (table->entries[i].opcode == frame->opcode)
+            entry = &table->entries[i];
+    }
+    if (!entry)
+        return NULL;
+
+    size_t pos = 2;
+    while (pos < len)
+    {
+        if (len - pos < 2 || len - pos - 2 < data[pos + 1])
+            return NULL; // Truncated TLV
+        if (!ble_cmd_add_field(frame, data[pos], data + pos + 2, data[pos + 1]))
+            return NULL;
+        pos += 2 + data[pos + 1];
+    }
+    return entry;
+}
+
+// Tag of a text field: positional first, then key=value (value is moved past the '=')
+static uint8_t ble_cmd_text_tag(const ble_cmd_entry_t *entry, size_t index, const uint8_t **value, size_t *len)
+{
+    if (index < entry->positional)
+        return (uint8_t)(index + 1);
+
+    const uint8_t *eq = (const uint8_t *)memchr(*value, '=', *len);
+    if (!eq || !entry->keys)
+        return 0;
+
+    size_t key_len = eq - *value;
+    for (size_t k = 0; entry->keys[k]; k++)
+    {
+        if (strlen(entry->keys[k]) == key_len && memcmp(entry->keys[k], *value, key_len) == 0)
+        {
+            *len -= key_len + 1;
+            *value = eq + 1;
+            return (uint8_t)(entry->positional + 1 + k);
+        }
+    }
+    return 0;
+}
+
+static const ble_cmd_entry_t *ble_cmd_parse_text(const ble_cmd_table_t *table, const uint8_t *data, size_t len,
+                                                 ble_cmd_frame_t *frame)
+{
+    if (table->trim)
+    {
+        while (len > 0 && ble_cmd_is_space(data[0]))
+        {
+            data++;
+            len--;
+        }
+        while (len > 0 && ble_cmd_is_space(data[len - 1]))
+            len--;
+    }
+
+    const uint8_t *sep = (const uint8_t *)memchr(data, table->separator, len);
+    size_t name_len = sep ? (size_t)(sep - data) : len;
+
+    const ble_cmd_entry_t *entry = NULL;
+    const ble_cmd_entry_t *fallback = NULL;
+    for (size_t i = 0; i < table->count && !entry; i++)
+    {
+        const char *name = table->entries[i].name;
+        if (!name)
+            fallback = &table->entries[i];
+        else if (strlen(name) == name_len && memcmp(name, data, name_len) == 0)
+            entry = &table->entries[i];
+    }
+
+    size_t pos = 0;
+    if (entry)
+    {
+        if (!sep)
+            return entry; // Bare command
+        pos = name_len + 1;
+    }
+    else if (fallback)
+    {
+        entry = fallback;
+    }
+    else
+    {
+        return NULL;
+    }
+    frame->opcode = entry->opcode;
+
+    for (size_t index = 0;; index++)
+    {
+        // The last positional field of a keyless entry takes the rest (e.g. a password with the separator in it)
+        bool rest = !entry->keys && index + 1 == entry->positional;
+        const uint8_t *end = rest ? NULL : (const uint8_t *)memchr(data + pos, table->separator, len - pos);
+        size_t field_len = end ? (size_t)(end - (data + pos)) : len - pos;
+
+        const uint8_t *value = data + pos;
+        size_t value_len = field_len;
+        uint8_t tag = ble_cmd_text_tag(entry, index, &value, &value_len);
+        if (tag != 0 && !ble_cmd_add_field(frame, tag, value, value_len))
+            return NULL;
+
+        if (!end)
+            break;
+        pos += field_len + 1;
+    }
+    return entry;
+}
+
+const ble_cmd_entry_t *ble_cmd_parse(const ble_cmd_table_t *table, const uint8_t *data, size_t len,
+                                     ble_cmd_frame_t *frame)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->raw = data;
+    frame->raw_len = len;
+    if (len == 0)
+        return NULL;
+
+    frame->binary = data[0] >= BLE_CMD_BINARY_MIN;
+    if (!frame->binary)
+    {
+        frame->opcode = data[0];
+        return ble_cmd_parse_text(table, data, len, frame);
+    }
+    if (data[0] != BLE_CMD_BINARY_V1 || len < 2)
+        return NULL; // Later frame version, or no opcode
+    frame->opcode = data[1];
+    return ble_cmd_parse_binary(table, data, len, frame);
+}
+
+const ble_cmd_field_t *ble_cmd_field(const ble_cmd_frame_t *frame, uint8_t tag)
+{
+    for (size_t i = 0; i < frame->field_count; i++)
+    {
+        if (frame->fields[i].tag == tag)
+            return &frame->fields[i];
+    }
+    return NULL;
+}
+
+uint32_t ble_cmd_u32(const ble_cmd_frame_t *frame, uint8_t tag, uint32_t def)
+{
+    const ble_cmd_field_t *field = ble_cmd_field(frame, tag);
+    if (!field || field->len == 0)
+        return def;
+
+    uint32_t value = 0;
+    if (frame->binary)
+    {
+        if (field->len > 4)
+            return def;
+        for (size_t i = 0; i < field->len; i++)
+            value |= (uint32_t)field->value[i] << (8 * i);
+        return value;
+    }
+
+    if (field->len > 10)
+        return def;
+    for (size_t i = 0; i < field->len; i++)
+    {
+        uint8_t c = field->value[i];
+        if (c < '0' || c > '9' || value > (UINT32_MAX - (c - '0')) / 10)
+            return def;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+static int ble_cmd_hex_nibble(uint8_t c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+size_t ble_cmd_bytes(const ble_cmd_frame_t *frame, uint8_t tag, uint8_t *out, size_t max)
+{
+    const ble_cmd_field_t *field = ble_cmd_field(frame, tag);
+    if (!field)
+        return 0;
+
+    if (frame->binary)
+    {
+        if (field->len > max)
+            return 0;
+        memcpy(out, field->value, field->len);
+        return field->len;
+    }
+
+    size_t len = field->len / 2;
+    if (field->len % 2 != 0 || len > max)
+        return 0;
+    for (size_t i = 0; i < len; i++)
+    {
+        int hi = ble_cmd_hex_nibble(field->value[2 * i]);
+        int lo = ble_cmd_hex_nibble(field->value[2 * i + 1]);
+        if (hi < 0 || lo < 0)
+            return 0;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return len;
+}
+
+size_t ble_cmd_str(const ble_cmd_frame_t *frame, uint8_t tag, char *out, size_t size)
+{
+    const ble_cmd_field_t *field = ble_cmd_field(frame, tag);
+    out[0] = '\0';
+    if (!field || field->len >= size)
+        return 0;
+
+    memcpy(out, field->value, field->len);
+    out[field->len] = '\0';
+    return field->len;
+}
+
+bool ble_cmd_equals(const ble_cmd_frame_t *frame, uint8_t tag, const char *str)
+{
+    const ble_cmd_field_t *field = ble_cmd_field(frame, tag);
+    return field && strlen(str) == field->len && memcmp(str, field->value, field->len) == 0;
+}
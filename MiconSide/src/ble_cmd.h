@@ -0,0 +1,82 @@
+/*
+  ============================================================================
+  BLE Command Frames
+
+  Parses a characteristic write in place (no heap) and looks the command
+  up in a per-characteristic table.
+
+  Binary frame (first byte BLE_CMD_BINARY_V1):
+    0xF5 <opcode> { <tag> <len> <len B value> }*
+    integers are little-endian (1-4 bytes), digests/signatures raw bytes.
+    Bytes 0xF5-0xFF never occur in UTF-8, so a text write in any script
+    (e.g. the SSID in "アNet\npassword") is never taken for a binary
+    frame. 0xF6-0xFF are kept for later frame versions and rejected.
+
+  Text shim (older clients):
+    NAME[<sep>field...]  positional fields get tags 1..positional, then
+    key=value fields get the tag of their key. Integers are decimal and
+    byte fields hex, so handlers read both forms through the accessors.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BLE_CMD_BINARY_MIN 0xF5 // Lowest byte that cannot appear in UTF-8 text
+#define BLE_CMD_BINARY_V1 0xF5  // Frame version this parser reads
+#define BLE_CMD_MAX_FIELDS 8
+
+typedef struct
+{
+    uint8_t tag;
+    uint8_t len; // Text fields are capped at 255 bytes as well
+    const uint8_t *value;
+} ble_cmd_field_t;
+
+typedef struct
+{
+    uint8_t opcode;
+    bool binary;
+    const uint8_t *raw; // Whole write, for logging
+    size_t raw_len;
+    size_t field_count;
+    ble_cmd_field_t fields[BLE_CMD_MAX_FIELDS];
+} ble_cmd_frame_t;
+
+typedef void (*ble_cmd_handler_fn)(const ble_cmd_frame_t *frame);
+
+typedef struct
+{
+    uint8_t opcode;
+    const char *name;        // Text name; NULL = the whole text write is the fields
+    uint8_t positional;      // Text fields taken in order as tags 1..positional
+    const char *const *keys; // Text key=value fields, keys[i] -> tag positional + 1 + i (NULL-terminated)
+    ble_cmd_handler_fn handler;
+} ble_cmd_entry_t;
+
+typedef struct
+{
+    const ble_cmd_entry_t *entries;
+    size_t count;
+    char separator; // Text field separator
+    bool trim;      // Strip surrounding whitespace from text commands
+} ble_cmd_table_t;
+
+// Parse a write and find its entry; NULL if malformed or unknown
+const ble_cmd_entry_t *ble_cmd_parse(const ble_cmd_table_t *table, const uint8_t *data, size_t len,
+                                     ble_cmd_frame_t *frame);
+
+const ble_cmd_field_t *ble_cmd_field(const ble_cmd_frame_t *frame, uint8_t tag);
+
+// Integer field (decimal text or LE binary); def if missing or malformed
+uint32_t ble_cmd_u32(const ble_cmd_frame_t *frame, uint8_t tag, uint32_t def);
+
+// Byte field (hex text or raw binary) into out; returns its length, 0 if missing or malformed
+size_t ble_cmd_bytes(const ble_cmd_frame_t *frame, uint8_t tag, uint8_t *out, size_t max);
+
+// String field copied NUL-terminated; returns its length, 0 if missing or it does not fit
+size_t ble_cmd_str(const ble_cmd_frame_t *frame, uint8_t tag, char *out, size_t size);
+
+bool ble_cmd_equals(const ble_cmd_frame_t *frame, uint8_t tag, const char *str);
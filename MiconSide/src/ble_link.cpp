@@ -0,0 +1,272 @@
+#include "ble_link.h"
+
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#define BLE_LINK_DEFAULT_OCTETS 27
+
+typedef struct
+{
+    uint16_t min_int;
+    uint16_t max_int;
+    uint16_t latency;
+    uint16_t timeout;
+} ble_link_request_t;
+
+// Indexed by ble_link_profile_t
+static const ble_link_request_t s_requests[] = {
+    {BLE_LINK_IDLE_INTERVAL_MIN, BLE_LINK_IDLE_INTERVAL_MAX, BLE_LINK_IDLE_LATENCY, BLE_LINK_IDLE_TIMEOUT},
+    {BLE_LINK_ACTIVE_INTERVAL_MIN, BLE_LINK_ACTIVE_INTERVAL_MAX, 0, BLE_LINK_TIMEOUT},
+    {BLE_LINK_BULK_INTERVAL_MIN, BLE_LINK_BULK_INTERVAL_MAX, 0, BLE_LINK_TIMEOUT},
+};
+
+static ble_link_changed_fn s_on_change = NULL;
+static SemaphoreHandle_t s_lock = NULL;
+static esp_timer_handle_t s_timer = NULL; // Ends the ACTIVE hold
+static ble_link_params_t s_params;
+static esp_bd_addr_t s_bda;
+static bool s_connected = false;
+static bool s_bulk = false;
+static bool s_fast_data = false;          // DLE / 2M PHY requested on this connection
+static bool s_awaiting = false;           // Request sent, no UPDATE_CONN_PARAMS answer yet
+static uint8_t s_retries = 0;             // Refusals of s_params.requested in a row
+static int64_t s_wait_until_us = 0;       // Answer deadline, or end of the retry wait
+static volatile int64_t s_active_until_us = 0;
+
+// Lock held: the profile the link should be in now
+static ble_link_profile_t ble_link_wanted(void)
+{
+    if (s_bulk)
+        return BLE_LINK_BULK;
+    return esp_timer_get_time() < s_active_until_us ? BLE_LINK_ACTIVE : BLE_LINK_IDLE;
+}
+
+// Lock held: the request for s_params.requested was refused; ask again after BLE_LINK_RETRY_MS
+static void ble_link_refused(void)
+{
+    s_awaiting = false;
+    s_params.rejects++;
+    if (s_retries < 0xFF)
+        s_retries++;
+    s_wait_until_us = esp_timer_get_time() + (int64_t)BLE_LINK_RETRY_MS * 1000;
+}
+
+// Lock held: ask the central for the wanted profile until it grants it
+static void ble_link_apply(void)
+{
+    ble_link_profile_t profile = ble_link_wanted();
+    if (!s_connected)
+        return;
+
+    // One request at a time; an unanswered one counts as refused
+    if (esp_timer_get_time() < s_wait_until_us)
+        return;
+    if (s_awaiting)
+        ble_link_refused();
+    if (esp_timer_get_time() < s_wait_until_us)
+        return;
+
+    if (profile == s_params.granted)
+    {
+        s_retries = 0;
+        return;
+    }
+    if (profile != s_params.requested)
+        s_retries = 0;
+    else if (s_retries > BLE_LINK_MAX_RETRIES)
+        return; // The central keeps refusing; ask again once the wanted profile changes
+
+    const ble_link_request_t *req = &s_requests[profile];
+    esp_ble_conn_update_params_t update = {};
+    memcpy(update.bda, s_bda, sizeof(update.bda));
+    update.min_int = req->min_int;
+    update.max_int = req->max_int;
+    update.latency = req->latency;
+    update.timeout = req->timeout;
+    s_params.requested = profile;
+    s_params.requests++;
+    if (esp_ble_gap_update_conn_params(&update) == ESP_OK)
+    {
+        s_awaiting = true;
+        s_wait_until_us = esp_timer_get_time() + (int64_t)BLE_LINK_ANSWER_TIMEOUT_MS * 1000;
+    }
+    else
+    {
+        ble_link_refused();
+    }
+
+    if (profile == BLE_LINK_BULK && !s_fast_data)
+    {
+        s_fast_data = true;
+        esp_ble_gap_set_pkt_data_len(s_bda, BLE_LINK_DLE_OCTETS);
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+        esp_ble_gap_set_preferred_phy(s_bda, 0, ESP_BLE_GAP_PHY_2M_PREF_MASK, ESP_BLE_GAP_PHY_2M_PREF_MASK,
+                                      ESP_BLE_GAP_PHY_OPTIONS_NO_PREF);
+#endif
+    }
+}
+
+// Lock held: re-evaluate when the ACTIVE hold or the answer / retry wait runs out
+static void ble_link_arm(void)
+{
+    int64_t now = esp_timer_get_time();
+    int64_t left_us = s_active_until_us - now;
+    int64_t wait_us = s_wait_until_us - now;
+    if (s_connected && wait_us > 0 && (left_us <= 0 || wait_us < left_us))
+        left_us = wait_us;
+    esp_timer_stop(s_timer);
+    if (left_us > 0)
+        esp_timer_start_once(s_timer, left_us);
+}
+
+static void ble_link_timer_cb(void *arg)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ble_link_apply();
+    ble_link_arm(); // Activity may have moved the deadline since the timer was armed
+    xSemaphoreGive(s_lock);
+}
+
+static void ble_link_hold_active(void)
+{
+    s_active_until_us = esp_timer_get_time() + (int64_t)BLE_LINK_ACTIVE_HOLD_MS * 1000;
+    ble_link_apply();
+    ble_link_arm();
+}
+
+void ble_link_init(ble_link_changed_fn on_change)
+{
+    s_on_change = on_change;
+    s_lock = xSemaphoreCreateMutex();
+
+    esp_timer_create_args_t args = {};
+    args.callback = ble_link_timer_cb;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "ble_link";
+    esp_timer_create(&args, &s_timer);
+}
+
+void ble_link_gap_event(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param)
+{
+    bool changed = true;
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    switch (event)
+    {
+    case ESP_GAP_BLE_UPDATE_CONN_PARAMS_EVT:
+        if (param->update_conn_params.status != ESP_BT_STATUS_SUCCESS)
+        {
+            if (s_awaiting)
+                ble_link_refused();
+        }
+        else
+        {
+            s_params.interval = param->update_conn_params.conn_int;
+            s_params.latency = param->update_conn_params.latency;
+            s_params.timeout = param->update_conn_params.timeout;
+            if (s_awaiting) // Otherwise the central changed them on its own
+            {
+                s_awaiting = false;
+                s_params.granted = s_params.requested;
+                s_retries = 0;
+                s_wait_until_us = 0;
+            }
+        }
+        // The wanted profile may have moved while the request was out
+        ble_link_apply();
+        ble_link_arm();
+        break;
+
+    case ESP_GAP_BLE_SET_PKT_LENGTH_COMPLETE_EVT:
+        if (param->pkt_data_length_cmpl.status == ESP_BT_STATUS_SUCCESS)
+        {
+            s_params.tx_octets = param->pkt_data_length_cmpl.params.tx_len;
+            s_params.rx_octets = param->pkt_data_length_cmpl.params.rx_len;
+        }
+        break;
+
+#if CONFIG_BT_BLE_50_FEATURES_SUPPORTED
+    case ESP_GAP_BLE_PHY_UPDATE_COMPLETE_EVT:
+        if (param->phy_update.status == ESP_BT_STATUS_SUCCESS)
+        {
+            s_params.tx_phy = param->phy_update.tx_phy;
+            s_params.rx_phy = param->phy_update.rx_phy;
+        }
+        break;
+#endif
+
+    default:
+        changed = false;
+        break;
+    }
+    changed = changed && s_connected;
+    xSemaphoreGive(s_lock);
+
+    if (changed && s_on_change)
+        s_on_change();
+}
+
+void ble_link_connected(const uint8_t bda[6], uint16_t interval, uint16_t latency, uint16_t timeout)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    memcpy(s_bda, bda, sizeof(s_bda));
+    memset(&s_params, 0, sizeof(s_params));
+    s_params.requested = BLE_LINK_IDLE;
+    s_params.granted = BLE_LINK_IDLE; // Unknown; the ACTIVE hold below sends a request
+    s_params.interval = interval;
+    s_params.latency = latency;
+    s_params.timeout = timeout;
+    s_params.tx_octets = BLE_LINK_DEFAULT_OCTETS;
+    s_params.rx_octets = BLE_LINK_DEFAULT_OCTETS;
+    s_params.tx_phy = 1;
+    s_params.rx_phy = 1;
+    s_connected = true;
+    s_fast_data = false;
+    s_awaiting = false;
+    s_retries = 0;
+    s_wait_until_us = 0;
+
+    // Service discovery and the MTU exchange follow the connect
+    ble_link_hold_active();
+    xSemaphoreGive(s_lock);
+}
+
+void ble_link_disconnected(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_connected = false;
+    s_bulk = false;
+    s_params.interval = 0;
+    esp_timer_stop(s_timer);
+    xSemaphoreGive(s_lock);
+}
+
+void ble_link_bulk(bool on)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_bulk != on)
+    {
+        s_bulk = on;
+        ble_link_hold_active(); // Relax in steps once the transfer is over
+    }
+    xSemaphoreGive(s_lock);
+}
+
+void ble_link_activity(void)
+{
+    // Called for every log batch: skip the lock while the hold has most of its time left
+    if (s_active_until_us - esp_timer_get_time() > (int64_t)BLE_LINK_ACTIVE_HOLD_MS * 1000 / 2)
+        return;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ble_link_hold_active();
+    xSemaphoreGive(s_lock);
+}
+
+void ble_link_get(ble_link_params_t *out)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_params;
+    xSemaphoreGive(s_lock);
+}
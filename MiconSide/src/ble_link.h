@@ -0,0 +1,90 @@
+/*
+  ============================================================================
+  BLE Link Manager
+
+  Asks the central for connection parameters that fit what the link is
+  doing, instead of keeping whatever the phone picked at connect:
+
+    BULK    OTA session open: shortest interval, no peripheral latency,
+            Data Length Extension (251-byte LL payloads) and the 2M PHY
+    ACTIVE  BLE_LINK_ACTIVE_HOLD_MS after a connect, a debug command, a
+            provisioning write or a batch of log lines
+    IDLE    otherwise: long interval with peripheral latency, so an idle
+            connection costs little power
+
+  Requests go out through the Bluedroid GAP API; the central decides and
+  the outcome comes back as GAP events (ble_link_gap_event, registered as
+  the custom GAP handler). A profile counts as granted only once the
+  central accepts it; a refused (or unanswered) request is sent again
+  after BLE_LINK_RETRY_MS, up to BLE_LINK_MAX_RETRIES times, and then left
+  until the wanted profile changes. DLE and the 2M PHY are requested once
+  per connection and kept: the shorter air time also saves power when
+  idle. One esp_timer one-shot ends the ACTIVE hold and the retry wait;
+  nothing is polled.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <esp_gap_ble_api.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// Connection intervals in 1.25 ms units, supervision timeout in 10 ms units
+#define BLE_LINK_BULK_INTERVAL_MIN 6   // 7.5 ms
+#define BLE_LINK_BULK_INTERVAL_MAX 12  // 15 ms (the shortest iOS grants)
+#define BLE_LINK_ACTIVE_INTERVAL_MIN 12 // 15 ms
+#define BLE_LINK_ACTIVE_INTERVAL_MAX 24 // 30 ms
+#define BLE_LINK_IDLE_INTERVAL_MIN 64  // 80 ms
+#define BLE_LINK_IDLE_INTERVAL_MAX 128 // 160 ms
+#define BLE_LINK_IDLE_LATENCY 4        // Connection events the device may skip while idle
+#define BLE_LINK_TIMEOUT 400           // 4 s
+#define BLE_LINK_IDLE_TIMEOUT 600      // 6 s; must exceed (1 + latency) * interval * 2
+#define BLE_LINK_DLE_OCTETS 251        // Max LL payload (27 without DLE)
+#define BLE_LINK_ACTIVE_HOLD_MS 5000
+#define BLE_LINK_ANSWER_TIMEOUT_MS 10000 // No UPDATE_CONN_PARAMS answer by then: treated as refused
+#define BLE_LINK_RETRY_MS 2000           // Wait after a refusal before asking again
+#define BLE_LINK_MAX_RETRIES 3           // Per wanted profile
+
+typedef enum
+{
+    BLE_LINK_IDLE = 0,
+    BLE_LINK_ACTIVE,
+    BLE_LINK_BULK,
+} ble_link_profile_t;
+
+typedef struct
+{
+    ble_link_profile_t requested; // Last asked for
+    ble_link_profile_t granted;   // Last the central accepted (IDLE until the first answer)
+    uint16_t interval;          // Negotiated, 1.25 ms units (0 = not connected)
+    uint16_t latency;
+    uint16_t timeout;           // 10 ms units
+    uint16_t tx_octets;         // LL payload per packet, device -> central
+    uint16_t rx_octets;
+    uint8_t tx_phy;             // 1 = 1M, 2 = 2M, 3 = Coded
+    uint8_t rx_phy;
+    uint32_t requests;          // Parameter update requests sent, this connection
+    uint32_t rejects;           // Requests the central refused or that failed
+} ble_link_params_t;
+
+// Negotiated parameters changed (called from the BLE stack's task)
+typedef void (*ble_link_changed_fn)(void);
+
+// Hold timer; call once from setup, before BLE connections are accepted
+void ble_link_init(ble_link_changed_fn on_change);
+
+// GAP events: pass to BLEDevice::setCustomGapHandler()
+void ble_link_gap_event(esp_gap_ble_cb_event_t event, esp_ble_gap_cb_param_t *param);
+
+// Connection up with the parameters the central chose (gatts connect event)
+void ble_link_connected(const uint8_t bda[6], uint16_t interval, uint16_t latency, uint16_t timeout);
+void ble_link_disconnected(void);
+
+// OTA session opened / closed: BULK while on, then ACTIVE for the hold time
+void ble_link_bulk(bool on);
+
+// Traffic on the link: stay (or become) ACTIVE for BLE_LINK_ACTIVE_HOLD_MS
+void ble_link_activity(void);
+
+void ble_link_get(ble_link_params_t *out);
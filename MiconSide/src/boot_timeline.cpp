@@ -0,0 +1,38 @@
+#include "boot_timeline.h"
+
+#include <esp_timer.h>
+#include <stdio.h>
+
+static boot_mark_t s_marks[BOOT_TIMELINE_MAX];
+static size_t s_count = 0;
+
+uint32_t boot_timeline_mark(const char *phase)
+{
+    uint32_t us = (uint32_t)esp_timer_get_time();
+    if (s_count < BOOT_TIMELINE_MAX)
+    {
+        s_marks[s_count].phase = phase;
+        s_marks[s_count].us = us;
+        s_count++;
+    }
+    return us;
+}
+
+size_t boot_timeline_format(char *out, size_t size)
+{
+    size_t len = 0;
+    if (size > 0)
+        out[0] = '\0';
+
+    for (size_t i = 0; i < s_count && len < size; i++)
+    {
+        int n = snprintf(out + len, size - len, "%s%s=%u", i ? "," : "", s_marks[i].phase, (unsigned)s_marks[i].us);
+        if (n < 0 || (size_t)n >= size - len)
+        {
+            out[len] = '\0'; // Keep whole entries only
+            break;
+        }
+        len += n;
+    }
+    return len;
+}
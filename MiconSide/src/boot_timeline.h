@@ -0,0 +1,28 @@
+/*
+  ============================================================================
+  Boot Timeline
+
+  setup() records an esp_timer_get_time() timestamp at each checkpoint.
+  The formatted timeline is exposed on the DebugBoot characteristic so boot
+  latency can be compared across firmware versions and boot profiles.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define BOOT_TIMELINE_MAX 16
+
+typedef struct
+{
+    const char *phase; // Static string
+    uint32_t us;       // Microseconds since the timer started (≈ since reset)
+} boot_mark_t;
+
+// Record a checkpoint; returns its timestamp (marks past BOOT_TIMELINE_MAX are dropped)
+uint32_t boot_timeline_mark(const char *phase);
+
+// "<phase>=<us>,<phase>=<us>,..." ; returns the text length
+size_t boot_timeline_format(char *out, size_t size);
@@ -0,0 +1,389 @@
+#include "config_store.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#define CONFIG_COMMIT_MAX_DELAY_MS (4 * CONFIG_COMMIT_DELAY_MS) // Cap for a steady stream of changes
+
+static const char *NVS_WIFI_NS = "wifi";
+static const char *NVS_SYSCFG_NS = "syscfg";
+
+// Cached keys, one dirty bit each
+typedef enum
+{
+    KEY_SSID,
+    KEY_PASS,
+    KEY_PROV,
+    KEY_LINK,
+    KEY_STATIC_IP,
+    KEY_LOG_LVL,
+    KEY_FAST_BOOT,
+    KEY_FACTORY_RESET,
+    KEY_LEGACY_PROV, // v0 "prov" in syscfg, removed on migration
+    KEY_COUNT,
+} config_key_t;
+
+#define KEYS_WIFI ((1u << KEY_SSID) | (1u << KEY_PASS) | (1u << KEY_PROV) | (1u << KEY_LINK) | (1u << KEY_STATIC_IP))
+#define KEYS_SYSCFG ((1u << KEY_LOG_LVL) | (1u << KEY_FAST_BOOT) | (1u << KEY_FACTORY_RESET) | (1u << KEY_LEGACY_PROV))
+
+static config_t s_cfg;
+static config_t s_defaults;
+static SemaphoreHandle_t s_lock = NULL;
+static config_store_changed_fn s_on_change = NULL;
+static uint32_t s_dirty = 0;
+static uint32_t s_first_dirty_ms = 0;
+static uint32_t s_last_dirty_ms = 0;
+static uint8_t s_version[2] = {0, 0}; // Stored schema version: wifi, syscfg
+static config_stats_t s_stats;
+
+static void config_copy_str(char *dst, size_t size, const char *src)
+{
+    strncpy(dst, src ? src : "", size - 1);
+    dst[size - 1] = '\0';
+}
+
+static void config_store_load(void)
+{
+    Preferences nvs;
+    s_cfg = s_defaults;
+
+    // Read-only opens fail for a namespace that was never written: keep the defaults
+    if (nvs.begin(NVS_WIFI_NS, true))
+    {
+        nvs.getString("ssid", s_cfg.ssid, sizeof(s_cfg.ssid));
+        nvs.getString("pass", s_cfg.pass, sizeof(s_cfg.pass));
+        s_cfg.provisioned = nvs.getUChar("prov", s_defaults.provisioned);
+        s_cfg.static_ip = nvs.getUChar("static_ip", s_defaults.static_ip);
+        if (nvs.getBytes("link", &s_cfg.link, sizeof(s_cfg.link)) != sizeof(s_cfg.link))
+            s_cfg.link = s_defaults.link;
+        s_version[0] = nvs.getUChar("ver", 0);
+        nvs.end();
+    }
+
+    bool legacy_prov = false;
+    if (nvs.begin(NVS_SYSCFG_NS, true))
+    {
+        s_cfg.log_level = nvs.getUChar("log_lvl", s_defaults.log_level);
+        s_cfg.fast_boot = nvs.getUChar("fast_boot", s_defaults.fast_boot);
+        s_cfg.factory_reset = nvs.getUChar("factory_reset", s_defaults.factory_reset);
+        s_version[1] = nvs.getUChar("ver", 0);
+        if (s_version[1] < 1 && nvs.isKey("prov"))
+        {
+            legacy_prov = nvs.getUChar("prov", 0);
+            s_dirty |= 1u << KEY_LEGACY_PROV;
+        }
+        nvs.end();
+    }
+
+    // v0: provisioning wrote "prov" to syscfg while boot read it from wifi
+    if (legacy_prov && !s_cfg.provisioned && s_cfg.ssid[0])
+    {
+        s_cfg.provisioned = true;
+        s_dirty |= 1u << KEY_PROV;
+    }
+    s_first_dirty_ms = s_last_dirty_ms = millis();
+}
+
+void config_store_init(const config_t *defaults, config_store_changed_fn on_change)
+{
+    if (!s_lock)
+        s_lock = xSemaphoreCreateMutex();
+    s_defaults = *defaults;
+    s_on_change = on_change;
+    memset(&s_stats, 0, sizeof(s_stats));
+    s_dirty = 0;
+    config_store_load();
+}
+
+void config_get(config_t *out)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_cfg;
+    xSemaphoreGive(s_lock);
+}
+
+// Lock held; returns true if the key became (or stays) dirty
+static bool config_store_mark(config_key_t key, bool changed)
+{
+    if (!changed)
+    {
+        s_stats.unchanged++;
+        return false;
+    }
+
+    uint32_t now = millis();
+    if (s_dirty & (1u << key))
+        s_stats.coalesced++;
+    if (!s_dirty)
+        s_first_dirty_ms = now;
+    s_last_dirty_ms = now;
+    s_dirty |= 1u << key;
+    return true;
+}
+
+static void config_store_notify(bool changed)
+{
+    if (changed && s_on_change)
+        s_on_change();
+}
+
+void config_set_wifi(const char *ssid, const char *pass)
+{
+    char new_ssid[sizeof(s_cfg.ssid)];
+    char new_pass[sizeof(s_cfg.pass)];
+    config_copy_str(new_ssid, sizeof(new_ssid), ssid);
+    config_copy_str(new_pass, sizeof(new_pass), pass);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_SSID, strcmp(s_cfg.ssid, new_ssid) != 0);
+    changed |= config_store_mark(KEY_PASS, strcmp(s_cfg.pass, new_pass) != 0);
+    memcpy(s_cfg.ssid, new_ssid, sizeof(new_ssid));
+    memcpy(s_cfg.pass, new_pass, sizeof(new_pass));
+    if (changed && s_cfg.link.channel)
+    {
+        memset(&s_cfg.link, 0, sizeof(s_cfg.link)); // Cached for the old network
+        config_store_mark(KEY_LINK, true);
+    }
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_wifi_link(const config_wifi_link_t *link)
+{
+    config_wifi_link_t next = {};
+    if (link)
+        next = *link;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_LINK, memcmp(&s_cfg.link, &next, sizeof(next)) != 0);
+    s_cfg.link = next;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_static_ip(bool enabled)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_STATIC_IP, s_cfg.static_ip != enabled);
+    s_cfg.static_ip = enabled;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_provisioned(bool provisioned)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_PROV, s_cfg.provisioned != provisioned);
+    s_cfg.provisioned = provisioned;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_log_level(uint8_t level)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_LOG_LVL, s_cfg.log_level != level);
+    s_cfg.log_level = level;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_fast_boot(bool enabled)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_FAST_BOOT, s_cfg.fast_boot != enabled);
+    s_cfg.fast_boot = enabled;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+void config_set_factory_reset(bool requested)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = config_store_mark(KEY_FACTORY_RESET, s_cfg.factory_reset != requested);
+    s_cfg.factory_reset = requested;
+    xSemaphoreGive(s_lock);
+    config_store_notify(changed);
+}
+
+uint32_t config_store_pending_ms(uint32_t now_ms)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t left = CONFIG_CLEAN;
+    if (s_dirty)
+    {
+        uint32_t quiet = now_ms - s_last_dirty_ms;
+        uint32_t age = now_ms - s_first_dirty_ms;
+        left = 0;
+        if (quiet < CONFIG_COMMIT_DELAY_MS && age < CONFIG_COMMIT_MAX_DELAY_MS)
+            left = min(CONFIG_COMMIT_DELAY_MS - quiet, CONFIG_COMMIT_MAX_DELAY_MS - age);
+    }
+    xSemaphoreGive(s_lock);
+    return left;
+}
+
+static bool config_store_put(Preferences *nvs, config_key_t key, const config_t *cfg)
+{
+    switch (key)
+    {
+    case KEY_SSID:
+        return nvs->putString("ssid", cfg->ssid) == strlen(cfg->ssid);
+    case KEY_PASS:
+        return nvs->putString("pass", cfg->pass) == strlen(cfg->pass);
+    case KEY_PROV:
+        return nvs->putUChar("prov", cfg->provisioned) == 1;
+    case KEY_LINK:
+        if (!cfg->link.channel)
+            return !nvs->isKey("link") || nvs->remove("link");
+        return nvs->putBytes("link", &cfg->link, sizeof(cfg->link)) == sizeof(cfg->link);
+    case KEY_STATIC_IP:
+        return nvs->putUChar("static_ip", cfg->static_ip) == 1;
+    case KEY_LOG_LVL:
+        return nvs->putUChar("log_lvl", cfg->log_level) == 1;
+    case KEY_FAST_BOOT:
+        return nvs->putUChar("fast_boot", cfg->fast_boot) == 1;
+    case KEY_FACTORY_RESET:
+        return nvs->putUChar("factory_reset", cfg->factory_reset) == 1;
+    case KEY_LEGACY_PROV:
+        return !nvs->isKey("prov") || nvs->remove("prov");
+    default:
+        return true;
+    }
+}
+
+// One open/close (and NVS commit) per namespace; returns the keys that failed
+static uint32_t config_store_write_ns(int ns, const char *name, uint32_t keys, const config_t *cfg,
+                                      uint32_t *writes)
+{
+    if (!keys)
+        return 0;
+
+    Preferences nvs;
+    if (!nvs.begin(name, false))
+        return keys;
+
+    uint32_t failed = 0;
+    for (int key = 0; key < KEY_COUNT; key++)
+    {
+        if (!(keys & (1u << key)))
+            continue;
+        if (config_store_put(&nvs, (config_key_t)key, cfg))
+            (*writes)++;
+        else
+            failed |= 1u << key;
+    }
+    if (s_version[ns] != CONFIG_SCHEMA_VERSION && !failed &&
+        nvs.putUChar("ver", CONFIG_SCHEMA_VERSION) == 1)
+    {
+        s_version[ns] = CONFIG_SCHEMA_VERSION;
+    }
+    nvs.end();
+    return failed;
+}
+
+bool config_store_commit(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    uint32_t dirty = s_dirty;
+    config_t cfg = s_cfg;
+    s_dirty = 0;
+    xSemaphoreGive(s_lock);
+
+    if (!dirty)
+        return true;
+
+    // Flash writes happen outside the lock; keys changed meanwhile are dirty again
+    uint32_t writes = 0;
+    uint32_t failed = config_store_write_ns(0, NVS_WIFI_NS, dirty & KEYS_WIFI, &cfg, &writes);
+    failed |= config_store_write_ns(1, NVS_SYSCFG_NS, dirty & KEYS_SYSCFG, &cfg, &writes);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.commits += writes > 0;
+    s_stats.writes += writes;
+    s_stats.failures += __builtin_popcount(failed);
+    if (failed)
+    {
+        if (!s_dirty)
+            s_first_dirty_ms = millis();
+        s_last_dirty_ms = millis();
+        s_dirty |= failed;
+    }
+    xSemaphoreGive(s_lock);
+    return failed == 0;
+}
+
+void config_store_erase(uint32_t ns_mask)
+{
+    Preferences nvs;
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (ns_mask & CONFIG_NS_WIFI)
+    {
+        memcpy(s_cfg.ssid, s_defaults.ssid, sizeof(s_cfg.ssid));
+        memcpy(s_cfg.pass, s_defaults.pass, sizeof(s_cfg.pass));
+        s_cfg.provisioned = s_defaults.provisioned;
+        s_cfg.link = s_defaults.link;
+        s_cfg.static_ip = s_defaults.static_ip;
+        s_dirty &= ~KEYS_WIFI;
+    }
+    if (ns_mask & CONFIG_NS_SYSCFG)
+    {
+        s_cfg.log_level = s_defaults.log_level;
+        s_cfg.fast_boot = s_defaults.fast_boot;
+        s_cfg.factory_reset = s_defaults.factory_reset;
+        s_dirty &= ~KEYS_SYSCFG;
+    }
+    xSemaphoreGive(s_lock);
+
+    if ((ns_mask & CONFIG_NS_WIFI) && nvs.begin(NVS_WIFI_NS, false))
+    {
+        nvs.clear();
+        nvs.end();
+        s_version[0] = 0;
+    }
+    if ((ns_mask & CONFIG_NS_SYSCFG) && nvs.begin(NVS_SYSCFG_NS, false))
+    {
+        nvs.clear();
+        nvs.end();
+        s_version[1] = 0;
+    }
+}
+
+size_t config_store_blob_get(const char *key, void *out, size_t len)
+{
+    Preferences nvs;
+    if (!nvs.begin(NVS_SYSCFG_NS, true))
+        return 0;
+    size_t got = nvs.getBytes(key, out, len);
+    nvs.end();
+    return got;
+}
+
+bool config_store_blob_put(const char *key, const void *data, size_t len)
+{
+    Preferences nvs;
+    if (!nvs.begin(NVS_SYSCFG_NS, false))
+        return false;
+    bool ok = nvs.putBytes(key, data, len) == len;
+    nvs.end();
+    return ok;
+}
+
+void config_store_blob_remove(const char *key)
+{
+    Preferences nvs;
+    if (!nvs.begin(NVS_SYSCFG_NS, false))
+        return;
+    nvs.remove(key);
+    nvs.end();
+}
+
+void config_store_get_stats(config_stats_t *out)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_stats;
+    xSemaphoreGive(s_lock);
+}
@@ -0,0 +1,102 @@
+/*
+  ============================================================================
+  Configuration Store
+
+  Typed settings from the "wifi" and "syscfg" NVS namespaces, loaded into
+  RAM once at boot. Reads never touch flash. Setters only mark changed
+  keys dirty; loop() commits them in one pass per namespace once writes
+  have been quiet for CONFIG_COMMIT_DELAY_MS, so a burst of changes costs
+  a single NVS commit and unchanged values are never rewritten.
+
+  The last successful Wi-Fi link (BSSID, channel, DHCP lease) is cached
+  too, so a reconnect can skip the scan and, optionally, DHCP.
+
+  Each namespace carries a schema version ("ver"). Loading an older
+  layout migrates it on the next commit (v0 kept "prov" in either
+  namespace; it now lives in "wifi" only).
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define CONFIG_SCHEMA_VERSION 1
+#define CONFIG_SSID_MAX 32
+#define CONFIG_PASS_MAX 64
+#define CONFIG_COMMIT_DELAY_MS 500 // Quiet time before dirty keys are written
+#define CONFIG_CLEAN 0xffffffffu   // config_store_pending_ms(): nothing to commit
+
+#define CONFIG_NS_WIFI (1u << 0)
+#define CONFIG_NS_SYSCFG (1u << 1)
+
+typedef struct
+{
+    uint8_t bssid[6];
+    uint8_t channel; // 0 = nothing cached
+    uint8_t reserved; // Keeps the NVS blob free of padding
+    uint32_t ip;     // Last lease, as IPAddress converts to uint32_t
+    uint32_t gateway;
+    uint32_t netmask;
+    uint32_t dns;
+} config_wifi_link_t;
+
+typedef struct
+{
+    // "wifi"
+    char ssid[CONFIG_SSID_MAX + 1];
+    char pass[CONFIG_PASS_MAX + 1];
+    bool provisioned;
+    config_wifi_link_t link;
+    bool static_ip; // Reuse link's lease instead of DHCP on the cached-channel connect
+
+    // "syscfg"
+    uint8_t log_level;
+    bool fast_boot;
+    bool factory_reset;
+} config_t;
+
+typedef struct
+{
+    uint32_t commits;    // Commit passes that wrote at least one key
+    uint32_t writes;     // Keys written (or removed)
+    uint32_t coalesced;  // Changes merged into a pending write of the same key
+    uint32_t unchanged;  // Setter calls that matched the stored value
+    uint32_t failures;   // Keys that failed to write (retried on the next commit)
+} config_stats_t;
+
+// Called (from the setter's task) whenever a key becomes dirty
+typedef void (*config_store_changed_fn)(void);
+
+// Load both namespaces; keys that are missing take their value from defaults
+void config_store_init(const config_t *defaults, config_store_changed_fn on_change);
+
+// Consistent snapshot of the current settings
+void config_get(config_t *out);
+
+// New credentials also drop the cached link
+void config_set_wifi(const char *ssid, const char *pass);
+// NULL clears the cached link
+void config_set_wifi_link(const config_wifi_link_t *link);
+void config_set_static_ip(bool enabled);
+void config_set_provisioned(bool provisioned);
+void config_set_log_level(uint8_t level);
+void config_set_fast_boot(bool enabled);
+void config_set_factory_reset(bool requested);
+
+// Milliseconds until the pending commit is due (0 = now), CONFIG_CLEAN if nothing is dirty
+uint32_t config_store_pending_ms(uint32_t now_ms);
+
+// Write dirty keys now (call before a reboot); false if a key failed to write
+bool config_store_commit(void);
+
+// Erase the namespaces in ns_mask and reset their settings to the defaults
+void config_store_erase(uint32_t ns_mask);
+
+// Uncached records in "syscfg" (e.g. OTA session state), written through immediately
+size_t config_store_blob_get(const char *key, void *out, size_t len);
+bool config_store_blob_put(const char *key, const void *data, size_t len);
+void config_store_blob_remove(const char *key);
+
+void config_store_get_stats(config_stats_t *out);
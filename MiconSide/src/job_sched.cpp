@@ -0,0 +1,271 @@
+#include "job_sched.h"
+
+#include <string.h>
+
+#define SCHED_SLOTS (1u << SCHED_WHEEL_BITS)
+#define SCHED_SLOT_MASK (SCHED_SLOTS - 1)
+#define SCHED_SPAN (SCHED_SLOTS * SCHED_SLOTS) // Ticks covered by both levels
+#define SCHED_NONE -1
+
+typedef struct
+{
+    sched_job_fn fn;
+    void *arg;
+    uint32_t due;    // Tick
+    int8_t next;     // Next job in the same slot
+    int8_t level;    // Wheel level holding the job, SCHED_NONE = unlinked
+    uint8_t slot;
+    bool active;
+    sched_stats_t stats;
+} sched_job_t;
+
+static sched_job_t s_jobs[SCHED_MAX_JOBS];
+static int8_t s_wheel[2][SCHED_SLOTS]; // Slot list heads
+static uint32_t s_tick = 0;            // Next tick to process
+static sched_clock_fn s_clock = NULL;
+
+static uint32_t sched_now_tick(void)
+{
+    return (uint32_t)(s_clock() / 1000 / SCHED_TICK_MS);
+}
+
+static void sched_link(int id)
+{
+    sched_job_t *job = &s_jobs[id];
+    int32_t delta = (int32_t)(job->due - s_tick);
+    if (delta < 0)
+    {
+        job->due = s_tick; // Overdue: next tick
+        delta = 0;
+    }
+
+    if (delta < (int32_t)SCHED_SLOTS)
+    {
+        job->level = 0;
+        job->slot = job->due & SCHED_SLOT_MASK;
+    }
+    else
+    {
+        // Beyond the upper level: park in its last slot and cascade again later
+        uint32_t at = delta < (int32_t)SCHED_SPAN ? job->due : s_tick + SCHED_SPAN - SCHED_SLOTS;
+        job->level = 1;
+        job->slot = (at >> SCHED_WHEEL_BITS) & SCHED_SLOT_MASK;
+    }
+    job->next = s_wheel[job->level][job->slot];
+    s_wheel[job->level][job->slot] = id;
+}
+
+static void sched_unlink(int id)
+{
+    sched_job_t *job = &s_jobs[id];
+    if (job->level == SCHED_NONE)
+        return;
+
+    int8_t *link = &s_wheel[job->level][job->slot];
+    while (*link != SCHED_NONE && *link != id)
+        link = &s_jobs[*link].next;
+    if (*link == id)
+        *link = job->next;
+    job->level = SCHED_NONE;
+}
+
+static void sched_execute(int id, uint32_t now_tick)
+{
+    sched_job_t *job = &s_jobs[id];
+    sched_stats_t *st = &job->stats;
+
+    uint32_t late_ms = (now_tick - job->due) * SCHED_TICK_MS;
+    if (late_ms > st->max_late_ms)
+        st->max_late_ms = late_ms;
+
+    int64_t start = s_clock();
+    job->fn(job->arg);
+    uint32_t us = (uint32_t)(s_clock() - start);
+
+    st->runs++;
+    st->last_us = us;
+    st->total_us += us;
+    if (us > st->max_us)
+        st->max_us = us;
+
+    // The job may have cancelled or re-triggered itself
+    if (!job->active || job->level != SCHED_NONE)
+        return;
+
+    if (st->period_ms == 0)
+    {
+        job->active = false;
+        return;
+    }
+
+    uint32_t period = (st->period_ms + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+    if (us / 1000 > st->period_ms)
+        st->overruns++;
+    job->due += period;
+    if ((int32_t)(job->due - now_tick) <= 0)
+    {
+        // Missed at least one period: skip ahead instead of running back to back
+        st->overruns++;
+        job->due = now_tick + period;
+    }
+    sched_link(id);
+}
+
+// Start of a level 0 rotation: move the matching upper slot down
+static void sched_cascade(uint32_t tick)
+{
+    int8_t *head = &s_wheel[1][(tick >> SCHED_WHEEL_BITS) & SCHED_SLOT_MASK];
+    int8_t id = *head;
+    *head = SCHED_NONE;
+    while (id != SCHED_NONE)
+    {
+        int8_t next = s_jobs[id].next;
+        sched_link(id);
+        id = next;
+    }
+}
+
+// Fire the level 0 slot of tick in priority order
+static void sched_fire(uint32_t tick, uint32_t now_tick)
+{
+    int8_t due[SCHED_MAX_JOBS];
+    size_t count = 0;
+    int8_t *head = &s_wheel[0][tick & SCHED_SLOT_MASK];
+    int8_t id = *head;
+    *head = SCHED_NONE;
+    while (id != SCHED_NONE)
+    {
+        int8_t next = s_jobs[id].next;
+        s_jobs[id].level = SCHED_NONE;
+
+        // Insertion sort, highest priority first (stable for equal priority)
+        size_t i = count++;
+        while (i > 0 && s_jobs[due[i - 1]].stats.priority < s_jobs[id].stats.priority)
+        {
+            due[i] = due[i - 1];
+            i--;
+        }
+        due[i] = id;
+        id = next;
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // An earlier job in this tick may have cancelled or re-triggered it
+        if (s_jobs[due[i]].active && s_jobs[due[i]].level == SCHED_NONE)
+            sched_execute(due[i], now_tick);
+    }
+}
+
+void sched_init(sched_clock_fn clock)
+{
+    s_clock = clock;
+    memset(s_jobs, 0, sizeof(s_jobs));
+    memset(s_wheel, SCHED_NONE, sizeof(s_wheel));
+    for (int i = 0; i < SCHED_MAX_JOBS; i++)
+        s_jobs[i].level = SCHED_NONE;
+    s_tick = sched_now_tick();
+}
+
+int sched_add(const char *name, sched_job_fn fn, void *arg,
+              uint32_t period_ms, uint32_t delay_ms, uint8_t priority)
+{
+    for (int id = 0; id < SCHED_MAX_JOBS; id++)
+    {
+        sched_job_t *job = &s_jobs[id];
+        if (job->active)
+            continue;
+
+        memset(job, 0, sizeof(*job));
+        job->fn = fn;
+        job->arg = arg;
+        job->active = true;
+        job->level = SCHED_NONE;
+        job->stats.name = name;
+        job->stats.period_ms = period_ms;
+        job->stats.priority = priority;
+        job->due = sched_now_tick() + (delay_ms + SCHED_TICK_MS - 1) / SCHED_TICK_MS;
+        sched_link(id);
+        return id;
+    }
+    return -1;
+}
+
+void sched_cancel(int id)
+{
+    if (id < 0 || id >= SCHED_MAX_JOBS)
+        return;
+    sched_unlink(id);
+    s_jobs[id].active = false;
+}
+
+void sched_trigger(int id)
+{
+    if (id < 0 || id >= SCHED_MAX_JOBS || !s_jobs[id].active)
+        return;
+    sched_unlink(id);
+    s_jobs[id].due = s_tick;
+    sched_link(id);
+}
+
+void sched_run(void)
+{
+    uint32_t now_tick = sched_now_tick();
+    uint32_t behind = now_tick - s_tick + 1;
+
+    if ((int32_t)behind > (int32_t)SCHED_SPAN)
+    {
+        // Clock jumped past the whole wheel: relink everything as due now
+        for (int id = 0; id < SCHED_MAX_JOBS; id++)
+        {
+            sched_unlink(id);
+            if (s_jobs[id].active && (int32_t)(s_jobs[id].due - now_tick) < 0)
+            {
+                s_jobs[id].stats.overruns += s_jobs[id].stats.period_ms > 0;
+                s_jobs[id].due = now_tick;
+            }
+        }
+        s_tick = now_tick;
+        for (int id = 0; id < SCHED_MAX_JOBS; id++)
+        {
+            if (s_jobs[id].active)
+                sched_link(id);
+        }
+    }
+
+    while ((int32_t)(now_tick - s_tick) >= 0)
+    {
+        uint32_t tick = s_tick;
+        if ((tick & SCHED_SLOT_MASK) == 0)
+            sched_cascade(tick);
+        // Jobs (re)linked while firing land on later ticks, never the slot being fired
+        s_tick = tick + 1;
+        sched_fire(tick, now_tick);
+    }
+}
+
+uint32_t sched_next_ms(void)
+{
+    int64_t now_ms = s_clock() / 1000;
+    uint32_t now_tick = (uint32_t)(now_ms / SCHED_TICK_MS);
+    uint32_t next = SCHED_IDLE;
+
+    for (int id = 0; id < SCHED_MAX_JOBS; id++)
+    {
+        if (!s_jobs[id].active)
+            continue;
+        int32_t ticks = (int32_t)(s_jobs[id].due - now_tick);
+        uint32_t ms = ticks <= 0 ? 0 : (uint32_t)ticks * SCHED_TICK_MS - (uint32_t)(now_ms % SCHED_TICK_MS);
+        if (ms < next)
+            next = ms;
+    }
+    return next;
+}
+
+bool sched_get_stats(int id, sched_stats_t *out)
+{
+    if (id < 0 || id >= SCHED_MAX_JOBS || !s_jobs[id].active)
+        return false;
+    *out = s_jobs[id].stats;
+    return true;
+}
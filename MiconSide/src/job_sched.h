@@ -0,0 +1,68 @@
+/*
+  ============================================================================
+  Cooperative Job Scheduler
+
+  Periodic and one-shot jobs run from loop() (sched_run), kept in a
+  two-level hierarchical timer wheel: 64 slots of SCHED_TICK_MS, then 64
+  slots of 64 ticks; jobs further out cascade down as the wheel turns.
+  Jobs due in the same tick run highest priority first. Per-job run time
+  and overrun statistics are kept for the SCHED debug command.
+
+  Time comes from an injected microsecond clock (esp_timer_get_time on the
+  device), so a host build can drive the wheel with a virtual clock.
+  Not thread-safe: call everything from the loop task (jobs included).
+  No Arduino / FreeRTOS dependency.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SCHED_MAX_JOBS 16
+#define SCHED_TICK_MS 10
+#define SCHED_WHEEL_BITS 6 // 64 slots per level: ~0.64 s / ~41 s spans
+#define SCHED_IDLE 0xffffffffu // sched_next_ms(): no job armed
+
+#define SCHED_PRIO_LOW 0
+#define SCHED_PRIO_NORMAL 1
+#define SCHED_PRIO_HIGH 2
+
+typedef int64_t (*sched_clock_fn)(void); // Monotonic time in microseconds
+typedef void (*sched_job_fn)(void *arg);
+
+typedef struct
+{
+    const char *name;
+    uint32_t period_ms; // 0 = one-shot
+    uint8_t priority;
+    uint32_t runs;
+    uint32_t overruns;  // Ran longer than its period, or a whole period was missed
+    uint32_t max_late_ms; // Worst start delay past the due time
+    uint32_t last_us;
+    uint32_t max_us;
+    uint64_t total_us;
+} sched_stats_t;
+
+void sched_init(sched_clock_fn clock);
+
+// Returns a job id, or -1 when all SCHED_MAX_JOBS slots are used.
+// First run after delay_ms; period_ms = 0 runs once and frees the slot.
+// Periods and delays round up to whole ticks.
+int sched_add(const char *name, sched_job_fn fn, void *arg,
+              uint32_t period_ms, uint32_t delay_ms, uint8_t priority);
+
+void sched_cancel(int id);
+
+// Run the job at the next tick (a periodic job keeps its period from then)
+void sched_trigger(int id);
+
+// Run every job that is due
+void sched_run(void);
+
+// Milliseconds until the next job is due (0 = overdue), SCHED_IDLE if none
+uint32_t sched_next_ms(void);
+
+// False if id is not an active job
+bool sched_get_stats(int id, sched_stats_t *out);
@@ -0,0 +1,65 @@
+#include "led_engine.h"
+
+static const led_step_t LED_OFF = {0, 0, 0, false, LED_HOLD};
+
+void led_engine_init(led_engine_t *e)
+{
+    e->base = NULL;
+    e->overlay = NULL;
+    e->step = 0;
+    e->loops = 0;
+}
+
+bool led_engine_set_base(led_engine_t *e, const led_pattern_t *pattern)
+{
+    if (e->base == pattern)
+        return false;
+
+    e->base = pattern;
+    if (e->overlay)
+        return false; // Picked up when the overlay ends
+
+    e->step = 0;
+    e->loops = 0;
+    return true;
+}
+
+void led_engine_play(led_engine_t *e, const led_pattern_t *pattern)
+{
+    e->overlay = pattern;
+    e->step = 0;
+    e->loops = 0;
+}
+
+uint32_t led_engine_advance(led_engine_t *e, led_step_t *out)
+{
+    for (;;)
+    {
+        const led_pattern_t *p = e->overlay ? e->overlay : e->base;
+        if (!p || p->count == 0)
+        {
+            *out = LED_OFF;
+            return LED_HOLD;
+        }
+
+        if (e->step >= p->count)
+        {
+            e->step = 0;
+            if (p->repeat && ++e->loops >= p->repeat)
+            {
+                e->loops = 0;
+                if (e->overlay)
+                {
+                    e->overlay = NULL; // Back to the base, from its first step
+                    continue;
+                }
+                // A finite base pattern holds its last step
+                *out = p->steps[p->count - 1];
+                return LED_HOLD;
+            }
+        }
+
+        *out = p->steps[e->step++];
+        return out->ms;
+    }
+}
@@ -0,0 +1,55 @@
+/*
+  ============================================================================
+  Status LED Pattern Engine
+
+  Declarative LED patterns (lists of colour + duration steps) played by a
+  pure state machine: a base pattern for the current device state and an
+  optional overlay (e.g. the heartbeat flash) that plays its repeat count
+  and then hands back to the base. The driver applies each step and arms
+  a one-shot timer for its duration, so nothing ever blocks on the LED.
+  No Arduino / FreeRTOS dependency so it can be built on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LED_HOLD 0 // Step duration / led_engine_advance(): keep until the pattern changes
+
+typedef struct
+{
+    uint8_t r, g, b; // RGB LED colour
+    bool gpio_on;    // Plain GPIO LED
+    uint16_t ms;     // Step duration, LED_HOLD = forever
+} led_step_t;
+
+typedef struct
+{
+    const led_step_t *steps;
+    uint8_t count;
+    uint8_t repeat; // Times to play, 0 = loop forever
+} led_pattern_t;
+
+#define LED_PATTERN(steps, repeat) {steps, sizeof(steps) / sizeof(steps[0]), repeat}
+
+typedef struct
+{
+    const led_pattern_t *base;
+    const led_pattern_t *overlay;
+    uint8_t step;  // Next step of the playing pattern
+    uint8_t loops; // Completed plays of the playing pattern
+} led_engine_t;
+
+void led_engine_init(led_engine_t *e);
+
+// Switch the state pattern (restarts it unless it is already the base)
+// Returns true if the output must be refreshed now.
+bool led_engine_set_base(led_engine_t *e, const led_pattern_t *pattern);
+
+// Play a pattern over the base, then return to the base from its start
+void led_engine_play(led_engine_t *e, const led_pattern_t *pattern);
+
+// Output for now and how long to keep it (ms, LED_HOLD = until the next change)
+uint32_t led_engine_advance(led_engine_t *e, led_step_t *out);
@@ -0,0 +1,178 @@
+#include "log_async.h"
+#include "log_dict.h"
+#include "log_ring.h"
+
+#include <Arduino.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+
+#define LOG_TASK_STACK 4096
+#define LOG_TASK_PRIORITY 1 // Same as loopTask; only runs when lines are pending
+#define LOG_TASK_CORE 1     // Keep core 0 free for the BLE stack
+#define LOG_LINE_MAX 512
+
+static log_ring_t s_ring;
+static uint8_t s_storage[LOG_RING_SIZE] __attribute__((aligned(4)));
+static TaskHandle_t s_task = NULL;
+static log_async_notify_fn s_notify = NULL;
+static log_async_payload_fn s_payload_max = NULL;
+static volatile uint32_t s_lines = 0;
+static volatile uint32_t s_notifications = 0;
+static std::atomic<uint32_t> s_clear_upto(0); // CLR: discard records below this ring position
+static std::atomic<bool> s_clear_pending(false);
+
+static char s_line[LOG_LINE_MAX];
+static char s_text[LOG_LINE_MAX]; // Formatted dictionary record
+static uint8_t s_batch[LOG_BLE_PAYLOAD_MAX];
+static size_t s_batch_len = 0;
+
+static void log_async_send(void)
+{
+    if (s_batch_len == 0)
+        return;
+    s_notify(s_batch, s_batch_len);
+    s_batch_len = 0;
+    s_notifications++;
+    vTaskDelay(pdMS_TO_TICKS(LOG_NOTIFY_GAP_MS));
+}
+
+#if LOG_DICT_ENABLED
+// Binary batch: marker, then <len> <id> <args/text> per line
+static void log_async_batch_line(const char *line, size_t len, uint8_t flags, size_t payload_max)
+{
+    uint32_t text_id = LOG_DICT_TEXT_ID;
+    const uint8_t *id = (flags & LOG_OUT_DICT) ? (const uint8_t *)line : (const uint8_t *)&text_id;
+    const uint8_t *body = (flags & LOG_OUT_DICT) ? (const uint8_t *)line + LOG_DICT_HEADER_SIZE : (const uint8_t *)line;
+    size_t body_len = (flags & LOG_OUT_DICT) ? len - LOG_DICT_HEADER_SIZE : len;
+
+    size_t max_body = (payload_max < 256 ? payload_max : 256) - 1 - 1 - 4; // marker, len, id
+    if (body_len > max_body)
+        body_len = max_body;
+
+    if (s_batch_len > 0 && s_batch_len + 1 + 4 + body_len > payload_max)
+        log_async_send();
+    if (s_batch_len == 0)
+        s_batch[s_batch_len++] = LOG_DICT_MARKER;
+
+    s_batch[s_batch_len++] = (uint8_t)(4 + body_len);
+    memcpy(s_batch + s_batch_len, id, 4);
+    memcpy(s_batch + s_batch_len + 4, body, body_len);
+    s_batch_len += 4 + body_len;
+}
+#else
+// Text batch: lines are '\n' separated within a notification
+static void log_async_batch_line(const char *line, size_t len, uint8_t flags, size_t payload_max)
+{
+    if (len > payload_max)
+        len = payload_max;
+
+    if (s_batch_len > 0 && s_batch_len + 1 + len > payload_max)
+        log_async_send();
+    if (s_batch_len > 0)
+        s_batch[s_batch_len++] = '\n';
+    memcpy(s_batch + s_batch_len, line, len);
+    s_batch_len += len;
+}
+#endif
+
+static void log_async_task(void *arg)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        size_t len;
+        uint8_t flags;
+        while (log_ring_read(&s_ring, s_line, sizeof(s_line), &len, &flags))
+        {
+            // CLR: records queued before the request are dropped ((int32_t) handles counter wrap)
+            if (s_clear_pending.load())
+            {
+                if ((int32_t)(s_ring.tail.load(std::memory_order_relaxed) - s_clear_upto.load()) <= 0)
+                    continue;
+                s_clear_pending.store(false);
+            }
+
+            s_lines++;
+            if (flags & LOG_OUT_SERIAL)
+            {
+                // Dictionary records are formatted here, off the caller's path
+                if (flags & LOG_OUT_DICT)
+                    Serial.write((const uint8_t *)s_text, log_dict_format((const uint8_t *)s_line, len, s_text, sizeof(s_text)));
+                else
+                    Serial.write((const uint8_t *)s_line, len);
+                Serial.println();
+            }
+
+            size_t payload_max = (flags & LOG_OUT_BLE) ? s_payload_max() : 0;
+            if (payload_max > LOG_BLE_PAYLOAD_MAX)
+                payload_max = LOG_BLE_PAYLOAD_MAX;
+            if (payload_max > 8)
+                log_async_batch_line(s_line, len, flags, payload_max);
+        }
+        log_async_send();
+    }
+}
+
+bool log_async_init(log_async_notify_fn notify, log_async_payload_fn payload_max)
+{
+    if (s_task)
+        return true;
+
+    s_notify = notify;
+    s_payload_max = payload_max;
+    if (!log_ring_init(&s_ring, s_storage, sizeof(s_storage)))
+        return false;
+
+    return xTaskCreatePinnedToCore(log_async_task, "log_drain", LOG_TASK_STACK, NULL,
+                                   LOG_TASK_PRIORITY, &s_task, LOG_TASK_CORE) == pdPASS;
+}
+
+void log_async_write(const char *msg, uint8_t outputs)
+{
+    if (!s_task)
+    {
+        if (outputs & LOG_OUT_SERIAL)
+            Serial.println(msg);
+        return;
+    }
+
+    if (log_ring_write(&s_ring, msg, strlen(msg), outputs))
+        xTaskNotifyGive(s_task);
+}
+
+void log_async_write_record(const uint8_t *rec, size_t len, uint8_t outputs)
+{
+    if (!outputs)
+        return;
+
+    if (!s_task)
+    {
+        if (outputs & LOG_OUT_SERIAL)
+        {
+            char text[LOG_LINE_MAX];
+            log_dict_format(rec, len, text, sizeof(text));
+            Serial.println(text);
+        }
+        return;
+    }
+
+    if (log_ring_write(&s_ring, (const char *)rec, len, outputs | LOG_OUT_DICT))
+        xTaskNotifyGive(s_task);
+}
+
+void log_async_clear(void)
+{
+    s_clear_upto.store(s_ring.head.load(std::memory_order_acquire));
+    s_clear_pending.store(true);
+    if (s_task)
+        xTaskNotifyGive(s_task);
+}
+
+void log_async_get_stats(log_async_stats_t *stats)
+{
+    stats->dropped_lines = s_ring.dropped_lines.load(std::memory_order_relaxed);
+    stats->dropped_bytes = s_ring.dropped_bytes.load(std::memory_order_relaxed);
+    stats->lines = s_lines;
+    stats->notifications = s_notifications;
+}
@@ -0,0 +1,58 @@
+/*
+  ============================================================================
+  Asynchronous Logger
+
+  log_async_write() only copies the line into a lock-free ring (log_ring);
+  a low-priority task drains it to Serial and packs BLE lines into as few
+  notifications as the negotiated MTU allows ('\n' separated).
+
+  With LOG_DICT_ENABLED, lines logged through log_async_write_record() are
+  dictionary records (log_dict.h) and BLE notifications are binary:
+    0x00 { <len u8> <id u32> <args | text if id == 0> }*
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define LOG_RING_SIZE 4096       // Power of two
+#define LOG_BLE_PAYLOAD_MAX 512  // ATT value limit
+#define LOG_NOTIFY_GAP_MS 5      // Pause between notifications (BLE stack TX queue)
+
+#ifndef LOG_DICT_ENABLED
+#define LOG_DICT_ENABLED 1 // Deferred formatting: IDs + packed args over BLE
+#endif
+#define LOG_DICT_MARKER 0x00 // First byte of a binary notification (text lines never start with NUL)
+
+// Line outputs (record flags)
+#define LOG_OUT_SERIAL 0x01
+#define LOG_OUT_BLE 0x02
+#define LOG_OUT_DICT 0x80 // Record is a log_dict record, not text
+
+// Sends one notification of len bytes
+typedef void (*log_async_notify_fn)(const uint8_t *data, size_t len);
+// Current notification payload limit (MTU - 3), 0 = BLE not available
+typedef size_t (*log_async_payload_fn)(void);
+
+typedef struct
+{
+    uint32_t dropped_lines; // Ring full
+    uint32_t dropped_bytes;
+    uint32_t lines;         // Lines drained
+    uint32_t notifications; // BLE notifications sent
+} log_async_stats_t;
+
+bool log_async_init(log_async_notify_fn notify, log_async_payload_fn payload_max);
+
+// Never blocks; before log_async_init() lines go straight to Serial
+void log_async_write(const char *msg, uint8_t outputs);
+
+// Never blocks; rec is a log_dict record
+void log_async_write_record(const uint8_t *rec, size_t len, uint8_t outputs);
+
+// Drop the lines queued so far (drained without output)
+void log_async_clear(void);
+
+void log_async_get_stats(log_async_stats_t *stats);
@@ -0,0 +1,191 @@
+#include "log_dict.h"
+
+#include <stdio.h>
+
+typedef struct
+{
+    const uint8_t *p;
+    const uint8_t *end;
+    bool missing; // Ran out of packed arguments
+} log_dict_args_t;
+
+static bool log_dict_take(log_dict_args_t *a, void *dst, size_t n)
+{
+    if ((size_t)(a->end - a->p) < n)
+    {
+        a->missing = true;
+        return false;
+    }
+    memcpy(dst, a->p, n);
+    a->p += n;
+    return true;
+}
+
+static size_t log_dict_append(char *out, size_t size, size_t pos, const char *src, size_t n)
+{
+    if (pos + 1 < size)
+    {
+        size_t room = size - 1 - pos;
+        memcpy(out + pos, src, n < room ? n : room);
+    }
+    return pos + n;
+}
+
+size_t log_dict_format(const uint8_t *rec, size_t len, char *out, size_t size)
+{
+    if (len < LOG_DICT_HEADER_SIZE || size == 0)
+        return 0;
+
+    const char *fmt;
+    memcpy(&fmt, rec + 4, sizeof(fmt));
+    log_dict_args_t args = {rec + LOG_DICT_HEADER_SIZE, rec + len, false};
+
+    size_t pos = 0;
+    while (*fmt)
+    {
+        if (*fmt != '%')
+        {
+            const char *lit = strchr(fmt, '%');
+            size_t n = lit ? (size_t)(lit - fmt) : strlen(fmt);
+            pos = log_dict_append(out, size, pos, fmt, n);
+            fmt += n;
+            continue;
+        }
+
+        // Rebuild one conversion with '*' resolved, then format just that argument
+        char spec[40];
+        size_t sl = 0;
+        spec[sl++] = *fmt++;
+        int longs = 0;
+        while (*fmt && sl < 24) // Leaves room for a resolved '*' and "ll" + conversion
+        {
+            char c = *fmt;
+            if (c == '*')
+            {
+                int32_t v = 0;
+                log_dict_take(&args, &v, 4);
+                sl += snprintf(spec + sl, sizeof(spec) - sl, "%d", (int)v);
+                fmt++;
+                continue;
+            }
+            if (strchr("-+ #0123456789.", c))
+            {
+                spec[sl++] = c;
+                fmt++;
+                continue;
+            }
+            // Count what the packer stored: 8 bytes for anything wider than 32 bit
+            if (c == 'l' || c == 'j')
+            {
+                longs += (c == 'j' || sizeof(long) > 4) ? 2 : 1;
+                fmt++;
+                continue;
+            }
+            if (c == 'h' || c == 'z' || c == 't')
+            {
+                longs += (c != 'h' && sizeof(size_t) > 4) ? 2 : 0;
+                fmt++;
+                continue;
+            }
+            break;
+        }
+
+        char conv = *fmt ? *fmt++ : '\0';
+        char buf[64];
+        int n = 0;
+        spec[sl] = '\0';
+        switch (conv)
+        {
+        case '%':
+            buf[0] = '%';
+            n = 1;
+            break;
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o':
+        case 'c':
+            if (longs >= 2)
+            {
+                int64_t v = 0;
+                if (log_dict_take(&args, &v, 8))
+                {
+                    strcat(spec, "ll");
+                    size_t k = strlen(spec);
+                    spec[k] = conv;
+                    spec[k + 1] = '\0';
+                    n = snprintf(buf, sizeof(buf), spec, (long long)v);
+                }
+            }
+            else
+            {
+                uint32_t v = 0;
+                if (log_dict_take(&args, &v, 4))
+                {
+                    size_t k = strlen(spec);
+                    spec[k] = conv;
+                    spec[k + 1] = '\0';
+                    n = (conv == 'd' || conv == 'i') ? snprintf(buf, sizeof(buf), spec, (int)(int32_t)v)
+                                                     : snprintf(buf, sizeof(buf), spec, (unsigned)v);
+                }
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        {
+            double v = 0;
+            if (log_dict_take(&args, &v, 8))
+            {
+                size_t k = strlen(spec);
+                spec[k] = conv;
+                spec[k + 1] = '\0';
+                n = snprintf(buf, sizeof(buf), spec, v);
+            }
+            break;
+        }
+        case 'p':
+        {
+            uint32_t v = 0;
+            if (log_dict_take(&args, &v, 4))
+                n = snprintf(buf, sizeof(buf), "0x%08x", (unsigned)v);
+            break;
+        }
+        case 's':
+        {
+            uint8_t slen = 0;
+            char str[LOG_DICT_STRING_MAX + 1];
+            if (log_dict_take(&args, &slen, 1) && log_dict_take(&args, str, slen))
+            {
+                str[slen] = '\0';
+                strcat(spec, "s");
+                char text[LOG_DICT_STRING_MAX + 64];
+                int tn = snprintf(text, sizeof(text), spec, str);
+                pos = log_dict_append(out, size, pos, text, tn < (int)sizeof(text) ? tn : sizeof(text) - 1);
+            }
+            break;
+        }
+        default:
+            break;
+        }
+
+        if (args.missing)
+        {
+            pos = log_dict_append(out, size, pos, "?", 1);
+            args.missing = false;
+        }
+        else if (n > 0)
+        {
+            pos = log_dict_append(out, size, pos, buf, n < (int)sizeof(buf) ? n : sizeof(buf) - 1);
+        }
+    }
+
+    size_t end = pos < size ? pos : size - 1;
+    out[end] = '\0';
+    return end;
+}
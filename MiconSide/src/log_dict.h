@@ -0,0 +1,128 @@
+/*
+  ============================================================================
+  Dictionary-Encoded Log Records
+
+  Deferred formatting: a log call stores the FNV-1a ID of its format string
+  plus its arguments packed as binary, without running snprintf. The log
+  task formats records for Serial (log_dict_format); over BLE only the ID
+  and arguments are sent, and the WebApp renders them with the dictionary
+  generated by tools/log_dict.py (WebAppSide/log-dictionary.json).
+
+  Record : <id u32> <format pointer> <args>   (BLE: <id u32> <args>)
+  Args   : integers <= 32 bit -> 4 bytes LE, 64 bit -> 8, floating -> f64,
+           strings -> <len u8> <bytes>, other pointers -> 4 bytes
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <type_traits>
+
+#define LOG_DICT_RECORD_MAX 160  // Header + packed arguments
+#define LOG_DICT_HEADER_SIZE (4 + sizeof(const char *))
+#define LOG_DICT_STRING_MAX 255
+#define LOG_DICT_TEXT_ID 0       // BLE record carrying a plain text line
+
+// FNV-1a of the format string (must match tools/log_dict.py)
+constexpr uint32_t log_dict_id(const char *s, uint32_t h = 0x811c9dc5u)
+{
+    return *s ? log_dict_id(s + 1, (h ^ (uint8_t)*s) * 0x01000193u) : h;
+}
+
+// Forces the hash to be computed at compile time
+#define LOG_DICT_ID(fmt) (std::integral_constant<uint32_t, log_dict_id(fmt)>::value)
+
+typedef struct
+{
+    uint8_t data[LOG_DICT_RECORD_MAX];
+    size_t len;
+} log_dict_record_t;
+
+static inline void log_dict_put(log_dict_record_t *rec, const void *src, size_t n)
+{
+    // Arguments that do not fit are dropped; the decoder shows them as '?'
+    if (rec->len + n <= sizeof(rec->data))
+    {
+        memcpy(rec->data + rec->len, src, n);
+        rec->len += n;
+    }
+    else
+    {
+        rec->len = sizeof(rec->data);
+    }
+}
+
+static inline void log_dict_arg(log_dict_record_t *rec, const char *s)
+{
+    // Scan no further than what still fits (length byte included); a longer string is cut there
+    size_t room = rec->len + 1 < sizeof(rec->data) ? sizeof(rec->data) - rec->len - 1 : 0;
+    if (room > LOG_DICT_STRING_MAX)
+        room = LOG_DICT_STRING_MAX;
+    size_t n = 0;
+    while (s && n < room && s[n])
+        n++;
+    uint8_t len = (uint8_t)n;
+    log_dict_put(rec, &len, 1);
+    log_dict_put(rec, s, n);
+}
+
+static inline void log_dict_arg(log_dict_record_t *rec, char *s)
+{
+    log_dict_arg(rec, (const char *)s);
+}
+
+template <typename T>
+typename std::enable_if<std::is_integral<T>::value || std::is_enum<T>::value>::type
+log_dict_arg(log_dict_record_t *rec, T value)
+{
+    if (sizeof(T) > 4)
+    {
+        int64_t v = (int64_t)value;
+        log_dict_put(rec, &v, 8);
+    }
+    else
+    {
+        uint32_t v = (uint32_t)value;
+        log_dict_put(rec, &v, 4);
+    }
+}
+
+template <typename T>
+typename std::enable_if<std::is_floating_point<T>::value>::type
+log_dict_arg(log_dict_record_t *rec, T value)
+{
+    double v = value;
+    log_dict_put(rec, &v, 8);
+}
+
+static inline void log_dict_arg(log_dict_record_t *rec, const void *p)
+{
+    uint32_t v = (uint32_t)(uintptr_t)p;
+    log_dict_put(rec, &v, 4);
+}
+
+static inline void log_dict_pack(log_dict_record_t *rec)
+{
+}
+
+template <typename T, typename... Rest>
+void log_dict_pack(log_dict_record_t *rec, T first, Rest... rest)
+{
+    log_dict_arg(rec, first);
+    log_dict_pack(rec, rest...);
+}
+
+template <typename... Args>
+void log_dict_build(log_dict_record_t *rec, uint32_t id, const char *fmt, Args... args)
+{
+    rec->len = 0;
+    log_dict_put(rec, &id, 4);
+    log_dict_put(rec, &fmt, sizeof(fmt));
+    log_dict_pack(rec, args...);
+}
+
+// Render a record (header included) as text, printf-compatible; returns the text length
+size_t log_dict_format(const uint8_t *rec, size_t len, char *out, size_t size);
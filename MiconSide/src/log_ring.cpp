@@ -0,0 +1,107 @@
+#include "log_ring.h"
+
+#include <string.h>
+
+// Header word: bits 0-15 length, 16-23 flags, bit 30 padding, bit 31 published
+#define LOG_RING_PUBLISHED 0x80000000u
+#define LOG_RING_PADDING 0x40000000u
+#define LOG_RING_LEN_MAX 0xFFFFu
+
+static uint32_t log_ring_align(uint32_t n)
+{
+    return (n + 3) & ~3u;
+}
+
+static uint32_t *log_ring_header(log_ring_t *ring, uint32_t pos)
+{
+    return (uint32_t *)(ring->buf + (pos & (ring->capacity - 1)));
+}
+
+bool log_ring_init(log_ring_t *ring, uint8_t *storage, uint32_t capacity)
+{
+    if (!ring || !storage || capacity < 64 || capacity > 0x10000 || (capacity & (capacity - 1)) != 0)
+        return false;
+
+    ring->buf = storage;
+    ring->capacity = capacity;
+    ring->head.store(0);
+    ring->tail.store(0);
+    ring->dropped_lines.store(0);
+    ring->dropped_bytes.store(0);
+    return true;
+}
+
+bool log_ring_write(log_ring_t *ring, const char *msg, size_t len, uint8_t flags)
+{
+    // One record never takes more than a quarter of the ring
+    uint32_t max_len = ring->capacity / 4 - LOG_RING_HEADER_SIZE;
+    if (len > max_len)
+        len = max_len;
+
+    uint32_t need = log_ring_align(LOG_RING_HEADER_SIZE + len);
+    uint32_t head = ring->head.load(std::memory_order_relaxed);
+    uint32_t pad;
+    do
+    {
+        // A record does not wrap: the rest of the ring becomes padding
+        uint32_t to_end = ring->capacity - (head & (ring->capacity - 1));
+        pad = to_end < need ? to_end : 0;
+
+        uint32_t tail = ring->tail.load(std::memory_order_acquire);
+        if (head + pad + need - tail > ring->capacity)
+        {
+            ring->dropped_lines.fetch_add(1, std::memory_order_relaxed);
+            ring->dropped_bytes.fetch_add(len, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!ring->head.compare_exchange_weak(head, head + pad + need, std::memory_order_acq_rel,
+                                               std::memory_order_relaxed));
+
+    if (pad)
+    {
+        __atomic_store_n(log_ring_header(ring, head), LOG_RING_PUBLISHED | LOG_RING_PADDING | pad,
+                         __ATOMIC_RELEASE);
+        head += pad;
+    }
+
+    memcpy(ring->buf + (head & (ring->capacity - 1)) + LOG_RING_HEADER_SIZE, msg, len);
+    __atomic_store_n(log_ring_header(ring, head), LOG_RING_PUBLISHED | ((uint32_t)flags << 16) | (uint32_t)len,
+                     __ATOMIC_RELEASE);
+    return true;
+}
+
+bool log_ring_read(log_ring_t *ring, char *dst, size_t max, size_t *len, uint8_t *flags)
+{
+    for (;;)
+    {
+        uint32_t tail = ring->tail.load(std::memory_order_relaxed);
+        if (tail == ring->head.load(std::memory_order_acquire))
+            return false;
+
+        uint32_t *header = log_ring_header(ring, tail);
+        uint32_t word = __atomic_load_n(header, __ATOMIC_ACQUIRE);
+        if (!(word & LOG_RING_PUBLISHED))
+            return false; // Reserved, producer still copying
+
+        uint32_t size;
+        bool padding = word & LOG_RING_PADDING;
+        if (padding)
+        {
+            size = word & LOG_RING_LEN_MAX;
+        }
+        else
+        {
+            size_t n = word & LOG_RING_LEN_MAX;
+            size = log_ring_align(LOG_RING_HEADER_SIZE + n);
+            *len = n < max ? n : max;
+            *flags = (uint8_t)(word >> 16);
+            memcpy(dst, (const uint8_t *)header + LOG_RING_HEADER_SIZE, *len);
+        }
+
+        // Zero the record so stale bytes never look like a published header on the next lap
+        memset(header, 0, size);
+        ring->tail.store(tail + size, std::memory_order_release);
+        if (!padding)
+            return true;
+    }
+}
@@ -0,0 +1,40 @@
+/*
+  ============================================================================
+  Log Ring Buffer
+
+  Lock-free multi-producer / single-consumer ring of variable-length log
+  records. Producers reserve space with a CAS on head and publish the
+  record by storing its header last; a full ring drops the line (counted)
+  instead of waiting. No Arduino / FreeRTOS dependency.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define LOG_RING_HEADER_SIZE 4
+
+typedef struct
+{
+    uint8_t *buf;
+    uint32_t capacity; // Power of two
+    // Monotonic byte counters; index = counter & (capacity - 1)
+    std::atomic<uint32_t> head; // Reserved by producers
+    std::atomic<uint32_t> tail; // Released by the consumer
+    std::atomic<uint32_t> dropped_lines;
+    std::atomic<uint32_t> dropped_bytes;
+} log_ring_t;
+
+// Attach zeroed storage; capacity must be a power of two
+bool log_ring_init(log_ring_t *ring, uint8_t *storage, uint32_t capacity);
+
+// Producer (any task): copy msg as one record tagged with flags (8 bits).
+// Returns false and counts a drop if it does not fit.
+bool log_ring_write(log_ring_t *ring, const char *msg, size_t len, uint8_t flags);
+
+// Consumer: copy the oldest published record into dst (truncated to max).
+// Returns false if the ring is empty or the oldest record is still being written.
+bool log_ring_read(log_ring_t *ring, char *dst, size_t max, size_t *len, uint8_t *flags);
@@ -7,14 +7,39 @@
   ============================================================================
 */
 
-#include <WiFi.h>
-#include <Update.h>
-#include <Preferences.h>
 #include <BLEDevice.h>
 #include <BLEServer.h>
 #include <BLEUtils.h>
 #include <BLE2902.h>
 #include <esp32-hal-rgb-led.h>
+#include <esp_ota_ops.h>
+#include <esp_timer.h>
+#include <mbedtls/sha256.h>
+
+#include <atomic>
+
+#include "app_event.h"
+#include "ble_cmd.h"
+#include "ble_link.h"
+#include "boot_timeline.h"
+#include "config_store.h"
+#include "led_engine.h"
+#include "log_async.h"
+#include "log_dict.h"
+#include "ota_flash.h"
+#include "ota_history.h"
+#include "ota_image.h"
+#include "ota_inflate.h"
+#include "ota_net.h"
+#include "ota_patch.h"
+#include "ota_pipeline.h"
+#include "ota_rx.h"
+#include "ota_sack.h"
+#include "ota_verify.h"
+#include "prov.h"
+#include "job_sched.h"
+#include "telemetry.h"
+#include "wifi_mgr.h"
 
 // =============================================================================
 // Constants & Configuration
@@ -23,28 +48,64 @@
 #ifndef LOG_SERIAL_ENABLED
 #define LOG_SERIAL_ENABLED 1
 #endif
+
+// Log levels (LVL:n shows levels <= n)
+#define LOG_LEVEL_ERROR 0
+#define LOG_LEVEL_WARN 1
+#define LOG_LEVEL_INFO 2
+#define LOG_LEVEL_DEBUG 3
+#ifndef LOG_COMPILE_LEVEL
+#define LOG_COMPILE_LEVEL LOG_LEVEL_DEBUG // Levels above this are compiled out (e.g. -DLOG_COMPILE_LEVEL=1)
+#endif
+#define LOG_DEFAULT_LEVEL LOG_LEVEL_INFO  // Runtime level until LVL:n is stored in NVS
+
+// Arguments are only evaluated and formatted if the level is enabled
+#define LOG_AT(level, tag, fmt, ...)                                        \
+    do                                                                      \
+    {                                                                       \
+        if ((level) <= LOG_COMPILE_LEVEL && (level) <= log_level)           \
+            LOG_EMIT(tag fmt, ##__VA_ARGS__);                               \
+    } while (0)
+#if LOG_DICT_ENABLED
+// Format ID + packed arguments; formatted later by the log task / the WebApp
+#define LOG_EMIT(fmt, ...)                                                  \
+    do                                                                      \
+    {                                                                       \
+        log_dict_record_t rec;                                              \
+        log_dict_build(&rec, LOG_DICT_ID(fmt), fmt, ##__VA_ARGS__);         \
+        log_async_write_record(rec.data, rec.len, log_outputs());           \
+    } while (0)
+#else
+#define LOG_EMIT(fmt, ...) log_printf(fmt, ##__VA_ARGS__)
+#endif
+#define LOG_E(fmt, ...) LOG_AT(LOG_LEVEL_ERROR, "[E] ", fmt, ##__VA_ARGS__)
+#define LOG_W(fmt, ...) LOG_AT(LOG_LEVEL_WARN, "[W] ", fmt, ##__VA_ARGS__)
+#define LOG_I(fmt, ...) LOG_AT(LOG_LEVEL_INFO, "[I] ", fmt, ##__VA_ARGS__)
+#define LOG_D(fmt, ...) LOG_AT(LOG_LEVEL_DEBUG, "[D] ", fmt, ##__VA_ARGS__)
 #define SERIAL_BAUD 115200
+#define FW_VERSION "1.0.0"
 
-// Wi-Fi
-#define WIFI_SSID_MAX 32
-#define WIFI_PASS_MAX 64
+// Fast boot: no settle delays or Serial countdown, BLE advertises before Wi-Fi init.
+// Also enabled at runtime with FAST_BOOT:1 (NVS "fast_boot", applies from the next boot).
+#ifndef FAST_BOOT
+#define FAST_BOOT 0
+#endif
 
 // BLE Output
 #define BLE_OUTPUT_INTERVAL_MS 1000
+#define BLE_CONNECT_SETTLE_MS 100 // Initial status goes out this long after a connection
 
 // Status LED (ESP32-S3 Super Mini compatibility)
 #define STATUS_LED_GPIO_PIN 47
 #define STATUS_LED_RGB_PIN 48
 
-// NVS Namespace
-const char *NVS_WIFI_NS = "wifi";
-const char *NVS_SYSCFG_NS = "syscfg";
-
 // BLE Debug Service UUID (128-bit from spec)
 #define DEBUG_SERVICE_UUID "7f3f0001-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
 #define DEBUG_LOG_TX_UUID "7f3f0002-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
 #define DEBUG_CMD_RX_UUID "7f3f0003-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
 #define DEBUG_STAT_UUID "7f3f0005-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
+#define DEBUG_BOOT_UUID "7f3f0006-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
+#define DEBUG_OTA_HIST_UUID "7f3f0007-6b7c-4f2e-9b8a-1a2b3c4d5e6f"
 
 // BLE Provisioning Service UUID
 #define PROV_SERVICE_UUID "8f4f0001-7c8d-5f3e-ac9b-2b3c4d5e6f70"
@@ -56,13 +117,36 @@ const char *NVS_SYSCFG_NS = "syscfg";
 #define OTA_DATA_UUID "9f5f0003-8d9e-6f4e-bd0c-3c4d5e6f7180"
 #define OTA_STATUS_UUID "9f5f0004-8d9e-6f4e-bd0c-3c4d5e6f7180"
 
+// BLE OTA sequenced transfer
+// Each OtaData packet = [offset: u32 LE][payload] (ota_rx)
+#define OTA_ACK_STRIDE_BYTES 8192 // Send ACK after this much in-order progress
+#define OTA_ACK_INTERVAL_MS 50    // Re-send pending ACKs from loop() at this rate
+#define OTA_FLUSH_TIMEOUT_MS 5000 // Max time to drain the ring at END
+#define OTA_CHECKPOINT_INTERVAL (64 * 1024) // Image bytes between resume checkpoints (NVS writes)
+
+// BLE binary command opcodes (see ble_cmd.h); text commands map onto the same entries
+#define CMD_OP_FACTORY_RESET 0x80 // DebugCmdRx
+#define CMD_OP_STATUS 0x81
+#define CMD_OP_OTA_MODE 0x82
+#define CMD_OP_LOG_LEVEL 0x83     // 1 = level (0 = ERROR .. 3 = DEBUG)
+#define CMD_OP_LOG_CLEAR 0x84
+#define CMD_OP_SCHED 0x85
+#define CMD_OP_FAST_BOOT 0x86     // 1 = 0/1
+#define CMD_OP_WIFI_STATIC 0x87   // 1 = 0/1
+#define CMD_OP_TELEMETRY 0x88     // 1 = DebugStat period in ms (optional)
+#define CMD_OP_PROV_SET 0x90      // ProvWifiConfig: 1 = ssid, 2 = password
+#define CMD_OP_OTA_START 0xA0     // OtaControl: 1 = size, 2 = transfer size, 3 = codec,
+                                  //   4 = sha, 5 = at, 6 = bsize, 7 = bsha
+#define CMD_OP_OTA_RESUME 0xA1    // 1 = sha
+#define CMD_OP_OTA_SIG 0xA2       // 1 = DER signature
+#define CMD_OP_OTA_END 0xA3
+#define CMD_OP_OTA_ABORT 0xA4
+#define CMD_OP_OTA_WIFI 0xA5      // Reply WIFI:<ip>:<port>:<token>:<offset>, data then goes over HTTP
+
 // =============================================================================
 // Global Variables
 // =============================================================================
 
-Preferences nvs_wifi;
-Preferences nvs_syscfg;
-
 // State
 typedef enum
 {
@@ -71,43 +155,115 @@ typedef enum
     STATE_APP_RUNNING,
 } system_state_t;
 
-typedef enum
-{
-    WIFI_IDLE = 0,
-    WIFI_CONNECTING,
-    WIFI_CONNECTED,
-    WIFI_FAILED,
-} wifi_state_t;
-
 struct
 {
     system_state_t system_state;
-    wifi_state_t wifi_state;
-    char wifi_ip[16];
     char device_name[32];
-} g_state = {STATE_FACTORY_RESET_DETECT, WIFI_IDLE, "", ""};
+} g_state = {STATE_FACTORY_RESET_DETECT, ""};
 
 // BLE
 BLEServer *pServer = NULL;
 BLECharacteristic *pDebugLogTx = NULL;
 BLECharacteristic *pDebugCmdRx = NULL;
 BLECharacteristic *pDebugStat = NULL;
+BLECharacteristic *pDebugBoot = NULL;
+BLECharacteristic *pDebugOtaHist = NULL;
 BLECharacteristic *pProvWifiConfig = NULL;
 BLECharacteristic *pOtaControl = NULL;
 BLECharacteristic *pOtaData = NULL;
 BLECharacteristic *pOtaStatus = NULL;
+volatile uint32_t ble_notify_failures = 0; // Notifications the BLE stack reported as not sent
+volatile uint32_t telemetry_period_ms = TELEMETRY_PERIOD_DEFAULT_MS; // DebugStat notify period (TELEM)
 
 // OTA via BLE state
+typedef enum
+{
+    OTA_CODEC_NONE = 0, // Raw image
+    OTA_CODEC_DEFLATE,  // zlib stream, inflated by the writer task
+} ota_codec_t;
+
 bool ota_mode_active = false;
-size_t ota_expected_size = 0;
+ota_codec_t ota_codec = OTA_CODEC_NONE;
+size_t ota_image_size = 0;    // Bytes written to flash (uncompressed image)
+size_t ota_expected_size = 0; // Bytes transferred over BLE (compressed if ota_codec != NONE)
+bool ota_patching = false;    // Transfer is a delta patch against the running app
+size_t ota_image_offset = 0;  // Image offset the transfer starts at (resumed session)
+char ota_session_sha[65] = ""; // Image SHA-256 from START (session id), empty = not resumable
+size_t ota_checkpoint_offset = 0;
+uint8_t ota_signature[OTA_SIGNATURE_MAX_SIZE]; // From SIG:, checked at END
+size_t ota_signature_len = 0;
 size_t ota_received_size = 0;
+unsigned long ota_start_ms = 0; // START of the current transfer (DebugStat bytes/s)
 size_t ota_last_reported_size = 0;
-bool ota_in_progress = false;
-bool ota_finalize_requested = false;
-bool ota_abort_requested = false;
+ota_sack_t ota_sack;           // ota_sack.cum mirrors ota_received_size
+const ota_rx_ops_t ota_rx_pipeline = {ota_pipeline_write_at, ota_pipeline_commit, ota_pipeline_free};
+size_t ota_last_acked_size = 0;
+size_t ota_last_acked_window = 0;
+bool ota_ack_pending = false;  // Gap/duplicate/drop seen since the last ACK
+unsigned long ota_last_ack_ms = 0;
+// Gates OtaDataCallbacks::receive() on the BLE task; loop() sets it last, once the session is set up
+std::atomic<bool> ota_in_progress(false);
+
+// START as parsed on the BLE task, handed to loop() (ota_start)
+typedef struct
+{
+    unsigned long start_ms;
+    size_t size;
+    size_t transfer_size;
+    ota_codec_t codec;
+    char sha[65];        // Image SHA-256 (hex), empty = not resumable
+    size_t image_offset; // Resume offset (at=)
+    size_t base_size;    // Delta base size (bsize=), 0 = full image
+    char base_sha[65];   // Delta base SHA-256 (bsha=)
+    bool base_sha_valid;
+    bool suspend;        // A session was open: loop() suspends it before setting up the new one
+    uint32_t seq;        // ota_cmd_seq when received
+} ota_start_request_t;
+
+ota_start_request_t ota_start_req;
+std::atomic<bool> ota_start_pending(false); // ota_start_req is set and not yet taken by loop()
+
+// START / END / ABORT handed to loop() coalesce into one event mask per wake;
+// these record the order they arrived in so loop() replays them in that order
+std::atomic<uint32_t> ota_cmd_seq(0);
+uint32_t ota_finalize_seq = 0;
+uint32_t ota_abort_seq = 0;
+bool ota_abort_session = false; // ABORT closed a session on the BLE task; loop() tears it down
 bool provisioning_in_progress = false;
 
-// Reboot management
+// Boot profile (FAST_BOOT build flag or NVS "fast_boot")
+bool fast_boot_enabled = FAST_BOOT;
+
+// Fixed settle delays of the normal boot profile; skipped in fast boot
+void boot_wait(uint32_t ms)
+{
+    if (!fast_boot_enabled)
+    {
+        delay(ms);
+    }
+}
+
+// Record a setup() phase on the boot timeline (DebugBoot characteristic)
+void boot_checkpoint(const char *phase)
+{
+    uint32_t us = boot_timeline_mark(phase);
+    Serial.printf("[CHECKPOINT] %s done at %u us\n", phase, (unsigned)us);
+}
+
+// Boot report for the DebugBoot characteristic: BOOT:fw=<ver>,fast=<0|1>,<phase>=<us>,...
+void boot_debug_publish(void)
+{
+    char report[384]; // BOOT_TIMELINE_MAX entries fit; a long read covers it (MTU 517)
+    int len = snprintf(report, sizeof(report), "BOOT:fw=%s,fast=%d,", FW_VERSION, fast_boot_enabled);
+    boot_timeline_format(report + len, sizeof(report) - len);
+    Serial.printf("[BOOT] %s\n", report);
+    if (pDebugBoot)
+    {
+        pDebugBoot->setValue((uint8_t *)report, strlen(report));
+    }
+}
+
+// Reboot management (APP_EVENT_REBOOT starts the delay)
 bool reboot_requested = false;
 unsigned long reboot_timestamp = 0;
 const unsigned long REBOOT_DELAY_MS = 2000;
@@ -118,106 +274,979 @@ const unsigned long WIFI_OTA_TIMEOUT_MS = 60000; // 1 minute
 bool wifi_ota_timeout_passed = false;
 bool wifi_ota_timeout_deferred_logged = false;
 
+// =============================================================================
+// Status LED (patterns played from an esp_timer one-shot, never blocks)
+// =============================================================================
+
+// {r, g, b, gpio_on, ms}
+const led_step_t LED_STEPS_IDLE[] = {{0, 0, 0, false, LED_HOLD}};
+const led_step_t LED_STEPS_HEARTBEAT[] = {{0, 24, 0, true, 120}};
+const led_step_t LED_STEPS_PROVISIONING[] = {{0, 0, 24, true, 500}, {0, 0, 0, false, 500}};
+const led_step_t LED_STEPS_OTA[] = {{16, 0, 24, true, 100}, {0, 0, 0, false, 100}};
+const led_step_t LED_STEPS_WIFI_FAILED[] = {
+    {24, 0, 0, true, 150}, {0, 0, 0, false, 150}, {24, 0, 0, true, 150}, {0, 0, 0, false, 1000}};
+
+const led_pattern_t LED_IDLE = LED_PATTERN(LED_STEPS_IDLE, 0);
+const led_pattern_t LED_HEARTBEAT = LED_PATTERN(LED_STEPS_HEARTBEAT, 1);
+const led_pattern_t LED_PROVISIONING = LED_PATTERN(LED_STEPS_PROVISIONING, 0);
+const led_pattern_t LED_OTA = LED_PATTERN(LED_STEPS_OTA, 0);
+const led_pattern_t LED_WIFI_FAILED = LED_PATTERN(LED_STEPS_WIFI_FAILED, 0);
+
+led_engine_t status_led;
+esp_timer_handle_t status_led_timer = NULL;
+SemaphoreHandle_t status_led_lock = NULL;
+int64_t status_led_deadline_us = 0; // When the armed step ends
+
+// Show the engine's next step and arm the timer for its duration (lock held)
+void status_led_apply(void)
+{
+    esp_timer_stop(status_led_timer);
+
+    led_step_t out;
+    uint32_t ms = led_engine_advance(&status_led, &out);
+    digitalWrite(STATUS_LED_GPIO_PIN, out.gpio_on ? LOW : HIGH); // Active low
+    neopixelWrite(STATUS_LED_RGB_PIN, out.r, out.g, out.b);      // RMT
+
+    status_led_deadline_us = ms == LED_HOLD ? INT64_MAX : esp_timer_get_time() + (int64_t)ms * 1000;
+    if (ms != LED_HOLD)
+    {
+        esp_timer_start_once(status_led_timer, (uint64_t)ms * 1000);
+    }
+}
+
+void status_led_timer_cb(void *arg)
+{
+    xSemaphoreTake(status_led_lock, portMAX_DELAY);
+    // Skip a stale expiry that raced with a pattern change
+    if (esp_timer_get_time() + 1000 >= status_led_deadline_us)
+    {
+        status_led_apply();
+    }
+    xSemaphoreGive(status_led_lock);
+}
+
 void status_led_init()
 {
     pinMode(STATUS_LED_GPIO_PIN, OUTPUT);
-    digitalWrite(STATUS_LED_GPIO_PIN, HIGH);
-    neopixelWrite(STATUS_LED_RGB_PIN, 0, 0, 0);
+    led_engine_init(&status_led);
+    status_led_lock = xSemaphoreCreateMutex();
+
+    esp_timer_create_args_t args = {};
+    args.callback = status_led_timer_cb;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "status_led";
+    esp_timer_create(&args, &status_led_timer);
+
+    led_engine_set_base(&status_led, &LED_IDLE);
+    status_led_apply();
+}
+
+// Base pattern for the device state (no-op if unchanged)
+void status_led_set_state(const led_pattern_t *pattern)
+{
+    if (!status_led_lock)
+        return;
+    xSemaphoreTake(status_led_lock, portMAX_DELAY);
+    if (led_engine_set_base(&status_led, pattern))
+    {
+        status_led_apply();
+    }
+    xSemaphoreGive(status_led_lock);
+}
+
+// One-off pattern over the base (e.g. the heartbeat flash)
+void status_led_play(const led_pattern_t *pattern)
+{
+    if (!status_led_lock)
+        return;
+    xSemaphoreTake(status_led_lock, portMAX_DELAY);
+    led_engine_play(&status_led, pattern);
+    status_led_apply();
+    xSemaphoreGive(status_led_lock);
 }
 
-void status_led_blink_aws()
+const led_pattern_t *status_led_pattern_for_state(void)
 {
-    digitalWrite(STATUS_LED_GPIO_PIN, LOW);
-    neopixelWrite(STATUS_LED_RGB_PIN, 0, 24, 0);
-    delay(120);
-    digitalWrite(STATUS_LED_GPIO_PIN, HIGH);
-    neopixelWrite(STATUS_LED_RGB_PIN, 0, 0, 0);
+    if (ota_in_progress)
+        return &LED_OTA;
+    if (provisioning_in_progress || g_state.system_state == STATE_PROVISIONING)
+        return &LED_PROVISIONING;
+    if (wifi_mgr_state() == WIFI_MGR_BACKOFF)
+        return &LED_WIFI_FAILED;
+    return &LED_IDLE;
 }
 
 bool ble_device_connected = false;
+uint16_t ble_peer_mtu = 23; // ATT MTU of the current connection (default until exchanged)
+bool ble_status_pending = false; // loop() sends the initial status once the stack has settled
+unsigned long ble_connect_ms = 0;
+
+uint8_t log_level = LOG_DEFAULT_LEVEL; // Runtime threshold (LVL:n, NVS "log_lvl")
 
+uint8_t log_outputs(void);
 void log_println(const char *msg);
+void log_printf(const char *fmt, ...);
+void ota_session_abort(const char *status);
+void ota_session_suspend(void);
+void ota_status_notify(const char *status);
+void ota_link_notify(bool force);
+void telemetry_build(telemetry_frame_t *frame);
 
 // =============================================================================
 // Utility Functions
 // =============================================================================
 
+// Where a line logged now should go
+uint8_t log_outputs(void)
+{
+    uint8_t outputs = LOG_SERIAL_ENABLED ? LOG_OUT_SERIAL : 0;
+
+    // Send via BLE if connected (real-time only) - but NOT during OTA or provisioning
+    if (ble_device_connected && pDebugLogTx && !ota_in_progress && !provisioning_in_progress)
+    {
+        outputs |= LOG_OUT_BLE;
+    }
+    return outputs;
+}
+
+// Queued for the log task; never blocks the caller
 void log_println(const char *msg)
 {
-    if (LOG_SERIAL_ENABLED)
+    log_async_write(msg, log_outputs());
+}
+
+void log_printf(const char *fmt, ...)
+{
+    char msg[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(msg, sizeof(msg), fmt, args);
+    va_end(args);
+    log_println(msg);
+}
+
+// Log task output: one DebugLogTx notification per batch of lines
+void log_ble_notify(const uint8_t *data, size_t len)
+{
+    if (ble_device_connected && pDebugLogTx)
     {
-        Serial.println(msg);
-        Serial.flush();
+        ble_link_activity(); // Log streaming keeps the link ACTIVE
+        pDebugLogTx->setValue((uint8_t *)data, len);
+        pDebugLogTx->notify();
     }
+}
 
-    // Send via BLE if connected (real-time only) - but NOT during OTA or provisioning
-    if (ble_device_connected && pDebugLogTx && !ota_in_progress && !provisioning_in_progress)
+size_t log_ble_payload_max(void)
+{
+    return ble_device_connected && pDebugLogTx ? ble_peer_mtu - 3 : 0;
+}
+
+// =============================================================================
+// OTA Flash Sink
+// =============================================================================
+
+ota_inflate_t ota_inflater;
+tinfl_decompressor *ota_inflate_decomp = NULL;
+uint8_t *ota_inflate_dict = NULL;
+ota_patch_t ota_patcher;
+ota_image_check_t ota_image_checker; // App image header/segment table check
+const esp_partition_t *ota_base_partition = NULL;
+
+// Delta patches are applied against the running app partition
+bool ota_base_read(size_t offset, uint8_t *dst, size_t len)
+{
+    return esp_partition_read(ota_base_partition, offset, dst, len) == ESP_OK;
+}
+
+// Image bytes on their way to flash; the header is checked before the first sector is written
+size_t ota_image_flash_write(const uint8_t *data, size_t len)
+{
+    if (ota_image_check_feed(&ota_image_checker, data, len) != OTA_IMAGE_OK)
+        return 0;
+    return ota_flash_write(data, len);
+}
+
+// Decoded transfer data: either the image itself or a delta patch
+size_t ota_image_write(const uint8_t *data, size_t len)
+{
+    if (ota_patching)
     {
-        size_t len = strlen(msg);
-        if (len > 0)
-        {
-            // BLE can send up to 512 bytes, but keep it safe at 200
-            if (len > 200)
-                len = 200;
-            pDebugLogTx->setValue((uint8_t *)msg, len);
-            pDebugLogTx->notify();
-            delay(10); // Small delay to avoid overwhelming BLE stack
-        }
+        return ota_patch_write(&ota_patcher, data, len, ota_image_flash_write) ? len : 0;
     }
+    return ota_image_flash_write(data, len);
 }
 
-void wifi_mgr_init(void)
+// Called from the OTA writer task with sector-sized batches
+size_t ota_update_sink_write(const uint8_t *data, size_t len)
 {
-    // Initialize Wi-Fi manager (non-blocking setup)
-    WiFi.mode(WIFI_STA);
-    g_state.wifi_state = WIFI_IDLE;
+    if (ota_codec == OTA_CODEC_DEFLATE)
+    {
+        return ota_inflate_write(&ota_inflater, data, len, ota_image_write) ? len : 0;
+    }
+    return ota_image_write(data, len);
 }
 
-esp_err_t wifi_mgr_connect(void)
+// Called from the OTA writer task: window reopened, checkpoint due or write error
+void ota_update_progress(void)
 {
-    if (g_state.wifi_state == WIFI_CONNECTING || g_state.wifi_state == WIFI_CONNECTED)
+    app_event_post(APP_EVENT_OTA_PROGRESS);
+}
+
+// The client's cached base image must be byte-identical to the running app
+bool ota_base_hash_matches(const esp_partition_t *part, size_t size, const char *sha_hex)
+{
+    if (!part || size == 0 || size > part->size || strlen(sha_hex) != 64)
+        return false;
+
+    uint8_t buf[512];
+    uint8_t digest[32];
+    mbedtls_sha256_context ctx;
+    mbedtls_sha256_init(&ctx);
+    mbedtls_sha256_starts(&ctx, 0);
+
+    bool ok = true;
+    for (size_t ofs = 0; ok && ofs < size; ofs += sizeof(buf))
     {
-        return ESP_OK;
+        size_t n = size - ofs < sizeof(buf) ? size - ofs : sizeof(buf);
+        ok = esp_partition_read(part, ofs, buf, n) == ESP_OK;
+        if (ok)
+            mbedtls_sha256_update(&ctx, buf, n);
     }
+    mbedtls_sha256_finish(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+    if (!ok)
+        return false;
+
+    char hex[65];
+    for (int i = 0; i < 32; i++)
+        snprintf(hex + i * 2, 3, "%02x", digest[i]);
+    return strcasecmp(sha_hex, hex) == 0;
+}
 
-    char ssid[WIFI_SSID_MAX] = {0};
-    char pass[WIFI_PASS_MAX] = {0};
+// Decompressor state is only allocated once the first compressed image arrives
+bool ota_inflate_alloc(void)
+{
+    if (ota_inflate_decomp && ota_inflate_dict)
+        return true;
+
+    uint32_t caps = psramFound() ? (MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT) : (MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+    if (!ota_inflate_decomp)
+        ota_inflate_decomp = (tinfl_decompressor *)heap_caps_malloc(sizeof(tinfl_decompressor), caps);
+    if (!ota_inflate_dict)
+        ota_inflate_dict = (uint8_t *)heap_caps_malloc(TINFL_LZ_DICT_SIZE, caps);
+    return ota_inflate_decomp && ota_inflate_dict;
+}
 
-    nvs_wifi.begin(NVS_WIFI_NS, true);
-    size_t ssid_len = nvs_wifi.getString("ssid", ssid, sizeof(ssid));
-    size_t pass_len = nvs_wifi.getString("pass", pass, sizeof(pass));
-    nvs_wifi.end();
+// Streamed image hash vs. the digest declared at START (sha=)
+bool ota_digest_matches(const uint8_t digest[OTA_DIGEST_SIZE])
+{
+    if (!ota_session_sha[0])
+        return true; // Older clients: esp_image_verify() still checks the image
+
+    uint8_t expected[OTA_DIGEST_SIZE];
+    return ota_verify_hex_decode(ota_session_sha, expected, sizeof(expected)) &&
+           ota_verify_equal(digest, expected, sizeof(expected));
+}
+
+// Writer failures are a rejected image header, flash errors or a corrupt compressed/patch stream
+const char *ota_write_error_status(void)
+{
+    if (ota_image_checker.result != OTA_IMAGE_OK)
+        return ota_image_result_status(ota_image_checker.result);
+    if (ota_patching && ota_patcher.failed && !ota_flash_failed())
+        return "ERROR:PATCH_FAILED";
+    if (ota_codec == OTA_CODEC_DEFLATE && ota_inflater.failed && !ota_flash_failed())
+        return "ERROR:DECOMPRESS_FAILED";
+    return "ERROR:WRITE_FAILED";
+}
+
+// =============================================================================
+// OTA Resume Checkpoint (syscfg NVS)
+// =============================================================================
 
-    if (ssid_len == 0)
+typedef struct
+{
+    char sha[65];        // Image SHA-256 (session id)
+    uint32_t image_size;
+    uint32_t offset;     // Image bytes known to be in flash
+    uint32_t partition;  // Target partition address
+} ota_checkpoint_t;
+
+void ota_checkpoint_save(size_t offset)
+{
+    const esp_partition_t *part = ota_flash_partition();
+    if (!ota_session_sha[0] || !part)
+        return;
+
+    ota_checkpoint_t ckpt = {};
+    snprintf(ckpt.sha, sizeof(ckpt.sha), "%s", ota_session_sha);
+    ckpt.image_size = ota_image_size;
+    ckpt.offset = offset;
+    ckpt.partition = part->address;
+
+    config_store_blob_put("ota_ckpt", &ckpt, sizeof(ckpt));
+    ota_checkpoint_offset = offset;
+}
+
+void ota_checkpoint_clear(void)
+{
+    ota_session_sha[0] = '\0';
+    ota_checkpoint_offset = 0;
+
+    config_store_blob_remove("ota_ckpt");
+}
+
+// Checkpoint for this image that still targets the same partition, if any
+bool ota_checkpoint_find(const char *sha, ota_checkpoint_t *ckpt)
+{
+    size_t len = config_store_blob_get("ota_ckpt", ckpt, sizeof(*ckpt));
+
+    const esp_partition_t *next = esp_ota_get_next_update_partition(NULL);
+    return len == sizeof(*ckpt) && next && ckpt->partition == next->address &&
+           sha[0] && strcasecmp(sha, ckpt->sha) == 0;
+}
+
+// Stop the writer before touching the flash session, then discard the partial image.
+// status is what the client is told; it closes the session's history record.
+void ota_session_abort(const char *status)
+{
+    ota_net_close();
+    ota_history_end(status, ota_received_size);
+    ota_in_progress = false;
+    ble_link_bulk(false);
+    ota_pipeline_reset();
+    ota_flash_abort();
+    ota_checkpoint_clear();
+}
+
+// Stop receiving but keep what is in flash so the client can RESUME
+void ota_session_suspend(void)
+{
+    ota_net_close();
+    bool failed = ota_pipeline_failed() || ota_flash_failed();
+    ota_history_end(failed ? ota_write_error_status() : "SUSPENDED", ota_received_size);
+    ota_in_progress = false;
+    ble_link_bulk(false);
+    ota_pipeline_reset();
+    if (failed)
     {
-        log_println("[E] No Wi-Fi config found");
-        g_state.wifi_state = WIFI_FAILED;
-        return ESP_FAIL;
+        ota_flash_abort();
+        ota_checkpoint_clear();
+        return;
     }
 
-    // Debug: Show what we're trying to connect to
-    char debug_msg[128];
-    snprintf(debug_msg, sizeof(debug_msg), "[I] Connecting to SSID: '%s' (len=%d, pass_len=%d)",
-             ssid, ssid_len, pass_len);
-    log_println(debug_msg);
+    ota_checkpoint_save(ota_flash_committed());
+    ota_flash_abort();
 
-    log_println("[I] Starting Wi-Fi connection...");
-    g_state.wifi_state = WIFI_CONNECTING;
+    LOG_I("[OTA] Session suspended at %u bytes", ota_checkpoint_offset);
+}
 
-    WiFi.begin(ssid, pass);
-    return ESP_OK;
+// Digest field (raw or hex) as lowercase hex, the form checkpoints are keyed by
+bool ota_cmd_sha_hex(const ble_cmd_frame_t *frame, uint8_t tag, char hex[65])
+{
+    uint8_t digest[OTA_DIGEST_SIZE];
+    hex[0] = '\0';
+    if (ble_cmd_bytes(frame, tag, digest, sizeof(digest)) != sizeof(digest))
+        return false;
+    for (size_t i = 0; i < sizeof(digest); i++)
+        snprintf(hex + 2 * i, 3, "%02x", digest[i]);
+    return true;
 }
 
-bool wifi_mgr_is_connected(void)
+// Log a command write without copying it into a String
+void ble_cmd_log(const char *prefix, const ble_cmd_frame_t *frame)
 {
-    return g_state.wifi_state == WIFI_CONNECTED;
+    if (frame->binary)
+        LOG_D("%s op=0x%02X (%u bytes)", prefix, frame->opcode, frame->raw_len);
+    else
+        LOG_D("%s %.*s", prefix, (int)frame->raw_len, (const char *)frame->raw);
 }
 
-const char *wifi_mgr_get_ip_str(void)
+// OtaStatus is notified from both BLE callbacks and loop()
+SemaphoreHandle_t ota_status_lock = NULL;
+
+void ota_status_notify(const char *status)
 {
-    return g_state.wifi_ip;
+    if (!pOtaStatus)
+        return;
+
+    if (ota_status_lock)
+        xSemaphoreTake(ota_status_lock, portMAX_DELAY);
+    pOtaStatus->setValue(status);
+    pOtaStatus->notify();
+    if (ota_status_lock)
+        xSemaphoreGive(ota_status_lock);
 }
 
+// LINK:<interval us>:<latency>:<timeout ms>:<LL octets>:<phy>:<mtu> - sent when the negotiated
+// parameters change (or always with force), so the client can size its chunks and window
+void ota_link_notify(bool force)
+{
+    static char reported[64];
+    ble_link_params_t link;
+    ble_link_get(&link);
+    if (!ble_device_connected || link.interval == 0)
+        return;
+
+    char status[sizeof(reported)];
+    snprintf(status, sizeof(status), "LINK:%u:%u:%u:%u:%u:%u", link.interval * 1250u, link.latency,
+             link.timeout * 10u, link.tx_octets, link.tx_phy, ble_peer_mtu);
+    if (!force && strcmp(status, reported) == 0)
+        return;
+    strcpy(reported, status);
+    ota_status_notify(status);
+}
+
+// ACK:<cum>:<window>[:<s>-<e>,...]
+// cum    = bytes received in order (everything below is committed)
+// window = free receive buffer beyond cum the client may have in flight
+// s-e    = out-of-order ranges already held (client resends only the gaps)
+void ota_send_ack(void)
+{
+    char sack_str[OTA_SACK_MAX_BLOCKS * 24];
+    char ack[sizeof(sack_str) + 32];
+
+    size_t window = ota_pipeline_free();
+    size_t sack_len = ota_sack_format(&ota_sack, sack_str, sizeof(sack_str));
+    snprintf(ack, sizeof(ack), "ACK:%u:%u%s%s", ota_received_size, window,
+             sack_len ? ":" : "", sack_str);
+
+    ota_last_acked_size = ota_received_size;
+    ota_last_acked_window = window;
+    ota_ack_pending = false;
+    ota_last_ack_ms = millis();
+    ota_status_notify(ack);
+}
+
+// =============================================================================
+// BLE Command Handlers
+// =============================================================================
+
+void cmd_factory_reset(const ble_cmd_frame_t *frame)
+{
+    LOG_I("Factory reset requested via BLE");
+    LOG_I("Clearing NVS...");
+
+    // Clear all NVS namespaces
+    config_store_erase(CONFIG_NS_WIFI | CONFIG_NS_SYSCFG);
+
+    LOG_I("NVS cleared. Rebooting in 2 seconds...");
+
+    // Schedule reboot
+    app_event_post(APP_EVENT_REBOOT);
+}
+
+void cmd_status(const ble_cmd_frame_t *frame)
+{
+    LOG_I("Status requested");
+    log_async_stats_t log_stats;
+    log_async_get_stats(&log_stats);
+    LOG_I("STATE=%d,WIFI=%d,OTA_MODE=%d,IP=%s,LVL=%d,LOG_DROP=%u/%uB,LOG_NOTIFY=%u",
+          g_state.system_state, wifi_mgr_state(), ota_mode_active ? 1 : 0, wifi_mgr_get_ip_str(), log_level,
+          log_stats.dropped_lines, log_stats.dropped_bytes, log_stats.notifications);
+    // WIFI_MS=<assoc>/<ip> of the last attempt, PATH=fast|scan + static|dhcp, FALLBACK=<count>
+    wifi_mgr_stats_t wifi;
+    wifi_mgr_get_stats(&wifi);
+    LOG_I("WIFI_MS=%u/%u,PATH=%s+%s,FALLBACK=%u", wifi.assoc_ms, wifi.connect_ms,
+          wifi.fast ? "fast" : "scan", wifi.static_ip ? "static" : "dhcp", wifi.fallbacks);
+    // WLAT=<last>/<avg>/<max> ms to IP, WDOWN=<last>/<max> ms outage, WBACKOFF=<step>:<delay ms>
+    LOG_I("WLAT=%u/%u/%u,WDOWN=%u/%u,WBACKOFF=%u:%u",
+          wifi.connect_ms, wifi.connects ? wifi.connect_total_ms / wifi.connects : 0, wifi.connect_max_ms,
+          wifi.outage_ms, wifi.outage_max_ms, wifi.backoff_step, wifi.backoff_ms);
+
+    // OTA_NET=<uploads>/<endpoints opened>,DENIED=<bad tokens>,LAST=<bytes>/<ms>
+    ota_net_stats_t net;
+    ota_net_get_stats(&net);
+    LOG_I("OTA_NET=%u/%u,DENIED=%u,LAST=%u/%u", net.uploads, net.sessions, net.auth_failures,
+          net.last_bytes, net.last_ms);
+
+    // LINK=<granted>/<requested>:<interval us>/<latency>/<timeout ms>,DLE=<tx>/<rx>,PHY=<tx>/<rx>,
+    //      REQ=<sent>/<rejected>
+    static const char *const profiles[] = {"IDLE", "ACTIVE", "BULK"};
+    ble_link_params_t link;
+    ble_link_get(&link);
+    LOG_I("LINK=%s/%s:%u/%u/%u,DLE=%u/%u,PHY=%u/%u,REQ=%u/%u", profiles[link.granted], profiles[link.requested],
+          link.interval * 1250u, link.latency, link.timeout * 10u, link.tx_octets, link.rx_octets, link.tx_phy,
+          link.rx_phy, link.requests, link.rejects);
+}
+
+void cmd_ota_mode(const ble_cmd_frame_t *frame)
+{
+    if (wifi_ota_timeout_passed)
+    {
+        LOG_W("OTA mode disabled after 60s timeout");
+        return;
+    }
+    LOG_I("OTA mode activation requested via BLE");
+    ota_mode_active = true;
+    LOG_I("OTA mode activated - ready to receive firmware data");
+}
+
+// LVL:<n> - runtime log level, kept across reboots
+void cmd_log_level(const ble_cmd_frame_t *frame)
+{
+    uint32_t level = ble_cmd_u32(frame, 1, UINT32_MAX);
+    if (level > LOG_LEVEL_DEBUG)
+    {
+        LOG_E("Invalid log level");
+        return;
+    }
+
+    log_level = level;
+    config_set_log_level(level);
+
+    // Always shown, so the WebApp sees the change even at LVL:0
+    char msg[48];
+    snprintf(msg, sizeof(msg), "[LVL] Log level %u%s", level,
+             level > LOG_COMPILE_LEVEL ? " (above compile-time level)" : "");
+    log_println(msg);
+}
+
+// CLR - drop log lines that are still queued
+void cmd_log_clear(const ble_cmd_frame_t *frame)
+{
+    log_async_clear();
+}
+
+// FAST_BOOT:<0|1> - boot profile for the next boot (FAST_BOOT=1 builds always boot fast)
+void cmd_fast_boot(const ble_cmd_frame_t *frame)
+{
+    uint32_t enable = ble_cmd_u32(frame, 1, UINT32_MAX);
+    if (enable > 1)
+    {
+        LOG_E("Invalid fast boot value");
+        return;
+    }
+
+    config_set_fast_boot(enable);
+
+    char msg[48];
+    snprintf(msg, sizeof(msg), "[BOOT] Fast boot %s from next boot", enable || FAST_BOOT ? "on" : "off");
+    log_println(msg);
+}
+
+// WIFI_STATIC:<0|1> - reuse the cached DHCP lease (no DHCP) on the cached-channel connect
+void cmd_wifi_static(const ble_cmd_frame_t *frame)
+{
+    uint32_t enable = ble_cmd_u32(frame, 1, UINT32_MAX);
+    if (enable > 1)
+    {
+        LOG_E("Invalid static IP value");
+        return;
+    }
+
+    config_set_static_ip(enable);
+
+    char msg[48];
+    snprintf(msg, sizeof(msg), "[WIFI] Static IP %s from next connect", enable ? "on" : "off");
+    log_println(msg);
+}
+
+// TELEM[:<ms>] - DebugStat notification period (until reboot)
+void cmd_telemetry(const ble_cmd_frame_t *frame)
+{
+    uint32_t period = ble_cmd_u32(frame, 1, telemetry_period_ms);
+    if (period < TELEMETRY_PERIOD_MIN_MS || period > TELEMETRY_PERIOD_MAX_MS)
+    {
+        LOG_E("Invalid telemetry period (%u-%u ms)", TELEMETRY_PERIOD_MIN_MS, TELEMETRY_PERIOD_MAX_MS);
+        return;
+    }
+    telemetry_period_ms = period;
+    app_event_post(APP_EVENT_TELEMETRY); // loop() owns the scheduler
+
+    char msg[48];
+    snprintf(msg, sizeof(msg), "[TELEM] DebugStat every %u ms", period);
+    log_println(msg);
+}
+
+// SCHED - one line per periodic job: runs, run time, lateness, overruns
+void cmd_sched(const ble_cmd_frame_t *frame)
+{
+    sched_stats_t st;
+    for (int id = 0; id < SCHED_MAX_JOBS; id++)
+    {
+        if (!sched_get_stats(id, &st))
+            continue;
+
+        char msg[128];
+        snprintf(msg, sizeof(msg), "[SCHED] %s: period=%u runs=%u avg=%uus max=%uus late=%ums overruns=%u",
+                 st.name, st.period_ms, st.runs, st.runs ? (unsigned)(st.total_us / st.runs) : 0,
+                 st.max_us, st.max_late_ms, st.overruns);
+        log_println(msg);
+    }
+}
+
+// SSID\nPassword (text) or ssid/password fields (binary)
+void cmd_prov_set(const ble_cmd_frame_t *frame)
+{
+    prov_credentials_t creds;
+    switch (prov_parse(frame, &creds))
+    {
+    case PROV_OK:
+        break;
+    case PROV_NO_SEPARATOR:
+        LOG_E("Invalid provisioning format (no separator)");
+        provisioning_in_progress = false;
+        return;
+    case PROV_BAD_SSID:
+        LOG_E("Invalid SSID length");
+        provisioning_in_progress = false;
+        return;
+    case PROV_BAD_PASSWORD:
+        LOG_E("Invalid password length");
+        provisioning_in_progress = false;
+        return;
+    }
+
+    LOG_I("Received Wi-Fi credentials via BLE");
+
+    // Log SSID and lengths (Serial only during provisioning)
+    LOG_I("SSID: %s", creds.ssid);
+    LOG_D("SSID length: %d", strlen(creds.ssid));
+    LOG_D("Password length: %d", strlen(creds.password));
+
+    // Credentials and the provisioned flag go out in one NVS commit (before the reboot at the latest)
+    config_set_wifi(creds.ssid, creds.password);
+    config_set_provisioned(true);
+
+    LOG_I("Wi-Fi config saved! Device will reboot in 2 seconds...");
+
+    // Clear flag to allow final log messages to be sent via BLE
+    provisioning_in_progress = false;
+
+    // Request reboot (will be executed in main loop after callback returns)
+    // This ensures BLE write response is sent back to client before reboot
+    app_event_post(APP_EVENT_REBOOT);
+
+    LOG_I("Reboot scheduled...");
+}
+
+// START:<size>[:<transfer_size>:<codec>[:sha=<sha256>:at=<offset>:bsize=<n>:bsha=<sha256>]]
+// Parsed here; the checks, base hash and flash setup run in loop() (ota_start), which replies READY / ERROR
+void cmd_ota_start(const ble_cmd_frame_t *frame)
+{
+    if (ota_start_pending)
+    {
+        LOG_E("OTA start already pending");
+        ota_status_notify("ERROR:BUSY");
+        return;
+    }
+
+    ota_start_request_t *req = &ota_start_req;
+    req->start_ms = millis(); // Session history: START -> READY includes the checks in ota_start()
+    req->size = ble_cmd_u32(frame, 1, 0);
+    req->transfer_size = ble_cmd_u32(frame, 2, req->size);
+    req->codec = OTA_CODEC_NONE;
+
+    if (ble_cmd_equals(frame, 3, "deflate"))
+    {
+        req->codec = OTA_CODEC_DEFLATE;
+    }
+    else if (ble_cmd_field(frame, 2) && !ble_cmd_equals(frame, 3, "none"))
+    {
+        LOG_E("Unsupported OTA codec");
+        ota_status_notify("ERROR:UNSUPPORTED_CODEC");
+        return;
+    }
+
+    // sha: image hash (enables checkpoints), at: resume offset from RESUME
+    ota_cmd_sha_hex(frame, 4, req->sha);
+    req->image_offset = ble_cmd_u32(frame, 5, 0);
+
+    // bsize/bsha: the transfer is a delta patch against the running app
+    req->base_size = ble_cmd_u32(frame, 6, 0);
+    req->base_sha_valid = ota_cmd_sha_hex(frame, 7, req->base_sha);
+
+    // receive() runs on this task: once this is cleared no packet touches ota_sack or the ring
+    // until ota_start() has reset them and opened the new session
+    req->suspend = ota_in_progress.exchange(false);
+    req->seq = ++ota_cmd_seq;
+
+    ota_start_pending = true;
+    app_event_post(APP_EVENT_OTA_START);
+}
+
+// START accepted by cmd_ota_start(): validate, set up flash and reply READY / ERROR (loop task)
+void ota_start(const ota_start_request_t *req)
+{
+    unsigned long start_ms = req->start_ms;
+    size_t size = req->size;
+    size_t transfer_size = req->transfer_size;
+    ota_codec_t codec = req->codec;
+    size_t base_size = req->base_size;
+    bool patching = base_size > 0;
+    const char *sha = req->sha;
+    size_t image_offset = req->image_offset;
+
+    // A new START replaces a half-open session but keeps its checkpoint
+    if (req->suspend)
+    {
+        ota_session_suspend();
+    }
+
+    if (size == 0 || size > 2000000 || transfer_size == 0 || // Max 2MB
+        (codec == OTA_CODEC_NONE && !patching && transfer_size != size - image_offset))
+    {
+        LOG_E("Invalid OTA size");
+        ota_status_notify("ERROR:INVALID_SIZE");
+        return;
+    }
+
+    if (codec == OTA_CODEC_DEFLATE && !ota_inflate_alloc())
+    {
+        LOG_E("No memory for OTA decompressor");
+        ota_status_notify("ERROR:NO_MEMORY");
+        return;
+    }
+
+    ota_checkpoint_t ckpt;
+    if (image_offset > 0 &&
+        (patching || !ota_checkpoint_find(sha, &ckpt) || ckpt.image_size != size ||
+         image_offset > ckpt.offset || image_offset % OTA_FLASH_SECTOR_SIZE != 0))
+    {
+        LOG_E("No matching OTA session to resume");
+        ota_status_notify("ERROR:RESUME_MISMATCH");
+        return;
+    }
+
+    const esp_partition_t *target_partition = esp_ota_get_next_update_partition(NULL);
+    if (target_partition && size > target_partition->size)
+    {
+        Serial.printf("[OTA] Image %u bytes exceeds partition %u bytes\n", size, target_partition->size);
+        LOG_E("OTA image too large for partition");
+        ota_status_notify("ERROR:TOO_LARGE");
+        return;
+    }
+
+    const esp_partition_t *base_partition = esp_ota_get_running_partition();
+    if (patching && (!req->base_sha_valid || !ota_base_hash_matches(base_partition, base_size, req->base_sha)))
+    {
+        LOG_E("Delta base does not match running firmware");
+        ota_status_notify("ERROR:BASE_MISMATCH");
+        return;
+    }
+
+    ota_history_begin(start_ms, size, transfer_size, image_offset,
+                      (codec == OTA_CODEC_DEFLATE ? OTA_HISTORY_FLAG_DEFLATE : 0) |
+                          (patching ? OTA_HISTORY_FLAG_PATCH : 0) |
+                          (image_offset > 0 ? OTA_HISTORY_FLAG_RESUMED : 0));
+    LOG_I("[OTA] Starting OTA update...");
+    Serial.printf("[OTA] Expected size: %u bytes (transfer %u bytes, codec %d, patch %d, from %u)\n",
+                  size, transfer_size, codec, patching, image_offset);
+
+    ota_codec = codec;
+    ota_patching = patching;
+    ota_image_offset = image_offset;
+    ota_base_partition = base_partition;
+    ota_image_size = size;
+    ota_expected_size = transfer_size;
+    ota_received_size = 0;
+    ota_start_ms = millis();
+    ota_last_reported_size = 0;
+    ota_last_acked_size = 0;
+    ota_last_acked_window = 0;
+    ota_ack_pending = false;
+    ota_sack_reset(&ota_sack, 0);
+    ota_pipeline_reset();
+    if (codec == OTA_CODEC_DEFLATE)
+    {
+        ota_inflate_begin(&ota_inflater, ota_inflate_decomp, ota_inflate_dict);
+    }
+    if (patching)
+    {
+        ota_patch_begin(&ota_patcher, ota_base_read, base_size);
+    }
+    if (image_offset == 0)
+    {
+        ota_image_check_begin(&ota_image_checker, size, CONFIG_IDF_FIRMWARE_CHIP_ID, ESP.getFlashChipRealSize());
+    }
+    else
+    {
+        ota_image_check_skip(&ota_image_checker); // Header was checked by the original session
+    }
+
+    if (!ota_flash_begin(size, image_offset))
+    {
+        Serial.printf("[OTA] Flash error: %s\n", esp_err_to_name(ota_flash_error()));
+        LOG_E("ota_flash_begin() failed");
+        ota_in_progress = false;
+        ble_link_bulk(false);
+        ota_history_end("ERROR:BEGIN_FAILED", 0);
+        ota_status_notify("ERROR:BEGIN_FAILED");
+        return;
+    }
+
+    // Checkpoints are keyed by the image hash; without it the session is not resumable
+    snprintf(ota_session_sha, sizeof(ota_session_sha), "%s", sha);
+    if (image_offset == 0)
+    {
+        ota_checkpoint_save(0);
+    }
+    ota_checkpoint_offset = image_offset;
+    ota_signature_len = 0;
+
+    ota_in_progress = true;
+    ble_link_bulk(true);
+    LOG_I("OTA update started successfully");
+
+    // READY:SEQ:<window>:<codec>[:patch] - data packets carry an offset header
+    char ready[48];
+    snprintf(ready, sizeof(ready), "READY:SEQ:%u:%s%s", ota_pipeline_free(),
+             codec == OTA_CODEC_DEFLATE ? "deflate" : "none", patching ? ":patch" : "");
+    ota_history_mark(OTA_PHASE_READY, millis());
+    ota_status_notify(ready);
+    ota_link_notify(true); // Parameters before the BULK request; the negotiated ones follow
+}
+
+// RESUME:<sha256> -> RESUME:<offset> already in flash for that image (0 = start over)
+void cmd_ota_resume(const ble_cmd_frame_t *frame)
+{
+    char sha[65];
+    ota_checkpoint_t ckpt;
+    size_t offset = ota_cmd_sha_hex(frame, 1, sha) && ota_checkpoint_find(sha, &ckpt) ? ckpt.offset : 0;
+
+    char reply[32];
+    snprintf(reply, sizeof(reply), "RESUME:%u", offset);
+    ota_status_notify(reply);
+}
+
+// SIG:<hex> - DER ECDSA signature of the image SHA-256, checked at END
+void cmd_ota_sig(const ble_cmd_frame_t *frame)
+{
+    ota_signature_len = 0;
+    size_t len = ble_cmd_bytes(frame, 1, ota_signature, sizeof(ota_signature));
+    if (!ota_in_progress || len == 0)
+    {
+        LOG_E("Invalid OTA signature");
+        ota_status_notify("ERROR:SIGNATURE_INVALID");
+        return;
+    }
+    ota_signature_len = len;
+}
+
+void cmd_ota_end(const ble_cmd_frame_t *frame)
+{
+    if (!ota_in_progress)
+    {
+        LOG_E("OTA not in progress");
+        ota_status_notify("ERROR:NOT_STARTED");
+        return;
+    }
+
+    if (ota_received_size != ota_expected_size)
+    {
+        LOG_E("OTA incomplete: %u / %u", ota_received_size, ota_expected_size);
+        ota_status_notify("ERROR:INCOMPLETE");
+        return;
+    }
+
+    LOG_I("[OTA] Finalize requested - will process in main loop");
+    ota_history_mark(OTA_PHASE_END, millis());
+    ota_finalize_seq = ++ota_cmd_seq;
+    app_event_post(APP_EVENT_OTA_FINALIZE);
+}
+
+void cmd_ota_abort(const ble_cmd_frame_t *frame)
+{
+    LOG_W("OTA abort requested by user");
+    // Stop receive() now, like START; a session started after this ABORT is not affected by it
+    ota_abort_session = ota_in_progress.exchange(false) || ota_abort_session;
+    ota_abort_seq = ++ota_cmd_seq;
+    app_event_post(APP_EVENT_OTA_ABORT);
+}
+
+// WIFI -> WIFI:<ip>:<port>:<token>:<offset>; the client then POSTs the transfer from offset to
+// http://<ip>:<port>/ota with "X-OTA-Token: <token>" and finishes with SIG / END over BLE as usual
+void cmd_ota_wifi(const ble_cmd_frame_t *frame)
+{
+    if (!ota_in_progress)
+    {
+        LOG_E("OTA not in progress");
+        ota_status_notify("ERROR:NOT_STARTED");
+        return;
+    }
+
+    char token[OTA_NET_TOKEN_SIZE * 2 + 1];
+    if (!wifi_mgr_is_connected() || !ota_net_open(ota_expected_size - ota_received_size, token))
+    {
+        LOG_W("Wi-Fi OTA unavailable (Wi-Fi state %d)", wifi_mgr_state());
+        ota_status_notify("ERROR:WIFI_UNAVAILABLE");
+        return;
+    }
+
+    // Out-of-order BLE data staged past the committed offset is overwritten by the upload
+    ota_sack_reset(&ota_sack, ota_received_size);
+    ota_history_flag(OTA_HISTORY_FLAG_WIFI);
+    ble_link_bulk(false); // Only control traffic stays on BLE; a longer interval leaves Wi-Fi more air time
+    LOG_I("[OTA] Wi-Fi endpoint open: %s:%u from offset %u", wifi_mgr_get_ip_str(), OTA_NET_PORT, ota_received_size);
+
+    char reply[96];
+    snprintf(reply, sizeof(reply), "WIFI:%s:%u:%s:%u", wifi_mgr_get_ip_str(), OTA_NET_PORT, token, ota_received_size);
+    ota_status_notify(reply);
+}
+
+// ota_net task: len more bytes of the transfer are in the pipeline
+void ota_net_received(size_t len)
+{
+    ota_received_size += len;
+    ota_sack_reset(&ota_sack, ota_received_size);
+    ota_history_mark(OTA_PHASE_FIRST_BYTE, millis());
+    if (ota_received_size == ota_expected_size)
+    {
+        ota_history_mark(OTA_PHASE_LAST_BYTE, millis());
+    }
+    app_event_post(APP_EVENT_OTA_PROGRESS); // loop() reports progress with the usual ACKs
+}
+
+// ota_net task: the endpoint closed by itself (upload done, failed, timed out or refused)
+void ota_net_closed(ota_net_result_t result)
+{
+    ota_net_stats_t st;
+    ota_net_get_stats(&st);
+    if (result == OTA_NET_COMPLETE)
+    {
+        LOG_I("[OTA] Wi-Fi upload done: %u bytes in %u ms (%u KB/s), waiting for END", st.last_bytes, st.last_ms,
+              st.last_ms ? (unsigned)((uint64_t)st.last_bytes * 1000 / 1024 / st.last_ms) : 0);
+    }
+    else
+    {
+        // 1 = failed, 2 = timeout, 3 = too many bad tokens; BLE OtaData can take over from here
+        LOG_W("[OTA] Wi-Fi upload ended (result %d) at %u / %u bytes", result, ota_received_size, ota_expected_size);
+    }
+    app_event_post(APP_EVENT_OTA_PROGRESS);
+}
+
+const ble_cmd_entry_t debug_cmd_entries[] = {
+    {CMD_OP_FACTORY_RESET, "RESET_NVS", 0, NULL, cmd_factory_reset},
+    {CMD_OP_FACTORY_RESET, "FACTORY_RESET", 0, NULL, cmd_factory_reset},
+    {CMD_OP_STATUS, "STATUS", 0, NULL, cmd_status},
+    {CMD_OP_OTA_MODE, "OTA_MODE", 0, NULL, cmd_ota_mode},
+    {CMD_OP_LOG_LEVEL, "LVL", 1, NULL, cmd_log_level},
+    {CMD_OP_LOG_CLEAR, "CLR", 0, NULL, cmd_log_clear},
+    {CMD_OP_SCHED, "SCHED", 0, NULL, cmd_sched},
+    {CMD_OP_FAST_BOOT, "FAST_BOOT", 1, NULL, cmd_fast_boot},
+    {CMD_OP_WIFI_STATIC, "WIFI_STATIC", 1, NULL, cmd_wifi_static},
+    {CMD_OP_TELEMETRY, "TELEM", 1, NULL, cmd_telemetry},
+};
+const ble_cmd_table_t debug_cmd_table = {debug_cmd_entries, sizeof(debug_cmd_entries) / sizeof(debug_cmd_entries[0]), ':', true};
+
+// Text form is the whole write: SSID\nPassword
+const ble_cmd_entry_t prov_cmd_entries[] = {
+    {CMD_OP_PROV_SET, NULL, 2, NULL, cmd_prov_set},
+};
+const ble_cmd_table_t prov_cmd_table = {prov_cmd_entries, 1, '\n', false};
+
+const char *const ota_start_keys[] = {"sha", "at", "bsize", "bsha", NULL};
+const ble_cmd_entry_t ota_cmd_entries[] = {
+    {CMD_OP_OTA_START, "START", 3, ota_start_keys, cmd_ota_start},
+    {CMD_OP_OTA_RESUME, "RESUME", 1, NULL, cmd_ota_resume},
+    {CMD_OP_OTA_SIG, "SIG", 1, NULL, cmd_ota_sig},
+    {CMD_OP_OTA_END, "END", 0, NULL, cmd_ota_end},
+    {CMD_OP_OTA_ABORT, "ABORT", 0, NULL, cmd_ota_abort},
+    {CMD_OP_OTA_WIFI, "WIFI", 0, NULL, cmd_ota_wifi},
+};
+const ble_cmd_table_t ota_cmd_table = {ota_cmd_entries, sizeof(ota_cmd_entries) / sizeof(ota_cmd_entries[0]), ':', true};
+
 // =============================================================================
 // BLE Callback Classes
 // =============================================================================
@@ -227,22 +1256,37 @@ class MyServerCallbacks : public BLEServerCallbacks
     void onConnect(BLEServer *pServer)
     {
         ble_device_connected = true;
-        log_println("[I] BLE device connected");
+        LOG_I("BLE device connected");
+        // loop() sends the initial status; waiting for the stack here would stall the BLE task
+        app_event_post(APP_EVENT_BLE_LINK | APP_EVENT_BLE_CONNECTED);
+    }
 
-        // Send initial status immediately on connection
-        delay(100); // Give BLE stack time to settle
+    // Called right after onConnect(pServer); the parameters the central chose
+    void onConnect(BLEServer *pServer, esp_ble_gatts_cb_param_t *param)
+    {
+        ble_link_connected(param->connect.remote_bda, param->connect.conn_params.interval,
+                           param->connect.conn_params.latency, param->connect.conn_params.timeout);
+    }
 
-        char status[128];
-        snprintf(status, sizeof(status), "[STATUS] WIFI=%d, OTA=%s",
-                 g_state.wifi_state,
-                 ota_mode_active ? "ACTIVE" : "IDLE");
-        log_println(status);
+    void onMtuChanged(BLEServer *pServer, esp_ble_gatts_cb_param_t *param)
+    {
+        ble_peer_mtu = param->mtu.mtu;
+        app_event_post(APP_EVENT_BLE_LINK); // LINK: carries the MTU as well
     }
 
     void onDisconnect(BLEServer *pServer)
     {
         ble_device_connected = false;
-        log_println("[I] BLE device disconnected");
+        ble_peer_mtu = 23;
+        ble_link_disconnected();
+        LOG_I("BLE device disconnected");
+
+        // Keep the partial image for RESUME instead of leaving the session half-open
+        if (ota_in_progress)
+        {
+            app_event_post(APP_EVENT_OTA_SUSPEND);
+        }
+        app_event_post(APP_EVENT_BLE_LINK);
     }
 };
 
@@ -250,59 +1294,56 @@ class MyCharacteristicCallbacks : public BLECharacteristicCallbacks
 {
     void onWrite(BLECharacteristic *pCharacteristic)
     {
-        std::string rxValue = pCharacteristic->getValue();
-        if (rxValue.length() > 0)
-        {
-            String command = String(rxValue.c_str());
-            command.trim();
+        const uint8_t *data = pCharacteristic->getData();
+        size_t len = pCharacteristic->getLength();
+        if (len == 0)
+            return;
 
-            // Log via BLE as well
-            char ble_log[128];
-            snprintf(ble_log, sizeof(ble_log), "[BLE RX] %s", command.c_str());
-            log_println(ble_log);
-            Serial.println("[BLE RX] Command received via Serial");
+        ble_link_activity();
+        ble_cmd_frame_t frame;
+        const ble_cmd_entry_t *entry = ble_cmd_parse(&debug_cmd_table, data, len, &frame);
 
-            // Handle special commands
-            if (command == "RESET_NVS" || command == "FACTORY_RESET")
-            {
-                log_println("[I] Factory reset requested via BLE");
-                log_println("[I] Clearing NVS...");
+        // Log via BLE as well
+        ble_cmd_log("[BLE RX]", &frame);
 
-                // Clear all NVS namespaces
-                nvs_wifi.begin(NVS_WIFI_NS, false);
-                nvs_wifi.clear();
-                nvs_wifi.end();
+        if (entry)
+        {
+            entry->handler(&frame);
+        }
+    }
+};
 
-                nvs_syscfg.begin(NVS_SYSCFG_NS, false);
-                nvs_syscfg.clear();
-                nvs_syscfg.end();
+// Counts notifications the stack could not send (a client not subscribed is not a failure)
+class NotifyStatusCallbacks : public BLECharacteristicCallbacks
+{
+    void onStatus(BLECharacteristic *pCharacteristic, Status s, uint32_t code)
+    {
+        if (s != SUCCESS_NOTIFY && s != SUCCESS_INDICATE && s != ERROR_NOTIFY_DISABLED)
+        {
+            ble_notify_failures++;
+        }
+    }
+};
 
-                log_println("[I] NVS cleared. Rebooting in 2 seconds...");
+// DebugOtaHist: every read gets the current session history
+class OtaHistoryCallbacks : public BLECharacteristicCallbacks
+{
+    void onRead(BLECharacteristic *pCharacteristic)
+    {
+        uint8_t history[sizeof(ota_history_t)];
+        size_t len = ota_history_serialize(history, sizeof(history));
+        pCharacteristic->setValue(history, len);
+    }
+};
 
-                // Schedule reboot
-                reboot_requested = true;
-                reboot_timestamp = millis();
-            }
-            else if (command == "STATUS")
-            {
-                log_println("[I] Status requested");
-                char msg[128];
-                snprintf(msg, sizeof(msg), "[I] STATE=%d,WIFI=%d,OTA_MODE=%d,IP=%s",
-                         g_state.system_state, g_state.wifi_state, ota_mode_active ? 1 : 0, g_state.wifi_ip);
-                log_println(msg);
-            }
-            else if (command == "OTA_MODE")
-            {
-                if (wifi_ota_timeout_passed)
-                {
-                    log_println("[W] OTA mode disabled after 60s timeout");
-                    return;
-                }
-                log_println("[I] OTA mode activation requested via BLE");
-                ota_mode_active = true;
-                log_println("[I] OTA mode activated - ready to receive firmware data");
-            }
-        }
+// DebugStat: every read gets a fresh telemetry frame
+class DebugStatCallbacks : public NotifyStatusCallbacks
+{
+    void onRead(BLECharacteristic *pCharacteristic)
+    {
+        telemetry_frame_t frame;
+        telemetry_build(&frame);
+        pCharacteristic->setValue((uint8_t *)&frame, sizeof(frame));
     }
 };
 
@@ -313,98 +1354,31 @@ class ProvisioningCallbacks : public BLECharacteristicCallbacks
         // Check if WiFi/OTA timeout has passed
         if (wifi_ota_timeout_passed)
         {
-            log_println("[W] WiFi provisioning disabled after 60s timeout");
+            LOG_W("WiFi provisioning disabled after 60s timeout");
             return;
         }
 
         // Set flag to suppress BLE log output during provisioning
         provisioning_in_progress = true;
+        ble_link_activity();
 
-        std::string rxValue = pCharacteristic->getValue();
-        if (rxValue.length() == 0)
-        {
-            log_println("[E] Empty provisioning data");
-            provisioning_in_progress = false;
-            return;
-        }
-
-        // Format: SSID\nPassword (separated by newline)
-        String data = String(rxValue.c_str());
-        int separatorIndex = data.indexOf('\n');
-
-        if (separatorIndex == -1)
-        {
-            log_println("[E] Invalid provisioning format (no separator)");
-            provisioning_in_progress = false;
-            return;
-        }
-
-        String ssid = data.substring(0, separatorIndex);
-        String password = data.substring(separatorIndex + 1);
-
-        if (ssid.length() == 0 || ssid.length() > WIFI_SSID_MAX)
+        size_t len = pCharacteristic->getLength();
+        if (len == 0)
         {
-            log_println("[E] Invalid SSID length");
+            LOG_E("Empty provisioning data");
             provisioning_in_progress = false;
             return;
         }
 
-        if (password.length() > WIFI_PASS_MAX)
+        ble_cmd_frame_t frame;
+        const ble_cmd_entry_t *entry = ble_cmd_parse(&prov_cmd_table, pCharacteristic->getData(), len, &frame);
+        if (!entry)
         {
-            log_println("[E] Invalid password length");
+            LOG_E("Invalid provisioning data");
             provisioning_in_progress = false;
             return;
         }
-
-        log_println("[I] Received Wi-Fi credentials via BLE");
-
-        // Log SSID and lengths (Serial only during provisioning)
-        char ssid_info[128];
-        snprintf(ssid_info, sizeof(ssid_info), "[I] SSID: %s", ssid.c_str());
-        log_println(ssid_info);
-
-        char len_info[64];
-        snprintf(len_info, sizeof(len_info), "[I] SSID length: %d", ssid.length());
-        log_println(len_info);
-
-        snprintf(len_info, sizeof(len_info), "[I] Password length: %d", password.length());
-        log_println(len_info);
-
-        // Save to NVS
-        nvs_wifi.begin(NVS_WIFI_NS, false);
-        nvs_wifi.putString("ssid", ssid.c_str());
-        nvs_wifi.putString("pass", password.c_str());
-        nvs_wifi.end();
-
-        // Verify what was saved
-        char verify_ssid[WIFI_SSID_MAX] = {0};
-        nvs_wifi.begin(NVS_WIFI_NS, true);
-        size_t verify_len = nvs_wifi.getString("ssid", verify_ssid, sizeof(verify_ssid));
-        nvs_wifi.end();
-
-        char verify_info[128];
-        snprintf(verify_info, sizeof(verify_info), "[I] Verified saved SSID: %s", verify_ssid);
-        log_println(verify_info);
-
-        snprintf(verify_info, sizeof(verify_info), "[I] Verified SSID length: %d", verify_len);
-        log_println(verify_info);
-
-        // Mark as provisioned
-        nvs_syscfg.begin(NVS_SYSCFG_NS, false);
-        nvs_syscfg.putUChar("prov", 1);
-        nvs_syscfg.end();
-
-        log_println("[I] Wi-Fi config saved! Device will reboot in 2 seconds...");
-
-        // Clear flag to allow final log messages to be sent via BLE
-        provisioning_in_progress = false;
-
-        // Request reboot (will be executed in main loop after callback returns)
-        // This ensures BLE write response is sent back to client before reboot
-        reboot_requested = true;
-        reboot_timestamp = millis();
-
-        log_println("[I] Reboot scheduled...");
+        entry->handler(&frame);
     }
 };
 
@@ -416,185 +1390,115 @@ class OtaControlCallbacks : public BLECharacteristicCallbacks
 {
     void onWrite(BLECharacteristic *pCharacteristic)
     {
-        std::string rxValue = pCharacteristic->getValue();
-        if (rxValue.length() == 0)
+        size_t len = pCharacteristic->getLength();
+        if (len == 0)
         {
-            log_println("[E] Empty OTA control data");
+            LOG_E("Empty OTA control data");
             return;
         }
 
-        String command = String(rxValue.c_str());
-        command.trim();
-
-        String msg = "[OTA] Control command: " + command;
-        log_println(msg.c_str());
+        ble_cmd_frame_t frame;
+        const ble_cmd_entry_t *entry = ble_cmd_parse(&ota_cmd_table, pCharacteristic->getData(), len, &frame);
+        ble_cmd_log("[OTA] Control command:", &frame);
+        if (!entry)
+        {
+            LOG_E("Unknown OTA control command");
+            return;
+        }
 
         // Check if WiFi/OTA timeout has passed
         // Allow END/ABORT for in-progress session even after timeout
-        bool is_end_or_abort = (command == "END" || command == "ABORT");
+        bool is_end_or_abort = (entry->opcode == CMD_OP_OTA_END || entry->opcode == CMD_OP_OTA_ABORT);
         if (wifi_ota_timeout_passed && !(is_end_or_abort && ota_in_progress))
         {
-            log_println("[W] OTA mode disabled after 60s timeout");
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("ERROR:TIMEOUT");
-                pOtaStatus->notify();
-            }
+            LOG_W("OTA mode disabled after 60s timeout");
+            ota_status_notify("ERROR:TIMEOUT");
             return;
         }
 
-        // Format: START:<size> or END
-        if (command.startsWith("START:"))
-        {
-            size_t size = command.substring(6).toInt();
-            if (size == 0 || size > 2000000) // Max 2MB
-            {
-                log_println("[E] Invalid OTA size");
-                if (pOtaStatus)
-                {
-                    pOtaStatus->setValue("ERROR:INVALID_SIZE");
-                    pOtaStatus->notify();
-                }
-                return;
-            }
-
-            log_println("[OTA] Starting OTA update...");
-            Serial.printf("[OTA] Expected size: %u bytes\n", size);
-
-            ota_expected_size = size;
-            ota_received_size = 0;
-            ota_last_reported_size = 0;
-            ota_in_progress = true;
-            ota_finalize_requested = false;
-            ota_abort_requested = false;
-
-            if (!Update.begin(size, U_FLASH))
-            {
-                Update.printError(Serial);
-                log_println("[E] Update.begin() failed");
-                ota_in_progress = false;
-                if (pOtaStatus)
-                {
-                    pOtaStatus->setValue("ERROR:BEGIN_FAILED");
-                    pOtaStatus->notify();
-                }
-                return;
-            }
-
-            log_println("[I] OTA update started successfully");
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("READY");
-                pOtaStatus->notify();
-            }
-        }
-        else if (command == "END")
-        {
-            if (!ota_in_progress)
-            {
-                log_println("[E] OTA not in progress");
-                if (pOtaStatus)
-                {
-                    pOtaStatus->setValue("ERROR:NOT_STARTED");
-                    pOtaStatus->notify();
-                }
-                return;
-            }
-
-            if (ota_received_size != ota_expected_size)
-            {
-                char err[64];
-                snprintf(err, sizeof(err), "[E] OTA incomplete: %u / %u", ota_received_size, ota_expected_size);
-                log_println(err);
-                if (pOtaStatus)
-                {
-                    pOtaStatus->setValue("ERROR:INCOMPLETE");
-                    pOtaStatus->notify();
-                }
-                return;
-            }
-
-            log_println("[OTA] Finalize requested - will process in main loop");
-            ota_finalize_requested = true;
-        }
-        else if (command == "ABORT")
-        {
-            log_println("[W] OTA abort requested by user");
-            ota_abort_requested = true;
-        }
+        entry->handler(&frame);
     }
 };
 
 class OtaDataCallbacks : public BLECharacteristicCallbacks
 {
     void onWrite(BLECharacteristic *pCharacteristic)
+    {
+        receive(pCharacteristic);
+        app_event_post(APP_EVENT_OTA_PROGRESS); // loop() re-evaluates the ACK deadline
+    }
+
+    void receive(BLECharacteristic *pCharacteristic)
     {
         if (!ota_in_progress)
         {
-            log_println("[E] OTA not started, ignoring data");
+            LOG_E("OTA not started, ignoring data");
             return;
         }
 
-        std::string rxValue = pCharacteristic->getValue();
-        size_t len = rxValue.length();
-
-        if (len == 0)
+        // The Wi-Fi transport owns the pipeline until its endpoint closes
+        if (ota_net_active())
         {
-            log_println("[E] Empty OTA data packet");
             return;
         }
 
-        if (ota_received_size + len > ota_expected_size)
+        // Read the attribute buffer in place; getValue() would copy every packet into a heap string
+        ota_rx_info_t info;
+        ota_rx_result_t result = ota_rx_packet(&ota_sack, &ota_rx_pipeline, ota_expected_size,
+                                               pCharacteristic->getData(), pCharacteristic->getLength(), &info);
+        switch (result)
         {
-            log_println("[E] OTA data overflow (received more than expected)");
-            Update.abort();
-            ota_in_progress = false;
+        case OTA_RX_ACCEPTED:
+            break;
+
+        case OTA_RX_SHORT:
+            LOG_E("Empty OTA data packet");
+            return;
+
+        case OTA_RX_OVERFLOW:
+            LOG_E("OTA data overflow (received more than expected)");
+            ota_session_abort("ERROR:OVERFLOW");
             ota_mode_active = false;
 
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("ERROR:OVERFLOW");
-                pOtaStatus->notify();
-            }
+            ota_status_notify("ERROR:OVERFLOW");
             return;
-        }
 
-        // Write data to flash
-        size_t written = Update.write((uint8_t *)rxValue.data(), len);
-        if (written != len)
-        {
-            Update.printError(Serial);
-            log_println("[E] OTA write failed");
-            Update.abort();
-            ota_in_progress = false;
+        case OTA_RX_WRITE_FAILED:
+            LOG_E("OTA buffer full");
+            ota_session_abort("ERROR:BUFFER_FULL");
+            ota_status_notify("ERROR:BUFFER_FULL");
+            return;
 
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("ERROR:WRITE_FAILED");
-                pOtaStatus->notify();
-            }
+        default:
+            // Duplicate (our ACK was probably lost), beyond the window or too many gaps
+            ota_ack_pending = true;
             return;
         }
+        ota_received_size += info.advance;
+        if (ota_received_size == info.advance && info.advance > 0)
+        {
+            ota_history_mark(OTA_PHASE_FIRST_BYTE, millis());
+        }
+        if (ota_received_size == ota_expected_size)
+        {
+            ota_history_mark(OTA_PHASE_LAST_BYTE, millis());
+        }
 
-        ota_received_size += written;
+        // Acknowledge promptly on new gaps, every stride, and at completion
+        if (info.new_gap ||
+            ota_received_size - ota_last_acked_size >= OTA_ACK_STRIDE_BYTES ||
+            ota_received_size == ota_expected_size)
+        {
+            ota_send_ack();
+        }
 
-        // Progress notification every 100KB or at completion (reduce overhead)
+        // Progress log every 100KB or at completion
         if (ota_received_size - ota_last_reported_size >= 102400 || ota_received_size == ota_expected_size)
         {
             ota_last_reported_size = ota_received_size;
             Serial.printf("[OTA] Progress: %u / %u bytes (%.1f%%)\n",
                           ota_received_size, ota_expected_size,
                           (ota_received_size * 100.0) / ota_expected_size);
-
-            // Only notify progress occasionally to reduce BLE stack load
-            if (pOtaStatus && (ota_received_size % 204800 == 0 || ota_received_size == ota_expected_size))
-            {
-                char progress[32];
-                snprintf(progress, sizeof(progress), "PROGRESS:%u/%u",
-                         ota_received_size, ota_expected_size);
-                pOtaStatus->setValue(progress);
-                pOtaStatus->notify();
-            }
         }
     }
 };
@@ -612,6 +1516,7 @@ void setup_ble_debug_service(void)
         DEBUG_LOG_TX_UUID,
         BLECharacteristic::PROPERTY_NOTIFY);
     pDebugLogTx->addDescriptor(new BLE2902());
+    pDebugLogTx->setCallbacks(new NotifyStatusCallbacks());
 
     // DebugCmdRx (Write)
     pDebugCmdRx = pService->createCharacteristic(
@@ -620,12 +1525,24 @@ void setup_ble_debug_service(void)
             BLECharacteristic::PROPERTY_WRITE_NR);
     pDebugCmdRx->setCallbacks(new MyCharacteristicCallbacks());
 
-    // DebugStat (Read/Notify)
+    // DebugStat (Read/Notify) - binary telemetry frame
     pDebugStat = pService->createCharacteristic(
         DEBUG_STAT_UUID,
         BLECharacteristic::PROPERTY_READ |
             BLECharacteristic::PROPERTY_NOTIFY);
     pDebugStat->addDescriptor(new BLE2902());
+    pDebugStat->setCallbacks(new DebugStatCallbacks());
+
+    // DebugBoot (Read) - boot timeline, set at the end of setup()
+    pDebugBoot = pService->createCharacteristic(
+        DEBUG_BOOT_UUID,
+        BLECharacteristic::PROPERTY_READ);
+
+    // DebugOtaHist (Read) - OTA session history (ota_history.h)
+    pDebugOtaHist = pService->createCharacteristic(
+        DEBUG_OTA_HIST_UUID,
+        BLECharacteristic::PROPERTY_READ);
+    pDebugOtaHist->setCallbacks(new OtaHistoryCallbacks());
 
     pService->start();
 }
@@ -642,11 +1559,13 @@ void setup_ble_provisioning_service(void)
     pProvWifiConfig->setCallbacks(new ProvisioningCallbacks());
 
     pProvService->start();
-    log_println("[I] BLE Provisioning service started");
+    LOG_I("BLE Provisioning service started");
 }
 
 void setup_ble_ota_service(void)
 {
+    ota_status_lock = xSemaphoreCreateMutex();
+
     BLEService *pOtaService = pServer->createService(OTA_SERVICE_UUID);
 
     // OTA Control (Write) - for START, END, ABORT commands
@@ -670,42 +1589,53 @@ void setup_ble_ota_service(void)
         BLECharacteristic::PROPERTY_READ |
             BLECharacteristic::PROPERTY_NOTIFY);
     pOtaStatus->addDescriptor(new BLE2902());
+    pOtaStatus->setCallbacks(new NotifyStatusCallbacks());
     pOtaStatus->setValue("IDLE");
 
     pOtaService->start();
-    log_println("[I] BLE OTA service started");
+    LOG_I("BLE OTA service started");
+}
+
+// BLE stack task: the report goes out from loop()
+void ble_link_changed(void)
+{
+    app_event_post(APP_EVENT_BLE_LINK);
 }
 
 void init_ble(void)
 {
-    log_println("[I] Starting BLE device init...");
+    LOG_I("Starting BLE device init...");
     BLEDevice::init("ESP32-S3-MICON");
 
     // Request larger MTU for better OTA throughput
     BLEDevice::setMTU(517);
 
-    log_println("[I] BLE device initialized");
+    // Connection parameters / DLE / PHY follow what the link is used for
+    ble_link_init(ble_link_changed);
+    BLEDevice::setCustomGapHandler(ble_link_gap_event);
 
-    delay(100);
+    LOG_I("BLE device initialized");
 
-    log_println("[I] Creating BLE server...");
+    boot_wait(100);
+
+    LOG_I("Creating BLE server...");
     pServer = BLEDevice::createServer();
     pServer->setCallbacks(new MyServerCallbacks());
-    log_println("[I] BLE server created");
+    LOG_I("BLE server created");
 
-    log_println("[I] Setting up debug service...");
+    LOG_I("Setting up debug service...");
     setup_ble_debug_service();
-    log_println("[I] Debug service ready");
+    LOG_I("Debug service ready");
 
     // Setup OTA service (always available)
-    log_println("[I] Setting up OTA service...");
+    LOG_I("Setting up OTA service...");
     setup_ble_ota_service();
 
     // Setup provisioning service (always available for WiFi re-provisioning during operation)
-    log_println("[I] Setting up provisioning service...");
+    LOG_I("Setting up provisioning service...");
     setup_ble_provisioning_service();
 
-    log_println("[I] Starting advertising...");
+    LOG_I("Starting advertising...");
     BLEAdvertising *pAdvertising = BLEDevice::getAdvertising();
     pAdvertising->addServiceUUID(DEBUG_SERVICE_UUID);
     pAdvertising->addServiceUUID(OTA_SERVICE_UUID);
@@ -715,33 +1645,46 @@ void init_ble(void)
     pAdvertising->setMaxPreferred(0x12);
     BLEDevice::startAdvertising();
 
-    log_println("[I] BLE initialized successfully");
+    LOG_I("BLE initialized successfully");
 }
 
 // =============================================================================
 // Factory Reset / NVS Management
 // =============================================================================
 
-void config_store_init(void)
+// Wakes loop() so the coalesced NVS commit gets scheduled
+void config_changed(void)
+{
+    app_event_post(APP_EVENT_CONFIG);
+}
+
+// Load settings into RAM once; nothing below reads NVS again
+void config_init(void)
 {
-    nvs_wifi.begin(NVS_WIFI_NS, false);
-    nvs_syscfg.begin(NVS_SYSCFG_NS, false);
+    config_t defaults = {};
+    defaults.log_level = LOG_DEFAULT_LEVEL;
+    config_store_init(&defaults, config_changed);
+    ota_history_init();
+
+    config_t cfg;
+    config_get(&cfg);
+    log_level = cfg.log_level <= LOG_LEVEL_DEBUG ? cfg.log_level : LOG_DEFAULT_LEVEL;
+    fast_boot_enabled = FAST_BOOT || cfg.fast_boot;
 }
 
 void config_store_check_provisioned(void)
 {
-    nvs_wifi.begin(NVS_WIFI_NS, true);
-    uint8_t is_provisioned = nvs_wifi.getUChar("prov", 0);
-    nvs_wifi.end();
+    config_t cfg;
+    config_get(&cfg);
 
-    if (is_provisioned)
+    if (cfg.provisioned)
     {
-        log_println("[I] Wi-Fi config found, entering APP mode");
+        LOG_I("Wi-Fi config found, entering APP mode");
         g_state.system_state = STATE_APP_RUNNING;
     }
     else
     {
-        log_println("[I] No Wi-Fi config, entering PROVISIONING mode");
+        LOG_I("No Wi-Fi config, entering PROVISIONING mode");
         g_state.system_state = STATE_PROVISIONING;
     }
 }
@@ -752,22 +1695,17 @@ void factory_reset_check(void)
     // In real implementation, use GPIO interrupt
     // For now, just check a flag in preferences
 
-    nvs_syscfg.begin(NVS_SYSCFG_NS, true);
-    uint8_t factory_reset_flag = nvs_syscfg.getUChar("factory_reset", 0);
-    nvs_syscfg.end();
+    config_t cfg;
+    config_get(&cfg);
 
-    if (factory_reset_flag)
+    if (cfg.factory_reset)
     {
-        log_println("[W] Factory reset triggered!");
-        nvs_wifi.begin(NVS_WIFI_NS, false);
-        nvs_wifi.clear();
-        nvs_wifi.end();
+        LOG_W("Factory reset triggered!");
+        config_store_erase(CONFIG_NS_WIFI);
+        config_set_factory_reset(false);
+        config_store_commit();
 
-        nvs_syscfg.begin(NVS_SYSCFG_NS, false);
-        nvs_syscfg.putUChar("factory_reset", 0);
-        nvs_syscfg.end();
-
-        log_println("[I] NVS cleared, rebooting...");
+        LOG_I("NVS cleared, rebooting...");
         delay(1000);
         ESP.restart();
     }
@@ -777,63 +1715,116 @@ void factory_reset_check(void)
 // Wi-Fi Event Handler
 // =============================================================================
 
-void wifi_event_handler(WiFiEvent_t event)
+// Called by wifi_mgr (event / timer task) on every state change or new attempt
+void wifi_changed(wifi_mgr_state_t state)
 {
-    switch (event)
-    {
-    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
-        log_println("[I] Wi-Fi connected");
-        break;
+    wifi_mgr_stats_t st;
+    wifi_mgr_get_stats(&st);
 
-    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+    switch (state)
     {
-        g_state.wifi_state = WIFI_CONNECTED;
-        IPAddress ip = WiFi.localIP();
-        snprintf(g_state.wifi_ip, sizeof(g_state.wifi_ip), "%d.%d.%d.%d",
-                 ip[0], ip[1], ip[2], ip[3]);
+    case WIFI_MGR_IDLE:
+        LOG_E("No Wi-Fi config found");
+        break;
 
-        char msg[64];
-        snprintf(msg, sizeof(msg), "[I] Got IP: %s", g_state.wifi_ip);
-        log_println(msg);
+    case WIFI_MGR_CONNECTING:
+        LOG_I("Starting Wi-Fi connection #%u (%s%s)...", st.attempts, st.fast ? "cached channel" : "scan",
+              st.static_ip ? ", static IP" : "");
+        break;
 
-        // If in provisioning mode, mark as provisioned
-        if (g_state.system_state == STATE_PROVISIONING)
-        {
-            nvs_wifi.begin(NVS_WIFI_NS, false);
-            nvs_wifi.putUChar("prov", 1);
-            nvs_wifi.end();
+    case WIFI_MGR_CONNECTED:
+        LOG_I("Got IP: %s", wifi_mgr_get_ip_str());
+        LOG_I("Wi-Fi up in %u ms (assoc %u ms, %s, %s, outage %u ms)", st.connect_ms, st.assoc_ms,
+              st.fast ? "cached channel" : "scan", st.static_ip ? "static IP" : "DHCP", st.outage_ms);
+        break;
 
-            log_println("[I] WiFi provisioned successfully");
-            g_state.system_state = STATE_APP_RUNNING;
-        }
+    case WIFI_MGR_BACKOFF:
+        // 201 = AP not found, 202/15 = authentication (check the password)
+        LOG_W("Wi-Fi down (reason %u), retry #%u in %u ms", st.last_reason, st.backoff_step, st.backoff_ms);
         break;
     }
 
-    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    app_event_post(APP_EVENT_WIFI);
+}
+
+// Connect attempts wait while OTA mode has the radio
+bool wifi_hold(void)
+{
+    return ota_mode_active;
+}
+
+// =============================================================================
+// Periodic Jobs (the heartbeat is skipped while OTA mode has the link)
+// =============================================================================
+
+int stat_job = -1; // Triggered early on link / Wi-Fi changes
+bool wifi_boot_marked = false;
+
+// BLE Output: Send "Hello World via BLE" every 1 second
+void job_ble_heartbeat(void *arg)
+{
+    if (ota_mode_active || !ble_device_connected || !pDebugLogTx)
     {
-        g_state.wifi_state = WIFI_FAILED;
+        return;
+    }
 
-        // Get detailed disconnect reason
-        char reason_msg[128];
-        snprintf(reason_msg, sizeof(reason_msg),
-                 "[W] Wi-Fi disconnected (status=%d)", WiFi.status());
-        log_println(reason_msg);
+    log_async_write("Hello World via BLE", LOG_OUT_BLE);
 
-        // Additional debug info
-        if (WiFi.status() == WL_NO_SSID_AVAIL)
-        {
-            log_println("[E] SSID not found - check if SSID is correct");
-        }
-        else if (WiFi.status() == WL_CONNECT_FAILED)
-        {
-            log_println("[E] Connection failed - check password");
-        }
-        break;
+    // Flash status LED when sending BLE message
+    status_led_play(&LED_HEARTBEAT);
+}
+
+// DebugStat telemetry frame (see telemetry.h)
+void telemetry_build(telemetry_frame_t *frame)
+{
+    telemetry_begin(frame);
+    frame->flags = (ble_device_connected ? TELEMETRY_FLAG_BLE : 0) |
+                   (ota_mode_active ? TELEMETRY_FLAG_OTA_MODE : 0) |
+                   (ota_in_progress ? TELEMETRY_FLAG_OTA_ACTIVE : 0) |
+                   (ota_net_active() ? TELEMETRY_FLAG_OTA_WIFI : 0);
+
+    wifi_mgr_stats_t wifi;
+    wifi_mgr_get_stats(&wifi);
+    frame->wifi_state = wifi_mgr_state();
+    frame->rssi = wifi_mgr_rssi();
+    frame->wifi_reason = wifi.last_reason;
+    frame->ip = wifi_mgr_is_connected() ? wifi_mgr_get_ip() : 0;
+    frame->wifi_attempts = wifi.attempts;
+    frame->wifi_connects = wifi.connects;
+    frame->wifi_disconnects = wifi.disconnects;
+
+    if (ota_in_progress)
+    {
+        unsigned long elapsed = millis() - ota_start_ms;
+        frame->ota_received = ota_received_size;
+        frame->ota_expected = ota_expected_size;
+        frame->ota_bytes_per_s = elapsed > 0 ? (uint32_t)((uint64_t)ota_received_size * 1000 / elapsed) : 0;
     }
 
-    default:
-        break;
+    ota_pipeline_stats_t writes;
+    ota_pipeline_get_stats(&writes);
+    frame->write_count = writes.writes;
+    memcpy(frame->write_hist, writes.write_hist, sizeof(frame->write_hist));
+    frame->write_max_us = writes.write_max_us;
+
+    log_async_stats_t logs;
+    log_async_get_stats(&logs);
+    frame->notify_failures = ble_notify_failures;
+    frame->log_dropped = logs.dropped_lines;
+}
+
+// Every telemetry_period_ms (and on link / Wi-Fi changes), notify the DebugStat frame
+void job_stat_update(void *arg)
+{
+    if (!ble_device_connected || !pDebugStat)
+    {
+        return;
     }
+
+    telemetry_frame_t frame;
+    telemetry_build(&frame);
+    pDebugStat->setValue((uint8_t *)&frame, sizeof(frame));
+    pDebugStat->notify();
 }
 
 // =============================================================================
@@ -845,21 +1836,33 @@ void setup()
     boot_timestamp = millis(); // Record boot time for power-saving mode
 
     Serial.begin(SERIAL_BAUD);
-    delay(500);
 
-    // Boot sequence with repeated messages - allows time to catch output after USB reconnect
-    Serial.println("\n\n=== ESP32-S3 BOOT SEQUENCE STARTING ===");
-    Serial.println("=== Waiting 5 seconds for monitor to connect... ===\n");
+    // Log lines are drained to Serial/BLE by a low-priority task from here on
+    log_async_init(log_ble_notify, log_ble_payload_max);
+
+    // NVS first: the boot profile (fast_boot) and log level live in syscfg
+    config_init();
+    boot_checkpoint("config");
 
-    for (int i = 5; i > 0; i--)
+    if (!fast_boot_enabled)
     {
-        Serial.print("[BOOT] ");
-        Serial.print(i);
-        Serial.println(" seconds until initialization continues...");
-        delay(1000);
-    }
+        delay(500);
+
+        // Boot sequence with repeated messages - allows time to catch output after USB reconnect
+        Serial.println("\n\n=== ESP32-S3 BOOT SEQUENCE STARTING ===");
+        Serial.println("=== Waiting 5 seconds for monitor to connect... ===\n");
+
+        for (int i = 5; i > 0; i--)
+        {
+            Serial.print("[BOOT] ");
+            Serial.print(i);
+            Serial.println(" seconds until initialization continues...");
+            delay(1000);
+        }
 
-    Serial.println("\n=== Proceeding with initialization ===\n");
+        Serial.println("\n=== Proceeding with initialization ===\n");
+        boot_checkpoint("countdown");
+    }
 
     // Direct output to confirm serial is working
     Serial.println("=== ESP32-S3 Booting ===");
@@ -871,123 +1874,392 @@ void setup()
     Serial.println("WARNING: LOG_SERIAL_ENABLED is NOT defined");
 #endif
 
-    log_println("\n\n[System] ESP32-S3 Starting...");
-    log_println("[Version] FW v1.0.0");
+    LOG_I("[System] ESP32-S3 Starting...");
+    LOG_I("[Version] FW v%s (fast boot %d)", FW_VERSION, fast_boot_enabled);
 
-    // Initialize components - add checkpoint logging
-    Serial.println("[CHECKPOINT] Calling config_store_init...");
-    config_store_init();
-    Serial.println("[CHECKPOINT] config_store_init done");
-
-    Serial.println("[CHECKPOINT] Calling factory_reset_check...");
     factory_reset_check();
-    Serial.println("[CHECKPOINT] factory_reset_check done");
+    boot_checkpoint("factory_reset");
 
-    Serial.println("[CHECKPOINT] Calling config_store_check_provisioned...");
     config_store_check_provisioned();
-    Serial.println("[CHECKPOINT] config_store_check_provisioned done");
-
-    log_println("[Setup] Initializing WiFi...");
-    wifi_mgr_init();
+    boot_checkpoint("provisioned");
 
     // Setup status LED
     status_led_init();
 
-    delay(500); // Give time for WiFi stack to initialize
+    if (fast_boot_enabled)
+    {
+        // Advertise as early as possible; Wi-Fi and the OTA pipeline follow
+        LOG_I("[Setup] Initializing BLE...");
+        init_ble();
+        boot_checkpoint("ble");
+    }
+
+    LOG_I("[Setup] Initializing WiFi...");
+    wifi_mgr_init(wifi_changed, wifi_hold);
+    boot_checkpoint("wifi");
+
+    // OTA ring buffer + flash writer task (allocated once, PSRAM preferred)
+    if (!ota_pipeline_init(ota_update_sink_write, ota_update_progress))
+    {
+        LOG_E("OTA pipeline init failed");
+    }
+    if (!ota_net_init(ota_net_received, ota_net_closed))
+    {
+        LOG_E("Wi-Fi OTA transport init failed");
+    }
+    boot_checkpoint("ota_pipeline");
 
-    log_println("[Setup] Initializing BLE...");
-    init_ble();
+    if (!fast_boot_enabled)
+    {
+        delay(500); // Give time for WiFi stack to initialize
 
-    delay(500); // Give time for BLE stack to initialize
+        LOG_I("[Setup] Initializing BLE...");
+        init_ble();
+        boot_checkpoint("ble");
 
-    // WiFi event handler
-    WiFi.onEvent(wifi_event_handler);
+        delay(500); // Give time for BLE stack to initialize
+    }
 
     snprintf(g_state.device_name, sizeof(g_state.device_name), "ESP32-S3-SUPERMINI");
 
-    log_println("[Setup] Initialization complete");
-    log_println("[Info] Waiting for BLE provisioning or app commands...");
+    // Periodic jobs, run from loop()
+    sched_init(esp_timer_get_time);
+    sched_add("heartbeat", job_ble_heartbeat, NULL, BLE_OUTPUT_INTERVAL_MS, BLE_OUTPUT_INTERVAL_MS, SCHED_PRIO_LOW);
+    stat_job = sched_add("stat", job_stat_update, NULL, telemetry_period_ms, telemetry_period_ms, SCHED_PRIO_LOW);
+
+    // Connect with the stored credentials; retries are driven by Wi-Fi events and wifi_mgr's timer
+    wifi_mgr_start();
+
+    boot_checkpoint("setup_done");
+    boot_debug_publish();
+
+    LOG_I("[Setup] Initialization complete");
+    LOG_I("[Info] Waiting for BLE provisioning or app commands...");
 }
 
 // =============================================================================
-// Loop
+// Loop (event dispatcher)
 // =============================================================================
 
-void loop()
+// END accepted: drain the pipeline, verify and activate the new image
+void ota_finalize(void)
 {
-    // Handle reboot request (e.g., after WiFi provisioning)
+    uint8_t digest[OTA_DIGEST_SIZE];
+    LOG_I("[OTA] Finalizing update...");
+    Serial.printf("[OTA] Received: %u bytes / Expected: %u bytes\n", ota_received_size, ota_expected_size);
+
+    // Drain the ring buffer before finalizing
+    if (!ota_pipeline_flush(OTA_FLUSH_TIMEOUT_MS))
+    {
+        Serial.printf("[OTA] Flash error: %s\n", esp_err_to_name(ota_flash_error()));
+        LOG_E("OTA flush failed");
+        const char *status = ota_write_error_status();
+        ota_session_abort(status);
+
+        ota_status_notify(status);
+    }
+    else if (ota_codec == OTA_CODEC_DEFLATE &&
+             (!ota_inflater.done || (!ota_patching && ota_inflater.total_out != ota_image_size - ota_image_offset)))
+    {
+        Serial.printf("[OTA] Decompressed %u / %u bytes\n", ota_inflater.total_out, ota_image_size);
+        LOG_E("OTA compressed stream incomplete");
+        ota_session_abort("ERROR:DECOMPRESS_FAILED");
+
+        ota_status_notify("ERROR:DECOMPRESS_FAILED");
+    }
+    else if (ota_patching &&
+             (!ota_patch_complete(&ota_patcher) || ota_patcher.target_size != ota_image_size))
+    {
+        Serial.printf("[OTA] Patched %u / %u bytes\n", ota_patcher.total_out, ota_image_size);
+        LOG_E("OTA delta patch incomplete");
+        ota_session_abort("ERROR:PATCH_FAILED");
+
+        ota_status_notify("ERROR:PATCH_FAILED");
+    }
+    else if (!ota_flash_finish(digest))
+    {
+        Serial.printf("[OTA] Flash error: %s\n", esp_err_to_name(ota_flash_error()));
+        LOG_E("OTA final write failed");
+        ota_session_abort("ERROR:WRITE_FAILED");
+
+        ota_status_notify("ERROR:WRITE_FAILED");
+    }
+    else if (!ota_digest_matches(digest))
+    {
+        LOG_E("OTA image hash mismatch");
+        ota_session_abort("ERROR:HASH_MISMATCH");
+
+        ota_status_notify("ERROR:HASH_MISMATCH");
+    }
+    else if (OTA_SIGNATURE_ENABLED && !ota_verify_signature(digest, ota_signature, ota_signature_len))
+    {
+        LOG_E("OTA image signature missing or invalid");
+        ota_session_abort("ERROR:SIGNATURE_INVALID");
+
+        ota_status_notify("ERROR:SIGNATURE_INVALID");
+    }
+    else if (ota_flash_activate()) // esp_image_verify() runs here as well
+    {
+        Serial.printf("[OTA] Update Success: %u bytes (%u sectors skipped, %u written)\n", ota_image_size,
+                      ota_flash_sectors_skipped(), ota_flash_sectors_written());
+        LOG_I("OTA update successful!");
+        ota_in_progress = false;
+        ota_mode_active = false;
+        ble_link_bulk(false);
+        ota_checkpoint_clear();
+
+        // SUCCESS:SKIP=<unchanged sectors>,WRITE=<rewritten sectors>
+        char success[48];
+        snprintf(success, sizeof(success), "SUCCESS:SKIP=%u,WRITE=%u",
+                 ota_flash_sectors_skipped(), ota_flash_sectors_written());
+        ota_history_mark(OTA_PHASE_DONE, millis());
+        ota_history_end(success, ota_received_size); // Written before the reboot; the new firmware serves it
+        ota_status_notify(success);
+
+        config_store_commit();
+        delay(1000);
+        LOG_I("Rebooting...");
+        delay(500);
+        ESP.restart();
+    }
+    else
+    {
+        Serial.println("\n=== ota_flash_activate() FAILED ===");
+        Serial.printf("[OTA] ota_received_size = %u\n", ota_received_size);
+        Serial.printf("[OTA] ota_expected_size = %u\n", ota_expected_size);
+        Serial.printf("[OTA] Flash error: %s\n", esp_err_to_name(ota_flash_error()));
+        LOG_E("ota_flash_activate() failed");
+        ota_session_abort("ERROR:END_FAILED");
+
+        ota_status_notify("ERROR:END_FAILED");
+    }
+}
+
+// Progress, gaps, or a window reopened by the writer task not yet reported
+bool ota_ack_owed(void)
+{
+    return ota_ack_pending || ota_received_size != ota_last_acked_size ||
+           ota_pipeline_free() >= ota_last_acked_window + OTA_FLASH_BATCH_SIZE;
+}
+
+// Milliseconds until last + interval (0 if already due)
+uint32_t loop_time_left(unsigned long last, unsigned long interval, unsigned long now)
+{
+    unsigned long elapsed = now - last;
+    return elapsed >= interval ? 0 : interval - elapsed;
+}
+
+// How long loop() may sleep: the earliest deadline of the work that is armed
+uint32_t loop_next_timeout_ms(void)
+{
+    unsigned long now = millis();
     if (reboot_requested)
     {
-        unsigned long elapsed = millis() - reboot_timestamp;
-        if (elapsed >= REBOOT_DELAY_MS)
+        return loop_time_left(reboot_timestamp, REBOOT_DELAY_MS, now);
+    }
+
+    uint32_t timeout = APP_EVENT_WAIT_FOREVER;
+    if (ota_in_progress && ota_ack_owed())
+    {
+        timeout = min(timeout, loop_time_left(ota_last_ack_ms, OTA_ACK_INTERVAL_MS, now));
+    }
+    if (!wifi_ota_timeout_passed && !(ota_in_progress && wifi_ota_timeout_deferred_logged))
+    {
+        timeout = min(timeout, loop_time_left(boot_timestamp, WIFI_OTA_TIMEOUT_MS, now));
+    }
+    if (ble_status_pending)
+    {
+        timeout = min(timeout, loop_time_left(ble_connect_ms, BLE_CONNECT_SETTLE_MS, now));
+    }
+    timeout = min(timeout, config_store_pending_ms(now));
+    return min(timeout, sched_next_ms());
+}
+
+// ABORT received: drop the session it closed, or one a later-handled START opened since
+void ota_abort(void)
+{
+    LOG_W("OTA aborted by user");
+    bool had_session = ota_abort_session;
+    ota_abort_session = false;
+    if (had_session || ota_in_progress)
+    {
+        ota_session_abort("ABORTED");
+    }
+    ota_mode_active = false;
+
+    ota_status_notify("ABORTED");
+}
+
+// Run the OTA commands posted since the last wake in arrival order, so ABORT then START
+// does not start the new session and then abort it
+void loop_handle_ota_commands(uint32_t events)
+{
+    struct
+    {
+        uint32_t seq;
+        uint32_t event;
+    } cmds[3];
+    size_t count = 0;
+
+    if (events & APP_EVENT_OTA_START)
+    {
+        cmds[count++] = {ota_start_req.seq, APP_EVENT_OTA_START};
+    }
+    if (events & APP_EVENT_OTA_FINALIZE)
+    {
+        cmds[count++] = {ota_finalize_seq, APP_EVENT_OTA_FINALIZE};
+    }
+    if (events & APP_EVENT_OTA_ABORT)
+    {
+        cmds[count++] = {ota_abort_seq, APP_EVENT_OTA_ABORT};
+    }
+    for (size_t i = 1; i < count; i++)
+    {
+        for (size_t j = i; j > 0 && (int32_t)(cmds[j].seq - cmds[j - 1].seq) < 0; j--)
         {
-            log_println("[I] Rebooting now...");
-            delay(100); // Give time for final log to be sent
-            ESP.restart();
+            std::swap(cmds[j], cmds[j - 1]);
         }
-        // Don't process other operations while reboot is pending
+    }
+
+    for (size_t i = 0; i < count; i++)
+    {
+        switch (cmds[i].event)
+        {
+        case APP_EVENT_OTA_START:
+        {
+            // START parsed on the BLE task; the base hash, flash setup and checkpoint run here
+            ota_start_request_t req = ota_start_req;
+            ota_start_pending = false;
+            ota_start(&req);
+            break;
+        }
+        case APP_EVENT_OTA_FINALIZE:
+            // Moved from the BLE callback to avoid stack issues
+            ota_finalize();
+            break;
+        case APP_EVENT_OTA_ABORT:
+            ota_abort();
+            break;
+        }
+    }
+}
+
+void loop_handle_events(uint32_t events)
+{
+    // Handle reboot request (e.g., after WiFi provisioning)
+    if ((events & APP_EVENT_REBOOT) && !reboot_requested)
+    {
+        reboot_requested = true;
+        reboot_timestamp = millis();
+    }
+    if (reboot_requested)
+    {
         return;
     }
 
-    // Handle OTA finalization request (moved from BLE callback to avoid stack issues)
-    if (ota_finalize_requested)
+    // START / END / ABORT, in the order the BLE task received them
+    loop_handle_ota_commands(events);
+
+    // BLE link lost mid-transfer: checkpoint and wait for RESUME
+    if ((events & APP_EVENT_OTA_SUSPEND) && ota_in_progress)
     {
-        ota_finalize_requested = false;
+        ota_session_suspend();
+    }
 
-        log_println("[OTA] Finalizing update...");
-        Serial.printf("[OTA] Received: %u bytes / Expected: %u bytes\n", ota_received_size, ota_expected_size);
+    // New DebugStat period: restart the job, first frame right away
+    if (events & APP_EVENT_TELEMETRY)
+    {
+        sched_cancel(stat_job);
+        stat_job = sched_add("stat", job_stat_update, NULL, telemetry_period_ms, 0, SCHED_PRIO_LOW);
+    }
 
-        if (Update.end(true)) // true = do checksum validation
-        {
-            Serial.printf("[OTA] Update Success: %u bytes\n", ota_received_size);
-            log_println("[I] OTA update successful!");
-            ota_in_progress = false;
-            ota_mode_active = false;
+    // Report link / Wi-Fi changes on DebugStat right away
+    if (events & (APP_EVENT_BLE_LINK | APP_EVENT_WIFI))
+    {
+        sched_trigger(stat_job);
+    }
 
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("SUCCESS");
-                pOtaStatus->notify();
-            }
+    if (events & APP_EVENT_BLE_LINK)
+    {
+        ota_link_notify(false);
+    }
 
-            delay(1000);
-            log_println("[I] Rebooting...");
-            delay(500);
-            ESP.restart();
+    // New connection: initial status after BLE_CONNECT_SETTLE_MS (see loop())
+    if (events & APP_EVENT_BLE_CONNECTED)
+    {
+        ble_status_pending = true;
+        ble_connect_ms = millis();
+    }
+
+    if ((events & APP_EVENT_WIFI) && wifi_mgr_is_connected())
+    {
+        // First connection since boot goes on the boot timeline
+        if (!wifi_boot_marked)
+        {
+            wifi_boot_marked = true;
+            boot_timeline_mark("wifi_ip");
+            boot_debug_publish();
         }
-        else
+
+        // If in provisioning mode, mark as provisioned
+        if (g_state.system_state == STATE_PROVISIONING)
         {
-            Serial.println("\n=== Update.end() FAILED ===");
-            Serial.printf("[OTA] ota_received_size = %u\n", ota_received_size);
-            Serial.printf("[OTA] ota_expected_size = %u\n", ota_expected_size);
-            Update.printError(Serial);
-            log_println("[E] Update.end() failed");
-            ota_in_progress = false;
-
-            if (pOtaStatus)
-            {
-                pOtaStatus->setValue("ERROR:END_FAILED");
-                pOtaStatus->notify();
-            }
+            config_set_provisioned(true);
+
+            LOG_I("WiFi provisioned successfully");
+            g_state.system_state = STATE_APP_RUNNING;
         }
     }
+}
 
-    // Handle OTA abort request
-    if (ota_abort_requested)
+void loop()
+{
+    // Sleep until a callback posts an event or the next deadline is due
+    loop_handle_events(app_event_wait(loop_next_timeout_ms()));
+    status_led_set_state(status_led_pattern_for_state());
+
+    if (reboot_requested)
     {
-        ota_abort_requested = false;
-        log_println("[W] OTA aborted by user");
-        if (ota_in_progress)
+        if (millis() - reboot_timestamp >= REBOOT_DELAY_MS)
         {
-            Update.abort();
-            ota_in_progress = false;
+            LOG_I("Rebooting now...");
+            config_store_commit();
+            delay(100); // Give time for final log to be sent
+            ESP.restart();
         }
-        ota_mode_active = false;
+        // Don't process other operations while reboot is pending
+        return;
+    }
+
+    // Flash writer state: report write errors, keep the client's window moving
+    if (ota_in_progress && ota_pipeline_failed())
+    {
+        Serial.printf("[OTA] Flash error: %s\n", esp_err_to_name(ota_flash_error()));
+        LOG_E("OTA write failed");
+        const char *status = ota_write_error_status();
+        ota_session_abort(status);
+
+        ota_status_notify(status);
+    }
+    else if (ota_in_progress && millis() - ota_last_ack_ms >= OTA_ACK_INTERVAL_MS && ota_ack_owed())
+    {
+        // Report progress, gaps, or a window reopened by the writer task
+        ota_send_ack();
+    }
+
+    if (ota_in_progress && ota_session_sha[0] &&
+        ota_flash_committed() >= ota_checkpoint_offset + OTA_CHECKPOINT_INTERVAL)
+    {
+        ota_checkpoint_save(ota_flash_committed());
+    }
 
-        if (pOtaStatus)
+    // Initial status for a new connection, once the BLE stack has settled
+    if (ble_status_pending && millis() - ble_connect_ms >= BLE_CONNECT_SETTLE_MS)
+    {
+        ble_status_pending = false;
+        if (ble_device_connected)
         {
-            pOtaStatus->setValue("ABORTED");
-            pOtaStatus->notify();
+            LOG_I("[STATUS] WIFI=%d, OTA=%s", wifi_mgr_state(), ota_mode_active ? "ACTIVE" : "IDLE");
         }
     }
 
@@ -999,119 +2271,32 @@ void loop()
         {
             if (!wifi_ota_timeout_deferred_logged)
             {
-                log_println("[I] OTA timeout deferred while write is in progress");
+                LOG_I("OTA timeout deferred while write is in progress");
                 wifi_ota_timeout_deferred_logged = true;
             }
         }
         else
         {
             wifi_ota_timeout_passed = true;
-            log_println("[I] === OTA timeout activated ===");
-            log_println("[I] OTA and WiFi provisioning disabled after 60s");
-            log_println("[I] WiFi connection will be maintained");
+            LOG_I("=== OTA timeout activated ===");
+            LOG_I("OTA and WiFi provisioning disabled after 60s");
+            LOG_I("WiFi connection will be maintained");
 
             // Disable OTA mode if active (only when not writing)
             if (ota_mode_active)
             {
-                log_println("[W] Disabling OTA mode (timeout)");
+                LOG_W("Disabling OTA mode (timeout)");
                 ota_mode_active = false;
             }
         }
     }
 
-    // If OTA mode is active, stop normal app operation
-    if (ota_mode_active)
-    {
-        // Only handle BLE and OTA processing
-        delay(10); // Reduced delay for faster response
-        return;
-    }
-
-    // Wi-Fi state monitoring and auto-reconnect management
-    static unsigned long last_wifi_check = 0;
-    static unsigned long last_wifi_reconnect_try = 0;
-    static unsigned long wifi_connect_start_time = 0;
-
-    if (millis() - last_wifi_check > 5000) // Check WiFi state every 5 seconds
-    {
-        last_wifi_check = millis();
-
-        if (g_state.wifi_state == WIFI_CONNECTING)
-        {
-            if (WiFi.status() == WL_CONNECTED)
-            {
-                // Will be handled by event handler
-            }
-            else
-            {
-                // Check for connection timeout (30 seconds)
-                if (wifi_connect_start_time > 0 &&
-                    (millis() - wifi_connect_start_time > 30000))
-                {
-                    log_println("[E] WiFi connection timeout - marking as failed");
-                    g_state.wifi_state = WIFI_FAILED;
-                    wifi_connect_start_time = 0;
-                    WiFi.disconnect();
-                }
-            }
-        }
-
-        // Auto-reconnect: if WiFi config exists but not connected, try to connect
-        if ((g_state.wifi_state == WIFI_IDLE || g_state.wifi_state == WIFI_FAILED) &&
-            (millis() - last_wifi_reconnect_try > 30000)) // Retry every 30 seconds
-        {
-            char ssid[WIFI_SSID_MAX] = {0};
-            nvs_wifi.begin(NVS_WIFI_NS, true);
-            size_t ssid_len = nvs_wifi.getString("ssid", ssid, sizeof(ssid));
-            nvs_wifi.end();
-
-            if (ssid_len > 0) // WiFi config exists
-            {
-                log_println("[I] Loop: WiFi config found, initiating connection...");
-                last_wifi_reconnect_try = millis();
-                wifi_connect_start_time = millis();
-                wifi_mgr_connect();
-            }
-        }
-        else if (g_state.wifi_state == WIFI_CONNECTING && wifi_connect_start_time == 0)
-        {
-            // Initialize connection start time if not set
-            wifi_connect_start_time = millis();
-        }
-    }
-
-    // BLE Output: Send "Hello World via BLE" every 1 second
-    static unsigned long last_ble_output = 0;
-    if (ble_device_connected && pDebugLogTx && millis() - last_ble_output >= BLE_OUTPUT_INTERVAL_MS)
+    // Settings changed since the last quiet period: one NVS commit for all of them
+    if (config_store_pending_ms(millis()) == 0)
     {
-        last_ble_output = millis();
-        const char *msg = "Hello World via BLE";
-        pDebugLogTx->setValue((uint8_t *)msg, strlen(msg));
-        pDebugLogTx->notify();
-
-        // Blink status LED when sending BLE message
-        status_led_blink_aws();
-    }
-
-    // Every 10 seconds, update BLE debug stat
-    static unsigned long last_stat_update = 0;
-    if (millis() - last_stat_update > 10000)
-    {
-        last_stat_update = millis();
-
-        if (ble_device_connected && pDebugStat)
-        {
-            char stat_str[128];
-            snprintf(stat_str, sizeof(stat_str),
-                     "STATE:BLE=%d,WIFI=%d,OTA_MODE=%d,IP=%s",
-                     ble_device_connected ? 1 : 0,
-                     g_state.wifi_state,
-                     ota_mode_active ? 1 : 0,
-                     g_state.wifi_ip);
-            pDebugStat->setValue((uint8_t *)stat_str, strlen(stat_str));
-            pDebugStat->notify();
-        }
+        config_store_commit();
     }
 
-    delay(100);
+    // Periodic jobs (each one stands down while OTA mode is active)
+    sched_run();
 }
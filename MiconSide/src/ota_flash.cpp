@@ -0,0 +1,190 @@
+#include "ota_flash.h"
+
+#include <string.h>
+#include <esp_ota_ops.h>
+#include <mbedtls/sha256.h>
+
+static const esp_partition_t *s_part = NULL;
+static size_t s_image_size = 0;
+static volatile size_t s_committed = 0; // Image offset of s_sector
+static size_t s_fill = 0;
+static volatile esp_err_t s_error = ESP_OK;
+static mbedtls_sha256_context s_sha; // Hardware SHA on the ESP32-S3
+static bool s_sha_active = false;
+static size_t s_sectors_skipped = 0;
+static size_t s_sectors_written = 0;
+
+// One sector is collected in internal RAM, then erased and programmed
+static uint8_t s_sector[OTA_FLASH_SECTOR_SIZE];
+
+static bool ota_flash_fail(esp_err_t err)
+{
+    s_error = err;
+    return false;
+}
+
+#if OTA_FLASH_SKIP_UNCHANGED
+// True if flash at s_committed already holds s_sector[0 .. s_fill)
+static bool ota_flash_sector_unchanged(void)
+{
+    static uint8_t current[OTA_FLASH_COMPARE_CHUNK];
+    for (size_t ofs = 0; ofs < s_fill; ofs += OTA_FLASH_COMPARE_CHUNK)
+    {
+        size_t n = s_fill - ofs < OTA_FLASH_COMPARE_CHUNK ? s_fill - ofs : OTA_FLASH_COMPARE_CHUNK;
+        if (esp_partition_read(s_part, s_committed + ofs, current, n) != ESP_OK ||
+            memcmp(current, s_sector + ofs, n) != 0)
+            return false;
+    }
+    return true;
+}
+#endif
+
+static bool ota_flash_write_sector(void)
+{
+#if OTA_FLASH_SKIP_UNCHANGED
+    if (ota_flash_sector_unchanged())
+    {
+        s_sectors_skipped++;
+    }
+    else
+#endif
+    {
+        esp_err_t err = esp_partition_erase_range(s_part, s_committed, OTA_FLASH_SECTOR_SIZE);
+        if (err == ESP_OK)
+            err = esp_partition_write(s_part, s_committed, s_sector, s_fill);
+        if (err != ESP_OK)
+            return ota_flash_fail(err);
+        s_sectors_written++;
+    }
+
+    mbedtls_sha256_update(&s_sha, s_sector, s_fill);
+    s_committed += s_fill;
+    s_fill = 0;
+    return true;
+}
+
+static void ota_flash_sha_reset(void)
+{
+    if (s_sha_active)
+        mbedtls_sha256_free(&s_sha);
+    mbedtls_sha256_init(&s_sha);
+    mbedtls_sha256_starts(&s_sha, 0);
+    s_sha_active = true;
+}
+
+bool ota_flash_begin(size_t image_size, size_t offset)
+{
+    s_part = esp_ota_get_next_update_partition(NULL);
+    s_image_size = image_size;
+    s_committed = 0;
+    s_fill = 0;
+    s_error = ESP_OK;
+    s_sectors_skipped = 0;
+    s_sectors_written = 0;
+
+    if (!s_part)
+        return ota_flash_fail(ESP_ERR_NOT_FOUND);
+    if (image_size > s_part->size || offset > image_size || offset % OTA_FLASH_SECTOR_SIZE != 0)
+        return ota_flash_fail(ESP_ERR_INVALID_SIZE);
+
+    // Resumed session: hash the part of the image that is already in flash
+    ota_flash_sha_reset();
+    for (size_t ofs = 0; ofs < offset; ofs += OTA_FLASH_SECTOR_SIZE)
+    {
+        esp_err_t err = esp_partition_read(s_part, ofs, s_sector, OTA_FLASH_SECTOR_SIZE);
+        if (err != ESP_OK)
+            return ota_flash_fail(err);
+        mbedtls_sha256_update(&s_sha, s_sector, OTA_FLASH_SECTOR_SIZE);
+    }
+
+    s_committed = offset;
+    return true;
+}
+
+size_t ota_flash_write(const uint8_t *data, size_t len)
+{
+    if (!s_part || s_error != ESP_OK)
+        return 0;
+    if (len > s_image_size - s_committed - s_fill)
+    {
+        ota_flash_fail(ESP_ERR_INVALID_SIZE);
+        return 0;
+    }
+
+    size_t done = 0;
+    while (done < len)
+    {
+        size_t n = len - done;
+        if (n > OTA_FLASH_SECTOR_SIZE - s_fill)
+            n = OTA_FLASH_SECTOR_SIZE - s_fill;
+
+        memcpy(s_sector + s_fill, data + done, n);
+        s_fill += n;
+        done += n;
+
+        if (s_fill == OTA_FLASH_SECTOR_SIZE && !ota_flash_write_sector())
+            return 0;
+    }
+    return len;
+}
+
+bool ota_flash_finish(uint8_t digest[32])
+{
+    if (!s_part || s_error != ESP_OK)
+        return false;
+    if (s_committed + s_fill != s_image_size)
+        return ota_flash_fail(ESP_ERR_INVALID_SIZE);
+    if (s_fill > 0 && !ota_flash_write_sector())
+        return false;
+
+    mbedtls_sha256_finish(&s_sha, digest);
+    return true;
+}
+
+bool ota_flash_activate(void)
+{
+    if (!s_part || s_error != ESP_OK || s_committed != s_image_size)
+        return false;
+
+    // Runs esp_image_verify() (segments + appended SHA-256) before switching
+    esp_err_t err = esp_ota_set_boot_partition(s_part);
+    if (err != ESP_OK)
+        return ota_flash_fail(err);
+    return true;
+}
+
+void ota_flash_abort(void)
+{
+    s_part = NULL;
+    s_fill = 0;
+}
+
+size_t ota_flash_committed(void)
+{
+    return s_committed;
+}
+
+bool ota_flash_failed(void)
+{
+    return s_error != ESP_OK;
+}
+
+size_t ota_flash_sectors_skipped(void)
+{
+    return s_sectors_skipped;
+}
+
+size_t ota_flash_sectors_written(void)
+{
+    return s_sectors_written;
+}
+
+esp_err_t ota_flash_error(void)
+{
+    return s_error;
+}
+
+const esp_partition_t *ota_flash_partition(void)
+{
+    return s_part;
+}
@@ -0,0 +1,51 @@
+/*
+  ============================================================================
+  OTA Flash Writer
+
+  Writes the OTA image straight into the next app partition, one sector at
+  a time (erase + program). Unlike Arduino's Update, a session can start at
+  any sector boundary, so an interrupted transfer can be resumed.
+  A SHA-256 of the image is kept up to date as each sector is written.
+  Sectors that already hold the incoming bytes are left untouched
+  (OTA_FLASH_SKIP_UNCHANGED), so re-flashing a similar image mostly reads.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <esp_err.h>
+#include <esp_partition.h>
+
+#define OTA_FLASH_SECTOR_SIZE 4096
+
+#ifndef OTA_FLASH_SKIP_UNCHANGED
+#define OTA_FLASH_SKIP_UNCHANGED 1 // Compare each sector with flash before erasing
+#endif
+#define OTA_FLASH_COMPARE_CHUNK 512
+
+// Target the next OTA partition. offset (sector aligned) = image bytes already in flash,
+// which are read back once to seed the running hash.
+bool ota_flash_begin(size_t image_size, size_t offset);
+
+// Sink for the writer task: returns len, or 0 on failure
+size_t ota_flash_write(const uint8_t *data, size_t len);
+
+// Write the last partial sector; digest = SHA-256 of the whole image
+bool ota_flash_finish(uint8_t digest[32]);
+
+// Select the finished image for boot (esp_ota_set_boot_partition also verifies it)
+bool ota_flash_activate(void);
+
+// Drop the session; sectors already written stay in flash
+void ota_flash_abort(void);
+
+// Image bytes durably in flash (sector aligned until the end)
+size_t ota_flash_committed(void);
+bool ota_flash_failed(void);
+// Sectors left as they were / erased and programmed in this session
+size_t ota_flash_sectors_skipped(void);
+size_t ota_flash_sectors_written(void);
+esp_err_t ota_flash_error(void);
+const esp_partition_t *ota_flash_partition(void);
@@ -0,0 +1,140 @@
+#include "ota_history.h"
+#include "config_store.h"
+
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#define OTA_HISTORY_KEY "ota_hist"
+
+// Indexed by ota_history_result_t; also the <code> of the matching ERROR:<code> status
+static const char *const s_result_names[OTA_HISTORY_RESULT_COUNT] = {
+    "RUNNING", "SUCCESS", "ABORTED", "SUSPENDED", "INTERRUPTED", "FAILED",
+    "BEGIN_FAILED", "OVERFLOW", "BUFFER_FULL", "WRITE_FAILED", "DECOMPRESS_FAILED",
+    "PATCH_FAILED", "HASH_MISMATCH", "SIGNATURE_INVALID", "END_FAILED",
+    "BAD_MAGIC", "WRONG_CHIP", "FLASH_SIZE", "TOO_LARGE", "BAD_SEGMENT",
+};
+
+static SemaphoreHandle_t s_lock = NULL;
+static ota_history_t s_history;
+static ota_history_record_t *s_open = NULL; // Record of the running session
+static uint32_t s_start_ms = 0;
+
+// Write the used part of the ring through (caller holds s_lock)
+static void ota_history_save(void)
+{
+    config_store_blob_put(OTA_HISTORY_KEY, &s_history,
+                          offsetof(ota_history_t, records) + s_history.count * sizeof(ota_history_record_t));
+}
+
+void ota_history_init(void)
+{
+    s_lock = xSemaphoreCreateMutex();
+
+    size_t len = config_store_blob_get(OTA_HISTORY_KEY, &s_history, sizeof(s_history));
+    if (len < offsetof(ota_history_t, records) || s_history.version != OTA_HISTORY_VERSION ||
+        s_history.record_size != sizeof(ota_history_record_t) || s_history.count > OTA_HISTORY_MAX ||
+        len != offsetof(ota_history_t, records) + s_history.count * sizeof(ota_history_record_t))
+    {
+        memset(&s_history, 0, sizeof(s_history));
+        s_history.version = OTA_HISTORY_VERSION;
+        s_history.record_size = sizeof(ota_history_record_t);
+        return;
+    }
+
+    // The last boot went down mid-session; saved with the next record
+    ota_history_record_t *last = s_history.count ? &s_history.records[s_history.count - 1] : NULL;
+    if (last && last->result == OTA_HISTORY_RUNNING)
+        last->result = OTA_HISTORY_INTERRUPTED;
+}
+
+void ota_history_begin(uint32_t start_ms, uint32_t image_size, uint32_t transfer_size, uint32_t offset,
+                       uint8_t flags)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_open)
+        s_open->result = OTA_HISTORY_INTERRUPTED;
+
+    if (s_history.count == OTA_HISTORY_MAX)
+    {
+        memmove(&s_history.records[0], &s_history.records[1], (OTA_HISTORY_MAX - 1) * sizeof(ota_history_record_t));
+        s_history.count--;
+    }
+
+    ota_history_record_t *rec = &s_history.records[s_history.count++];
+    memset(rec, 0, sizeof(*rec));
+    rec->seq = s_history.next_seq++;
+    rec->image_size = image_size;
+    rec->transfer_size = transfer_size;
+    rec->offset = offset;
+    for (int i = 0; i < OTA_PHASE_COUNT; i++)
+        rec->phase_ms[i] = OTA_HISTORY_NOT_REACHED;
+    rec->result = OTA_HISTORY_RUNNING;
+    rec->flags = flags;
+
+    s_open = rec;
+    s_start_ms = start_ms;
+    ota_history_save();
+    xSemaphoreGive(s_lock);
+}
+
+void ota_history_mark(ota_phase_t phase, uint32_t now_ms)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_open && s_open->phase_ms[phase] == OTA_HISTORY_NOT_REACHED)
+        s_open->phase_ms[phase] = now_ms - s_start_ms;
+    xSemaphoreGive(s_lock);
+}
+
+void ota_history_flag(uint8_t flags)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_open)
+        s_open->flags |= flags;
+    xSemaphoreGive(s_lock);
+}
+
+void ota_history_end(const char *status, uint32_t received)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    if (s_open)
+    {
+        s_open->result = ota_history_result(status);
+        s_open->received = received;
+        s_open = NULL;
+        ota_history_save();
+    }
+    xSemaphoreGive(s_lock);
+}
+
+uint8_t ota_history_result(const char *status)
+{
+    if (strncmp(status, "ERROR:", 6) == 0)
+        status += 6;
+
+    // Match the code up to its first ':' ("SUCCESS:SKIP=..." -> SUCCESS)
+    size_t len = strcspn(status, ":");
+    for (int i = OTA_HISTORY_SUCCESS; i < OTA_HISTORY_RESULT_COUNT; i++)
+    {
+        if (strlen(s_result_names[i]) == len && strncmp(status, s_result_names[i], len) == 0)
+            return i;
+    }
+    return OTA_HISTORY_FAILED;
+}
+
+const char *ota_history_result_name(uint8_t result)
+{
+    return result < OTA_HISTORY_RESULT_COUNT ? s_result_names[result] : "?";
+}
+
+size_t ota_history_serialize(uint8_t *out, size_t size)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    size_t len = offsetof(ota_history_t, records) + s_history.count * sizeof(ota_history_record_t);
+    if (len > size)
+        len = 0;
+    else
+        memcpy(out, &s_history, len);
+    xSemaphoreGive(s_lock);
+    return len;
+}
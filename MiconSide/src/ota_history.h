@@ -0,0 +1,118 @@
+/*
+  ============================================================================
+  OTA Session History
+
+  One record per OTA session (START to SUCCESS / error / abort / suspend),
+  kept for the last OTA_HISTORY_MAX sessions in the "ota_hist" blob of the
+  syscfg namespace. Each record has the sizes, the outcome and the time of
+  every phase after START, so a slow update in the field shows whether
+  the time went into setting up the session, the transfer, or the final
+  verification.
+
+  The record is written to NVS when the session opens and again when it
+  closes. A session that is still open at the next boot (reset or crash
+  mid-update) is reported as OTA_HISTORY_INTERRUPTED. The successful
+  record is written before the post-OTA reboot, so the new firmware
+  serves it.
+
+  The serialized history (ota_history_t, records oldest first) is the
+  value of the DebugOtaHist characteristic. Timestamps are passed in by
+  the caller, so the module does not depend on the Arduino clock.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_HISTORY_VERSION 1
+#define OTA_HISTORY_MAX 8                   // Records kept (44 bytes each)
+#define OTA_HISTORY_NOT_REACHED 0xffffffffu // Phase time of a phase the session never got to
+
+// Phase times are ms after START was received
+typedef enum
+{
+    OTA_PHASE_READY = 0,  // READY sent: checks, resume hashing and flash setup done
+    OTA_PHASE_FIRST_BYTE, // First transfer byte accepted
+    OTA_PHASE_LAST_BYTE,  // Whole transfer received
+    OTA_PHASE_END,        // END accepted
+    OTA_PHASE_DONE,       // Image verified and activated (before the reboot)
+    OTA_PHASE_COUNT,
+} ota_phase_t;
+
+// Outcome; the ERROR:<code> statuses map to the codes below (append only, the WebApp mirrors them)
+typedef enum
+{
+    OTA_HISTORY_RUNNING = 0,  // Session still open
+    OTA_HISTORY_SUCCESS,
+    OTA_HISTORY_ABORTED,      // ABORT from the client
+    OTA_HISTORY_SUSPENDED,    // Link lost or replaced by a new START; resumable
+    OTA_HISTORY_INTERRUPTED,  // Device reset with the session open
+    OTA_HISTORY_FAILED,       // ERROR:<code> without a code of its own
+    OTA_HISTORY_BEGIN_FAILED,
+    OTA_HISTORY_OVERFLOW,
+    OTA_HISTORY_BUFFER_FULL,
+    OTA_HISTORY_WRITE_FAILED,
+    OTA_HISTORY_DECOMPRESS_FAILED,
+    OTA_HISTORY_PATCH_FAILED,
+    OTA_HISTORY_HASH_MISMATCH,
+    OTA_HISTORY_SIGNATURE_INVALID,
+    OTA_HISTORY_END_FAILED,
+    OTA_HISTORY_BAD_MAGIC,
+    OTA_HISTORY_WRONG_CHIP,
+    OTA_HISTORY_FLASH_SIZE,
+    OTA_HISTORY_TOO_LARGE,
+    OTA_HISTORY_BAD_SEGMENT,
+    OTA_HISTORY_RESULT_COUNT,
+} ota_history_result_t;
+
+#define OTA_HISTORY_FLAG_DEFLATE 0x01 // Compressed transfer
+#define OTA_HISTORY_FLAG_PATCH 0x02   // Delta patch against the running app
+#define OTA_HISTORY_FLAG_RESUMED 0x04 // Started at a checkpoint (offset > 0)
+#define OTA_HISTORY_FLAG_WIFI 0x08    // Data went (partly) over the Wi-Fi transport
+
+typedef struct
+{
+    uint32_t seq;           // Session number, counts up across reboots
+    uint32_t image_size;    // Bytes of the image in flash
+    uint32_t transfer_size; // Bytes the client sends (compressed / patch size)
+    uint32_t offset;        // Image offset the session started at
+    uint32_t received;      // Transfer bytes received when the session closed
+    uint32_t phase_ms[OTA_PHASE_COUNT];
+    uint8_t result;         // ota_history_result_t
+    uint8_t flags;          // OTA_HISTORY_FLAG_*
+    uint16_t reserved;      // Keeps the blob free of padding
+} ota_history_record_t;
+
+typedef struct
+{
+    uint8_t version;      // OTA_HISTORY_VERSION
+    uint8_t count;        // Records in use
+    uint16_t record_size; // sizeof(ota_history_record_t), lets readers skip fields added later
+    uint32_t next_seq;
+    ota_history_record_t records[OTA_HISTORY_MAX]; // Oldest first
+} ota_history_t;
+
+// Load the history from NVS (call once from setup, after config_store_init)
+void ota_history_init(void);
+
+// Open a record for a session whose START arrived at start_ms (a record left open becomes INTERRUPTED)
+void ota_history_begin(uint32_t start_ms, uint32_t image_size, uint32_t transfer_size, uint32_t offset,
+                       uint8_t flags);
+
+// Record when the open session reached phase (first time only)
+void ota_history_mark(ota_phase_t phase, uint32_t now_ms);
+
+// Add OTA_HISTORY_FLAG_* bits to the open record
+void ota_history_flag(uint8_t flags);
+
+// Close the open record with the status sent to the client ("SUCCESS:...", "ABORTED", "ERROR:<code>", ...)
+void ota_history_end(const char *status, uint32_t received);
+
+// ERROR:<code> / SUCCESS / ABORTED / SUSPENDED -> ota_history_result_t
+uint8_t ota_history_result(const char *status);
+const char *ota_history_result_name(uint8_t result);
+
+// Copy the history (header + records in use) into out; returns the length, 0 if out is too small
+size_t ota_history_serialize(uint8_t *out, size_t size);
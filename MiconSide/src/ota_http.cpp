@@ -0,0 +1,140 @@
+#include "ota_http.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+
+void ota_http_begin(ota_http_request_t *req)
+{
+    memset(req, 0, sizeof(*req));
+    req->state = OTA_HTTP_REQUEST_LINE;
+}
+
+static void ota_http_fail(ota_http_request_t *req, uint16_t status)
+{
+    req->state = OTA_HTTP_ERROR;
+    req->status = status;
+}
+
+// Case-insensitive "Name:" match; returns the value with leading spaces skipped
+static const char *ota_http_header_value(const char *line, const char *name)
+{
+    size_t n = strlen(name);
+    for (size_t i = 0; i < n; i++)
+    {
+        if (tolower((unsigned char)line[i]) != name[i])
+            return NULL;
+    }
+    if (line[n] != ':')
+        return NULL;
+
+    const char *value = line + n + 1;
+    while (*value == ' ' || *value == '\t')
+        value++;
+    return value;
+}
+
+// "<METHOD> <path>[?query] HTTP/1.x"
+static void ota_http_request_line(ota_http_request_t *req, char *line)
+{
+    char *path = strchr(line, ' ');
+    char *version = path ? strchr(path + 1, ' ') : NULL;
+    if (!version || strncmp(version + 1, "HTTP/1.", 7) != 0)
+    {
+        ota_http_fail(req, 400);
+        return;
+    }
+    *path++ = '\0';
+    *version = '\0';
+
+    if (strcmp(line, "POST") == 0)
+        req->method = OTA_HTTP_METHOD_POST;
+    else if (strcmp(line, "OPTIONS") == 0)
+        req->method = OTA_HTTP_METHOD_OPTIONS;
+
+    size_t path_len = strcspn(path, "?");
+    if (path_len >= sizeof(req->path))
+    {
+        ota_http_fail(req, 414);
+        return;
+    }
+    memcpy(req->path, path, path_len);
+    req->path[path_len] = '\0';
+    req->state = OTA_HTTP_HEADERS;
+}
+
+static void ota_http_header(ota_http_request_t *req, const char *line)
+{
+    const char *value;
+    if ((value = ota_http_header_value(line, "content-length")) != NULL)
+    {
+        char *end;
+        unsigned long length = strtoul(value, &end, 10);
+        if (end == value || length > UINT32_MAX)
+        {
+            ota_http_fail(req, 400);
+            return;
+        }
+        req->content_length = (uint32_t)length;
+        req->has_length = true;
+    }
+    else if ((value = ota_http_header_value(line, "x-ota-token")) != NULL)
+    {
+        size_t len = strcspn(value, " \t");
+        if (len > OTA_HTTP_TOKEN_MAX)
+            len = OTA_HTTP_TOKEN_MAX;
+        memcpy(req->token, value, len);
+        req->token[len] = '\0';
+    }
+    else if ((value = ota_http_header_value(line, "transfer-encoding")) != NULL)
+    {
+        req->chunked = strstr(value, "chunked") != NULL;
+    }
+}
+
+static void ota_http_line_done(ota_http_request_t *req)
+{
+    size_t len = req->line_len;
+    if (len > 0 && req->line[len - 1] == '\r')
+        len--;
+    req->line[len] = '\0';
+    req->line_len = 0;
+
+    if (req->state == OTA_HTTP_REQUEST_LINE)
+    {
+        if (len > 0) // Tolerate blank lines before the request (RFC 9112 2.2)
+            ota_http_request_line(req, req->line);
+    }
+    else if (len == 0)
+    {
+        req->state = OTA_HTTP_BODY;
+    }
+    else
+    {
+        ota_http_header(req, req->line);
+    }
+}
+
+size_t ota_http_feed(ota_http_request_t *req, const uint8_t *data, size_t len)
+{
+    size_t i = 0;
+    while (i < len && (req->state == OTA_HTTP_REQUEST_LINE || req->state == OTA_HTTP_HEADERS))
+    {
+        if (++req->head_len > OTA_HTTP_HEAD_MAX)
+        {
+            ota_http_fail(req, 431);
+            break;
+        }
+
+        char c = (char)data[i++];
+        if (c == '\n')
+        {
+            ota_http_line_done(req);
+        }
+        else if (req->line_len < sizeof(req->line) - 1)
+        {
+            req->line[req->line_len++] = c;
+        }
+    }
+    return i;
+}
@@ -0,0 +1,58 @@
+/*
+  ============================================================================
+  OTA HTTP Request Parser
+
+  Incremental parser for the request head of the Wi-Fi OTA upload endpoint
+  (ota_net). Bytes are fed as they come off the socket; parsing stops at
+  the blank line that ends the headers and the caller streams the body
+  itself. Only what the endpoint needs is kept: method, path,
+  Content-Length and the X-OTA-Token header.
+  No Arduino / FreeRTOS dependency so it can be built on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_HTTP_LINE_MAX 128  // Longer header lines are truncated (only known names are read)
+#define OTA_HTTP_HEAD_MAX 4096 // Request line + headers
+#define OTA_HTTP_PATH_MAX 32
+#define OTA_HTTP_TOKEN_MAX 64
+
+typedef enum
+{
+    OTA_HTTP_REQUEST_LINE = 0,
+    OTA_HTTP_HEADERS,
+    OTA_HTTP_BODY,  // Head complete, the rest of the stream is the body
+    OTA_HTTP_ERROR, // Malformed; status holds the HTTP status to answer with
+} ota_http_state_t;
+
+typedef enum
+{
+    OTA_HTTP_METHOD_OTHER = 0,
+    OTA_HTTP_METHOD_POST,
+    OTA_HTTP_METHOD_OPTIONS, // CORS preflight from the WebApp
+} ota_http_method_t;
+
+typedef struct
+{
+    ota_http_state_t state;
+    uint16_t status;
+    ota_http_method_t method;
+    char path[OTA_HTTP_PATH_MAX];         // Without the query string
+    char token[OTA_HTTP_TOKEN_MAX + 1];   // X-OTA-Token, "" if absent
+    uint32_t content_length;
+    bool has_length;
+    bool chunked;                         // Transfer-Encoding: chunked (not supported)
+    char line[OTA_HTTP_LINE_MAX];
+    size_t line_len;
+    size_t head_len;
+} ota_http_request_t;
+
+void ota_http_begin(ota_http_request_t *req);
+
+// Parse up to len bytes of the head. Returns the bytes consumed; once the
+// state is OTA_HTTP_BODY, data + consumed is the start of the body.
+size_t ota_http_feed(ota_http_request_t *req, const uint8_t *data, size_t len);
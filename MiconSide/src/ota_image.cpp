@@ -0,0 +1,141 @@
+#include "ota_image.h"
+
+#include <string.h>
+
+static uint32_t ota_image_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static ota_image_result_t ota_image_fail(ota_image_check_t *c, ota_image_result_t result)
+{
+    c->result = result;
+    return result;
+}
+
+// Header complete: magic, chip and flash size
+static ota_image_result_t ota_image_check_header(ota_image_check_t *c)
+{
+    const uint8_t *h = c->header;
+    if (h[0] != OTA_IMAGE_MAGIC)
+        return ota_image_fail(c, OTA_IMAGE_BAD_MAGIC);
+
+    uint16_t chip_id = (uint16_t)(h[12] | (h[13] << 8));
+    if (chip_id != c->chip_id)
+        return ota_image_fail(c, OTA_IMAGE_WRONG_CHIP);
+
+    // spi_size nibble: 0 = 1MB, 1 = 2MB, 2 = 4MB, 3 = 8MB, 4 = 16MB ...
+    size_t header_flash_size = (size_t)(1024 * 1024) << (h[3] >> 4);
+    if (header_flash_size > c->flash_size)
+        return ota_image_fail(c, OTA_IMAGE_FLASH_SIZE);
+
+    if (h[1] == 0 || h[1] > OTA_IMAGE_MAX_SEGMENTS)
+        return ota_image_fail(c, OTA_IMAGE_BAD_SEGMENT);
+
+    c->segments_left = h[1];
+    c->end = OTA_IMAGE_HEADER_SIZE;
+    return OTA_IMAGE_OK;
+}
+
+// Segment header complete: its data must be word sized and fit in the image
+static ota_image_result_t ota_image_check_segment(ota_image_check_t *c)
+{
+    uint32_t data_len = ota_image_u32(c->seg_header + 4);
+    if (data_len % 4 != 0)
+        return ota_image_fail(c, OTA_IMAGE_BAD_SEGMENT);
+
+    c->end += OTA_IMAGE_SEGMENT_HEADER_SIZE + data_len;
+    if (c->end > c->image_size)
+        return ota_image_fail(c, OTA_IMAGE_TOO_LARGE);
+
+    c->seg_remaining = data_len;
+    c->seg_fill = 0;
+    c->segments_left--;
+
+    // Checksum byte padded to 16 bytes, then the optional appended SHA-256
+    if (c->segments_left == 0)
+    {
+        size_t total = (c->end | 15) + 1 + (c->header[23] ? 32 : 0);
+        if (total > c->image_size)
+            return ota_image_fail(c, OTA_IMAGE_TOO_LARGE);
+        c->done = true;
+    }
+    return OTA_IMAGE_OK;
+}
+
+void ota_image_check_begin(ota_image_check_t *c, size_t image_size, uint16_t chip_id, size_t flash_size)
+{
+    memset(c, 0, sizeof(*c));
+    c->image_size = image_size;
+    c->chip_id = chip_id;
+    c->flash_size = flash_size;
+    c->result = OTA_IMAGE_OK;
+}
+
+void ota_image_check_skip(ota_image_check_t *c)
+{
+    memset(c, 0, sizeof(*c));
+    c->done = true;
+}
+
+ota_image_result_t ota_image_check_feed(ota_image_check_t *c, const uint8_t *data, size_t len)
+{
+    while (c->result == OTA_IMAGE_OK && !c->done && len > 0)
+    {
+        if (c->pos < OTA_IMAGE_HEADER_SIZE)
+        {
+            size_t n = OTA_IMAGE_HEADER_SIZE - c->pos;
+            if (n > len)
+                n = len;
+            memcpy(c->header + c->pos, data, n);
+            c->pos += n;
+            data += n;
+            len -= n;
+
+            if (c->pos == OTA_IMAGE_HEADER_SIZE)
+                ota_image_check_header(c);
+        }
+        else if (c->seg_remaining > 0)
+        {
+            size_t n = c->seg_remaining < len ? c->seg_remaining : len;
+            c->seg_remaining -= n;
+            c->pos += n;
+            data += n;
+            len -= n;
+        }
+        else
+        {
+            size_t n = OTA_IMAGE_SEGMENT_HEADER_SIZE - c->seg_fill;
+            if (n > len)
+                n = len;
+            memcpy(c->seg_header + c->seg_fill, data, n);
+            c->seg_fill += n;
+            c->pos += n;
+            data += n;
+            len -= n;
+
+            if (c->seg_fill == OTA_IMAGE_SEGMENT_HEADER_SIZE)
+                ota_image_check_segment(c);
+        }
+    }
+    return c->result;
+}
+
+const char *ota_image_result_status(ota_image_result_t result)
+{
+    switch (result)
+    {
+    case OTA_IMAGE_BAD_MAGIC:
+        return "ERROR:BAD_MAGIC";
+    case OTA_IMAGE_WRONG_CHIP:
+        return "ERROR:WRONG_CHIP";
+    case OTA_IMAGE_FLASH_SIZE:
+        return "ERROR:FLASH_SIZE";
+    case OTA_IMAGE_TOO_LARGE:
+        return "ERROR:TOO_LARGE";
+    case OTA_IMAGE_BAD_SEGMENT:
+        return "ERROR:BAD_SEGMENT";
+    default:
+        return "ERROR:WRITE_FAILED";
+    }
+}
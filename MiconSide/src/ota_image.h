@@ -0,0 +1,57 @@
+/*
+  ============================================================================
+  OTA Image Header Check
+
+  Parses the ESP app image header and segment table from the image bytes
+  as they stream to flash, so a wrong-chip or oversized image is rejected
+  on its first sector instead of after the whole transfer.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_IMAGE_MAGIC 0xE9
+#define OTA_IMAGE_HEADER_SIZE 24 // esp_image_header_t
+#define OTA_IMAGE_SEGMENT_HEADER_SIZE 8
+#define OTA_IMAGE_MAX_SEGMENTS 16
+
+typedef enum
+{
+    OTA_IMAGE_OK = 0,
+    OTA_IMAGE_BAD_MAGIC,   // Not an app image
+    OTA_IMAGE_WRONG_CHIP,  // Built for another chip
+    OTA_IMAGE_FLASH_SIZE,  // Header flash size larger than the chip
+    OTA_IMAGE_TOO_LARGE,   // Segments extend past the declared image size
+    OTA_IMAGE_BAD_SEGMENT, // Segment count/length invalid
+} ota_image_result_t;
+
+typedef struct
+{
+    size_t image_size;
+    uint16_t chip_id;
+    size_t flash_size;
+    size_t pos; // Image bytes seen
+    uint8_t header[OTA_IMAGE_HEADER_SIZE];
+    uint8_t seg_header[OTA_IMAGE_SEGMENT_HEADER_SIZE];
+    size_t seg_fill;
+    uint8_t segments_left;
+    size_t seg_remaining; // Data bytes left in the current segment
+    size_t end;           // Image length implied by the segment table so far
+    bool done;            // Segment table fully parsed
+    ota_image_result_t result;
+} ota_image_check_t;
+
+// chip_id: esp_chip_id_t of this chip, flash_size: physical flash size in bytes
+void ota_image_check_begin(ota_image_check_t *c, size_t image_size, uint16_t chip_id, size_t flash_size);
+
+// Skip checking (resumed session: the header was checked when it was first written)
+void ota_image_check_skip(ota_image_check_t *c);
+
+// Feed the next image bytes; returns the first failure (sticky)
+ota_image_result_t ota_image_check_feed(ota_image_check_t *c, const uint8_t *data, size_t len);
+
+// OtaStatus error for a failed check
+const char *ota_image_result_status(ota_image_result_t result);
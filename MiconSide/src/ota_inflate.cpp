@@ -0,0 +1,63 @@
+#include "ota_inflate.h"
+
+void ota_inflate_begin(ota_inflate_t *z, tinfl_decompressor *decomp, uint8_t *dict)
+{
+    z->decomp = decomp;
+    z->dict = dict;
+    z->dict_ofs = 0;
+    z->total_out = 0;
+    z->done = false;
+    z->failed = false;
+    tinfl_init(z->decomp);
+}
+
+bool ota_inflate_write(ota_inflate_t *z, const uint8_t *in, size_t in_len, ota_inflate_out_fn out)
+{
+    if (z->failed)
+        return false;
+
+    for (;;)
+    {
+        if (z->done)
+        {
+            // Trailing bytes after the end of the stream are not allowed
+            z->failed = in_len > 0;
+            return !z->failed;
+        }
+
+        size_t in_bytes = in_len;
+        size_t out_bytes = TINFL_LZ_DICT_SIZE - z->dict_ofs;
+        tinfl_status status = tinfl_decompress(z->decomp, in, &in_bytes,
+                                               z->dict, z->dict + z->dict_ofs, &out_bytes,
+                                               TINFL_FLAG_PARSE_ZLIB_HEADER | TINFL_FLAG_HAS_MORE_INPUT);
+        in += in_bytes;
+        in_len -= in_bytes;
+
+        if (out_bytes > 0)
+        {
+            if (out(z->dict + z->dict_ofs, out_bytes) != out_bytes)
+            {
+                z->failed = true;
+                return false;
+            }
+            z->dict_ofs = (z->dict_ofs + out_bytes) & (TINFL_LZ_DICT_SIZE - 1);
+            z->total_out += out_bytes;
+        }
+
+        if (status < TINFL_STATUS_DONE)
+        {
+            z->failed = true;
+            return false;
+        }
+
+        if (status == TINFL_STATUS_DONE)
+        {
+            z->done = true;
+        }
+        else if (status == TINFL_STATUS_NEEDS_MORE_INPUT && in_len == 0)
+        {
+            return true;
+        }
+        // TINFL_STATUS_HAS_MORE_OUTPUT: dictionary wrapped, keep draining
+    }
+}
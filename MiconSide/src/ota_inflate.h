@@ -0,0 +1,39 @@
+/*
+  ============================================================================
+  OTA Streaming Decompressor
+
+  Bounded-memory zlib/deflate stream decoder (miniz tinfl, in ROM on the
+  ESP32-S3) used between the OTA receive ring and the flash sink.
+  Memory: one tinfl_decompressor (~11 KB) + a 32 KB circular dictionary.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef ESP_PLATFORM
+#include "rom/miniz.h"
+#else
+#include "miniz.h"
+#endif
+
+// Receives decompressed bytes, returns bytes consumed (short = failure)
+typedef size_t (*ota_inflate_out_fn)(const uint8_t *data, size_t len);
+
+typedef struct
+{
+    tinfl_decompressor *decomp;
+    uint8_t *dict; // TINFL_LZ_DICT_SIZE bytes, used as a ring
+    size_t dict_ofs;
+    size_t total_out;
+    bool done;   // End of the deflate stream was reached
+    bool failed; // Corrupt stream or sink failure
+} ota_inflate_t;
+
+// Attach caller-provided storage (decomp + TINFL_LZ_DICT_SIZE dict) and reset
+void ota_inflate_begin(ota_inflate_t *z, tinfl_decompressor *decomp, uint8_t *dict);
+
+// Feed compressed input; decompressed output is passed to out as it is produced
+bool ota_inflate_write(ota_inflate_t *z, const uint8_t *in, size_t in_len, ota_inflate_out_fn out);
@@ -0,0 +1,117 @@
+#include "ota_net.h"
+#include "ota_pipeline.h"
+
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <stdio.h>
+
+#define OTA_NET_TASK_STACK 4096
+#define OTA_NET_TASK_PRIORITY 1 // Same as loopTask, below the flash writer
+#define OTA_NET_TASK_CORE 1     // Keep core 0 free for the BLE stack
+
+static ota_net_closed_fn s_on_closed = NULL;
+static ota_net_server_ops_t s_ops;
+static ota_net_server_t s_server;
+static TaskHandle_t s_task = NULL;
+static SemaphoreHandle_t s_lock = NULL; // Stats
+static SemaphoreHandle_t s_idle = NULL; // Given when the task stopped serving
+static volatile bool s_active = false;
+static ota_net_stats_t s_stats;
+
+static int64_t ota_net_now_ms(void)
+{
+    return esp_timer_get_time() / 1000;
+}
+
+static void ota_net_task(void *arg)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        ota_net_result_t result = ota_net_server_run(&s_server);
+        bool closed_by_owner = s_server.closing;
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        s_stats.auth_failures += s_server.auth_failures;
+        if (result == OTA_NET_COMPLETE)
+        {
+            s_stats.uploads++;
+            s_stats.bytes += s_server.received;
+            s_stats.last_bytes = s_server.received;
+            s_stats.last_ms = s_server.upload_ms;
+        }
+        xSemaphoreGive(s_lock);
+
+        // Give before clearing s_active: ota_net_open() drops a completion nobody waited for
+        xSemaphoreGive(s_idle);
+        s_active = false;
+
+        if (!closed_by_owner && s_on_closed)
+            s_on_closed(result);
+    }
+}
+
+bool ota_net_init(ota_net_received_fn on_received, ota_net_closed_fn on_closed)
+{
+    s_ops.push = ota_pipeline_push;
+    s_ops.sink_failed = ota_pipeline_failed;
+    s_ops.received = on_received;
+    s_ops.now_ms = ota_net_now_ms;
+    s_on_closed = on_closed;
+    s_lock = xSemaphoreCreateMutex();
+    s_idle = xSemaphoreCreateBinary();
+    if (!s_lock || !s_idle)
+        return false;
+
+    return xTaskCreatePinnedToCore(ota_net_task, "ota_net", OTA_NET_TASK_STACK, NULL,
+                                   OTA_NET_TASK_PRIORITY, &s_task, OTA_NET_TASK_CORE) == pdPASS;
+}
+
+bool ota_net_open(size_t length, char token_hex[OTA_NET_TOKEN_SIZE * 2 + 1])
+{
+    if (s_active || !s_task)
+        return false;
+
+    int fd = ota_net_server_listen(OTA_NET_PORT);
+    if (fd < 0)
+        return false;
+
+    uint8_t token[OTA_NET_TOKEN_SIZE];
+    esp_fill_random(token, sizeof(token));
+    for (size_t i = 0; i < sizeof(token); i++)
+        snprintf(token_hex + i * 2, 3, "%02x", token[i]);
+
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    s_stats.sessions++;
+    xSemaphoreGive(s_lock);
+
+    ota_net_server_begin(&s_server, &s_ops, fd, length, token);
+    xSemaphoreTake(s_idle, 0);
+    s_active = true;
+    xTaskNotifyGive(s_task);
+    return true;
+}
+
+void ota_net_close(void)
+{
+    if (!s_active)
+        return;
+    ota_net_server_close(&s_server);
+    xSemaphoreTake(s_idle, pdMS_TO_TICKS(OTA_NET_CLOSE_TIMEOUT_MS));
+}
+
+bool ota_net_active(void)
+{
+    return s_active;
+}
+
+void ota_net_get_stats(ota_net_stats_t *out)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_stats;
+    xSemaphoreGive(s_lock);
+}
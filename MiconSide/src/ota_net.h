@@ -0,0 +1,62 @@
+/*
+  ============================================================================
+  OTA Wi-Fi Transport
+
+  Optional data path for a BLE OTA session. After START has set up the
+  session over BLE, the WIFI command opens a one-shot HTTP endpoint on the
+  station interface and hands out a random token; the client POSTs the
+  rest of the transfer (the same bytes it would write to OtaData) to
+  http://<ip>:OTA_NET_PORT/ota with an X-OTA-Token header, and the body
+  is streamed into the OTA write pipeline. TCP flow control replaces the
+  BLE ACK window: the socket is read only as fast as the ring drains.
+
+  BLE stays the control channel: SIG / END / ABORT and every status still
+  go through OtaControl / OtaStatus. The token is good for one upload;
+  the endpoint closes after it, after OTA_NET_ACCEPT_TIMEOUT_MS without
+  one, or after OTA_NET_MAX_AUTH_FAILURES bad tokens.
+
+  This file is the device glue: the transport task, the random token,
+  the OTA pipeline and the stats. Sockets and HTTP are in ota_net_server,
+  which has no platform dependency and is tested on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include "ota_net_server.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_NET_PORT 8032
+#define OTA_NET_CLOSE_TIMEOUT_MS 2000     // ota_net_close(): wait for the task to let go of the pipeline
+
+typedef struct
+{
+    uint32_t sessions;      // Endpoints opened
+    uint32_t uploads;       // Authorized uploads completed
+    uint32_t auth_failures; // Requests with a missing / wrong token
+    uint32_t bytes;         // Body bytes queued, all sessions
+    uint32_t last_bytes;
+    uint32_t last_ms;       // Last upload: first body byte -> last body byte
+} ota_net_stats_t;
+
+// Called from the transport task after len more body bytes were queued
+typedef void (*ota_net_received_fn)(size_t len);
+// Called from the transport task when the endpoint closed by itself (not via ota_net_close())
+typedef void (*ota_net_closed_fn)(ota_net_result_t result);
+
+// Start the transport task (call once from setup, after ota_pipeline_init)
+bool ota_net_init(ota_net_received_fn on_received, ota_net_closed_fn on_closed);
+
+// Listen on OTA_NET_PORT for one upload of exactly length bytes.
+// Writes the token as hex into token_hex. False if already open or the socket failed.
+bool ota_net_open(size_t length, char token_hex[OTA_NET_TOKEN_SIZE * 2 + 1]);
+
+// Close the endpoint and wait until the task no longer touches the pipeline
+void ota_net_close(void);
+
+// Endpoint open (BLE OtaData must not write to the pipeline meanwhile)
+bool ota_net_active(void);
+
+void ota_net_get_stats(ota_net_stats_t *out);
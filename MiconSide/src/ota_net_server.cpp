@@ -0,0 +1,249 @@
+#include "ota_net_server.h"
+#include "ota_http.h"
+#include "ota_verify.h"
+
+#ifdef ESP_PLATFORM
+#include <lwip/sockets.h>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+#endif
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#ifndef MSG_NOSIGNAL
+#define MSG_NOSIGNAL 0 // lwIP has no SIGPIPE
+#endif
+
+#define OTA_NET_NEXT -1 // ota_net_server_serve(): keep listening
+
+static size_t ota_net_min(size_t a, size_t b)
+{
+    return a < b ? a : b;
+}
+
+// Every answer closes the connection; the CORS headers let the WebApp read it
+static void ota_net_server_reply(int fd, uint16_t status, const char *reason, const char *body)
+{
+    char response[384];
+    int len = snprintf(response, sizeof(response),
+                       "HTTP/1.1 %u %s\r\n"
+                       "Access-Control-Allow-Origin: *\r\n"
+                       "Access-Control-Allow-Methods: POST, OPTIONS\r\n"
+                       "Access-Control-Allow-Headers: Content-Type, X-OTA-Token\r\n"
+                       "Access-Control-Allow-Private-Network: true\r\n"
+                       "Content-Type: text/plain\r\n"
+                       "Content-Length: %u\r\n"
+                       "Connection: close\r\n"
+                       "\r\n%s",
+                       status, reason, (unsigned)strlen(body), body);
+    send(fd, response, ota_net_min(len, sizeof(response) - 1), MSG_NOSIGNAL);
+}
+
+// Wait until fd is readable; false on timeout, error or close request
+static bool ota_net_server_wait(ota_net_server_t *srv, int fd, int64_t deadline_ms)
+{
+    while (!srv->closing)
+    {
+        int64_t left = deadline_ms - srv->ops->now_ms();
+        if (left <= 0)
+            return false;
+
+        fd_set fds;
+        FD_ZERO(&fds);
+        FD_SET(fd, &fds);
+        struct timeval tv = {0, (long)(left < OTA_NET_POLL_MS ? left : OTA_NET_POLL_MS) * 1000};
+        int n = select(fd + 1, &fds, NULL, NULL, &tv);
+        if (n != 0)
+            return n > 0;
+    }
+    return false;
+}
+
+// Queue in short slices so a close is noticed while the sink is full
+static bool ota_net_server_push(ota_net_server_t *srv, const uint8_t *data, size_t len)
+{
+    int64_t deadline = srv->ops->now_ms() + srv->idle_timeout_ms;
+    while (!srv->ops->push(data, len, OTA_NET_POLL_MS))
+    {
+        if (srv->closing || srv->ops->sink_failed() || srv->ops->now_ms() >= deadline)
+            return false;
+    }
+    return true;
+}
+
+// Stream the body into the sink; buffered bytes of it are already in rx
+static ota_net_result_t ota_net_server_receive(ota_net_server_t *srv, int fd, size_t buffered)
+{
+    int64_t start_ms = srv->ops->now_ms();
+    for (;;)
+    {
+        // Anything past Content-Length is ignored
+        size_t take = ota_net_min(buffered, srv->length - srv->received);
+        if (take > 0)
+        {
+            if (!ota_net_server_push(srv, srv->rx, take))
+            {
+                ota_net_server_reply(fd, 500, "Internal Server Error", "WRITE_FAILED");
+                return OTA_NET_FAILED;
+            }
+            srv->received += take;
+            srv->ops->received(take);
+        }
+        if (srv->received == srv->length)
+            break;
+
+        if (!ota_net_server_wait(srv, fd, srv->ops->now_ms() + srv->idle_timeout_ms))
+            return srv->closing ? OTA_NET_FAILED : OTA_NET_TIMEOUT;
+        ssize_t got = recv(fd, srv->rx, ota_net_min(sizeof(srv->rx), srv->length - srv->received), 0);
+        if (got <= 0)
+            return OTA_NET_FAILED;
+        buffered = (size_t)got;
+    }
+    srv->upload_ms = (uint32_t)(srv->ops->now_ms() - start_ms);
+
+    char body[32];
+    snprintf(body, sizeof(body), "RECEIVED:%u", (unsigned)srv->received);
+    ota_net_server_reply(fd, 200, "OK", body);
+    return OTA_NET_COMPLETE;
+}
+
+// One connection: OTA_NET_NEXT unless it used up the token (or the last try)
+static int ota_net_server_serve(ota_net_server_t *srv, int fd)
+{
+    ota_http_request_t req;
+    ota_http_begin(&req);
+    size_t buffered = 0;
+    int64_t deadline = srv->ops->now_ms() + srv->idle_timeout_ms;
+    while (req.state == OTA_HTTP_REQUEST_LINE || req.state == OTA_HTTP_HEADERS)
+    {
+        if (!ota_net_server_wait(srv, fd, deadline))
+            return srv->closing ? OTA_NET_FAILED : OTA_NET_NEXT;
+        ssize_t got = recv(fd, srv->rx, sizeof(srv->rx), 0);
+        if (got <= 0)
+            return OTA_NET_NEXT;
+        size_t used = ota_http_feed(&req, srv->rx, (size_t)got);
+        buffered = (size_t)got - used;
+        memmove(srv->rx, srv->rx + used, buffered); // Start of the body
+    }
+
+    if (req.state == OTA_HTTP_ERROR)
+    {
+        ota_net_server_reply(fd, req.status, "Bad Request", "BAD_REQUEST");
+        return OTA_NET_NEXT;
+    }
+    if (req.method == OTA_HTTP_METHOD_OPTIONS)
+    {
+        ota_net_server_reply(fd, 204, "No Content", "");
+        return OTA_NET_NEXT;
+    }
+    if (strcmp(req.path, "/ota") != 0)
+    {
+        ota_net_server_reply(fd, 404, "Not Found", "NOT_FOUND");
+        return OTA_NET_NEXT;
+    }
+    if (req.method != OTA_HTTP_METHOD_POST)
+    {
+        ota_net_server_reply(fd, 405, "Method Not Allowed", "METHOD_NOT_ALLOWED");
+        return OTA_NET_NEXT;
+    }
+
+    uint8_t token[OTA_NET_TOKEN_SIZE];
+    if (!ota_verify_hex_decode(req.token, token, sizeof(token)) ||
+        !ota_verify_equal(token, srv->token, sizeof(token)))
+    {
+        ota_net_server_reply(fd, 401, "Unauthorized", "BAD_TOKEN");
+        return ++srv->auth_failures >= OTA_NET_MAX_AUTH_FAILURES ? OTA_NET_DENIED : OTA_NET_NEXT;
+    }
+
+    // The token is spent from here on: one upload per session
+    if (!req.has_length || req.chunked || req.content_length != srv->length)
+    {
+        char body[32];
+        snprintf(body, sizeof(body), "LENGTH:%u", (unsigned)srv->length);
+        ota_net_server_reply(fd, 400, "Bad Request", body);
+        return OTA_NET_FAILED;
+    }
+    return ota_net_server_receive(srv, fd, buffered);
+}
+
+int ota_net_server_listen(uint16_t port)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (fd < 0)
+        return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (bind(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(fd, 1) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+uint16_t ota_net_server_port(int fd)
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(addr);
+    if (getsockname(fd, (struct sockaddr *)&addr, &len) != 0)
+        return 0;
+    return ntohs(addr.sin_port);
+}
+
+void ota_net_server_begin(ota_net_server_t *srv, const ota_net_server_ops_t *ops, int listen_fd,
+                          size_t length, const uint8_t token[OTA_NET_TOKEN_SIZE])
+{
+    srv->ops = ops;
+    srv->listen_fd = listen_fd;
+    memcpy(srv->token, token, OTA_NET_TOKEN_SIZE);
+    srv->length = length;
+    srv->accept_timeout_ms = OTA_NET_ACCEPT_TIMEOUT_MS;
+    srv->idle_timeout_ms = OTA_NET_IDLE_TIMEOUT_MS;
+    srv->closing = false;
+    srv->auth_failures = 0;
+    srv->received = 0;
+    srv->upload_ms = 0;
+}
+
+ota_net_result_t ota_net_server_run(ota_net_server_t *srv)
+{
+    ota_net_result_t result;
+    int64_t deadline = srv->ops->now_ms() + srv->accept_timeout_ms;
+    for (;;)
+    {
+        if (!ota_net_server_wait(srv, srv->listen_fd, deadline))
+        {
+            result = srv->closing ? OTA_NET_FAILED : OTA_NET_TIMEOUT;
+            break;
+        }
+
+        int fd = accept(srv->listen_fd, NULL, NULL);
+        if (fd < 0)
+            continue;
+        int served = ota_net_server_serve(srv, fd);
+        close(fd);
+        if (served != OTA_NET_NEXT)
+        {
+            result = (ota_net_result_t)served;
+            break;
+        }
+    }
+
+    close(srv->listen_fd);
+    srv->listen_fd = -1;
+    return result;
+}
+
+void ota_net_server_close(ota_net_server_t *srv)
+{
+    srv->closing = true;
+}
@@ -0,0 +1,78 @@
+/*
+  ============================================================================
+  OTA Wi-Fi Upload Server
+
+  Socket and HTTP side of the Wi-Fi OTA transport (ota_net): accepts
+  connections on the listening socket, answers CORS preflights, checks
+  the X-OTA-Token header and streams exactly the expected number of body
+  bytes into the caller's push() (the OTA pipeline on the device). The
+  caller runs ota_net_server_run() on its own task / thread; another one
+  may stop it with ota_net_server_close().
+
+  BSD sockets only (lwIP on the device), no Arduino / FreeRTOS
+  dependency, so it is tested against a loopback client on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+#define OTA_NET_TOKEN_SIZE 16             // Random bytes; sent as hex
+#define OTA_NET_ACCEPT_TIMEOUT_MS 30000   // Endpoint open without an authorized upload
+#define OTA_NET_IDLE_TIMEOUT_MS 10000     // No data from the client mid-upload
+#define OTA_NET_MAX_AUTH_FAILURES 3
+#define OTA_NET_POLL_MS 100               // select() / push slice: how fast a close is noticed
+#define OTA_NET_RX_SIZE 2048
+
+typedef enum
+{
+    OTA_NET_COMPLETE = 0, // Whole body queued in the pipeline
+    OTA_NET_FAILED,       // Client dropped, bad request or pipeline error
+    OTA_NET_TIMEOUT,      // No upload in time, or the client stalled
+    OTA_NET_DENIED,       // Too many bad tokens
+} ota_net_result_t;
+
+typedef struct
+{
+    // Queue body bytes; false if there was no room within timeout_ms (retried)
+    bool (*push)(const uint8_t *data, size_t len, uint32_t timeout_ms);
+    bool (*sink_failed)(void);    // Stops the retries: the upload fails
+    void (*received)(size_t len); // After len more body bytes were queued
+    int64_t (*now_ms)(void);      // Monotonic milliseconds
+} ota_net_server_ops_t;
+
+typedef struct
+{
+    const ota_net_server_ops_t *ops;
+    int listen_fd;
+    uint8_t token[OTA_NET_TOKEN_SIZE];
+    size_t length;              // Expected body size
+    uint32_t accept_timeout_ms; // Defaults from ota_net_server_begin()
+    uint32_t idle_timeout_ms;
+    std::atomic<bool> closing;
+    // Outcome, valid once ota_net_server_run() returned
+    uint8_t auth_failures;
+    size_t received;
+    uint32_t upload_ms; // First body byte -> last body byte
+    uint8_t rx[OTA_NET_RX_SIZE];
+} ota_net_server_t;
+
+// Listening TCP socket on port (0 = any free port), or -1
+int ota_net_server_listen(uint16_t port);
+
+// Port a socket is bound to (0 on error)
+uint16_t ota_net_server_port(int fd);
+
+// Prepare one session on listen_fd (owned by the server from here on)
+void ota_net_server_begin(ota_net_server_t *srv, const ota_net_server_ops_t *ops, int listen_fd,
+                          size_t length, const uint8_t token[OTA_NET_TOKEN_SIZE]);
+
+// Serve connections until one upload completed, failed or timed out, or
+// too many bad tokens were sent; closes the listening socket
+ota_net_result_t ota_net_server_run(ota_net_server_t *srv);
+
+// Ask a running ota_net_server_run() to stop (it returns within OTA_NET_POLL_MS)
+void ota_net_server_close(ota_net_server_t *srv);
@@ -0,0 +1,157 @@
+#include "ota_patch.h"
+
+#include <string.h>
+
+#define OTA_PATCH_HEADER_SIZE 8
+
+static const uint8_t OTA_PATCH_MAGIC[4] = {'O', 'D', 'P', '1'};
+
+static uint32_t ota_patch_u32(const uint8_t *p)
+{
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+static bool ota_patch_fail(ota_patch_t *p)
+{
+    p->failed = true;
+    return false;
+}
+
+static bool ota_patch_emit(ota_patch_t *p, const uint8_t *data, size_t len, ota_patch_out_fn out)
+{
+    if (out(data, len) != len)
+        return ota_patch_fail(p);
+    p->total_out += len;
+    return true;
+}
+
+// Header or op fields are complete: validate them and start the op
+static bool ota_patch_start_op(ota_patch_t *p)
+{
+    p->field_len = 0;
+
+    if (!p->have_header)
+    {
+        if (memcmp(p->field, OTA_PATCH_MAGIC, sizeof(OTA_PATCH_MAGIC)) != 0)
+            return ota_patch_fail(p);
+        p->target_size = ota_patch_u32(p->field + 4);
+        p->have_header = true;
+        return true;
+    }
+
+    p->op = p->field[0];
+    if (p->op == OTA_PATCH_OP_INSERT)
+    {
+        p->base_ofs = 0;
+        p->remaining = ota_patch_u32(p->field + 1);
+    }
+    else
+    {
+        p->base_ofs = ota_patch_u32(p->field + 1);
+        p->remaining = ota_patch_u32(p->field + 5);
+        if (p->base_ofs > p->base_size || p->remaining > p->base_size - p->base_ofs)
+            return ota_patch_fail(p);
+    }
+
+    if (p->remaining > p->target_size - p->total_out)
+        return ota_patch_fail(p);
+
+    p->in_op = p->remaining > 0;
+    return true;
+}
+
+void ota_patch_begin(ota_patch_t *p, ota_patch_read_fn read_base, size_t base_size)
+{
+    p->read_base = read_base;
+    p->base_size = base_size;
+    p->target_size = 0;
+    p->total_out = 0;
+    p->field_len = 0;
+    p->field_need = OTA_PATCH_HEADER_SIZE;
+    p->have_header = false;
+    p->op = 0;
+    p->base_ofs = 0;
+    p->remaining = 0;
+    p->in_op = false;
+    p->failed = false;
+}
+
+bool ota_patch_write(ota_patch_t *p, const uint8_t *in, size_t in_len, ota_patch_out_fn out)
+{
+    if (p->failed)
+        return false;
+
+    for (;;)
+    {
+        if (p->in_op)
+        {
+            // COPY needs no input; ADD/INSERT consume patch data
+            if (p->op != OTA_PATCH_OP_COPY && in_len == 0)
+                return true;
+
+            size_t n = p->remaining < OTA_PATCH_BASE_CHUNK ? p->remaining : OTA_PATCH_BASE_CHUNK;
+            if (p->op != OTA_PATCH_OP_COPY && n > in_len)
+                n = in_len;
+
+            if (p->op == OTA_PATCH_OP_INSERT)
+            {
+                if (!ota_patch_emit(p, in, n, out))
+                    return false;
+            }
+            else
+            {
+                if (!p->read_base(p->base_ofs, p->buf, n))
+                    return ota_patch_fail(p);
+                if (p->op == OTA_PATCH_OP_ADD)
+                {
+                    for (size_t i = 0; i < n; i++)
+                        p->buf[i] += in[i];
+                }
+                if (!ota_patch_emit(p, p->buf, n, out))
+                    return false;
+                p->base_ofs += n;
+            }
+
+            if (p->op != OTA_PATCH_OP_COPY)
+            {
+                in += n;
+                in_len -= n;
+            }
+            p->remaining -= n;
+            p->in_op = p->remaining > 0;
+            continue;
+        }
+
+        if (in_len == 0)
+            return true;
+
+        p->field[p->field_len++] = *in++;
+        in_len--;
+
+        // First byte of an op selects its field length
+        if (p->have_header && p->field_len == 1)
+        {
+            switch (p->field[0])
+            {
+            case OTA_PATCH_OP_COPY:
+            case OTA_PATCH_OP_ADD:
+                p->field_need = 9;
+                break;
+            case OTA_PATCH_OP_INSERT:
+                p->field_need = 5;
+                break;
+            default:
+                return ota_patch_fail(p);
+            }
+        }
+
+        if (p->field_len == p->field_need && !ota_patch_start_op(p))
+            return false;
+    }
+}
+
+bool ota_patch_complete(const ota_patch_t *p)
+{
+    return p->have_header && !p->failed && !p->in_op && p->field_len == 0 &&
+           p->total_out == p->target_size;
+}
@@ -0,0 +1,56 @@
+/*
+  ============================================================================
+  OTA Delta Patch Applier
+
+  Rebuilds the new image from the running app partition plus a patch
+  stream, one op at a time, so only the patch travels over BLE.
+
+  Patch format (all integers u32 little-endian):
+    header : "ODP1" <target_size>
+    COPY   : 0x01 <base_offset> <len>          -> base[offset .. offset+len)
+    ADD    : 0x02 <base_offset> <len> <len B>  -> base[offset + i] + data[i]
+    INSERT : 0x03 <len> <len B>                -> data
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_PATCH_OP_COPY 0x01
+#define OTA_PATCH_OP_ADD 0x02
+#define OTA_PATCH_OP_INSERT 0x03
+
+#define OTA_PATCH_BASE_CHUNK 512 // Base bytes read per step
+
+// Reads len bytes of the base image at offset
+typedef bool (*ota_patch_read_fn)(size_t offset, uint8_t *dst, size_t len);
+// Receives rebuilt image bytes, returns bytes consumed (short = failure)
+typedef size_t (*ota_patch_out_fn)(const uint8_t *data, size_t len);
+
+typedef struct
+{
+    ota_patch_read_fn read_base;
+    size_t base_size;
+    size_t target_size;
+    size_t total_out;
+    uint8_t field[9]; // Header / op fields being collected
+    size_t field_len;
+    size_t field_need;
+    bool have_header;
+    uint8_t op;
+    size_t base_ofs;
+    size_t remaining; // Bytes left in the current op
+    bool in_op;       // Fields parsed, op body in progress
+    bool failed;
+    uint8_t buf[OTA_PATCH_BASE_CHUNK];
+} ota_patch_t;
+
+void ota_patch_begin(ota_patch_t *p, ota_patch_read_fn read_base, size_t base_size);
+
+// Feed patch bytes; rebuilt image data is passed to out as it is produced
+bool ota_patch_write(ota_patch_t *p, const uint8_t *in, size_t in_len, ota_patch_out_fn out);
+
+// True once target_size bytes were produced and no op is half-applied
+bool ota_patch_complete(const ota_patch_t *p);
@@ -0,0 +1,210 @@
+#include "ota_pipeline.h"
+#include "ota_ring.h"
+
+#include <Arduino.h>
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+#define OTA_WRITER_TASK_STACK 6144
+#define OTA_WRITER_TASK_PRIORITY 2 // Above loopTask (1), below BLE host
+#define OTA_WRITER_TASK_CORE 1     // Keep core 0 free for the BLE stack
+
+static ota_ring_t s_ring;
+static ota_sink_write_fn s_sink = NULL;
+static ota_pipeline_progress_fn s_on_progress = NULL;
+static TaskHandle_t s_writer_task = NULL;
+static SemaphoreHandle_t s_lock = NULL;       // Held while a batch is being written
+static SemaphoreHandle_t s_flush_done = NULL; // Given when a flush request completes
+static SemaphoreHandle_t s_stats_lock = NULL;
+static ota_pipeline_stats_t s_stats;
+static volatile bool s_flush_requested = false;
+static volatile bool s_failed = false;
+static volatile size_t s_written = 0;
+
+// Batches are staged in internal RAM (the ring may live in PSRAM)
+static uint8_t s_batch[OTA_FLASH_BATCH_SIZE];
+
+uint8_t ota_pipeline_hist_bucket(uint32_t us)
+{
+    uint8_t bucket = 0;
+    for (uint32_t limit = 1000; us >= limit && bucket < OTA_PIPELINE_HIST_BUCKETS - 1; limit <<= 1)
+        bucket++;
+    return bucket;
+}
+
+static void ota_pipeline_record_write(uint32_t us)
+{
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    s_stats.writes++;
+    s_stats.write_hist[ota_pipeline_hist_bucket(us)]++;
+    s_stats.write_max_us = max(s_stats.write_max_us, us);
+    s_stats.write_total_us += us;
+    xSemaphoreGive(s_stats_lock);
+}
+
+static void ota_writer_task(void *arg)
+{
+    for (;;)
+    {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+
+        xSemaphoreTake(s_lock, portMAX_DELAY);
+        size_t written_before = s_written;
+        while (!s_failed)
+        {
+            // Only full sectors, except for the tail on flush
+            size_t avail = ota_ring_used(&s_ring);
+            if (avail < OTA_FLASH_BATCH_SIZE && !(s_flush_requested && avail > 0))
+                break;
+
+            size_t n = ota_ring_read(&s_ring, s_batch, OTA_FLASH_BATCH_SIZE);
+            int64_t start_us = esp_timer_get_time();
+            size_t done = s_sink(s_batch, n);
+            ota_pipeline_record_write((uint32_t)(esp_timer_get_time() - start_us));
+            if (done != n)
+            {
+                s_failed = true;
+                break;
+            }
+            s_written += n;
+        }
+
+        bool flush_done = s_flush_requested && (s_failed || ota_ring_used(&s_ring) == 0);
+        if (flush_done)
+            s_flush_requested = false;
+        xSemaphoreGive(s_lock);
+
+        if (flush_done)
+            xSemaphoreGive(s_flush_done);
+        if (s_on_progress && (s_written != written_before || s_failed))
+            s_on_progress();
+    }
+}
+
+bool ota_pipeline_init(ota_sink_write_fn sink, ota_pipeline_progress_fn on_progress)
+{
+    if (s_writer_task)
+        return true;
+
+    uint8_t *storage = NULL;
+    size_t capacity = 0;
+
+#ifdef BOARD_HAS_PSRAM
+    if (psramFound())
+    {
+        storage = (uint8_t *)heap_caps_malloc(OTA_RING_SIZE_PSRAM, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        capacity = OTA_RING_SIZE_PSRAM;
+    }
+#endif
+    if (!storage)
+    {
+        storage = (uint8_t *)heap_caps_malloc(OTA_RING_SIZE_INTERNAL, MALLOC_CAP_INTERNAL | MALLOC_CAP_8BIT);
+        capacity = OTA_RING_SIZE_INTERNAL;
+    }
+    if (!storage)
+        return false;
+
+    ota_ring_init(&s_ring, storage, capacity);
+    s_sink = sink;
+    s_on_progress = on_progress;
+    s_lock = xSemaphoreCreateMutex();
+    s_flush_done = xSemaphoreCreateBinary();
+    s_stats_lock = xSemaphoreCreateMutex();
+    if (!s_lock || !s_flush_done || !s_stats_lock)
+        return false;
+
+    return xTaskCreatePinnedToCore(ota_writer_task, "ota_writer", OTA_WRITER_TASK_STACK, NULL,
+                                   OTA_WRITER_TASK_PRIORITY, &s_writer_task, OTA_WRITER_TASK_CORE) == pdPASS;
+}
+
+void ota_pipeline_reset(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    ota_ring_reset(&s_ring);
+    s_flush_requested = false;
+    s_failed = false;
+    s_written = 0;
+    xSemaphoreTake(s_flush_done, 0); // Drop a stale completion
+    xSemaphoreGive(s_lock);
+}
+
+bool ota_pipeline_push(const uint8_t *data, size_t len, uint32_t timeout_ms)
+{
+    TickType_t start = xTaskGetTickCount();
+    while (!ota_ring_write(&s_ring, data, len))
+    {
+        // Ring full: let the writer catch up (this throttles the BLE link)
+        if (s_failed || (xTaskGetTickCount() - start) >= pdMS_TO_TICKS(timeout_ms))
+            return false;
+        xTaskNotifyGive(s_writer_task);
+        vTaskDelay(1);
+    }
+
+    if (ota_ring_used(&s_ring) >= OTA_FLASH_BATCH_SIZE)
+        xTaskNotifyGive(s_writer_task);
+    return true;
+}
+
+bool ota_pipeline_write_at(size_t ahead, const uint8_t *data, size_t len)
+{
+    return ota_ring_write_at(&s_ring, ahead, data, len);
+}
+
+void ota_pipeline_commit(size_t len)
+{
+    ota_ring_commit(&s_ring, len);
+
+    if (ota_ring_used(&s_ring) >= OTA_FLASH_BATCH_SIZE)
+        xTaskNotifyGive(s_writer_task);
+}
+
+bool ota_pipeline_flush(uint32_t timeout_ms)
+{
+    s_flush_requested = true;
+    xTaskNotifyGive(s_writer_task);
+
+    if (xSemaphoreTake(s_flush_done, pdMS_TO_TICKS(timeout_ms)) != pdTRUE)
+        return false;
+    return !s_failed;
+}
+
+size_t ota_pipeline_buffered(void)
+{
+    return ota_ring_used(&s_ring);
+}
+
+size_t ota_pipeline_free(void)
+{
+    return ota_ring_free(&s_ring);
+}
+
+size_t ota_pipeline_capacity(void)
+{
+    return s_ring.capacity;
+}
+
+size_t ota_pipeline_written(void)
+{
+    return s_written;
+}
+
+bool ota_pipeline_failed(void)
+{
+    return s_failed;
+}
+
+void ota_pipeline_get_stats(ota_pipeline_stats_t *out)
+{
+    if (!s_stats_lock)
+    {
+        memset(out, 0, sizeof(*out));
+        return;
+    }
+    xSemaphoreTake(s_stats_lock, portMAX_DELAY);
+    *out = s_stats;
+    xSemaphoreGive(s_stats_lock);
+}
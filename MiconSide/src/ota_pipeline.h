@@ -0,0 +1,63 @@
+/*
+  ============================================================================
+  OTA Write Pipeline
+
+  BLE OTA data is copied into a preallocated ring buffer from the BLE
+  callback and drained by a dedicated flash-writer task, so sector
+  erase/program never stalls the BLE host task.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_FLASH_BATCH_SIZE 4096          // One flash sector per sink write
+#define OTA_RING_SIZE_PSRAM (64 * 1024)    // Used when PSRAM is available
+#define OTA_RING_SIZE_INTERNAL (16 * 1024) // Fallback (internal RAM)
+#define OTA_PIPELINE_HIST_BUCKETS 8        // Sink write latency: bucket i < (1 << i) ms, the last one the rest
+
+typedef struct
+{
+    uint32_t writes;                               // Sink calls since boot
+    uint32_t write_hist[OTA_PIPELINE_HIST_BUCKETS];
+    uint32_t write_max_us;
+    uint64_t write_total_us;
+} ota_pipeline_stats_t;
+
+// Flash sink: must consume all len bytes, returns bytes written
+typedef size_t (*ota_sink_write_fn)(const uint8_t *data, size_t len);
+// Called from the writer task after it wrote batches or the sink failed
+typedef void (*ota_pipeline_progress_fn)(void);
+
+// Allocate the ring buffer and start the writer task (call once from setup)
+bool ota_pipeline_init(ota_sink_write_fn sink, ota_pipeline_progress_fn on_progress);
+
+// Drop buffered data and clear error state. Waits for an in-flight batch.
+void ota_pipeline_reset(void);
+
+// Queue received data. Waits up to timeout_ms for space; false on timeout/error.
+bool ota_pipeline_push(const uint8_t *data, size_t len, uint32_t timeout_ms);
+
+// Stage out-of-order data `ahead` bytes past the committed position.
+// Returns false if it does not fit in the free space.
+bool ota_pipeline_write_at(size_t ahead, const uint8_t *data, size_t len);
+
+// Hand len staged bytes to the writer task
+void ota_pipeline_commit(size_t len);
+
+// Write out the remaining partial batch and wait until the ring is empty
+bool ota_pipeline_flush(uint32_t timeout_ms);
+
+size_t ota_pipeline_buffered(void);
+size_t ota_pipeline_free(void);
+size_t ota_pipeline_capacity(void);
+size_t ota_pipeline_written(void);
+bool ota_pipeline_failed(void);
+
+// Sink write latency since boot (not cleared by ota_pipeline_reset)
+void ota_pipeline_get_stats(ota_pipeline_stats_t *out);
+
+// Histogram bucket for one write of us microseconds
+uint8_t ota_pipeline_hist_bucket(uint32_t us);
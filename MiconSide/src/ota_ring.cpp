@@ -0,0 +1,94 @@
+#include "ota_ring.h"
+
+#include <string.h>
+
+bool ota_ring_init(ota_ring_t *ring, uint8_t *storage, size_t capacity)
+{
+    if (!ring || !storage || capacity == 0)
+    {
+        return false;
+    }
+
+    ring->buf = storage;
+    ring->capacity = capacity;
+    ring->head.store(0);
+    ring->tail.store(0);
+    return true;
+}
+
+void ota_ring_reset(ota_ring_t *ring)
+{
+    ring->head.store(0);
+    ring->tail.store(0);
+}
+
+size_t ota_ring_used(const ota_ring_t *ring)
+{
+    return ring->head.load(std::memory_order_acquire) - ring->tail.load(std::memory_order_acquire);
+}
+
+size_t ota_ring_free(const ota_ring_t *ring)
+{
+    return ring->capacity - ota_ring_used(ring);
+}
+
+bool ota_ring_write_at(ota_ring_t *ring, size_t ahead, const uint8_t *data, size_t len)
+{
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    size_t tail = ring->tail.load(std::memory_order_acquire);
+
+    if (ahead + len > ring->capacity - (head - tail))
+    {
+        return false;
+    }
+
+    size_t pos = (head + ahead) % ring->capacity;
+    size_t first = ring->capacity - pos;
+    if (first > len)
+        first = len;
+
+    memcpy(ring->buf + pos, data, first);
+    memcpy(ring->buf, data + first, len - first);
+    return true;
+}
+
+void ota_ring_commit(ota_ring_t *ring, size_t len)
+{
+    // Publish the bytes only after they are copied
+    size_t head = ring->head.load(std::memory_order_relaxed);
+    ring->head.store(head + len, std::memory_order_release);
+}
+
+bool ota_ring_write(ota_ring_t *ring, const uint8_t *data, size_t len)
+{
+    if (!ota_ring_write_at(ring, 0, data, len))
+    {
+        return false;
+    }
+
+    ota_ring_commit(ring, len);
+    return true;
+}
+
+size_t ota_ring_read(ota_ring_t *ring, uint8_t *dst, size_t max_len)
+{
+    size_t tail = ring->tail.load(std::memory_order_relaxed);
+    size_t head = ring->head.load(std::memory_order_acquire);
+
+    size_t len = head - tail;
+    if (len > max_len)
+        len = max_len;
+    if (len == 0)
+        return 0;
+
+    size_t pos = tail % ring->capacity;
+    size_t first = ring->capacity - pos;
+    if (first > len)
+        first = len;
+
+    memcpy(dst, ring->buf + pos, first);
+    memcpy(dst + first, ring->buf, len - first);
+
+    ring->tail.store(tail + len, std::memory_order_release);
+    return len;
+}
@@ -0,0 +1,46 @@
+/*
+  ============================================================================
+  OTA Receive Ring Buffer
+
+  Single-producer / single-consumer byte ring used between the BLE OTA data
+  callback (producer) and the flash writer task (consumer).
+  No Arduino / FreeRTOS dependency so it can be built on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+
+typedef struct
+{
+    uint8_t *buf;
+    size_t capacity;
+    // Monotonic byte counters; index = counter % capacity
+    std::atomic<size_t> head; // total bytes written by producer
+    std::atomic<size_t> tail; // total bytes consumed by consumer
+} ota_ring_t;
+
+// Attach preallocated storage. Returns false on invalid arguments.
+bool ota_ring_init(ota_ring_t *ring, uint8_t *storage, size_t capacity);
+
+// Discard all buffered data (caller must ensure neither side is active)
+void ota_ring_reset(ota_ring_t *ring);
+
+size_t ota_ring_used(const ota_ring_t *ring);
+size_t ota_ring_free(const ota_ring_t *ring);
+
+// Producer: copy all of data or nothing. Returns false if it does not fit.
+bool ota_ring_write(ota_ring_t *ring, const uint8_t *data, size_t len);
+
+// Producer: stage data `ahead` bytes past the write position without
+// publishing it (out-of-order receive). Returns false if it does not fit.
+bool ota_ring_write_at(ota_ring_t *ring, size_t ahead, const uint8_t *data, size_t len);
+
+// Producer: publish len staged bytes to the consumer
+void ota_ring_commit(ota_ring_t *ring, size_t len);
+
+// Consumer: copy up to max_len bytes into dst. Returns bytes copied.
+size_t ota_ring_read(ota_ring_t *ring, uint8_t *dst, size_t max_len);
@@ -0,0 +1,41 @@
+#include "ota_rx.h"
+
+ota_rx_result_t ota_rx_packet(ota_sack_t *sack, const ota_rx_ops_t *ops, uint32_t expected,
+                              const uint8_t *packet, size_t len, ota_rx_info_t *info)
+{
+    info->advance = 0;
+    info->new_gap = false;
+
+    if (len <= OTA_RX_HEADER_SIZE)
+        return OTA_RX_SHORT;
+
+    uint32_t offset = (uint32_t)packet[0] | ((uint32_t)packet[1] << 8) |
+                      ((uint32_t)packet[2] << 16) | ((uint32_t)packet[3] << 24);
+    const uint8_t *payload = packet + OTA_RX_HEADER_SIZE;
+    size_t payload_len = len - OTA_RX_HEADER_SIZE;
+
+    if (offset > expected || payload_len > expected - offset)
+        return OTA_RX_OVERFLOW;
+
+    // Part of a retransmit may already be committed; only stage the rest
+    size_t skip = offset < sack->cum ? sack->cum - offset : 0;
+    if (skip >= payload_len)
+        return OTA_RX_DUPLICATE;
+    size_t ahead = offset + skip - sack->cum;
+
+    // Beyond the advertised window: drop, the client resends after the next ACK
+    if (ahead + payload_len - skip > ops->free_space())
+        return OTA_RX_OUT_OF_WINDOW;
+
+    uint8_t blocks_before = sack->count;
+    if (ota_sack_add(sack, offset + skip, offset + payload_len, &info->advance) != OTA_SACK_ACCEPTED)
+        return OTA_RX_NO_ROOM;
+
+    if (!ops->write_at(ahead, payload + skip, payload_len - skip))
+        return OTA_RX_WRITE_FAILED;
+
+    if (info->advance > 0)
+        ops->commit(info->advance);
+    info->new_gap = sack->count > blocks_before;
+    return OTA_RX_ACCEPTED;
+}
@@ -0,0 +1,52 @@
+/*
+  ============================================================================
+  OTA Sequenced Packet Receiver
+
+  Decides what to do with one OtaData write of a sequenced BLE transfer:
+  <offset:4 LE><payload>. Retransmitted bytes already committed are
+  skipped, packets beyond the advertised window or needing a fifth SACK
+  block are dropped, and the rest is staged at its offset in the write
+  buffer; whatever became contiguous is committed.
+
+  The buffer is reached only through ota_rx_ops_t (the OTA pipeline on the
+  device), so the receiver has no Arduino / FreeRTOS dependency and can be
+  built on the host against a plain memory buffer.
+  ============================================================================
+*/
+
+#pragma once
+
+#include "ota_sack.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_RX_HEADER_SIZE 4 // uint32 LE byte offset in front of every payload
+
+typedef struct
+{
+    bool (*write_at)(size_t ahead, const uint8_t *data, size_t len); // Stage at ahead bytes past the committed data
+    void (*commit)(size_t len);                                      // Hand len staged bytes to the writer
+    size_t (*free_space)(void);                                      // Bytes that can still be staged
+} ota_rx_ops_t;
+
+typedef enum
+{
+    OTA_RX_ACCEPTED = 0,  // Staged (and committed as far as contiguous)
+    OTA_RX_SHORT,         // No payload after the header
+    OTA_RX_OVERFLOW,      // Ends past the transfer size: the session must be aborted
+    OTA_RX_DUPLICATE,     // Everything already committed (our ACK was probably lost)
+    OTA_RX_OUT_OF_WINDOW, // Does not fit the buffer yet; resent after the next ACK
+    OTA_RX_NO_ROOM,       // Too many gaps: dropped until they fill
+    OTA_RX_WRITE_FAILED,  // Buffer refused the bytes: the session must be aborted
+} ota_rx_result_t;
+
+typedef struct
+{
+    uint32_t advance; // Bytes committed by this packet (sack->cum moved as far)
+    bool new_gap;     // Opened a new SACK block: worth an immediate ACK
+} ota_rx_info_t;
+
+// Handle one packet of a transfer of expected bytes; sack->cum is the committed size
+ota_rx_result_t ota_rx_packet(ota_sack_t *sack, const ota_rx_ops_t *ops, uint32_t expected,
+                              const uint8_t *packet, size_t len, ota_rx_info_t *info);
@@ -0,0 +1,91 @@
+#include "ota_sack.h"
+
+#include <stdio.h>
+#include <string.h>
+
+void ota_sack_reset(ota_sack_t *sack, uint32_t cum)
+{
+    sack->cum = cum;
+    sack->count = 0;
+}
+
+static void ota_sack_remove(ota_sack_t *sack, uint8_t index)
+{
+    memmove(&sack->blocks[index], &sack->blocks[index + 1],
+            (sack->count - index - 1) * sizeof(ota_sack_block_t));
+    sack->count--;
+}
+
+ota_sack_result_t ota_sack_add(ota_sack_t *sack, uint32_t start, uint32_t end, uint32_t *advance)
+{
+    *advance = 0;
+
+    if (end <= sack->cum)
+    {
+        return OTA_SACK_DUPLICATE;
+    }
+
+    if (start <= sack->cum)
+    {
+        // In order: extend cum, then absorb any blocks that now touch it
+        uint32_t old_cum = sack->cum;
+        sack->cum = end;
+        while (sack->count > 0 && sack->blocks[0].start <= sack->cum)
+        {
+            if (sack->blocks[0].end > sack->cum)
+                sack->cum = sack->blocks[0].end;
+            ota_sack_remove(sack, 0);
+        }
+        *advance = sack->cum - old_cum;
+        return OTA_SACK_ACCEPTED;
+    }
+
+    // Out of order: merge with overlapping/adjacent blocks or insert a new one
+    uint8_t i = 0;
+    while (i < sack->count && sack->blocks[i].end < start)
+        i++;
+
+    if (i < sack->count && sack->blocks[i].start <= end)
+    {
+        ota_sack_block_t *b = &sack->blocks[i];
+        if (start < b->start)
+            b->start = start;
+        if (end > b->end)
+            b->end = end;
+        while (i + 1 < sack->count && sack->blocks[i + 1].start <= b->end)
+        {
+            if (sack->blocks[i + 1].end > b->end)
+                b->end = sack->blocks[i + 1].end;
+            ota_sack_remove(sack, i + 1);
+        }
+        return OTA_SACK_ACCEPTED;
+    }
+
+    if (sack->count >= OTA_SACK_MAX_BLOCKS)
+    {
+        return OTA_SACK_NO_ROOM;
+    }
+
+    memmove(&sack->blocks[i + 1], &sack->blocks[i], (sack->count - i) * sizeof(ota_sack_block_t));
+    sack->blocks[i].start = start;
+    sack->blocks[i].end = end;
+    sack->count++;
+    return OTA_SACK_ACCEPTED;
+}
+
+size_t ota_sack_format(const ota_sack_t *sack, char *out, size_t out_size)
+{
+    size_t pos = 0;
+    if (out_size > 0)
+        out[0] = '\0';
+
+    for (uint8_t i = 0; i < sack->count; i++)
+    {
+        int n = snprintf(out + pos, out_size - pos, "%s%lu-%lu", i ? "," : "",
+                         (unsigned long)sack->blocks[i].start, (unsigned long)sack->blocks[i].end);
+        if (n < 0 || (size_t)n >= out_size - pos)
+            break;
+        pos += n;
+    }
+    return pos;
+}
@@ -0,0 +1,44 @@
+/*
+  ============================================================================
+  OTA Selective Acknowledgement Tracker
+
+  Tracks the cumulative in-order offset of a sequenced OTA transfer plus a
+  few out-of-order byte ranges received beyond it (TCP-style SACK blocks).
+  No Arduino / FreeRTOS dependency so it can be built on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define OTA_SACK_MAX_BLOCKS 4
+
+typedef enum
+{
+    OTA_SACK_ACCEPTED = 0, // New data (in order or stored out of order)
+    OTA_SACK_DUPLICATE,    // Entirely below the cumulative offset
+    OTA_SACK_NO_ROOM,      // Would need a new block but all are in use
+} ota_sack_result_t;
+
+typedef struct
+{
+    uint32_t start; // inclusive
+    uint32_t end;   // exclusive
+} ota_sack_block_t;
+
+typedef struct
+{
+    uint32_t cum; // All bytes below this offset have been received
+    ota_sack_block_t blocks[OTA_SACK_MAX_BLOCKS];
+    uint8_t count; // Blocks are kept sorted and non-overlapping
+} ota_sack_t;
+
+void ota_sack_reset(ota_sack_t *sack, uint32_t cum);
+
+// Record [start, end). On OTA_SACK_ACCEPTED, *advance is how far cum moved.
+ota_sack_result_t ota_sack_add(ota_sack_t *sack, uint32_t start, uint32_t end, uint32_t *advance);
+
+// Format "<s>-<e>,<s>-<e>..." into out. Returns characters written.
+size_t ota_sack_format(const ota_sack_t *sack, char *out, size_t out_size);
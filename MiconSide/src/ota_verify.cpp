@@ -0,0 +1,64 @@
+#include "ota_verify.h"
+
+#include <string.h>
+
+#if OTA_SIGNATURE_ENABLED
+#include <mbedtls/pk.h>
+#include "ota_signing_key.h" // Defines OTA_SIGNING_PUBKEY_PEM (see README)
+#endif
+
+bool ota_verify_equal(const uint8_t *a, const uint8_t *b, size_t len)
+{
+    uint8_t diff = 0;
+    for (size_t i = 0; i < len; i++)
+        diff |= a[i] ^ b[i];
+    return diff == 0;
+}
+
+static int ota_verify_hex_nibble(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+bool ota_verify_hex_decode(const char *hex, uint8_t *out, size_t out_len)
+{
+    if (strlen(hex) != out_len * 2)
+        return false;
+
+    for (size_t i = 0; i < out_len; i++)
+    {
+        int hi = ota_verify_hex_nibble(hex[i * 2]);
+        int lo = ota_verify_hex_nibble(hex[i * 2 + 1]);
+        if (hi < 0 || lo < 0)
+            return false;
+        out[i] = (uint8_t)((hi << 4) | lo);
+    }
+    return true;
+}
+
+bool ota_verify_signature(const uint8_t digest[OTA_DIGEST_SIZE], const uint8_t *sig, size_t sig_len)
+{
+#if OTA_SIGNATURE_ENABLED
+    mbedtls_pk_context pk;
+    mbedtls_pk_init(&pk);
+
+    bool ok = mbedtls_pk_parse_public_key(&pk, (const unsigned char *)OTA_SIGNING_PUBKEY_PEM,
+                                          sizeof(OTA_SIGNING_PUBKEY_PEM)) == 0 &&
+              mbedtls_pk_can_do(&pk, MBEDTLS_PK_ECDSA) &&
+              mbedtls_pk_verify(&pk, MBEDTLS_MD_SHA256, digest, OTA_DIGEST_SIZE, sig, sig_len) == 0;
+
+    mbedtls_pk_free(&pk);
+    return ok;
+#else
+    (void)digest;
+    (void)sig;
+    (void)sig_len;
+    return false;
+#endif
+}
@@ -0,0 +1,30 @@
+/*
+  ============================================================================
+  OTA Image Verification
+
+  Digest comparison and optional ECDSA P-256 signature check of the image
+  SHA-256 computed while streaming. Signature checking is compiled in with
+  -DOTA_SIGNATURE_ENABLED=1 and a public key in ota_signing_key.h.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifndef OTA_SIGNATURE_ENABLED
+#define OTA_SIGNATURE_ENABLED 0
+#endif
+
+#define OTA_DIGEST_SIZE 32
+#define OTA_SIGNATURE_MAX_SIZE 72 // DER-encoded ECDSA P-256
+
+// Constant-time comparison (no early exit on the first differing byte)
+bool ota_verify_equal(const uint8_t *a, const uint8_t *b, size_t len);
+
+// Decode exactly out_len bytes from hex; false on bad length or characters
+bool ota_verify_hex_decode(const char *hex, uint8_t *out, size_t out_len);
+
+// Check a DER ECDSA signature over the image digest (always false if disabled)
+bool ota_verify_signature(const uint8_t digest[OTA_DIGEST_SIZE], const uint8_t *sig, size_t sig_len);
@@ -0,0 +1,27 @@
+#include "prov.h"
+
+#include <string.h>
+
+prov_result_t prov_parse(const ble_cmd_frame_t *frame, prov_credentials_t *out)
+{
+    out->ssid[0] = '\0';
+    out->password[0] = '\0';
+
+    const ble_cmd_field_t *ssid_field = ble_cmd_field(frame, 1);
+    const ble_cmd_field_t *pass_field = ble_cmd_field(frame, 2);
+    if (!pass_field && !frame->binary)
+        return PROV_NO_SEPARATOR;
+
+    // An embedded NUL would silently cut the string short
+    if (!ssid_field || ble_cmd_str(frame, 1, out->ssid, sizeof(out->ssid)) == 0 ||
+        strlen(out->ssid) != ssid_field->len)
+    {
+        out->ssid[0] = '\0';
+        return PROV_BAD_SSID;
+    }
+
+    if (pass_field && (pass_field->len > CONFIG_PASS_MAX || memchr(pass_field->value, '\0', pass_field->len)))
+        return PROV_BAD_PASSWORD;
+    ble_cmd_str(frame, 2, out->password, sizeof(out->password));
+    return PROV_OK;
+}
@@ -0,0 +1,31 @@
+/*
+  ============================================================================
+  Wi-Fi Provisioning Parser
+
+  Validates the credentials written to the provisioning characteristic:
+  "SSID\nPassword" (text) or ssid / password fields (binary, tags 1 / 2).
+  Storing them and rebooting stay with the caller. Works on a parsed
+  ble_cmd frame only, so it can be built on the host.
+  ============================================================================
+*/
+
+#pragma once
+
+#include "ble_cmd.h"
+#include "config_store.h"
+
+typedef enum
+{
+    PROV_OK = 0,
+    PROV_NO_SEPARATOR, // Text write without the password line
+    PROV_BAD_SSID,     // Missing, empty, longer than CONFIG_SSID_MAX or containing a NUL
+    PROV_BAD_PASSWORD, // Longer than CONFIG_PASS_MAX or containing a NUL (empty = open network)
+} prov_result_t;
+
+typedef struct
+{
+    char ssid[CONFIG_SSID_MAX + 1];
+    char password[CONFIG_PASS_MAX + 1];
+} prov_credentials_t;
+
+prov_result_t prov_parse(const ble_cmd_frame_t *frame, prov_credentials_t *out);
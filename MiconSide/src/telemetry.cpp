@@ -0,0 +1,34 @@
+#include "telemetry.h"
+
+#include <esp_heap_caps.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#include <string.h>
+
+// loopTask: loop() and sched jobs, BTC_TASK: BLE callbacks, esp_timer: Wi-Fi retry timer
+const char *const telemetry_task_names[TELEMETRY_TASKS] = {
+    "loopTask", "BTC_TASK", "esp_timer", "log_drain", "ota_writer", "ota_net",
+};
+
+void telemetry_begin(telemetry_frame_t *frame)
+{
+    memset(frame, 0, sizeof(*frame));
+    frame->magic = TELEMETRY_MAGIC;
+    frame->version = TELEMETRY_VERSION;
+    frame->size = sizeof(*frame);
+    frame->uptime_ms = (uint32_t)(esp_timer_get_time() / 1000);
+
+    frame->heap_free = heap_caps_get_free_size(MALLOC_CAP_INTERNAL);
+    frame->heap_min = heap_caps_get_minimum_free_size(MALLOC_CAP_INTERNAL);
+    frame->psram_free = heap_caps_get_free_size(MALLOC_CAP_SPIRAM);
+    frame->psram_min = heap_caps_get_minimum_free_size(MALLOC_CAP_SPIRAM);
+
+    // ESP-IDF reports the high-water mark in bytes
+    for (int i = 0; i < TELEMETRY_TASKS; i++)
+    {
+        TaskHandle_t task = xTaskGetHandle(telemetry_task_names[i]);
+        UBaseType_t free_bytes = task ? uxTaskGetStackHighWaterMark(task) : TELEMETRY_STACK_UNKNOWN;
+        frame->stack_free[i] = free_bytes < TELEMETRY_STACK_UNKNOWN ? free_bytes : TELEMETRY_STACK_UNKNOWN;
+    }
+}
@@ -0,0 +1,79 @@
+/*
+  ============================================================================
+  DebugStat Telemetry Frame
+
+  Versioned binary snapshot published on the DebugStat characteristic:
+  notified every period (TELEM command) and on link / Wi-Fi changes, and
+  rebuilt on every read. All fields are little-endian; size lets a client
+  read the fields it knows and skip what a newer firmware appended.
+
+  The first byte is TELEMETRY_MAGIC (>= 0x80), so clients tell the frame
+  apart from the text "STATE:..." line older firmware sends.
+  ============================================================================
+*/
+
+#pragma once
+
+#include "ota_pipeline.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define TELEMETRY_MAGIC 0xD7
+#define TELEMETRY_VERSION 1
+#define TELEMETRY_PERIOD_DEFAULT_MS 10000
+#define TELEMETRY_PERIOD_MIN_MS 250
+#define TELEMETRY_PERIOD_MAX_MS 3600000
+#define TELEMETRY_TASKS 6           // Stack high-water marks, in telemetry_task_names order
+#define TELEMETRY_STACK_UNKNOWN 0xFFFF
+
+// flags
+#define TELEMETRY_FLAG_BLE 0x01        // Client connected
+#define TELEMETRY_FLAG_OTA_MODE 0x02   // OTA_MODE active
+#define TELEMETRY_FLAG_OTA_ACTIVE 0x04 // Transfer in progress (START .. END / ABORT)
+#define TELEMETRY_FLAG_OTA_WIFI 0x08   // Data currently arriving over the Wi-Fi transport
+
+typedef struct __attribute__((packed))
+{
+    uint8_t magic;
+    uint8_t version;
+    uint16_t size; // sizeof(telemetry_frame_t)
+    uint32_t uptime_ms;
+    uint8_t flags;
+
+    // Wi-Fi (wifi_mgr)
+    uint8_t wifi_state; // wifi_mgr_state_t
+    int8_t rssi;        // dBm, 0 while not connected
+    uint8_t wifi_reason; // Last disconnect reason
+    uint32_t ip;        // a.b.c.d -> byte 0 = a, 0 = none
+    uint32_t wifi_attempts;
+    uint32_t wifi_connects;
+    uint32_t wifi_disconnects;
+
+    // OTA transfer (0 outside a session)
+    uint32_t ota_received;
+    uint32_t ota_expected;
+    uint32_t ota_bytes_per_s; // Average since START
+
+    // Flash sink writes since boot (ota_pipeline)
+    uint32_t write_count;
+    uint32_t write_hist[OTA_PIPELINE_HIST_BUCKETS]; // Bucket i < (1 << i) ms, the last one the rest
+    uint32_t write_max_us;
+
+    // Losses
+    uint32_t notify_failures; // BLE notifications the stack could not send
+    uint32_t log_dropped;     // Log lines dropped on a full ring
+
+    // Heap (bytes)
+    uint32_t heap_free;  // Internal RAM
+    uint32_t heap_min;   // Internal RAM low-water mark
+    uint32_t psram_free; // 0 without PSRAM
+    uint32_t psram_min;
+
+    uint16_t stack_free[TELEMETRY_TASKS]; // Bytes never used, TELEMETRY_STACK_UNKNOWN = task not running
+} telemetry_frame_t;
+
+extern const char *const telemetry_task_names[TELEMETRY_TASKS];
+
+// Header, uptime, heap and stack fields; the caller fills in the rest
+void telemetry_begin(telemetry_frame_t *frame);
@@ -0,0 +1,352 @@
+#include "wifi_mgr.h"
+#include "config_store.h"
+
+#include <Arduino.h>
+#include <WiFi.h>
+#include <esp_random.h>
+#include <esp_timer.h>
+#include <freertos/FreeRTOS.h>
+#include <freertos/semphr.h>
+#include <string.h>
+
+// wifi_err_reason_t values used here
+#define WIFI_REASON_AUTH_EXPIRE 2
+#define WIFI_REASON_ASSOC_EXPIRE 4
+#define WIFI_REASON_ASSOC_LEAVE 8 // We disconnected (timeout, or WiFi.begin() with a new config)
+#define WIFI_REASON_BEACON_TIMEOUT 200
+#define WIFI_REASON_HANDSHAKE_TIMEOUT 204
+#define WIFI_REASON_CONNECTION_FAIL 205
+#define WIFI_REASON_AP_TSF_RESET 206
+#define WIFI_REASON_ROAMING 207
+
+static SemaphoreHandle_t s_lock = NULL;
+static esp_timer_handle_t s_timer = NULL; // Connect timeout (CONNECTING) or retry delay (BACKOFF)
+static wifi_mgr_changed_fn s_on_change = NULL;
+static wifi_mgr_hold_fn s_hold = NULL;
+static volatile wifi_mgr_state_t s_state = WIFI_MGR_IDLE;
+static wifi_mgr_stats_t s_stats;
+static char s_ip[16] = "";
+static uint32_t s_ip_addr = 0;     // s_ip as IPAddress, a.b.c.d -> byte 0 = a
+static int64_t s_begin_us = 0;     // Current attempt started
+static int64_t s_down_us = 0;      // Outage started (0 = none tracked)
+static bool s_retried_now = false; // Immediate retry already spent in this outage
+static bool s_leave_pending = false; // Timer called WiFi.disconnect(); its ASSOC_LEAVE is ours
+
+uint32_t wifi_mgr_backoff_ms(uint8_t step, uint32_t random)
+{
+    uint32_t delay = WIFI_MGR_BACKOFF_MIN_MS;
+    for (uint8_t i = 1; i < step && delay < WIFI_MGR_BACKOFF_MAX_MS; i++)
+        delay *= 2;
+    delay = min(delay, (uint32_t)WIFI_MGR_BACKOFF_MAX_MS);
+    return delay / 2 + random % (delay / 2 + 1);
+}
+
+bool wifi_mgr_reason_transient(uint8_t reason)
+{
+    switch (reason)
+    {
+    case WIFI_REASON_AUTH_EXPIRE:
+    case WIFI_REASON_ASSOC_EXPIRE:
+    case WIFI_REASON_ASSOC_LEAVE:
+    case WIFI_REASON_BEACON_TIMEOUT:
+    case WIFI_REASON_HANDSHAKE_TIMEOUT:
+    case WIFI_REASON_CONNECTION_FAIL:
+    case WIFI_REASON_AP_TSF_RESET:
+    case WIFI_REASON_ROAMING:
+        return true;
+    default:
+        return false; // e.g. NO_AP_FOUND, AUTH_FAIL, 4-way handshake timeout (wrong password)
+    }
+}
+
+static uint32_t wifi_mgr_elapsed_ms(int64_t since_us)
+{
+    return (uint32_t)((esp_timer_get_time() - since_us) / 1000);
+}
+
+static void wifi_mgr_arm(uint32_t ms)
+{
+    esp_timer_stop(s_timer);
+    esp_timer_start_once(s_timer, (uint64_t)ms * 1000);
+}
+
+// Lock held: start an attempt, on the cached link if there is one
+static void wifi_mgr_begin(void)
+{
+    config_t cfg;
+    config_get(&cfg);
+    if (cfg.ssid[0] == '\0')
+    {
+        esp_timer_stop(s_timer);
+        s_state = WIFI_MGR_IDLE;
+        return;
+    }
+
+    s_stats.attempts++;
+    s_stats.fast = cfg.link.channel != 0;
+    s_stats.static_ip = s_stats.fast && cfg.static_ip && cfg.link.ip != 0;
+    s_stats.assoc_ms = 0;
+    s_stats.connect_ms = 0;
+    s_begin_us = esp_timer_get_time();
+    s_state = WIFI_MGR_CONNECTING;
+
+    // Zero addresses switch the STA interface back to DHCP
+    if (s_stats.static_ip)
+    {
+        WiFi.config(IPAddress(cfg.link.ip), IPAddress(cfg.link.gateway),
+                    IPAddress(cfg.link.netmask), IPAddress(cfg.link.dns));
+    }
+    else
+    {
+        WiFi.config(IPAddress(), IPAddress(), IPAddress());
+    }
+
+    // Cached link: join the last AP directly, no scan across all channels
+    if (s_stats.fast)
+        WiFi.begin(cfg.ssid, cfg.pass, cfg.link.channel, cfg.link.bssid);
+    else
+        WiFi.begin(cfg.ssid, cfg.pass);
+
+    wifi_mgr_arm(s_stats.fast ? WIFI_MGR_FAST_TIMEOUT_MS : WIFI_MGR_CONNECT_TIMEOUT_MS);
+}
+
+// Lock held: next retry after the backoff delay
+static void wifi_mgr_backoff(void)
+{
+    if (s_stats.backoff_step < UINT8_MAX)
+        s_stats.backoff_step++;
+    s_stats.backoff_ms = wifi_mgr_backoff_ms(s_stats.backoff_step, esp_random());
+    s_state = WIFI_MGR_BACKOFF;
+    wifi_mgr_arm(s_stats.backoff_ms);
+}
+
+// Lock held: the cached BSSID/channel did not work (AP moved channel or is gone);
+// later attempts scan until GOT_IP caches the AP again. The lease is kept.
+static void wifi_mgr_drop_link(void)
+{
+    config_t cfg;
+    config_get(&cfg);
+    memset(cfg.link.bssid, 0, sizeof(cfg.link.bssid));
+    cfg.link.channel = 0;
+    config_set_wifi_link(&cfg.link);
+    s_stats.fallbacks++;
+}
+
+// Lock held: the attempt (or link) failed with reason
+static void wifi_mgr_failed(uint8_t reason)
+{
+    if (s_stats.fast)
+    {
+        // One failed attempt on the cached link: scan next time, after the usual backoff
+        wifi_mgr_drop_link();
+        wifi_mgr_backoff();
+    }
+    else if (wifi_mgr_reason_transient(reason) && !s_retried_now)
+    {
+        s_retried_now = true;
+        s_stats.immediate_retries++;
+        wifi_mgr_begin();
+    }
+    else
+    {
+        wifi_mgr_backoff();
+    }
+}
+
+static void wifi_mgr_notify(wifi_mgr_state_t state)
+{
+    if (s_on_change)
+        s_on_change(state);
+}
+
+static void wifi_mgr_timer_cb(void *arg)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = true;
+    if (s_state == WIFI_MGR_CONNECTING)
+    {
+        // Timed out; the DISCONNECTED this causes arrives in BACKOFF and is ignored
+        s_stats.timeouts++;
+        s_state = WIFI_MGR_BACKOFF;
+        s_leave_pending = true;
+        WiFi.disconnect();
+        if (s_stats.fast)
+            wifi_mgr_drop_link();
+        wifi_mgr_backoff();
+    }
+    else if (s_state == WIFI_MGR_BACKOFF && s_hold && s_hold())
+    {
+        wifi_mgr_arm(WIFI_MGR_HOLD_RECHECK_MS);
+        changed = false;
+    }
+    else if (s_state == WIFI_MGR_BACKOFF)
+    {
+        wifi_mgr_begin();
+    }
+    else
+    {
+        changed = false;
+    }
+    wifi_mgr_state_t state = s_state;
+    xSemaphoreGive(s_lock);
+
+    if (changed)
+        wifi_mgr_notify(state);
+}
+
+// Lock held
+static void wifi_mgr_got_ip(void)
+{
+    esp_timer_stop(s_timer);
+    if (s_state == WIFI_MGR_CONNECTING)
+    {
+        s_stats.connect_ms = wifi_mgr_elapsed_ms(s_begin_us);
+        s_stats.connect_total_ms += s_stats.connect_ms;
+        s_stats.connect_max_ms = max(s_stats.connect_max_ms, s_stats.connect_ms);
+    }
+    if (s_down_us)
+    {
+        s_stats.outage_ms = wifi_mgr_elapsed_ms(s_down_us);
+        s_stats.outage_max_ms = max(s_stats.outage_max_ms, s_stats.outage_ms);
+        s_down_us = 0;
+    }
+    s_stats.connects++;
+    s_stats.backoff_step = 0;
+    s_retried_now = false;
+    s_leave_pending = false;
+    s_state = WIFI_MGR_CONNECTED;
+
+    IPAddress ip = WiFi.localIP();
+    s_ip_addr = ip;
+    snprintf(s_ip, sizeof(s_ip), "%d.%d.%d.%d", ip[0], ip[1], ip[2], ip[3]);
+
+    // Remember this AP and lease for the next connect (not rewritten if unchanged)
+    config_wifi_link_t link = {};
+    const uint8_t *bssid = WiFi.BSSID();
+    if (bssid)
+        memcpy(link.bssid, bssid, sizeof(link.bssid));
+    link.channel = WiFi.channel();
+    link.ip = WiFi.localIP();
+    link.gateway = WiFi.gatewayIP();
+    link.netmask = WiFi.subnetMask();
+    link.dns = WiFi.dnsIP();
+    config_set_wifi_link(&link);
+}
+
+static void wifi_mgr_event(arduino_event_t *event)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = false;
+    switch (event->event_id)
+    {
+    case ARDUINO_EVENT_WIFI_STA_CONNECTED:
+        if (s_state == WIFI_MGR_CONNECTING)
+            s_stats.assoc_ms = wifi_mgr_elapsed_ms(s_begin_us);
+        break;
+
+    case ARDUINO_EVENT_WIFI_STA_GOT_IP:
+        wifi_mgr_got_ip();
+        changed = true;
+        break;
+
+    case ARDUINO_EVENT_WIFI_STA_DISCONNECTED:
+    {
+        uint8_t reason = event->event_info.wifi_sta_disconnected.reason;
+        bool own_leave = reason == WIFI_REASON_ASSOC_LEAVE && s_leave_pending;
+        s_leave_pending = false;
+        if (s_state == WIFI_MGR_CONNECTED)
+        {
+            s_stats.disconnects++;
+            s_stats.last_reason = reason;
+            s_down_us = esp_timer_get_time();
+            s_stats.fast = false; // A dropped link is not a stale cache
+            wifi_mgr_failed(reason);
+            changed = true;
+        }
+        else if (s_state == WIFI_MGR_CONNECTING && !own_leave)
+        {
+            s_stats.last_reason = reason;
+            wifi_mgr_failed(reason);
+            changed = true;
+        }
+        // IDLE / BACKOFF, or the leave of a timed-out attempt: already handled
+        break;
+    }
+
+    default:
+        break;
+    }
+    wifi_mgr_state_t state = s_state;
+    xSemaphoreGive(s_lock);
+
+    if (changed)
+        wifi_mgr_notify(state);
+}
+
+void wifi_mgr_init(wifi_mgr_changed_fn on_change, wifi_mgr_hold_fn hold)
+{
+    s_on_change = on_change;
+    s_hold = hold;
+    s_lock = xSemaphoreCreateMutex();
+
+    esp_timer_create_args_t args = {};
+    args.callback = wifi_mgr_timer_cb;
+    args.dispatch_method = ESP_TIMER_TASK;
+    args.name = "wifi_mgr";
+    esp_timer_create(&args, &s_timer);
+
+    // Retries are ours; credentials live in config_store, not in the driver's NVS copy
+    WiFi.persistent(false);
+    WiFi.setAutoReconnect(false);
+    WiFi.mode(WIFI_STA);
+    WiFi.onEvent(wifi_mgr_event);
+}
+
+void wifi_mgr_start(void)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    bool changed = s_state == WIFI_MGR_IDLE || s_state == WIFI_MGR_BACKOFF;
+    if (changed)
+    {
+        if (!s_down_us)
+            s_down_us = esp_timer_get_time();
+        wifi_mgr_begin();
+    }
+    wifi_mgr_state_t state = s_state;
+    xSemaphoreGive(s_lock);
+
+    if (changed)
+        wifi_mgr_notify(state);
+}
+
+wifi_mgr_state_t wifi_mgr_state(void)
+{
+    return s_state;
+}
+
+bool wifi_mgr_is_connected(void)
+{
+    return s_state == WIFI_MGR_CONNECTED;
+}
+
+const char *wifi_mgr_get_ip_str(void)
+{
+    return s_ip;
+}
+
+uint32_t wifi_mgr_get_ip(void)
+{
+    return s_ip_addr;
+}
+
+int8_t wifi_mgr_rssi(void)
+{
+    return s_state == WIFI_MGR_CONNECTED ? WiFi.RSSI() : 0;
+}
+
+void wifi_mgr_get_stats(wifi_mgr_stats_t *out)
+{
+    xSemaphoreTake(s_lock, portMAX_DELAY);
+    *out = s_stats;
+    xSemaphoreGive(s_lock);
+}
@@ -0,0 +1,87 @@
+/*
+  ============================================================================
+  Wi-Fi Connection Manager
+
+  STA state machine driven only by ESP-IDF Wi-Fi events and one esp_timer
+  one-shot (connect timeout / retry delay); nothing is polled.
+
+    IDLE ──start──> CONNECTING ──GOT_IP──> CONNECTED
+                     │   ^  ^                  │
+          fail/timeout   │  └──transient reason┘ (immediate retry, once)
+                     v   │                     │
+                    BACKOFF <──other reason────┘
+
+  Retries back off exponentially (WIFI_MGR_BACKOFF_MIN_MS doubling up to
+  WIFI_MGR_BACKOFF_MAX_MS) with "equal jitter": half the delay is fixed,
+  half random, so devices that lost the same AP do not retry in lockstep.
+  A connect to the cached BSSID/channel that fails drops the cached
+  BSSID/channel (see config_store) and backs off like any other failure;
+  the next attempt scans.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define WIFI_MGR_FAST_TIMEOUT_MS 5000     // Cached BSSID/channel attempt
+#define WIFI_MGR_CONNECT_TIMEOUT_MS 15000 // Scan + DHCP attempt
+#define WIFI_MGR_BACKOFF_MIN_MS 1000
+#define WIFI_MGR_BACKOFF_MAX_MS 120000
+#define WIFI_MGR_HOLD_RECHECK_MS 1000 // Retry due while held (e.g. OTA mode)
+
+// Values match wifi_state in the DebugStat telemetry frame
+typedef enum
+{
+    WIFI_MGR_IDLE = 0, // No credentials, or stopped
+    WIFI_MGR_CONNECTING,
+    WIFI_MGR_CONNECTED,
+    WIFI_MGR_BACKOFF, // Last attempt failed, retry timer armed
+} wifi_mgr_state_t;
+
+typedef struct
+{
+    uint32_t attempts;          // WiFi.begin() calls
+    uint32_t connects;          // GOT_IP
+    uint32_t disconnects;       // Link lost after GOT_IP
+    uint32_t timeouts;          // Attempts given up by the connect timer
+    uint32_t fallbacks;         // Failed cached-link attempts (cache dropped, next attempt scans)
+    uint32_t immediate_retries; // Transient disconnects retried without backoff
+    uint8_t last_reason;        // wifi_err_reason_t of the last disconnect
+    uint8_t backoff_step;       // Consecutive failed attempts
+    uint32_t backoff_ms;        // Delay armed for the current / last retry
+    uint32_t assoc_ms;          // Last attempt: begin -> associated (0 = not reached)
+    uint32_t connect_ms;        // Last attempt: begin -> got IP (0 = not reached)
+    uint32_t connect_max_ms;
+    uint32_t connect_total_ms;  // Sum over connects (average = total / connects)
+    uint32_t outage_ms;         // Last outage: link lost (or boot) -> got IP
+    uint32_t outage_max_ms;
+    bool fast;                  // Last attempt used the cached BSSID/channel
+    bool static_ip;             // Last attempt used the cached lease
+} wifi_mgr_stats_t;
+
+// State changed (called from the Wi-Fi event or esp_timer task)
+typedef void (*wifi_mgr_changed_fn)(wifi_mgr_state_t state);
+// True while connect attempts must wait (checked when a retry is due)
+typedef bool (*wifi_mgr_hold_fn)(void);
+
+// STA mode, event handler and retry timer; does not connect yet
+void wifi_mgr_init(wifi_mgr_changed_fn on_change, wifi_mgr_hold_fn hold);
+
+// Connect with the stored credentials (no-op without an SSID or while connected)
+void wifi_mgr_start(void);
+
+wifi_mgr_state_t wifi_mgr_state(void);
+bool wifi_mgr_is_connected(void);
+const char *wifi_mgr_get_ip_str(void); // "" until the first GOT_IP
+uint32_t wifi_mgr_get_ip(void);        // Same address as an IPAddress value, 0 until the first GOT_IP
+int8_t wifi_mgr_rssi(void);            // dBm, 0 while not connected
+
+void wifi_mgr_get_stats(wifi_mgr_stats_t *out);
+
+// Delay before retry number step (1-based), random in [d/2, d] where d = min(MIN << (step-1), MAX)
+uint32_t wifi_mgr_backoff_ms(uint8_t step, uint32_t random);
+
+// Disconnect reasons worth one immediate retry (AP blip, beacon loss, roaming)
+bool wifi_mgr_reason_transient(uint8_t reason);
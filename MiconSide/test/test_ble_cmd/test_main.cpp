@@ -0,0 +1,200 @@
+#include <unity.h>
+
+#include "ble_cmd.h"
+
+#include <BLECharacteristic.h>
+#include <string.h>
+
+#define OP_LEVEL 0x83
+#define OP_START 0xA0
+#define OP_END 0xA3
+
+static const ble_cmd_frame_t *s_last;
+static ble_cmd_frame_t s_frame;
+static int s_calls;
+
+static void on_cmd(const ble_cmd_frame_t *frame)
+{
+    s_last = frame;
+    s_calls++;
+}
+
+static const char *const start_keys[] = {"codec", "base", NULL};
+static const ble_cmd_entry_t entries[] = {
+    {OP_LEVEL, "LVL", 1, NULL, on_cmd},
+    {OP_START, "START", 2, start_keys, on_cmd},
+    {OP_END, "END", 0, NULL, on_cmd},
+};
+static const ble_cmd_table_t table = {entries, 3, ':', true};
+
+// Dispatches writes the way main.cpp's characteristic callbacks do
+class CmdCallbacks : public BLECharacteristicCallbacks
+{
+    void onWrite(BLECharacteristic *characteristic) override
+    {
+        const ble_cmd_entry_t *entry =
+            ble_cmd_parse(&table, characteristic->getData(), characteristic->getLength(), &s_frame);
+        if (entry)
+            entry->handler(&s_frame);
+    }
+};
+
+static BLECharacteristic s_chr("cmd");
+static CmdCallbacks s_callbacks;
+
+static const ble_cmd_entry_t *parse(const uint8_t *data, size_t len)
+{
+    return ble_cmd_parse(&table, data, len, &s_frame);
+}
+
+static const ble_cmd_entry_t *parse_text(const char *text)
+{
+    return parse((const uint8_t *)text, strlen(text));
+}
+
+void setUp(void)
+{
+    s_last = NULL;
+    s_calls = 0;
+    s_chr.setCallbacks(&s_callbacks);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_text_positional_and_keys(void)
+{
+    const ble_cmd_entry_t *entry = parse_text("  START:123456:100000:codec=1:base=ab01\r\n");
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_EQUAL_HEX8(OP_START, entry->opcode);
+    TEST_ASSERT_FALSE(s_frame.binary);
+    TEST_ASSERT_EQUAL_UINT32(123456, ble_cmd_u32(&s_frame, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(100000, ble_cmd_u32(&s_frame, 2, 0));
+    TEST_ASSERT_EQUAL_UINT32(1, ble_cmd_u32(&s_frame, 3, 0));
+
+    uint8_t base[4];
+    TEST_ASSERT_EQUAL_size_t(2, ble_cmd_bytes(&s_frame, 4, base, sizeof(base)));
+    TEST_ASSERT_EQUAL_HEX8(0xab, base[0]);
+    TEST_ASSERT_EQUAL_HEX8(0x01, base[1]);
+}
+
+static void test_text_bare_and_unknown(void)
+{
+    TEST_ASSERT_NOT_NULL(parse_text("END"));
+    TEST_ASSERT_EQUAL_size_t(0, s_frame.field_count);
+    TEST_ASSERT_NULL(parse_text("ENDX"));
+    TEST_ASSERT_NULL(parse_text(""));
+}
+
+static void test_text_malformed_numbers_use_default(void)
+{
+    TEST_ASSERT_NOT_NULL(parse_text("LVL:abc"));
+    TEST_ASSERT_EQUAL_UINT32(7, ble_cmd_u32(&s_frame, 1, 7));
+    TEST_ASSERT_NOT_NULL(parse_text("LVL:99999999999"));
+    TEST_ASSERT_EQUAL_UINT32(7, ble_cmd_u32(&s_frame, 1, 7));
+}
+
+static void test_binary_tlv(void)
+{
+    const uint8_t frame[] = {BLE_CMD_BINARY_V1, OP_START, 1, 3, 0x40, 0xE2, 0x01, 3, 1, 2, 4, 2, 0xde, 0xad};
+    const ble_cmd_entry_t *entry = parse(frame, sizeof(frame));
+    TEST_ASSERT_NOT_NULL(entry);
+    TEST_ASSERT_TRUE(s_frame.binary);
+    TEST_ASSERT_EQUAL_UINT32(123456, ble_cmd_u32(&s_frame, 1, 0));
+    TEST_ASSERT_EQUAL_UINT32(2, ble_cmd_u32(&s_frame, 3, 0));
+
+    uint8_t base[2];
+    TEST_ASSERT_EQUAL_size_t(2, ble_cmd_bytes(&s_frame, 4, base, sizeof(base)));
+    TEST_ASSERT_EQUAL_HEX8(0xde, base[0]);
+    TEST_ASSERT_EQUAL_size_t(0, ble_cmd_bytes(&s_frame, 4, base, 1)); // Does not fit
+}
+
+static void test_binary_truncated_or_unknown(void)
+{
+    const uint8_t truncated[] = {BLE_CMD_BINARY_V1, OP_START, 1, 4, 0x40, 0xE2};
+    TEST_ASSERT_NULL(parse(truncated, sizeof(truncated)));
+    const uint8_t no_len[] = {BLE_CMD_BINARY_V1, OP_START, 1};
+    TEST_ASSERT_NULL(parse(no_len, sizeof(no_len)));
+    const uint8_t unknown[] = {BLE_CMD_BINARY_V1, 0xEE};
+    TEST_ASSERT_NULL(parse(unknown, sizeof(unknown)));
+    const uint8_t zero_tag[] = {BLE_CMD_BINARY_V1, OP_END, 0, 0};
+    TEST_ASSERT_NULL(parse(zero_tag, sizeof(zero_tag)));
+    const uint8_t no_opcode[] = {BLE_CMD_BINARY_V1};
+    TEST_ASSERT_NULL(parse(no_opcode, sizeof(no_opcode)));
+    const uint8_t later_version[] = {0xF6, OP_END};
+    TEST_ASSERT_NULL(parse(later_version, sizeof(later_version)));
+    TEST_ASSERT_TRUE(s_frame.binary);
+}
+
+// UTF-8 lead bytes (0xC2-0xF4) start text, never a binary frame
+static void test_utf8_text_is_not_binary(void)
+{
+    static const ble_cmd_entry_t any_text[] = {{0x90, NULL, 2, NULL, on_cmd}};
+    static const ble_cmd_table_t text_table = {any_text, 1, '\n', false};
+    const char *samples[] = {"\xE3\x82\xA2Net\npassword", "\xC3\xA9t\xC3\xA9\npw", "\xF0\x9F\x93\xB6\npw"};
+    for (size_t i = 0; i < sizeof(samples) / sizeof(samples[0]); i++)
+    {
+        const ble_cmd_entry_t *entry =
+            ble_cmd_parse(&text_table, (const uint8_t *)samples[i], strlen(samples[i]), &s_frame);
+        TEST_ASSERT_NOT_NULL(entry);
+        TEST_ASSERT_FALSE(s_frame.binary);
+        TEST_ASSERT_EQUAL_size_t(2, s_frame.field_count);
+    }
+    TEST_ASSERT_TRUE(ble_cmd_equals(&s_frame, 2, "pw"));
+}
+
+static void test_too_many_fields(void)
+{
+    uint8_t frame[2 + 2 * (BLE_CMD_MAX_FIELDS + 1)];
+    frame[0] = BLE_CMD_BINARY_V1;
+    frame[1] = OP_END;
+    for (size_t i = 0; i <= BLE_CMD_MAX_FIELDS; i++)
+    {
+        frame[2 + 2 * i] = (uint8_t)(i + 1);
+        frame[3 + 2 * i] = 0;
+    }
+    TEST_ASSERT_NULL(parse(frame, sizeof(frame)));
+    TEST_ASSERT_NOT_NULL(parse(frame, sizeof(frame) - 2));
+}
+
+static void test_str_and_equals(void)
+{
+    char out[4];
+    TEST_ASSERT_NOT_NULL(parse_text("LVL:abc"));
+    TEST_ASSERT_TRUE(ble_cmd_equals(&s_frame, 1, "abc"));
+    TEST_ASSERT_FALSE(ble_cmd_equals(&s_frame, 1, "ab"));
+    TEST_ASSERT_EQUAL_size_t(3, ble_cmd_str(&s_frame, 1, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("abc", out);
+    TEST_ASSERT_EQUAL_size_t(0, ble_cmd_str(&s_frame, 1, out, 3)); // No room for the terminator
+}
+
+static void test_characteristic_write_dispatches(void)
+{
+    s_chr.write("LVL:2");
+    TEST_ASSERT_EQUAL_INT(1, s_calls);
+    TEST_ASSERT_EQUAL_UINT32(2, ble_cmd_u32(s_last, 1, 0));
+
+    const uint8_t binary[] = {BLE_CMD_BINARY_V1, OP_LEVEL, 1, 1, 3};
+    s_chr.write(binary, sizeof(binary));
+    TEST_ASSERT_EQUAL_INT(2, s_calls);
+    TEST_ASSERT_EQUAL_UINT32(3, ble_cmd_u32(s_last, 1, 0));
+
+    s_chr.write("NOPE");
+    TEST_ASSERT_EQUAL_INT(2, s_calls);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_positional_and_keys);
+    RUN_TEST(test_text_bare_and_unknown);
+    RUN_TEST(test_text_malformed_numbers_use_default);
+    RUN_TEST(test_binary_tlv);
+    RUN_TEST(test_binary_truncated_or_unknown);
+    RUN_TEST(test_utf8_text_is_not_binary);
+    RUN_TEST(test_too_many_fields);
+    RUN_TEST(test_str_and_equals);
+    RUN_TEST(test_characteristic_write_dispatches);
+    return UNITY_END();
+}
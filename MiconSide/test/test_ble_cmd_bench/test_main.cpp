@@ -0,0 +1,122 @@
+#include <unity.h>
+
+#include "ble_cmd.h"
+#include "prov.h"
+
+#include <chrono>
+#include <stdio.h>
+#include <string.h>
+
+// Host timings only show relative cost (text vs binary, growth with fields); the ESP32-S3 is slower
+#define BENCH_ITERATIONS 1000000
+
+static void bench_nop(const ble_cmd_frame_t *frame)
+{
+}
+
+static const char *const start_keys[] = {"sha", "at", "bsize", "bsha", NULL};
+static const ble_cmd_entry_t ota_entries[] = {
+    {0xA0, "START", 3, start_keys, bench_nop},
+    {0xA1, "RESUME", 1, NULL, bench_nop},
+    {0xA2, "SIG", 1, NULL, bench_nop},
+    {0xA3, "END", 0, NULL, bench_nop},
+    {0xA4, "ABORT", 0, NULL, bench_nop},
+    {0xA5, "WIFI", 0, NULL, bench_nop},
+};
+static const ble_cmd_table_t ota_table = {ota_entries, 6, ':', true};
+static const ble_cmd_entry_t prov_entries[] = {{0x90, NULL, 2, NULL, bench_nop}};
+static const ble_cmd_table_t prov_table = {prov_entries, 1, '\n', false};
+
+static volatile uint32_t s_sink; // Keeps the parse from being optimized out
+
+// ns per parse (plus field reads) of one write
+static double bench(const char *name, const ble_cmd_table_t *table, const uint8_t *data, size_t len)
+{
+    ble_cmd_frame_t frame;
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+    {
+        const ble_cmd_entry_t *entry = ble_cmd_parse(table, data, len, &frame);
+        s_sink += entry ? entry->opcode + ble_cmd_u32(&frame, 1, 0) + frame.field_count : 0;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                BENCH_ITERATIONS;
+
+    char line[96];
+    snprintf(line, sizeof(line), "%-28s %4u B %8.1f ns/parse", name, (unsigned)len, ns);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_NOT_NULL(ble_cmd_parse(table, data, len, &frame));
+    return ns;
+}
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+static void test_bench_ota_start(void)
+{
+    const char *text = "START:524288:301022:deflate:sha=000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f:at=65536";
+    uint8_t binary[2 + 6 + 6 + 9 + 34 + 6] = {BLE_CMD_BINARY_V1, 0xA0};
+    size_t pos = 2;
+    const uint8_t size[] = {1, 4, 0x00, 0x00, 0x08, 0x00};
+    const uint8_t xfer[] = {2, 4, 0xDE, 0x97, 0x04, 0x00};
+    const uint8_t codec[] = {3, 7, 'd', 'e', 'f', 'l', 'a', 't', 'e'};
+    memcpy(binary + pos, size, sizeof(size));
+    pos += sizeof(size);
+    memcpy(binary + pos, xfer, sizeof(xfer));
+    pos += sizeof(xfer);
+    memcpy(binary + pos, codec, sizeof(codec));
+    pos += sizeof(codec);
+    binary[pos++] = 4;
+    binary[pos++] = 32;
+    for (int i = 0; i < 32; i++)
+        binary[pos++] = (uint8_t)i;
+    const uint8_t at[] = {5, 4, 0x00, 0x00, 0x01, 0x00};
+    memcpy(binary + pos, at, sizeof(at));
+    pos += sizeof(at);
+
+    double text_ns = bench("START text (5 fields)", &ota_table, (const uint8_t *)text, strlen(text));
+    double binary_ns = bench("START binary (5 fields)", &ota_table, binary, pos);
+    TEST_ASSERT_TRUE(text_ns > 0 && binary_ns > 0);
+}
+
+static void test_bench_short_commands(void)
+{
+    const uint8_t end_binary[] = {BLE_CMD_BINARY_V1, 0xA3};
+    bench("END text", &ota_table, (const uint8_t *)"END", 3);
+    bench("END binary", &ota_table, end_binary, sizeof(end_binary));
+}
+
+static void test_bench_prov(void)
+{
+    const char *ascii = "HomeNetwork-5G\ncorrect horse battery staple";
+    const char *utf8 = "\xE3\x82\xA2\xE3\x83\x91\xE3\x83\xBC\xE3\x83\x88Net\ncorrect horse battery staple";
+    bench("prov text (ASCII SSID)", &prov_table, (const uint8_t *)ascii, strlen(ascii));
+    bench("prov text (UTF-8 SSID)", &prov_table, (const uint8_t *)utf8, strlen(utf8));
+
+    ble_cmd_frame_t frame;
+    prov_credentials_t creds;
+    ble_cmd_parse(&prov_table, (const uint8_t *)utf8, strlen(utf8), &frame);
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < BENCH_ITERATIONS; i++)
+        s_sink += prov_parse(&frame, &creds);
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() /
+                BENCH_ITERATIONS;
+    char line[96];
+    snprintf(line, sizeof(line), "%-28s        %8.1f ns/call", "prov_parse (validate+copy)", ns);
+    TEST_MESSAGE(line);
+    TEST_ASSERT_EQUAL(PROV_OK, prov_parse(&frame, &creds));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_ota_start);
+    RUN_TEST(test_bench_short_commands);
+    RUN_TEST(test_bench_prov);
+    return UNITY_END();
+}
@@ -0,0 +1,156 @@
+#include <unity.h>
+
+#define FUZZ_CHECK(cond) TEST_ASSERT_MESSAGE(cond, #cond)
+#include "../../tools/fuzz/ble_cmd_fuzz.cpp"
+
+#include <stdio.h>
+
+#define FUZZ_ITERATIONS 200000
+#define FUZZ_MAX_LEN 300
+
+static uint32_t s_rng;
+
+static uint32_t fuzz_rand(void)
+{
+    // xorshift32: the same corpus on every run
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+void setUp(void)
+{
+    s_rng = 0x9E3779B9u;
+}
+
+void tearDown(void)
+{
+}
+
+static void test_random_bytes(void)
+{
+    uint8_t buf[FUZZ_MAX_LEN];
+    for (int i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+        size_t len = fuzz_rand() % FUZZ_MAX_LEN;
+        for (size_t j = 0; j < len; j++)
+            buf[j] = (uint8_t)fuzz_rand();
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+}
+
+// Valid frames with bytes flipped, inserted or cut off
+static void test_mutated_seeds(void)
+{
+    static const char *const text_seeds[] = {
+        "LVL:3", " TELEM:1000 ", "START:524288:301022:deflate:sha=00ff:at=4096",
+        "RESUME:0123456789abcdef", "HomeNet\npassword", "\xE3\x82\xA2Net\npass\nword",
+    };
+    static const uint8_t binary_seed[] = {BLE_CMD_BINARY_V1, 0xA0, 1, 4, 0x00, 0x00, 0x08, 0x00, 3, 7,
+                                          'd', 'e', 'f', 'l', 'a', 't', 'e', 5, 1, 0x10};
+    uint8_t buf[FUZZ_MAX_LEN];
+
+    for (int i = 0; i < FUZZ_ITERATIONS; i++)
+    {
+        size_t seed = fuzz_rand() % 7;
+        size_t len;
+        if (seed == 6)
+        {
+            len = sizeof(binary_seed);
+            memcpy(buf, binary_seed, len);
+        }
+        else
+        {
+            len = strlen(text_seeds[seed]);
+            memcpy(buf, text_seeds[seed], len);
+        }
+
+        for (int m = fuzz_rand() % 4; m >= 0; m--)
+        {
+            size_t pos = len ? fuzz_rand() % len : 0;
+            switch (fuzz_rand() % 3)
+            {
+            case 0:
+                if (len)
+                    buf[pos] = (uint8_t)fuzz_rand();
+                break;
+            case 1:
+                if (len + 1 < FUZZ_MAX_LEN)
+                {
+                    memmove(buf + pos + 1, buf + pos, len - pos);
+                    buf[pos] = "\n:=\xF5\x00"[fuzz_rand() % 5];
+                    len++;
+                }
+                break;
+            default:
+                len = pos;
+                break;
+            }
+        }
+        LLVMFuzzerTestOneInput(buf, len);
+    }
+}
+
+// Random UTF-8 credentials (1-4 byte sequences) always parse as text
+static void test_utf8_credentials_are_text(void)
+{
+    for (int i = 0; i < FUZZ_ITERATIONS / 10; i++)
+    {
+        char text[128];
+        size_t len = 0;
+        size_t ssid_chars = 1 + fuzz_rand() % 8;
+        for (size_t c = 0; c < ssid_chars + 6; c++)
+        {
+            if (c == ssid_chars)
+            {
+                text[len++] = '\n';
+                continue;
+            }
+            uint32_t cp;
+            do
+                cp = 0x20 + fuzz_rand() % (fuzz_rand() % 2 ? 0x80 - 0x20 : 0x10FFFF);
+            while ((cp >= 0xD800 && cp <= 0xDFFF) || cp == 0x7F || cp > 0x10FFFF);
+            if (cp < 0x80)
+            {
+                text[len++] = (char)cp;
+            }
+            else if (cp < 0x800)
+            {
+                text[len++] = (char)(0xC0 | (cp >> 6));
+                text[len++] = (char)(0x80 | (cp & 0x3F));
+            }
+            else if (cp < 0x10000)
+            {
+                text[len++] = (char)(0xE0 | (cp >> 12));
+                text[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                text[len++] = (char)(0x80 | (cp & 0x3F));
+            }
+            else
+            {
+                text[len++] = (char)(0xF0 | (cp >> 18));
+                text[len++] = (char)(0x80 | ((cp >> 12) & 0x3F));
+                text[len++] = (char)(0x80 | ((cp >> 6) & 0x3F));
+                text[len++] = (char)(0x80 | (cp & 0x3F));
+            }
+        }
+
+        ble_cmd_frame_t frame;
+        prov_credentials_t creds;
+        TEST_ASSERT_NOT_NULL(ble_cmd_parse(&fuzz_tables[1], (const uint8_t *)text, len, &frame));
+        TEST_ASSERT_FALSE(frame.binary);
+        prov_result_t result = prov_parse(&frame, &creds);
+        const char *nl = (const char *)memchr(text, '\n', len);
+        size_t ssid_len = nl - text;
+        TEST_ASSERT_EQUAL(ssid_len <= CONFIG_SSID_MAX ? PROV_OK : PROV_BAD_SSID, result);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_random_bytes);
+    RUN_TEST(test_mutated_seeds);
+    RUN_TEST(test_utf8_credentials_are_text);
+    return UNITY_END();
+}
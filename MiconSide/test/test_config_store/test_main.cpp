@@ -0,0 +1,219 @@
+#include <unity.h>
+
+#include "config_store.h"
+
+#include <Arduino.h>
+#include <Preferences.h>
+#include <fake_rtos.h>
+#include <string.h>
+
+static config_t s_defaults;
+static int s_changes;
+
+static void on_change(void)
+{
+    s_changes++;
+}
+
+static void init_store(void)
+{
+    config_store_init(&s_defaults, on_change);
+}
+
+void setUp(void)
+{
+    fake_prefs_reset();
+    memset(&s_defaults, 0, sizeof(s_defaults));
+    s_defaults.log_level = 2;
+    s_changes = 0;
+    init_store();
+}
+
+void tearDown(void)
+{
+}
+
+static void test_empty_nvs_gives_defaults(void)
+{
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_STRING("", cfg.ssid);
+    TEST_ASSERT_FALSE(cfg.provisioned);
+    TEST_ASSERT_EQUAL_UINT8(2, cfg.log_level);
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_CLEAN, config_store_pending_ms(millis()));
+}
+
+static void test_burst_is_one_commit_per_namespace(void)
+{
+    config_set_wifi("Net", "pw");
+    config_set_provisioned(true);
+    config_set_log_level(3);
+    config_set_log_level(1);
+    config_set_fast_boot(true);
+    TEST_ASSERT_EQUAL_INT(5, s_changes);
+    TEST_ASSERT_EQUAL_UINT32(0, fake_prefs_commits());
+
+    TEST_ASSERT_TRUE(config_store_commit());
+    TEST_ASSERT_EQUAL_UINT32(2, fake_prefs_commits());
+
+    config_stats_t stats;
+    config_store_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.commits);
+    TEST_ASSERT_EQUAL_UINT32(5, stats.writes); // ssid, pass, prov, log_lvl, fast_boot
+    TEST_ASSERT_EQUAL_UINT32(1, stats.coalesced);
+
+    // Reloading sees what was written
+    init_store();
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_STRING("Net", cfg.ssid);
+    TEST_ASSERT_EQUAL_STRING("pw", cfg.pass);
+    TEST_ASSERT_TRUE(cfg.provisioned);
+    TEST_ASSERT_EQUAL_UINT8(1, cfg.log_level);
+    TEST_ASSERT_TRUE(cfg.fast_boot);
+}
+
+static void test_unchanged_values_are_not_written(void)
+{
+    config_set_log_level(2);
+    config_set_wifi("", "");
+    TEST_ASSERT_EQUAL_INT(0, s_changes);
+    TEST_ASSERT_TRUE(config_store_commit());
+    TEST_ASSERT_EQUAL_UINT32(0, fake_prefs_commits());
+
+    config_stats_t stats;
+    config_store_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(3, stats.unchanged);
+}
+
+static void test_commit_waits_for_quiet_time(void)
+{
+    uint32_t t0 = millis();
+    config_set_fast_boot(true);
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_COMMIT_DELAY_MS, config_store_pending_ms(t0));
+
+    // Changes keep pushing the commit out, up to 4 x the delay after the first one
+    for (int i = 1; i <= 10; i++)
+    {
+        fake_rtos_advance_us(400 * 1000);
+        config_set_fast_boot(i % 2 == 0);
+    }
+    TEST_ASSERT_EQUAL_UINT32(0, config_store_pending_ms(millis()));
+    TEST_ASSERT_TRUE(config_store_commit());
+    TEST_ASSERT_EQUAL_UINT32(CONFIG_CLEAN, config_store_pending_ms(millis()));
+}
+
+static void test_failed_write_is_retried(void)
+{
+    config_set_log_level(0);
+    fake_prefs_fail_writes(true);
+    TEST_ASSERT_FALSE(config_store_commit());
+    config_stats_t stats;
+    config_store_get_stats(&stats);
+    TEST_ASSERT_EQUAL_UINT32(1, stats.failures);
+    TEST_ASSERT_EQUAL_UINT32(0, config_store_pending_ms(millis() + CONFIG_COMMIT_DELAY_MS));
+
+    fake_prefs_fail_writes(false);
+    TEST_ASSERT_TRUE(config_store_commit());
+    init_store();
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_UINT8(0, cfg.log_level);
+
+}
+
+static void test_new_credentials_drop_cached_link(void)
+{
+    config_wifi_link_t link = {{1, 2, 3, 4, 5, 6}, 11, 0, 0x0100a8c0, 0x0100a8c0, 0x00ffffff, 0x0100a8c0};
+    config_set_wifi("Net", "pw");
+    config_set_wifi_link(&link);
+    TEST_ASSERT_TRUE(config_store_commit());
+
+    config_set_wifi("Other", "pw");
+    TEST_ASSERT_TRUE(config_store_commit());
+    init_store();
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_STRING("Other", cfg.ssid);
+    TEST_ASSERT_EQUAL_UINT8(0, cfg.link.channel);
+
+    Preferences nvs;
+    TEST_ASSERT_TRUE(nvs.begin("wifi", true));
+    TEST_ASSERT_FALSE(nvs.isKey("link"));
+    nvs.end();
+}
+
+// v0 wrote "prov" to syscfg; loading moves it to wifi and removes the old key
+static void test_v0_layout_is_migrated(void)
+{
+    Preferences nvs;
+    nvs.begin("wifi", false);
+    nvs.putString("ssid", "Legacy");
+    nvs.putString("pass", "pw");
+    nvs.end();
+    nvs.begin("syscfg", false);
+    nvs.putUChar("prov", 1);
+    nvs.end();
+
+    init_store();
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_TRUE(cfg.provisioned);
+    TEST_ASSERT_TRUE(config_store_commit());
+
+    nvs.begin("syscfg", true);
+    TEST_ASSERT_FALSE(nvs.isKey("prov"));
+    TEST_ASSERT_EQUAL_UINT8(CONFIG_SCHEMA_VERSION, nvs.getUChar("ver", 0));
+    nvs.end();
+    nvs.begin("wifi", true);
+    TEST_ASSERT_EQUAL_UINT8(1, nvs.getUChar("prov", 0));
+    nvs.end();
+}
+
+static void test_erase_resets_namespace(void)
+{
+    config_set_wifi("Net", "pw");
+    config_set_log_level(0);
+    TEST_ASSERT_TRUE(config_store_commit());
+
+    config_store_erase(CONFIG_NS_WIFI);
+    config_t cfg;
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_STRING("", cfg.ssid);
+    TEST_ASSERT_EQUAL_UINT8(0, cfg.log_level);
+
+    init_store();
+    config_get(&cfg);
+    TEST_ASSERT_EQUAL_STRING("", cfg.ssid);
+    TEST_ASSERT_EQUAL_UINT8(0, cfg.log_level);
+}
+
+static void test_blobs_write_through(void)
+{
+    const uint8_t record[5] = {1, 2, 3, 4, 5};
+    uint8_t out[8];
+    TEST_ASSERT_EQUAL_size_t(0, config_store_blob_get("ota_sess", out, sizeof(out)));
+    TEST_ASSERT_TRUE(config_store_blob_put("ota_sess", record, sizeof(record)));
+    TEST_ASSERT_EQUAL_UINT32(1, fake_prefs_commits());
+    TEST_ASSERT_EQUAL_size_t(5, config_store_blob_get("ota_sess", out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(record, out, 5);
+    TEST_ASSERT_EQUAL_size_t(0, config_store_blob_get("ota_sess", out, 4)); // Does not fit
+
+    config_store_blob_remove("ota_sess");
+    TEST_ASSERT_EQUAL_size_t(0, config_store_blob_get("ota_sess", out, sizeof(out)));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_empty_nvs_gives_defaults);
+    RUN_TEST(test_burst_is_one_commit_per_namespace);
+    RUN_TEST(test_unchanged_values_are_not_written);
+    RUN_TEST(test_commit_waits_for_quiet_time);
+    RUN_TEST(test_failed_write_is_retried);
+    RUN_TEST(test_new_credentials_drop_cached_link);
+    RUN_TEST(test_v0_layout_is_migrated);
+    RUN_TEST(test_erase_resets_namespace);
+    RUN_TEST(test_blobs_write_through);
+    return UNITY_END();
+}
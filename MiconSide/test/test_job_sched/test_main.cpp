@@ -0,0 +1,270 @@
+#include <unity.h>
+
+#include "job_sched.h"
+
+#include <string.h>
+
+#include <vector>
+
+// Virtual clock: only the test (and jobs simulating their run time) move it
+static int64_t s_now_us;
+
+static int64_t virtual_clock(void)
+{
+    return s_now_us;
+}
+
+typedef struct
+{
+    std::vector<int64_t> at_ms; // Virtual time of every run
+    uint32_t busy_ms;           // Simulated run time
+    int cancel_id;              // Job to cancel from inside the run, -1 = none
+} probe_t;
+
+static probe_t s_probe[SCHED_MAX_JOBS];
+static std::vector<int> s_order; // Probe index of every run, in run order
+
+static void probe_job(void *arg)
+{
+    probe_t *p = (probe_t *)arg;
+    p->at_ms.push_back(s_now_us / 1000);
+    s_order.push_back((int)(p - s_probe));
+    s_now_us += (int64_t)p->busy_ms * 1000;
+    if (p->cancel_id >= 0)
+        sched_cancel(p->cancel_id);
+}
+
+static int add(int probe, uint32_t period_ms, uint32_t delay_ms, uint8_t priority = SCHED_PRIO_NORMAL)
+{
+    return sched_add("probe", probe_job, &s_probe[probe], period_ms, delay_ms, priority);
+}
+
+// loop(): run due jobs every step_ms until the clock reaches until_ms
+static void run_until(int64_t until_ms, uint32_t step_ms = 1)
+{
+    while (s_now_us / 1000 < until_ms)
+    {
+        s_now_us += (int64_t)step_ms * 1000;
+        sched_run();
+    }
+}
+
+void setUp(void)
+{
+    s_now_us = 0;
+    for (int i = 0; i < SCHED_MAX_JOBS; i++)
+    {
+        s_probe[i].at_ms.clear();
+        s_probe[i].busy_ms = 0;
+        s_probe[i].cancel_id = -1;
+    }
+    s_order.clear();
+    sched_init(virtual_clock);
+}
+
+void tearDown(void)
+{
+}
+
+// The loop() timers it replaced: 1 s heartbeat, 5 s Wi-Fi check, 10 s stats, 30 s reconnect
+static void test_periodic_jobs_keep_their_period(void)
+{
+    add(0, 1000, 1000);
+    add(1, 5000, 5000);
+    add(2, 10000, 10000);
+    add(3, 30000, 30000);
+    run_until(120000);
+
+    TEST_ASSERT_EQUAL_size_t(120, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_size_t(24, s_probe[1].at_ms.size());
+    TEST_ASSERT_EQUAL_size_t(12, s_probe[2].at_ms.size());
+    TEST_ASSERT_EQUAL_size_t(4, s_probe[3].at_ms.size());
+    for (size_t i = 0; i < s_probe[0].at_ms.size(); i++)
+        TEST_ASSERT_EQUAL_INT64((int64_t)(i + 1) * 1000, s_probe[0].at_ms[i]);
+    for (size_t i = 0; i < s_probe[3].at_ms.size(); i++)
+        TEST_ASSERT_EQUAL_INT64((int64_t)(i + 1) * 30000, s_probe[3].at_ms[i]);
+}
+
+// Delays round up to whole ticks and are never early
+static void test_delay_rounds_up_to_ticks(void)
+{
+    add(0, 0, 1);
+    add(1, 0, 25);
+    run_until(100);
+    TEST_ASSERT_EQUAL_size_t(1, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_INT64(SCHED_TICK_MS, s_probe[0].at_ms[0]);
+    TEST_ASSERT_EQUAL_INT64(30, s_probe[1].at_ms[0]);
+}
+
+static void test_one_shot_frees_its_slot(void)
+{
+    int id = add(0, 0, 50);
+    sched_stats_t stats;
+    TEST_ASSERT_TRUE(sched_get_stats(id, &stats));
+    run_until(1000);
+    TEST_ASSERT_EQUAL_size_t(1, s_probe[0].at_ms.size());
+    TEST_ASSERT_FALSE(sched_get_stats(id, &stats));
+    TEST_ASSERT_EQUAL_UINT32(SCHED_IDLE, sched_next_ms());
+}
+
+static void test_slots_run_out(void)
+{
+    for (int i = 0; i < SCHED_MAX_JOBS; i++)
+        TEST_ASSERT_EQUAL_INT(i, add(i, 1000, 1000));
+    TEST_ASSERT_EQUAL_INT(-1, add(0, 1000, 1000));
+    sched_cancel(5);
+    TEST_ASSERT_EQUAL_INT(5, add(5, 1000, 1000));
+}
+
+// Beyond both wheel levels (~41 s) jobs cascade down and still fire on time
+static void test_long_delays_cascade(void)
+{
+    add(0, 0, 700);     // Level 0
+    add(1, 0, 20000);   // Level 1
+    add(2, 0, 100000);  // Past the wheel span: parked, then cascaded again
+    add(3, 0, 3600000); // One hour
+    run_until(3700000, SCHED_TICK_MS);
+    TEST_ASSERT_EQUAL_INT64(700, s_probe[0].at_ms[0]);
+    TEST_ASSERT_EQUAL_INT64(20000, s_probe[1].at_ms[0]);
+    TEST_ASSERT_EQUAL_INT64(100000, s_probe[2].at_ms[0]);
+    TEST_ASSERT_EQUAL_INT64(3600000, s_probe[3].at_ms[0]);
+    for (int i = 0; i < 4; i++)
+        TEST_ASSERT_EQUAL_size_t(1, s_probe[i].at_ms.size());
+}
+
+static void test_same_tick_runs_by_priority(void)
+{
+    add(0, 0, 100, SCHED_PRIO_LOW);
+    add(1, 0, 100, SCHED_PRIO_HIGH);
+    add(2, 0, 100, SCHED_PRIO_NORMAL);
+    add(3, 0, 100, SCHED_PRIO_HIGH);
+    run_until(200);
+    static const uint8_t prio[] = {SCHED_PRIO_LOW, SCHED_PRIO_HIGH, SCHED_PRIO_NORMAL, SCHED_PRIO_HIGH};
+    TEST_ASSERT_EQUAL_size_t(4, s_order.size());
+    for (size_t i = 1; i < s_order.size(); i++)
+        TEST_ASSERT_GREATER_OR_EQUAL(prio[s_order[i]], prio[s_order[i - 1]]);
+    TEST_ASSERT_EQUAL_INT(0, s_order[3]);
+}
+
+static void test_cancel_and_trigger(void)
+{
+    int a = add(0, 1000, 1000);
+    int b = add(1, 1000, 1000);
+    run_until(2500);
+    sched_cancel(a);
+    sched_trigger(b); // Runs at the next tick, then keeps its period from there
+    run_until(2500 + SCHED_TICK_MS);
+    TEST_ASSERT_EQUAL_size_t(2, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_size_t(3, s_probe[1].at_ms.size());
+    TEST_ASSERT_EQUAL_INT64(2500 + SCHED_TICK_MS, s_probe[1].at_ms[2]);
+    run_until(5000);
+    TEST_ASSERT_EQUAL_size_t(2, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_INT64(3500 + SCHED_TICK_MS, s_probe[1].at_ms[3]);
+
+    sched_cancel(-1); // Ignored
+    sched_trigger(SCHED_MAX_JOBS);
+}
+
+// A job due in the same tick that an earlier job cancels does not run
+static void test_cancel_from_a_job(void)
+{
+    int victim = add(1, 1000, 100, SCHED_PRIO_LOW);
+    s_probe[0].cancel_id = victim;
+    add(0, 0, 100, SCHED_PRIO_HIGH);
+    run_until(5000);
+    TEST_ASSERT_EQUAL_size_t(1, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_size_t(0, s_probe[1].at_ms.size());
+}
+
+static void test_run_time_and_overruns(void)
+{
+    int id = add(0, 100, 100);
+    s_probe[0].busy_ms = 30;
+    run_until(1000);
+    sched_stats_t stats;
+    TEST_ASSERT_TRUE(sched_get_stats(id, &stats));
+    TEST_ASSERT_EQUAL_UINT32(30000, stats.last_us);
+    TEST_ASSERT_EQUAL_UINT32(30000, stats.max_us);
+    TEST_ASSERT_EQUAL_UINT32(0, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT64((uint64_t)stats.runs * 30000, stats.total_us);
+
+    // Longer than its period: counted, and the missed run is skipped rather than made up
+    s_probe[0].busy_ms = 250;
+    uint32_t runs = stats.runs;
+    run_until(3000);
+    TEST_ASSERT_TRUE(sched_get_stats(id, &stats));
+    TEST_ASSERT_GREATER_THAN(0, stats.overruns);
+    TEST_ASSERT_LESS_OR_EQUAL(2000 / 250 + 1, stats.runs - runs);
+    for (size_t i = runs + 1; i < s_probe[0].at_ms.size(); i++)
+        TEST_ASSERT_GREATER_OR_EQUAL(s_probe[0].at_ms[i - 1] + (int64_t)s_probe[0].busy_ms,
+                                     s_probe[0].at_ms[i]);
+}
+
+// loop() stalled (e.g. a blocking Wi-Fi connect): jobs run once, late, and count the miss
+static void test_stalled_loop(void)
+{
+    int id = add(0, 1000, 1000);
+    run_until(3000);
+    s_now_us += 7500 * 1000;
+    sched_run();
+    TEST_ASSERT_EQUAL_size_t(4, s_probe[0].at_ms.size());
+    sched_stats_t stats;
+    TEST_ASSERT_TRUE(sched_get_stats(id, &stats));
+    TEST_ASSERT_EQUAL_UINT32(1, stats.overruns);
+    TEST_ASSERT_EQUAL_UINT32(6500, stats.max_late_ms);
+    run_until(12000);
+    TEST_ASSERT_EQUAL_INT64(11500, s_probe[0].at_ms[4]);
+
+    // A jump past the whole wheel relinks everything
+    s_now_us += 600000LL * 1000;
+    sched_run();
+    TEST_ASSERT_EQUAL_size_t(6, s_probe[0].at_ms.size());
+    TEST_ASSERT_EQUAL_UINT32(1000, sched_next_ms());
+}
+
+static void test_next_ms(void)
+{
+    TEST_ASSERT_EQUAL_UINT32(SCHED_IDLE, sched_next_ms());
+    add(0, 5000, 5000);
+    add(1, 0, 250);
+    s_now_us = 3000; // 3 ms into the first tick
+    TEST_ASSERT_EQUAL_UINT32(247, sched_next_ms());
+    run_until(300);
+    TEST_ASSERT_EQUAL_UINT32(4700, sched_next_ms());
+    s_now_us = 6000 * 1000; // Overdue until sched_run()
+    TEST_ASSERT_EQUAL_UINT32(0, sched_next_ms());
+}
+
+// The tick counter wraps after ~497 days of uptime
+static void test_tick_counter_wrap(void)
+{
+    s_now_us = ((int64_t)UINT32_MAX - 50) * SCHED_TICK_MS * 1000;
+    sched_init(virtual_clock);
+    int64_t start_ms = s_now_us / 1000;
+    add(0, 100, 100);
+    add(1, 0, 5000);
+    run_until(start_ms + 10000, SCHED_TICK_MS);
+    TEST_ASSERT_EQUAL_size_t(100, s_probe[0].at_ms.size());
+    for (size_t i = 0; i < s_probe[0].at_ms.size(); i++)
+        TEST_ASSERT_EQUAL_INT64(start_ms + (int64_t)(i + 1) * 100, s_probe[0].at_ms[i]);
+    TEST_ASSERT_EQUAL_size_t(1, s_probe[1].at_ms.size());
+    TEST_ASSERT_EQUAL_INT64(start_ms + 5000, s_probe[1].at_ms[0]);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_periodic_jobs_keep_their_period);
+    RUN_TEST(test_delay_rounds_up_to_ticks);
+    RUN_TEST(test_one_shot_frees_its_slot);
+    RUN_TEST(test_slots_run_out);
+    RUN_TEST(test_long_delays_cascade);
+    RUN_TEST(test_same_tick_runs_by_priority);
+    RUN_TEST(test_cancel_and_trigger);
+    RUN_TEST(test_cancel_from_a_job);
+    RUN_TEST(test_run_time_and_overruns);
+    RUN_TEST(test_stalled_loop);
+    RUN_TEST(test_next_ms);
+    RUN_TEST(test_tick_counter_wrap);
+    return UNITY_END();
+}
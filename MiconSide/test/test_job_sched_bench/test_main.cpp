@@ -0,0 +1,108 @@
+#include <unity.h>
+
+#include "job_sched.h"
+
+#include <chrono>
+#include <stdio.h>
+
+// Virtual time decides what is due; std::chrono measures what the scheduler itself costs.
+// Host timings only show relative cost; the ESP32-S3 is slower.
+#define BENCH_VIRTUAL_MS (3600 * 1000) // One hour of loop() iterations
+
+static int64_t s_now_us;
+static volatile uint32_t s_runs;
+
+static int64_t virtual_clock(void)
+{
+    return s_now_us;
+}
+
+static void bench_job(void *arg)
+{
+    s_runs++;
+}
+
+static void report(const char *name, double total_ns, uint32_t calls)
+{
+    char line[96];
+    snprintf(line, sizeof(line), "%-34s %10u calls %8.1f ns/call", name, (unsigned)calls, total_ns / calls);
+    TEST_MESSAGE(line);
+}
+
+// loop() polls every step_ms; returns ns per sched_run() call
+static double bench_loop(const char *name, uint32_t step_ms)
+{
+    int64_t end_us = s_now_us + (int64_t)BENCH_VIRTUAL_MS * 1000; // The wheel never goes back in time
+    s_runs = 0;
+    uint32_t calls = 0;
+    auto start = std::chrono::steady_clock::now();
+    while (s_now_us < end_us)
+    {
+        s_now_us += (int64_t)step_ms * 1000;
+        sched_run();
+        calls++;
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    report(name, ns, calls);
+    return ns / calls;
+}
+
+void setUp(void)
+{
+    s_now_us = 0;
+    sched_init(virtual_clock);
+}
+
+void tearDown(void)
+{
+}
+
+// The four loop() timers (1 s / 5 s / 10 s / 30 s)
+static void test_bench_loop_timers(void)
+{
+    sched_add("heartbeat", bench_job, NULL, 1000, 1000, SCHED_PRIO_NORMAL);
+    sched_add("wifi", bench_job, NULL, 5000, 5000, SCHED_PRIO_NORMAL);
+    sched_add("stats", bench_job, NULL, 10000, 10000, SCHED_PRIO_LOW);
+    sched_add("reconnect", bench_job, NULL, 30000, 30000, SCHED_PRIO_LOW);
+    bench_loop("4 jobs, loop() every 1 ms", 1);
+    TEST_ASSERT_EQUAL_UINT32(3600 + 720 + 360 + 120, s_runs);
+}
+
+// Every slot used, periods spread across both wheel levels
+static void test_bench_full_wheel(void)
+{
+    for (int i = 0; i < SCHED_MAX_JOBS; i++)
+    {
+        uint32_t period = 10u << (i % 12); // 10 ms .. ~20 s
+        TEST_ASSERT_GREATER_OR_EQUAL(0, sched_add("job", bench_job, NULL, period, period, (uint8_t)(i % 3)));
+    }
+    bench_loop("16 jobs, loop() every 1 ms", 1);
+    bench_loop("16 jobs, loop() every 10 ms", SCHED_TICK_MS);
+    TEST_ASSERT_GREATER_THAN(0, s_runs);
+}
+
+// A sleeping loop() asks how long it may wait
+static void test_bench_next_ms(void)
+{
+    for (int i = 0; i < SCHED_MAX_JOBS; i++)
+        sched_add("job", bench_job, NULL, 1000 + 100 * i, 1000, SCHED_PRIO_NORMAL);
+    uint32_t sum = 0, calls = 100000;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < calls; i++)
+    {
+        s_now_us = (int64_t)(i % 1000) * 1000;
+        sum += sched_next_ms();
+    }
+    double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+    report("sched_next_ms, 16 jobs", ns, calls);
+    TEST_ASSERT_GREATER_THAN(0, sum);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_bench_loop_timers);
+    RUN_TEST(test_bench_full_wheel);
+    RUN_TEST(test_bench_next_ms);
+    return UNITY_END();
+}
@@ -0,0 +1,244 @@
+#include <unity.h>
+
+#include "led_engine.h"
+
+#include <vector>
+
+// Patterns as main.cpp declares them: {r, g, b, gpio_on, ms}
+static const led_step_t STEPS_IDLE[] = {{0, 0, 0, false, LED_HOLD}};
+static const led_step_t STEPS_HEARTBEAT[] = {{0, 24, 0, true, 120}};
+static const led_step_t STEPS_PROVISIONING[] = {{0, 0, 24, true, 500}, {0, 0, 0, false, 500}};
+static const led_step_t STEPS_WIFI_FAILED[] = {
+    {24, 0, 0, true, 150}, {0, 0, 0, false, 150}, {24, 0, 0, true, 150}, {0, 0, 0, false, 1000}};
+static const led_step_t STEPS_OTA_DONE[] = {{0, 24, 0, true, 200}, {0, 0, 0, false, 200}, {0, 24, 0, true, 300}};
+
+static const led_pattern_t IDLE = LED_PATTERN(STEPS_IDLE, 0);
+static const led_pattern_t HEARTBEAT = LED_PATTERN(STEPS_HEARTBEAT, 1);
+static const led_pattern_t TRIPLE_HEARTBEAT = LED_PATTERN(STEPS_HEARTBEAT, 3);
+static const led_pattern_t PROVISIONING = LED_PATTERN(STEPS_PROVISIONING, 0);
+static const led_pattern_t WIFI_FAILED = LED_PATTERN(STEPS_WIFI_FAILED, 0);
+static const led_pattern_t OTA_DONE = LED_PATTERN(STEPS_OTA_DONE, 2);
+static const led_pattern_t EMPTY = {STEPS_IDLE, 0, 0};
+
+// Driver model of status_led_apply(): show a step, arm a one-shot for its duration
+typedef struct
+{
+    uint32_t at_ms;
+    led_step_t step;
+} shown_t;
+
+static led_engine_t s_e;
+static uint32_t s_now_ms;
+static uint32_t s_deadline_ms; // UINT32_MAX = held
+static std::vector<shown_t> s_shown;
+
+static void apply(void)
+{
+    led_step_t out;
+    uint32_t ms = led_engine_advance(&s_e, &out);
+    s_shown.push_back({s_now_ms, out});
+    s_deadline_ms = ms == LED_HOLD ? UINT32_MAX : s_now_ms + ms;
+}
+
+// Let the timer fire up to until_ms
+static void run_until(uint32_t until_ms)
+{
+    while (s_deadline_ms <= until_ms)
+    {
+        s_now_ms = s_deadline_ms;
+        apply();
+    }
+    s_now_ms = until_ms;
+}
+
+static void set_state(const led_pattern_t *p)
+{
+    if (led_engine_set_base(&s_e, p))
+        apply();
+}
+
+static void play(const led_pattern_t *p)
+{
+    led_engine_play(&s_e, p);
+    apply();
+}
+
+static void assert_shown(size_t i, uint32_t at_ms, const led_step_t *step)
+{
+    TEST_ASSERT_LESS_THAN(s_shown.size(), i);
+    TEST_ASSERT_EQUAL_UINT32(at_ms, s_shown[i].at_ms);
+    TEST_ASSERT_EQUAL_UINT8(step->r, s_shown[i].step.r);
+    TEST_ASSERT_EQUAL_UINT8(step->g, s_shown[i].step.g);
+    TEST_ASSERT_EQUAL_UINT8(step->b, s_shown[i].step.b);
+    TEST_ASSERT_EQUAL(step->gpio_on, s_shown[i].step.gpio_on);
+}
+
+void setUp(void)
+{
+    led_engine_init(&s_e);
+    s_now_ms = 0;
+    s_deadline_ms = UINT32_MAX;
+    s_shown.clear();
+}
+
+void tearDown(void)
+{
+}
+
+static void test_no_pattern_is_off(void)
+{
+    led_step_t out = {1, 1, 1, true, 5};
+    TEST_ASSERT_EQUAL_UINT32(LED_HOLD, led_engine_advance(&s_e, &out));
+    TEST_ASSERT_FALSE(out.gpio_on);
+    TEST_ASSERT_EQUAL_UINT8(0, out.r | out.g | out.b);
+
+    led_engine_set_base(&s_e, &EMPTY);
+    TEST_ASSERT_EQUAL_UINT32(LED_HOLD, led_engine_advance(&s_e, &out));
+    TEST_ASSERT_FALSE(out.gpio_on);
+}
+
+static void test_hold_step_needs_no_timer(void)
+{
+    set_state(&IDLE);
+    run_until(60000);
+    TEST_ASSERT_EQUAL_size_t(1, s_shown.size());
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, s_deadline_ms);
+}
+
+static void test_looping_base_cycles(void)
+{
+    set_state(&WIFI_FAILED);
+    run_until(2900);
+    static const uint32_t at[] = {0, 150, 300, 450, 1450, 1600, 1750, 1900, 2900};
+    TEST_ASSERT_EQUAL_size_t(9, s_shown.size());
+    for (size_t i = 0; i < 9; i++)
+        assert_shown(i, at[i], &STEPS_WIFI_FAILED[i % 4]);
+}
+
+// Same state again: no refresh, no restart mid-pattern
+static void test_same_base_does_not_restart(void)
+{
+    set_state(&PROVISIONING);
+    run_until(700);
+    TEST_ASSERT_FALSE(led_engine_set_base(&s_e, &PROVISIONING));
+    run_until(1000);
+    TEST_ASSERT_EQUAL_size_t(3, s_shown.size());
+    assert_shown(2, 1000, &STEPS_PROVISIONING[0]);
+}
+
+static void test_new_base_restarts_from_first_step(void)
+{
+    set_state(&PROVISIONING);
+    run_until(700);
+    set_state(&WIFI_FAILED);
+    assert_shown(2, 700, &STEPS_WIFI_FAILED[0]);
+    run_until(850);
+    assert_shown(3, 850, &STEPS_WIFI_FAILED[1]);
+}
+
+// The heartbeat flash interrupts the base, then the base starts over
+static void test_overlay_returns_to_base(void)
+{
+    set_state(&PROVISIONING);
+    run_until(700);
+    play(&HEARTBEAT);
+    assert_shown(2, 700, &STEPS_HEARTBEAT[0]);
+    run_until(820);
+    assert_shown(3, 820, &STEPS_PROVISIONING[0]);
+    run_until(1320);
+    assert_shown(4, 1320, &STEPS_PROVISIONING[1]);
+    TEST_ASSERT_EQUAL_size_t(5, s_shown.size());
+}
+
+static void test_overlay_repeats(void)
+{
+    set_state(&IDLE);
+    play(&TRIPLE_HEARTBEAT);
+    run_until(1000);
+    TEST_ASSERT_EQUAL_size_t(5, s_shown.size());
+    assert_shown(1, 0, &STEPS_HEARTBEAT[0]);
+    assert_shown(2, 120, &STEPS_HEARTBEAT[0]);
+    assert_shown(3, 240, &STEPS_HEARTBEAT[0]);
+    assert_shown(4, 360, &STEPS_IDLE[0]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, s_deadline_ms);
+}
+
+// A state change during an overlay waits for the overlay to finish
+static void test_base_change_during_overlay(void)
+{
+    set_state(&IDLE);
+    play(&TRIPLE_HEARTBEAT);
+    run_until(130);
+    TEST_ASSERT_FALSE(led_engine_set_base(&s_e, &PROVISIONING));
+    run_until(360);
+    assert_shown(4, 360, &STEPS_PROVISIONING[0]);
+    run_until(860);
+    assert_shown(5, 860, &STEPS_PROVISIONING[1]);
+}
+
+// A new overlay replaces the one playing
+static void test_overlay_replaces_overlay(void)
+{
+    set_state(&IDLE);
+    play(&TRIPLE_HEARTBEAT);
+    run_until(130);
+    play(&HEARTBEAT);
+    run_until(2000);
+    TEST_ASSERT_EQUAL_size_t(5, s_shown.size());
+    assert_shown(3, 130, &STEPS_HEARTBEAT[0]);
+    assert_shown(4, 250, &STEPS_IDLE[0]);
+}
+
+// A finite base plays its repeats and then holds the last step
+static void test_finite_base_holds_last_step(void)
+{
+    set_state(&OTA_DONE);
+    run_until(5000);
+    TEST_ASSERT_EQUAL_size_t(7, s_shown.size());
+    assert_shown(5, 1100, &STEPS_OTA_DONE[2]);
+    assert_shown(6, 1400, &STEPS_OTA_DONE[2]);
+    TEST_ASSERT_EQUAL_UINT32(UINT32_MAX, s_deadline_ms);
+}
+
+// loop() heartbeat every second over the provisioning blink
+static void test_heartbeat_over_provisioning(void)
+{
+    set_state(&PROVISIONING);
+    for (uint32_t t = 1000; t <= 10000; t += 1000)
+    {
+        run_until(t);
+        play(&HEARTBEAT);
+    }
+    run_until(10120);
+    assert_shown(s_shown.size() - 1, 10120, &STEPS_PROVISIONING[0]);
+
+    // Every flash is 120 ms and followed by the base's first step
+    size_t flashes = 0;
+    for (size_t i = 0; i + 1 < s_shown.size(); i++)
+    {
+        if (s_shown[i].step.g == 24)
+        {
+            flashes++;
+            TEST_ASSERT_EQUAL_UINT32(s_shown[i].at_ms + 120, s_shown[i + 1].at_ms);
+            TEST_ASSERT_EQUAL_UINT8(24, s_shown[i + 1].step.b);
+        }
+    }
+    TEST_ASSERT_EQUAL_size_t(10, flashes);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_no_pattern_is_off);
+    RUN_TEST(test_hold_step_needs_no_timer);
+    RUN_TEST(test_looping_base_cycles);
+    RUN_TEST(test_same_base_does_not_restart);
+    RUN_TEST(test_new_base_restarts_from_first_step);
+    RUN_TEST(test_overlay_returns_to_base);
+    RUN_TEST(test_overlay_repeats);
+    RUN_TEST(test_base_change_during_overlay);
+    RUN_TEST(test_overlay_replaces_overlay);
+    RUN_TEST(test_finite_base_holds_last_step);
+    RUN_TEST(test_heartbeat_over_provisioning);
+    return UNITY_END();
+}
@@ -0,0 +1,134 @@
+#include <unity.h>
+
+#include "log_dict.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+
+// The dictionary path of LOG_EMIT in main.cpp: pack now, format later
+#define DICT_FORMAT(out, fmt, ...)                                                  \
+    do                                                                              \
+    {                                                                               \
+        log_dict_record_t rec;                                                      \
+        log_dict_build(&rec, LOG_DICT_ID(fmt), fmt, ##__VA_ARGS__);                 \
+        log_dict_format(rec.data, rec.len, out, sizeof(out));                       \
+    } while (0)
+
+// Decoded text must equal what the text logger (log_printf -> vsnprintf) prints
+#define ASSERT_SAME_AS_TEXT(fmt, ...)                                               \
+    do                                                                              \
+    {                                                                               \
+        char text[256], decoded[256];                                               \
+        snprintf(text, sizeof(text), fmt, ##__VA_ARGS__);                           \
+        DICT_FORMAT(decoded, fmt, ##__VA_ARGS__);                                   \
+        TEST_ASSERT_EQUAL_STRING(text, decoded);                                    \
+    } while (0)
+
+void setUp(void)
+{
+}
+
+void tearDown(void)
+{
+}
+
+// Formats as they appear in main.cpp, tag included
+static void test_firmware_formats(void)
+{
+    uint32_t bytes = 1234567, ms = 98765;
+    ASSERT_SAME_AS_TEXT("[I] BLE device initialized");
+    ASSERT_SAME_AS_TEXT("[I] [OTA] Wi-Fi upload done: %u bytes in %u ms (%u KB/s), waiting for END", bytes, ms,
+                        (unsigned)(bytes / ms));
+    ASSERT_SAME_AS_TEXT("[I] OTA_NET=%u/%u,DENIED=%u,LAST=%u/%u", 1u, 2u, 0u, 3u, 4u);
+    ASSERT_SAME_AS_TEXT("[W] [OTA] Wi-Fi upload ended (result %d) at %u / %u bytes", -3, bytes, 2u * bytes);
+    ASSERT_SAME_AS_TEXT("[I] STATE=%d,WIFI=%d,OTA_MODE=%d,IP=%s,LVL=%d,LOG_DROP=%u/%uB,LOG_NOTIFY=%u", 2, 1, 0,
+                        "192.168.1.10", 2, 3u, 456u, 789u);
+    ASSERT_SAME_AS_TEXT("[I] SSID: %s", "my-network");
+    ASSERT_SAME_AS_TEXT("[D] hash %02X%02X%02X", 0x0A, 0xFF, 0x00);
+    ASSERT_SAME_AS_TEXT("[I] %.*s", 4, "truncate me");
+}
+
+static void test_integer_conversions(void)
+{
+    ASSERT_SAME_AS_TEXT("%d %i %u", INT32_MIN, -1, UINT32_MAX);
+    ASSERT_SAME_AS_TEXT("%x %X %o %c", 0xdeadbeefu, 0xabcu, 8u, 'Z');
+    ASSERT_SAME_AS_TEXT("[%8d|%-8d|%+d|% d|%08x|%#x]", 42, 42, 42, 42, 0x1f, 0x1f);
+    ASSERT_SAME_AS_TEXT("%*d|%-*u", 6, -7, 5, 9u);
+    ASSERT_SAME_AS_TEXT("%hd %hu", (short)-3, (unsigned short)65535);
+    ASSERT_SAME_AS_TEXT("%lld %llu %llx", (long long)INT64_MIN, (unsigned long long)UINT64_MAX, 0x123456789abcull);
+    ASSERT_SAME_AS_TEXT("%ld %lu", -123456L, 123456UL);
+    ASSERT_SAME_AS_TEXT("%zu %jd", (size_t)77, (intmax_t)-5);
+    ASSERT_SAME_AS_TEXT("100%% done");
+}
+
+static void test_floating_conversions(void)
+{
+    float rssi = -67.25f;
+    ASSERT_SAME_AS_TEXT("%.2f dBm", rssi);
+    ASSERT_SAME_AS_TEXT("%f %e %g %G", 3.5, 1234.5678, 0.0001, 1e20);
+    ASSERT_SAME_AS_TEXT("%8.3f|%-10.1e", -2.0, 6.02e23);
+}
+
+static void test_string_conversions(void)
+{
+    const char *ip = "192.168.1.10";
+    char name[] = "esp32-s3";
+    ASSERT_SAME_AS_TEXT("ip=%s host=%s", ip, name);
+    ASSERT_SAME_AS_TEXT("[%12s|%-12s|%.3s]", "ab", "cd", "efghij");
+    ASSERT_SAME_AS_TEXT("empty=[%s]", "");
+}
+
+// Deferred formatting copies strings at log time, not at format time
+static void test_strings_copied_at_log_time(void)
+{
+    char buf[16] = "before";
+    log_dict_record_t rec;
+    log_dict_build(&rec, LOG_DICT_ID("%s"), "%s", buf);
+    strcpy(buf, "after");
+    char out[32];
+    log_dict_format(rec.data, rec.len, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("before", out);
+}
+
+// Output is cut like snprintf: NUL-terminated, length of what fits
+static void test_output_truncation(void)
+{
+    char small[10];
+    DICT_FORMAT(small, "value=%u and more", 123456u);
+    TEST_ASSERT_EQUAL_STRING("value=123", small);
+}
+
+// Arguments past the record size are dropped and shown as '?'
+static void test_missing_arguments(void)
+{
+    char big[300];
+    memset(big, 'x', sizeof(big) - 1);
+    big[sizeof(big) - 1] = '\0';
+    char out[512];
+    DICT_FORMAT(out, "%s|%u|%u", big, 1u, 2u);
+    TEST_ASSERT_EQUAL_STRING("|?|?", strchr(out, '|'));
+    TEST_ASSERT_LESS_THAN(LOG_DICT_RECORD_MAX, strchr(out, '|') - out);
+}
+
+// The dictionary key is the same FNV-1a as tools/log_dict.py (WebAppSide/log-dictionary.json)
+static void test_ids_match_dictionary(void)
+{
+    TEST_ASSERT_EQUAL_HEX32(0x0242889b, LOG_DICT_ID("[I] BLE device initialized"));
+    TEST_ASSERT_EQUAL_HEX32(0x0e35c920, LOG_DICT_ID("[I] [OTA] Wi-Fi upload done: %u bytes in %u ms (%u KB/s), waiting for END"));
+    TEST_ASSERT_NOT_EQUAL(LOG_DICT_TEXT_ID, LOG_DICT_ID(""));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_firmware_formats);
+    RUN_TEST(test_integer_conversions);
+    RUN_TEST(test_floating_conversions);
+    RUN_TEST(test_string_conversions);
+    RUN_TEST(test_strings_copied_at_log_time);
+    RUN_TEST(test_output_truncation);
+    RUN_TEST(test_missing_arguments);
+    RUN_TEST(test_ids_match_dictionary);
+    return UNITY_END();
+}
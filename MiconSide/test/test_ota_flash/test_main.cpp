@@ -0,0 +1,188 @@
+#include <unity.h>
+
+#include "ota_flash.h"
+
+#include <esp_ota_ops.h>
+#include <fake_flash.h>
+#include <mbedtls/sha256.h>
+#include <string.h>
+
+#define IMAGE_SIZE (10 * OTA_FLASH_SECTOR_SIZE + 1000) // Ends in a partial sector
+
+static uint8_t s_image[IMAGE_SIZE];
+
+static void fill_image(uint32_t seed)
+{
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+    {
+        seed = seed * 1103515245u + 12345u;
+        s_image[i] = (uint8_t)(seed >> 16);
+    }
+}
+
+// Feed [from, IMAGE_SIZE) in uneven chunks, as the pipeline's batches would not be
+static bool write_image(size_t from)
+{
+    static const size_t chunks[] = {1, 100, 4096, 3000, 5000, 17};
+    size_t pos = from;
+    for (size_t i = 0; pos < IMAGE_SIZE; i++)
+    {
+        size_t n = chunks[i % 6];
+        if (n > IMAGE_SIZE - pos)
+            n = IMAGE_SIZE - pos;
+        if (ota_flash_write(s_image + pos, n) != n)
+            return false;
+        pos += n;
+    }
+    return true;
+}
+
+static void flash_full_image(void)
+{
+    uint8_t digest[32];
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    TEST_ASSERT_TRUE(write_image(0));
+    TEST_ASSERT_TRUE(ota_flash_finish(digest));
+}
+
+void setUp(void)
+{
+    fake_flash_reset();
+    fill_image(1);
+}
+
+void tearDown(void)
+{
+    ota_flash_abort();
+}
+
+static void test_image_lands_in_next_slot_with_digest(void)
+{
+    uint8_t digest[32];
+    uint8_t expected[32];
+    mbedtls_sha256(s_image, IMAGE_SIZE, expected, 0);
+
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    TEST_ASSERT_EQUAL_PTR(esp_ota_get_next_update_partition(NULL), ota_flash_partition());
+    TEST_ASSERT_TRUE(write_image(0));
+    TEST_ASSERT_EQUAL_size_t(10 * OTA_FLASH_SECTOR_SIZE, ota_flash_committed());
+    TEST_ASSERT_TRUE(ota_flash_finish(digest));
+
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, ota_flash_committed());
+    TEST_ASSERT_EQUAL_MEMORY(expected, digest, 32);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, fake_flash_data(ota_flash_partition()), IMAGE_SIZE);
+    TEST_ASSERT_EQUAL_size_t(11, ota_flash_sectors_written());
+}
+
+static void test_known_sha256(void)
+{
+    static const uint8_t abc_digest[32] = {
+        0xba, 0x78, 0x16, 0xbf, 0x8f, 0x01, 0xcf, 0xea, 0x41, 0x41, 0x40, 0xde, 0x5d, 0xae, 0x22, 0x23,
+        0xb0, 0x03, 0x61, 0xa3, 0x96, 0x17, 0x7a, 0x9c, 0xb4, 0x10, 0xff, 0x61, 0xf2, 0x00, 0x15, 0xad,
+    };
+    uint8_t digest[32];
+    mbedtls_sha256((const uint8_t *)"abc", 3, digest, 0);
+    TEST_ASSERT_EQUAL_MEMORY(abc_digest, digest, 32);
+}
+
+static void test_unchanged_sectors_are_skipped(void)
+{
+    flash_full_image();
+    fake_flash_stats_t before;
+    fake_flash_get_stats(&before);
+
+    s_image[5 * OTA_FLASH_SECTOR_SIZE + 10] ^= 0xFF; // One sector differs
+    flash_full_image();
+
+    fake_flash_stats_t after;
+    fake_flash_get_stats(&after);
+    TEST_ASSERT_EQUAL_size_t(1, ota_flash_sectors_written());
+    TEST_ASSERT_EQUAL_size_t(10, ota_flash_sectors_skipped());
+    TEST_ASSERT_EQUAL_UINT32(1, after.sectors_erased - before.sectors_erased);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, fake_flash_data(ota_flash_partition()), IMAGE_SIZE);
+}
+
+// A resumed session hashes what is already in flash, so the digest covers the whole image
+static void test_resume_offset_seeds_the_hash(void)
+{
+    uint8_t digest[32];
+    uint8_t expected[32];
+    mbedtls_sha256(s_image, IMAGE_SIZE, expected, 0);
+
+    const size_t resume_at = 4 * OTA_FLASH_SECTOR_SIZE;
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    TEST_ASSERT_EQUAL_size_t(resume_at, ota_flash_write(s_image, resume_at));
+    ota_flash_abort(); // Link lost
+
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, resume_at));
+    TEST_ASSERT_EQUAL_size_t(resume_at, ota_flash_committed());
+    TEST_ASSERT_TRUE(write_image(resume_at));
+    TEST_ASSERT_TRUE(ota_flash_finish(digest));
+    TEST_ASSERT_EQUAL_MEMORY(expected, digest, 32);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, fake_flash_data(ota_flash_partition()), IMAGE_SIZE);
+}
+
+static void test_begin_rejects_bad_offsets(void)
+{
+    TEST_ASSERT_FALSE(ota_flash_begin(IMAGE_SIZE, 100));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ota_flash_error());
+    TEST_ASSERT_FALSE(ota_flash_begin(0x200000, 0)); // Larger than the slot
+    TEST_ASSERT_FALSE(ota_flash_begin(IMAGE_SIZE, 12 * OTA_FLASH_SECTOR_SIZE));
+}
+
+static void test_write_past_size_fails(void)
+{
+    TEST_ASSERT_TRUE(ota_flash_begin(1000, 0));
+    TEST_ASSERT_EQUAL_size_t(0, ota_flash_write(s_image, 1001));
+    TEST_ASSERT_TRUE(ota_flash_failed());
+}
+
+static void test_flash_error_sticks(void)
+{
+    uint8_t digest[32];
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    fake_flash_fail(ESP_FAIL, 3); // Erase + program of sector 0, erase of sector 1, then the write fails
+    TEST_ASSERT_FALSE(write_image(0));
+    TEST_ASSERT_TRUE(ota_flash_failed());
+    TEST_ASSERT_EQUAL(ESP_FAIL, ota_flash_error());
+    TEST_ASSERT_EQUAL_size_t(OTA_FLASH_SECTOR_SIZE, ota_flash_committed());
+    TEST_ASSERT_FALSE(ota_flash_finish(digest));
+    TEST_ASSERT_FALSE(ota_flash_activate());
+}
+
+static void test_finish_needs_the_whole_image(void)
+{
+    uint8_t digest[32];
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    ota_flash_write(s_image, IMAGE_SIZE - 1);
+    TEST_ASSERT_FALSE(ota_flash_finish(digest));
+    TEST_ASSERT_EQUAL(ESP_ERR_INVALID_SIZE, ota_flash_error());
+}
+
+static void test_activate_switches_boot_slot(void)
+{
+    flash_full_image();
+    fake_flash_set_boot_result(ESP_ERR_OTA_VALIDATE_FAILED);
+    TEST_ASSERT_FALSE(ota_flash_activate());
+    TEST_ASSERT_EQUAL(ESP_ERR_OTA_VALIDATE_FAILED, ota_flash_error());
+
+    flash_full_image();
+    fake_flash_set_boot_result(ESP_OK);
+    TEST_ASSERT_TRUE(ota_flash_activate());
+    TEST_ASSERT_EQUAL_PTR(ota_flash_partition(), esp_ota_get_boot_partition());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_image_lands_in_next_slot_with_digest);
+    RUN_TEST(test_known_sha256);
+    RUN_TEST(test_unchanged_sectors_are_skipped);
+    RUN_TEST(test_resume_offset_seeds_the_hash);
+    RUN_TEST(test_begin_rejects_bad_offsets);
+    RUN_TEST(test_write_past_size_fails);
+    RUN_TEST(test_flash_error_sticks);
+    RUN_TEST(test_finish_needs_the_whole_image);
+    RUN_TEST(test_activate_switches_boot_slot);
+    return UNITY_END();
+}
@@ -0,0 +1,184 @@
+#include <unity.h>
+
+#include "ota_inflate.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+// Round-trips a real firmware image when one was built (pio run), else this test executable
+static const char *const BIN_CANDIDATES[] = {
+    ".pio/build/esp32-s3-devkitc-1/firmware.bin",
+    NULL, // argv[0]
+};
+
+static const char *s_bin_path;
+static std::vector<uint8_t> s_bin;
+static std::vector<uint8_t> s_zbin;
+static std::vector<uint8_t> s_out;
+static size_t s_out_limit;
+static tinfl_decompressor s_decomp;
+static uint8_t s_dict[TINFL_LZ_DICT_SIZE];
+static ota_inflate_t s_z;
+
+static bool load_file(const char *path, std::vector<uint8_t> *out)
+{
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    out->clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        out->insert(out->end(), buf, buf + n);
+    fclose(f);
+    return !out->empty();
+}
+
+static std::vector<uint8_t> compress(const std::vector<uint8_t> &in)
+{
+    mz_ulong len = mz_compressBound((mz_ulong)in.size());
+    std::vector<uint8_t> out(len);
+    TEST_ASSERT_EQUAL_INT(MZ_OK, mz_compress2(out.data(), &len, in.data(), (mz_ulong)in.size(), MZ_BEST_COMPRESSION));
+    out.resize(len);
+    return out;
+}
+
+// Flash sink stand-in: appends, and fails once s_out_limit is reached
+static size_t collect(const uint8_t *data, size_t len)
+{
+    if (s_out.size() + len > s_out_limit)
+        return 0;
+    s_out.insert(s_out.end(), data, data + len);
+    return len;
+}
+
+// Feed z in chunks of the given sizes (cycled); false as soon as a write fails
+static bool feed(const std::vector<uint8_t> &z, const size_t *sizes, size_t count)
+{
+    size_t pos = 0;
+    for (size_t i = 0; pos < z.size(); i++)
+    {
+        size_t n = sizes[i % count];
+        if (n > z.size() - pos)
+            n = z.size() - pos;
+        if (!ota_inflate_write(&s_z, z.data() + pos, n, collect))
+            return false;
+        pos += n;
+    }
+    return true;
+}
+
+void setUp(void)
+{
+    s_out.clear();
+    s_out_limit = SIZE_MAX;
+    ota_inflate_begin(&s_z, &s_decomp, s_dict);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_real_bin_round_trip(void)
+{
+    TEST_MESSAGE(s_bin_path);
+    TEST_ASSERT_GREATER_THAN(64 * 1024, s_bin.size()); // Spans many dictionary wraps
+    TEST_ASSERT_LESS_THAN(s_bin.size(), s_zbin.size());
+
+    // 244 = one 247-byte-MTU OTA packet after the offset header
+    static const size_t sizes[] = {244};
+    TEST_ASSERT_TRUE(feed(s_zbin, sizes, 1));
+    TEST_ASSERT_TRUE(s_z.done);
+    TEST_ASSERT_FALSE(s_z.failed);
+    TEST_ASSERT_EQUAL_size_t(s_bin.size(), s_z.total_out);
+    TEST_ASSERT_EQUAL_size_t(s_bin.size(), s_out.size());
+    TEST_ASSERT_EQUAL_MEMORY(s_bin.data(), s_out.data(), s_bin.size());
+}
+
+// Chunk boundaries must not matter, down to single bytes and up to the whole stream
+static void test_odd_chunk_sizes(void)
+{
+    static const size_t sizes[] = {1, 3, 511, 7, 4096, 2, 65537};
+    TEST_ASSERT_TRUE(feed(s_zbin, sizes, sizeof(sizes) / sizeof(sizes[0])));
+    TEST_ASSERT_TRUE(s_z.done);
+    TEST_ASSERT_EQUAL_MEMORY(s_bin.data(), s_out.data(), s_bin.size());
+
+    ota_inflate_begin(&s_z, &s_decomp, s_dict);
+    s_out.clear();
+    static const size_t whole[] = {SIZE_MAX};
+    TEST_ASSERT_TRUE(feed(s_zbin, whole, 1));
+    TEST_ASSERT_EQUAL_size_t(s_bin.size(), s_out.size());
+    TEST_ASSERT_EQUAL_MEMORY(s_bin.data(), s_out.data(), s_bin.size());
+}
+
+// Highly repetitive input expands far beyond one 32 KB dictionary per write
+static void test_long_runs(void)
+{
+    std::vector<uint8_t> plain(300 * 1024, 0xFF);
+    for (size_t i = 0; i < plain.size(); i += 10000)
+        plain[i] = (uint8_t)i;
+    std::vector<uint8_t> z = compress(plain);
+    TEST_ASSERT_LESS_THAN(plain.size() / 50, z.size());
+
+    static const size_t sizes[] = {100};
+    TEST_ASSERT_TRUE(feed(z, sizes, 1));
+    TEST_ASSERT_TRUE(s_z.done);
+    TEST_ASSERT_EQUAL_size_t(plain.size(), s_out.size());
+    TEST_ASSERT_EQUAL_MEMORY(plain.data(), s_out.data(), plain.size());
+}
+
+static void test_corrupt_stream_fails(void)
+{
+    std::vector<uint8_t> z = s_zbin;
+    for (size_t i = z.size() / 2; i < z.size() / 2 + 64; i++)
+        z[i] ^= 0x5A;
+    static const size_t sizes[] = {244};
+    TEST_ASSERT_FALSE(feed(z, sizes, 1));
+    TEST_ASSERT_TRUE(s_z.failed);
+    TEST_ASSERT_FALSE(ota_inflate_write(&s_z, z.data(), 1, collect)); // Stays failed
+}
+
+static void test_trailing_bytes_fail(void)
+{
+    std::vector<uint8_t> z = s_zbin;
+    z.push_back(0);
+    static const size_t whole[] = {SIZE_MAX};
+    TEST_ASSERT_FALSE(feed(z, whole, 1));
+    TEST_ASSERT_TRUE(s_z.failed);
+    TEST_ASSERT_EQUAL_size_t(s_bin.size(), s_out.size());
+}
+
+// The sink fills up halfway through whichever image was loaded
+static void test_sink_failure_fails(void)
+{
+    s_out_limit = s_bin.size() / 2;
+    static const size_t sizes[] = {244};
+    TEST_ASSERT_FALSE(feed(s_zbin, sizes, 1));
+    TEST_ASSERT_TRUE(s_z.failed);
+    TEST_ASSERT_LESS_OR_EQUAL(s_out_limit, s_out.size());
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    for (const char *candidate : BIN_CANDIDATES)
+    {
+        s_bin_path = candidate ? candidate : argv[0];
+        if (load_file(s_bin_path, &s_bin))
+            break;
+    }
+    if (s_bin.size() > 1200 * 1024)
+        s_bin.resize(1200 * 1024);
+    s_zbin = compress(s_bin);
+
+    RUN_TEST(test_real_bin_round_trip);
+    RUN_TEST(test_odd_chunk_sizes);
+    RUN_TEST(test_long_runs);
+    RUN_TEST(test_corrupt_stream_fails);
+    RUN_TEST(test_trailing_bytes_fail);
+    RUN_TEST(test_sink_failure_fails);
+    return UNITY_END();
+}
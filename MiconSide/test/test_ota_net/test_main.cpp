@@ -0,0 +1,333 @@
+#include <unity.h>
+
+#include "ota_net_server.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Real sockets on 127.0.0.1: the server runs on a thread, the test is the HTTP client
+#define BODY_SIZE (100 * 1024 + 17)
+
+static const uint8_t TOKEN[OTA_NET_TOKEN_SIZE] = {0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77,
+                                                  0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff};
+static const char TOKEN_HEX[] = "00112233445566778899aabbccddeeff";
+
+static ota_net_server_t s_srv;
+static std::thread s_thread;
+static std::atomic<int> s_result;
+static uint16_t s_port;
+
+// Sink standing in for the OTA pipeline
+static std::vector<uint8_t> s_sink;
+static std::vector<uint8_t> s_body;
+static std::atomic<int> s_refusals; // push() calls still to refuse (ring full)
+static std::atomic<bool> s_sink_failed;
+static std::atomic<size_t> s_received;
+
+static bool sink_push(const uint8_t *data, size_t len, uint32_t timeout_ms)
+{
+    if (s_sink_failed)
+        return false;
+    if (s_refusals > 0)
+    {
+        s_refusals--;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        return false;
+    }
+    s_sink.insert(s_sink.end(), data, data + len);
+    return true;
+}
+
+static bool sink_failed(void)
+{
+    return s_sink_failed;
+}
+
+static void on_received(size_t len)
+{
+    s_received += len;
+}
+
+static int64_t now_ms(void)
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
+
+static const ota_net_server_ops_t s_ops = {sink_push, sink_failed, on_received, now_ms};
+
+static void start_server(size_t length, uint32_t accept_timeout_ms = 5000, uint32_t idle_timeout_ms = 2000)
+{
+    int fd = ota_net_server_listen(0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    s_port = ota_net_server_port(fd);
+    TEST_ASSERT_NOT_EQUAL(0, s_port);
+    ota_net_server_begin(&s_srv, &s_ops, fd, length, TOKEN);
+    s_srv.accept_timeout_ms = accept_timeout_ms;
+    s_srv.idle_timeout_ms = idle_timeout_ms;
+    s_result = -1;
+    s_thread = std::thread([] { s_result = ota_net_server_run(&s_srv); });
+}
+
+static ota_net_result_t join_server(void)
+{
+    s_thread.join();
+    TEST_ASSERT_EQUAL_INT(-1, s_srv.listen_fd); // Listening socket closed
+    return (ota_net_result_t)s_result.load();
+}
+
+static int client_connect(void)
+{
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    TEST_ASSERT_GREATER_OR_EQUAL(0, fd);
+    struct sockaddr_in addr = {};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(s_port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    TEST_ASSERT_EQUAL_INT(0, connect(fd, (struct sockaddr *)&addr, sizeof(addr)));
+    return fd;
+}
+
+static void client_send(int fd, const void *data, size_t len)
+{
+    const uint8_t *p = (const uint8_t *)data;
+    while (len > 0)
+    {
+        ssize_t n = send(fd, p, len, MSG_NOSIGNAL);
+        TEST_ASSERT_GREATER_THAN(0, n);
+        p += n;
+        len -= (size_t)n;
+    }
+}
+
+// Everything the server sends until it closes the connection
+static std::string client_response(int fd)
+{
+    std::string out;
+    char buf[512];
+    ssize_t n;
+    while ((n = recv(fd, buf, sizeof(buf), 0)) > 0)
+        out.append(buf, (size_t)n);
+    close(fd);
+    return out;
+}
+
+static std::string post_head(const char *path, const char *token, size_t length)
+{
+    char head[256];
+    snprintf(head, sizeof(head),
+             "POST %s HTTP/1.1\r\nHost: 127.0.0.1\r\nContent-Type: application/octet-stream\r\n"
+             "X-OTA-Token: %s\r\nContent-Length: %u\r\n\r\n",
+             path, token, (unsigned)length);
+    return head;
+}
+
+// One request, the head together with the first body chunk, the rest in chunk-sized pieces.
+// (A server that answers early and closes with unread bytes resets the connection.)
+static std::string request(const std::string &head, const uint8_t *body, size_t len, size_t chunk)
+{
+    int fd = client_connect();
+    size_t first = len < chunk ? len : chunk;
+    std::string segment = head + std::string((const char *)body, first);
+    client_send(fd, segment.data(), segment.size());
+    for (size_t pos = first; pos < len; pos += chunk)
+        client_send(fd, body + pos, len - pos < chunk ? len - pos : chunk);
+    return client_response(fd);
+}
+
+static void assert_status(const std::string &response, const char *status_line, const char *body)
+{
+    TEST_ASSERT_EQUAL_INT(0, response.compare(0, strlen(status_line), status_line));
+    TEST_ASSERT_TRUE(response.find("Access-Control-Allow-Origin: *") != std::string::npos);
+    size_t at = response.find("\r\n\r\n");
+    TEST_ASSERT_TRUE(at != std::string::npos);
+    TEST_ASSERT_EQUAL_STRING(body, response.c_str() + at + 4);
+}
+
+void setUp(void)
+{
+    s_body.resize(BODY_SIZE);
+    for (size_t i = 0; i < BODY_SIZE; i++)
+        s_body[i] = (uint8_t)(i * 31 + (i >> 11));
+    s_sink.clear();
+    s_refusals = 0;
+    s_sink_failed = false;
+    s_received = 0;
+}
+
+void tearDown(void)
+{
+    if (s_thread.joinable())
+    {
+        ota_net_server_close(&s_srv);
+        s_thread.join();
+    }
+}
+
+static void test_upload_streams_body(void)
+{
+    start_server(BODY_SIZE);
+    std::string response = request(post_head("/ota", TOKEN_HEX, BODY_SIZE), s_body.data(), BODY_SIZE, 1000);
+    assert_status(response, "HTTP/1.1 200 OK", "RECEIVED:102417");
+    TEST_ASSERT_EQUAL(OTA_NET_COMPLETE, join_server());
+    TEST_ASSERT_EQUAL_size_t(BODY_SIZE, s_sink.size());
+    TEST_ASSERT_EQUAL_MEMORY(s_body.data(), s_sink.data(), BODY_SIZE);
+    TEST_ASSERT_EQUAL_size_t(BODY_SIZE, s_received.load());
+    TEST_ASSERT_EQUAL_size_t(BODY_SIZE, s_srv.received);
+}
+
+// Head split across segments, body bytes in the same segment as the head
+static void test_split_head_and_body(void)
+{
+    start_server(BODY_SIZE);
+    std::string head = post_head("/ota?resume=1", TOKEN_HEX, BODY_SIZE);
+    std::string first = head + std::string((const char *)s_body.data(), 300);
+    int fd = client_connect();
+    for (size_t pos = 0; pos < first.size(); pos += 7)
+    {
+        client_send(fd, first.data() + pos, first.size() - pos < 7 ? first.size() - pos : 7);
+        if (pos % 70 == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    client_send(fd, s_body.data() + 300, BODY_SIZE - 300);
+    assert_status(client_response(fd), "HTTP/1.1 200 OK", "RECEIVED:102417");
+    TEST_ASSERT_EQUAL(OTA_NET_COMPLETE, join_server());
+    TEST_ASSERT_EQUAL_MEMORY(s_body.data(), s_sink.data(), BODY_SIZE);
+}
+
+// Preflight and stray requests do not use up the token
+static void test_preflight_then_upload(void)
+{
+    start_server(1000);
+    int fd = client_connect();
+    const char *options = "OPTIONS /ota HTTP/1.1\r\nOrigin: https://example.com\r\n\r\n";
+    client_send(fd, options, strlen(options));
+    assert_status(client_response(fd), "HTTP/1.1 204 No Content", "");
+
+    assert_status(request(post_head("/other", TOKEN_HEX, 0), s_body.data(), 0, 1), "HTTP/1.1 404", "NOT_FOUND");
+    fd = client_connect();
+    const char *get = "GET /ota HTTP/1.1\r\n\r\n";
+    client_send(fd, get, strlen(get));
+    assert_status(client_response(fd), "HTTP/1.1 405", "METHOD_NOT_ALLOWED");
+    fd = client_connect();
+    const char *bad = "garbage\r\n\r\n";
+    client_send(fd, bad, strlen(bad));
+    assert_status(client_response(fd), "HTTP/1.1 400", "BAD_REQUEST");
+
+    assert_status(request(post_head("/ota", TOKEN_HEX, 1000), s_body.data(), 1000, 1000), "HTTP/1.1 200 OK",
+                  "RECEIVED:1000");
+    TEST_ASSERT_EQUAL(OTA_NET_COMPLETE, join_server());
+}
+
+static void test_bad_tokens_are_denied(void)
+{
+    start_server(1000);
+    const char *wrong[] = {"", "00112233445566778899aabbccddeefe", "not-hex"};
+    for (int i = 0; i < OTA_NET_MAX_AUTH_FAILURES; i++)
+    {
+        std::string head = post_head("/ota", wrong[i], 1000);
+        assert_status(request(head, s_body.data(), 0, 1), "HTTP/1.1 401", "BAD_TOKEN");
+    }
+    TEST_ASSERT_EQUAL(OTA_NET_DENIED, join_server());
+    TEST_ASSERT_EQUAL_UINT8(OTA_NET_MAX_AUTH_FAILURES, s_srv.auth_failures);
+    TEST_ASSERT_EQUAL_size_t(0, s_sink.size());
+}
+
+// A good token with the wrong length spends the token
+static void test_wrong_length_fails(void)
+{
+    start_server(1000);
+    assert_status(request(post_head("/ota", TOKEN_HEX, 999), s_body.data(), 0, 1), "HTTP/1.1 400",
+                  "LENGTH:1000");
+    TEST_ASSERT_EQUAL(OTA_NET_FAILED, join_server());
+    TEST_ASSERT_EQUAL_size_t(0, s_sink.size());
+}
+
+static void test_client_drop_fails(void)
+{
+    start_server(BODY_SIZE);
+    int fd = client_connect();
+    std::string head = post_head("/ota", TOKEN_HEX, BODY_SIZE);
+    client_send(fd, head.data(), head.size());
+    client_send(fd, s_body.data(), 5000);
+    close(fd);
+    TEST_ASSERT_EQUAL(OTA_NET_FAILED, join_server());
+    TEST_ASSERT_EQUAL_size_t(5000, s_sink.size());
+}
+
+// A full sink holds the socket back (TCP flow control) instead of failing
+static void test_full_sink_backpressure(void)
+{
+    s_refusals = 50;
+    start_server(BODY_SIZE);
+    assert_status(request(post_head("/ota", TOKEN_HEX, BODY_SIZE), s_body.data(), BODY_SIZE, 4096),
+                  "HTTP/1.1 200 OK", "RECEIVED:102417");
+    TEST_ASSERT_EQUAL(OTA_NET_COMPLETE, join_server());
+    TEST_ASSERT_EQUAL_INT(0, s_refusals.load());
+    TEST_ASSERT_EQUAL_MEMORY(s_body.data(), s_sink.data(), BODY_SIZE);
+}
+
+static void test_sink_failure_answers_500(void)
+{
+    s_sink_failed = true;
+    start_server(1000);
+    assert_status(request(post_head("/ota", TOKEN_HEX, 1000), s_body.data(), 1000, 1000),
+                  "HTTP/1.1 500", "WRITE_FAILED");
+    TEST_ASSERT_EQUAL(OTA_NET_FAILED, join_server());
+}
+
+static void test_timeouts(void)
+{
+    // Nobody connects
+    start_server(1000, 200);
+    int64_t start = now_ms();
+    TEST_ASSERT_EQUAL(OTA_NET_TIMEOUT, join_server());
+    TEST_ASSERT_GREATER_OR_EQUAL(200, now_ms() - start);
+
+    // The client stalls mid-body
+    start_server(1000, 5000, 200);
+    int fd = client_connect();
+    std::string head = post_head("/ota", TOKEN_HEX, 1000);
+    client_send(fd, head.data(), head.size());
+    client_send(fd, s_body.data(), 10);
+    TEST_ASSERT_EQUAL(OTA_NET_TIMEOUT, join_server());
+    close(fd);
+}
+
+// ota_net_close() from another task stops the server within a poll slice
+static void test_close_from_owner(void)
+{
+    start_server(1000);
+    std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    int64_t start = now_ms();
+    ota_net_server_close(&s_srv);
+    TEST_ASSERT_EQUAL(OTA_NET_FAILED, join_server());
+    TEST_ASSERT_LESS_OR_EQUAL(OTA_NET_POLL_MS * 5, now_ms() - start);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_upload_streams_body);
+    RUN_TEST(test_split_head_and_body);
+    RUN_TEST(test_preflight_then_upload);
+    RUN_TEST(test_bad_tokens_are_denied);
+    RUN_TEST(test_wrong_length_fails);
+    RUN_TEST(test_client_drop_fails);
+    RUN_TEST(test_full_sink_backpressure);
+    RUN_TEST(test_sink_failure_answers_500);
+    RUN_TEST(test_timeouts);
+    RUN_TEST(test_close_from_owner);
+    return UNITY_END();
+}
@@ -0,0 +1,397 @@
+#include <unity.h>
+
+#include "ota_patch.h"
+
+#include <mbedtls/sha256.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <unordered_map>
+#include <vector>
+
+// Base and target images: OTA_PATCH_BASE / OTA_PATCH_TARGET name two .bin files
+// (e.g. two firmware builds); otherwise 512 KB of pseudo-random bytes and an edited copy,
+// so the patch size does not depend on how the test was compiled
+#define DEFAULT_BASE_SIZE (512 * 1024 + 77)
+
+// Patch bytes allowed on top of the edited bytes: header, plus the ops around each edit
+#define PATCH_HEADER_OVERHEAD 8
+#define PATCH_EDIT_OVERHEAD 32
+
+typedef std::vector<uint8_t> bytes_t;
+
+static bytes_t s_base;
+static bytes_t s_target;
+static bytes_t s_patch;
+static size_t s_edit_bytes; // Bytes edit_image() changed, inserted or appended
+static size_t s_edits;      // Separate places it edited
+static bytes_t s_out;
+static size_t s_out_limit;
+static bool s_base_fails;
+static ota_patch_t s_p;
+
+static bool load_file(const char *path, bytes_t *out)
+{
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    out->clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        out->insert(out->end(), buf, buf + n);
+    fclose(f);
+    return !out->empty();
+}
+
+// ============================================================================
+// Patch builder (same ops as generateOtaPatch() in WebAppSide/ota-patch.js)
+// ============================================================================
+
+#define BLOCK 32
+#define STRIDE 8
+#define MAX_MISMATCH_RUN 64
+
+static void put_u32(bytes_t *out, uint32_t v)
+{
+    for (int i = 0; i < 4; i++)
+        out->push_back((uint8_t)(v >> (8 * i)));
+}
+
+static void put_op(bytes_t *out, uint8_t op, uint32_t a, uint32_t b)
+{
+    out->push_back(op);
+    put_u32(out, a);
+    if (op != OTA_PATCH_OP_INSERT)
+        put_u32(out, b);
+}
+
+static void put_insert(bytes_t *out, const bytes_t &target, size_t start, size_t end)
+{
+    if (end <= start)
+        return;
+    put_op(out, OTA_PATCH_OP_INSERT, (uint32_t)(end - start), 0);
+    out->insert(out->end(), target.begin() + start, target.begin() + end);
+}
+
+static void put_add(bytes_t *out, size_t base_ofs, const bytes_t &diff, size_t start, size_t end)
+{
+    if (end <= start)
+        return;
+    put_op(out, OTA_PATCH_OP_ADD, (uint32_t)(base_ofs + start), (uint32_t)(end - start));
+    out->insert(out->end(), diff.begin() + start, diff.begin() + end);
+}
+
+// Exact runs of at least BLOCK bytes become COPY, the rest ADD
+static void put_region(bytes_t *out, size_t b, size_t t, size_t len)
+{
+    bytes_t diff(len);
+    for (size_t i = 0; i < len; i++)
+        diff[i] = (uint8_t)(s_target[t + i] - s_base[b + i]);
+
+    size_t add_start = 0, i = 0;
+    while (i < len)
+    {
+        size_t run = 0;
+        while (i + run < len && diff[i + run] == 0)
+            run++;
+        if (run >= BLOCK || i + run == len)
+        {
+            put_add(out, b, diff, add_start, i);
+            if (run > 0)
+                put_op(out, OTA_PATCH_OP_COPY, (uint32_t)(b + i), (uint32_t)run);
+            add_start = i + run;
+        }
+        i += run + 1;
+    }
+    put_add(out, b, diff, add_start, i < len ? i : len);
+}
+
+static bool block_equals(size_t b, size_t t)
+{
+    return b + BLOCK <= s_base.size() && t + BLOCK <= s_target.size() &&
+           memcmp(&s_base[b], &s_target[t], BLOCK) == 0;
+}
+
+static uint64_t block_key(const bytes_t &data, size_t ofs)
+{
+    uint64_t h = 1469598103934665603ull;
+    for (size_t i = 0; i < BLOCK; i++)
+        h = (h ^ data[ofs + i]) * 1099511628211ull;
+    return h;
+}
+
+static bytes_t make_patch(void)
+{
+    std::unordered_map<uint64_t, size_t> index;
+    for (size_t b = 0; b + BLOCK <= s_base.size(); b += STRIDE)
+        index.emplace(block_key(s_base, b), b);
+
+    bytes_t out = {'O', 'D', 'P', '1'};
+    put_u32(&out, (uint32_t)s_target.size());
+    size_t t = 0, pending = 0;
+    long delta = 0;
+    while (t + BLOCK <= s_target.size())
+    {
+        size_t b = (size_t)((long)t + delta);
+        if ((long)t + delta < 0 || !block_equals(b, t))
+        {
+            auto it = index.find(block_key(s_target, t));
+            if (it == index.end() || !block_equals(it->second, t))
+            {
+                t++;
+                continue;
+            }
+            b = it->second;
+        }
+        while (t > pending && b > 0 && s_target[t - 1] == s_base[b - 1])
+        {
+            t--;
+            b--;
+        }
+        put_insert(&out, s_target, pending, t);
+
+        long score = 0, best = 0;
+        size_t len = 0;
+        for (size_t i = 0; t + i < s_target.size() && b + i < s_base.size() && i - len < MAX_MISMATCH_RUN; i++)
+        {
+            score += s_target[t + i] == s_base[b + i] ? 1 : -1;
+            if (score > best)
+            {
+                best = score;
+                len = i + 1;
+            }
+        }
+        put_region(&out, b, t, len);
+        delta = (long)b - (long)t;
+        t += len;
+        pending = t;
+    }
+    put_insert(&out, s_target, pending, s_target.size());
+    return out;
+}
+
+static void make_base(bytes_t *out)
+{
+    uint32_t x = 0x2545F491;
+    out->resize(DEFAULT_BASE_SIZE);
+    for (uint8_t &b : *out)
+    {
+        x ^= x << 13;
+        x ^= x >> 17;
+        x ^= x << 5;
+        b = (uint8_t)x;
+    }
+}
+
+// "A few KB of code changed": an inserted function, shifted addresses, tweaks and a new tail.
+// Counts the edited bytes (the literal pool as one span) and the places edited into s_edit_bytes / s_edits.
+static bytes_t edit_image(const bytes_t &base)
+{
+    bytes_t t = base;
+    size_t n = t.size();
+    s_edit_bytes = 0;
+    s_edits = 0;
+
+    for (size_t i = 0; i < 8192 && n / 2 + i + 4 <= n; i += 4)
+        t[n / 2 + i] += 0x40; // Literal pool entries pointing past the insertion
+    s_edit_bytes += 8192;
+    s_edits++;
+
+    for (size_t i = 0; i < 100; i++)
+        t[(i * 7919) % n] ^= 0x5A;
+    s_edit_bytes += 100;
+    s_edits += 100;
+
+    bytes_t code(700);
+    for (size_t i = 0; i < code.size(); i++)
+        code[i] = (uint8_t)(i * 37 + 11);
+    t.insert(t.begin() + n / 3, code.begin(), code.end());
+    s_edit_bytes += code.size();
+    s_edits++;
+
+    t.resize(t.size() - 1000);
+    for (size_t i = 0; i < 2000; i++)
+        t.push_back((uint8_t)(i * 13));
+    s_edit_bytes += 2000;
+    s_edits++;
+    return t;
+}
+
+// ============================================================================
+// Applier harness
+// ============================================================================
+
+static bool read_base(size_t offset, uint8_t *dst, size_t len)
+{
+    if (s_base_fails || offset + len > s_base.size())
+        return false;
+    memcpy(dst, &s_base[offset], len);
+    return true;
+}
+
+static size_t collect(const uint8_t *data, size_t len)
+{
+    if (s_out.size() + len > s_out_limit)
+        return 0;
+    s_out.insert(s_out.end(), data, data + len);
+    return len;
+}
+
+// Feed the patch in chunks of the given size; false as soon as a write fails
+static bool apply_patch(const bytes_t &patch, size_t chunk)
+{
+    for (size_t pos = 0; pos < patch.size(); pos += chunk)
+    {
+        size_t n = patch.size() - pos < chunk ? patch.size() - pos : chunk;
+        if (!ota_patch_write(&s_p, &patch[pos], n, collect))
+            return false;
+    }
+    return true;
+}
+
+static void sha256(const bytes_t &data, uint8_t digest[32])
+{
+    mbedtls_sha256(data.data(), data.size(), digest, 0);
+}
+
+void setUp(void)
+{
+    s_out.clear();
+    s_out_limit = SIZE_MAX;
+    s_base_fails = false;
+    ota_patch_begin(&s_p, read_base, s_base.size());
+}
+
+void tearDown(void)
+{
+}
+
+static void test_images_loaded(void)
+{
+    TEST_ASSERT_GREATER_THAN(64 * 1024, s_base.size());
+    TEST_ASSERT_GREATER_THAN(0, s_target.size());
+}
+
+static void test_rebuilds_target_byte_exact(void)
+{
+    char msg[96];
+    snprintf(msg, sizeof(msg), "base %u B, target %u B, patch %u B", (unsigned)s_base.size(),
+             (unsigned)s_target.size(), (unsigned)s_patch.size());
+    TEST_MESSAGE(msg);
+
+    TEST_ASSERT_TRUE(apply_patch(s_patch, 244)); // One OTA packet payload at a time
+    TEST_ASSERT_TRUE(ota_patch_complete(&s_p));
+    TEST_ASSERT_EQUAL_size_t(s_target.size(), s_p.target_size);
+    TEST_ASSERT_EQUAL_size_t(s_target.size(), s_out.size());
+    TEST_ASSERT_EQUAL_MEMORY(s_target.data(), s_out.data(), s_target.size());
+
+    // The image hash check then sees the same digest as a full OTA
+    uint8_t want[32], got[32];
+    sha256(s_target, want);
+    sha256(s_out, got);
+    TEST_ASSERT_EQUAL_MEMORY(want, got, 32);
+}
+
+// Unchanged bytes cost only COPY ops: the patch is the edits plus a bounded overhead per edit
+static void test_patch_is_small(void)
+{
+    if (getenv("OTA_PATCH_TARGET"))
+        TEST_IGNORE_MESSAGE("size depends on the given images");
+    size_t limit = s_edit_bytes + s_edits * PATCH_EDIT_OVERHEAD + PATCH_HEADER_OVERHEAD;
+    char msg[96];
+    snprintf(msg, sizeof(msg), "patch %u B, edits %u B in %u places, limit %u B", (unsigned)s_patch.size(),
+             (unsigned)s_edit_bytes, (unsigned)s_edits, (unsigned)limit);
+    TEST_MESSAGE(msg);
+    TEST_ASSERT_LESS_OR_EQUAL(limit, s_patch.size());
+}
+
+// Fields and op bodies split at every possible byte boundary
+static void test_byte_at_a_time(void)
+{
+    TEST_ASSERT_TRUE(apply_patch(s_patch, 1));
+    TEST_ASSERT_TRUE(ota_patch_complete(&s_p));
+    TEST_ASSERT_EQUAL_MEMORY(s_target.data(), s_out.data(), s_target.size());
+}
+
+static void test_truncated_patch_incomplete(void)
+{
+    bytes_t patch(s_patch.begin(), s_patch.end() - 3);
+    TEST_ASSERT_TRUE(apply_patch(patch, 244));
+    TEST_ASSERT_FALSE(ota_patch_complete(&s_p));
+}
+
+static void test_bad_magic_fails(void)
+{
+    bytes_t patch = s_patch;
+    patch[3] = '2';
+    TEST_ASSERT_FALSE(apply_patch(patch, 244));
+    TEST_ASSERT_TRUE(s_p.failed);
+    TEST_ASSERT_EQUAL_size_t(0, s_out.size());
+}
+
+static void test_invalid_ops_fail(void)
+{
+    // COPY past the end of the base
+    bytes_t patch = {'O', 'D', 'P', '1'};
+    put_u32(&patch, 100);
+    put_op(&patch, OTA_PATCH_OP_COPY, (uint32_t)s_base.size() - 10, 20);
+    TEST_ASSERT_FALSE(apply_patch(patch, 244));
+
+    // INSERT longer than the target
+    ota_patch_begin(&s_p, read_base, s_base.size());
+    patch.resize(8);
+    put_op(&patch, OTA_PATCH_OP_INSERT, 101, 0);
+    TEST_ASSERT_FALSE(apply_patch(patch, 244));
+
+    // Unknown opcode
+    ota_patch_begin(&s_p, read_base, s_base.size());
+    patch.resize(8);
+    patch.push_back(0x04);
+    TEST_ASSERT_FALSE(apply_patch(patch, 244));
+    TEST_ASSERT_TRUE(s_p.failed);
+}
+
+static void test_base_read_failure_fails(void)
+{
+    s_base_fails = true;
+    TEST_ASSERT_FALSE(apply_patch(s_patch, 244));
+    TEST_ASSERT_TRUE(s_p.failed);
+    TEST_ASSERT_FALSE(ota_patch_write(&s_p, s_patch.data(), 1, collect)); // Stays failed
+}
+
+static void test_sink_failure_fails(void)
+{
+    s_out_limit = s_target.size() / 2;
+    TEST_ASSERT_FALSE(apply_patch(s_patch, 244));
+    TEST_ASSERT_TRUE(s_p.failed);
+    TEST_ASSERT_FALSE(ota_patch_complete(&s_p));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    if (getenv("OTA_PATCH_BASE") && getenv("OTA_PATCH_TARGET"))
+    {
+        load_file(getenv("OTA_PATCH_BASE"), &s_base);
+        load_file(getenv("OTA_PATCH_TARGET"), &s_target);
+    }
+    else
+    {
+        make_base(&s_base);
+        s_target = edit_image(s_base);
+    }
+    s_patch = make_patch();
+
+    RUN_TEST(test_images_loaded);
+    RUN_TEST(test_rebuilds_target_byte_exact);
+    RUN_TEST(test_patch_is_small);
+    RUN_TEST(test_byte_at_a_time);
+    RUN_TEST(test_truncated_patch_incomplete);
+    RUN_TEST(test_bad_magic_fails);
+    RUN_TEST(test_invalid_ops_fail);
+    RUN_TEST(test_base_read_failure_fails);
+    RUN_TEST(test_sink_failure_fails);
+    return UNITY_END();
+}
@@ -0,0 +1,157 @@
+#include <unity.h>
+
+#include "ota_flash.h"
+#include "ota_pipeline.h"
+
+#include <fake_flash.h>
+#include <fake_rtos.h>
+#include <string.h>
+
+#define IMAGE_SIZE (40 * 1024 + 300)
+
+static uint8_t s_image[IMAGE_SIZE];
+static bool s_sink_fails;
+static int s_progress_calls;
+
+// The writer task drains into ota_flash, which runs on the fake flash
+static size_t flash_sink(const uint8_t *data, size_t len)
+{
+    return s_sink_fails ? 0 : ota_flash_write(data, len);
+}
+
+static void on_progress(void)
+{
+    s_progress_calls++;
+}
+
+static void set_latency(uint32_t erase_sector_us, uint32_t program_kb_us)
+{
+    fake_flash_timing_t timing = {erase_sector_us, program_kb_us, 0};
+    fake_flash_set_timing(&timing);
+}
+
+static void push_all(size_t chunk)
+{
+    for (size_t pos = 0; pos < IMAGE_SIZE; pos += chunk)
+    {
+        size_t n = IMAGE_SIZE - pos < chunk ? IMAGE_SIZE - pos : chunk;
+        TEST_ASSERT_TRUE(ota_pipeline_push(s_image + pos, n, 1000));
+    }
+}
+
+void setUp(void)
+{
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+        s_image[i] = (uint8_t)(i ^ (i >> 9));
+    fake_flash_reset();
+    TEST_ASSERT_TRUE(ota_pipeline_init(flash_sink, on_progress));
+    ota_pipeline_reset();
+    TEST_ASSERT_TRUE(ota_flash_begin(IMAGE_SIZE, 0));
+    s_sink_fails = false;
+    s_progress_calls = 0;
+}
+
+void tearDown(void)
+{
+    ota_flash_abort();
+}
+
+static void test_push_and_flush_reach_flash(void)
+{
+    TEST_ASSERT_EQUAL_size_t(OTA_RING_SIZE_PSRAM, ota_pipeline_capacity());
+    push_all(244);
+    TEST_ASSERT_TRUE(ota_pipeline_flush(1000));
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, ota_pipeline_written());
+    TEST_ASSERT_EQUAL_size_t(0, ota_pipeline_buffered());
+    TEST_ASSERT_GREATER_THAN(0, s_progress_calls);
+
+    uint8_t digest[32];
+    TEST_ASSERT_TRUE(ota_flash_finish(digest));
+    TEST_ASSERT_EQUAL_MEMORY(s_image, fake_flash_data(ota_flash_partition()), IMAGE_SIZE);
+}
+
+// Erase/program time is spent in the writer task: the caller only sees it once it waits
+static void test_writer_drains_in_background(void)
+{
+    set_latency(30000, 1000);
+    int64_t start = fake_rtos_now_us();
+    push_all(4096);
+    TEST_ASSERT_LESS_THAN(1000, fake_rtos_now_us() - start);
+    TEST_ASSERT_GREATER_THAN(0, ota_pipeline_buffered());
+
+    fake_rtos_advance_us(100000);
+    TEST_ASSERT_GREATER_THAN(0, ota_pipeline_written());
+    TEST_ASSERT_TRUE(ota_pipeline_flush(2000));
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, ota_pipeline_written());
+    // 10 full sectors at 34 ms each, one after the other (the tail waits for ota_flash_finish)
+    TEST_ASSERT_GREATER_OR_EQUAL(10 * 34000, fake_rtos_now_us() - start);
+
+    ota_pipeline_stats_t stats;
+    ota_pipeline_get_stats(&stats);
+    TEST_ASSERT_GREATER_OR_EQUAL(34000, stats.write_max_us);
+}
+
+// A full ring throttles push() until the writer frees space
+static void test_full_ring_throttles_push(void)
+{
+    static uint8_t big[OTA_RING_SIZE_PSRAM];
+    set_latency(50000, 0);
+    TEST_ASSERT_TRUE(ota_pipeline_push(big, sizeof(big), 0));
+    // The writer already took the first batch and is stuck erasing
+    TEST_ASSERT_TRUE(ota_pipeline_push(big, ota_pipeline_free(), 0));
+    TEST_ASSERT_EQUAL_size_t(0, ota_pipeline_free());
+
+    int64_t start = fake_rtos_now_us();
+    TEST_ASSERT_FALSE(ota_pipeline_push(big, 100, 10));
+    TEST_ASSERT_GREATER_OR_EQUAL(10000, fake_rtos_now_us() - start);
+
+    TEST_ASSERT_TRUE(ota_pipeline_push(big, 100, 100));
+    TEST_ASSERT_GREATER_OR_EQUAL(50000, fake_rtos_now_us() - start);
+}
+
+static void test_sink_failure_fails_pipeline(void)
+{
+    s_sink_fails = true;
+    push_all(1000);
+    TEST_ASSERT_FALSE(ota_pipeline_flush(1000));
+    TEST_ASSERT_TRUE(ota_pipeline_failed());
+    TEST_ASSERT_GREATER_THAN(0, s_progress_calls);
+    TEST_ASSERT_FALSE(ota_pipeline_push(s_image, OTA_RING_SIZE_PSRAM, 10));
+
+    ota_pipeline_reset();
+    TEST_ASSERT_FALSE(ota_pipeline_failed());
+    TEST_ASSERT_EQUAL_size_t(0, ota_pipeline_buffered());
+}
+
+// Out-of-order staging: nothing reaches the writer until the gap is committed
+static void test_write_at_then_commit(void)
+{
+    TEST_ASSERT_TRUE(ota_pipeline_write_at(4096, s_image + 4096, 4096));
+    TEST_ASSERT_EQUAL_size_t(0, ota_pipeline_buffered());
+    TEST_ASSERT_TRUE(ota_pipeline_write_at(0, s_image, 4096));
+    ota_pipeline_commit(8192);
+    TEST_ASSERT_EQUAL_size_t(8192, ota_pipeline_written());
+    TEST_ASSERT_EQUAL_MEMORY(s_image, fake_flash_data(ota_flash_partition()), 8192);
+
+    TEST_ASSERT_FALSE(ota_pipeline_write_at(ota_pipeline_free(), s_image, 1));
+}
+
+static void test_hist_buckets(void)
+{
+    TEST_ASSERT_EQUAL_UINT8(0, ota_pipeline_hist_bucket(999));
+    TEST_ASSERT_EQUAL_UINT8(1, ota_pipeline_hist_bucket(1000));
+    TEST_ASSERT_EQUAL_UINT8(3, ota_pipeline_hist_bucket(7999));
+    TEST_ASSERT_EQUAL_UINT8(OTA_PIPELINE_HIST_BUCKETS - 1, ota_pipeline_hist_bucket(0xFFFFFFFF));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_push_and_flush_reach_flash);
+    RUN_TEST(test_writer_drains_in_background);
+    RUN_TEST(test_full_ring_throttles_push);
+    RUN_TEST(test_sink_failure_fails_pipeline);
+    RUN_TEST(test_write_at_then_commit);
+    RUN_TEST(test_hist_buckets);
+    return UNITY_END();
+}
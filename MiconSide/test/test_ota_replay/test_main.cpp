@@ -0,0 +1,181 @@
+#include <unity.h>
+
+#include "ota_pipeline.h"
+#include "ota_rx.h"
+
+#include <fake_rtos.h>
+#include <string.h>
+
+#include <vector>
+
+#define IMAGE_SIZE (200 * 1024 + 123)
+#define PAYLOAD 240 // 247-byte MTU minus the ATT and offset headers
+
+// Stands in for Update.write(): appends to memory and records every call
+static uint8_t s_image[IMAGE_SIZE];
+static uint8_t s_flash[IMAGE_SIZE];
+static size_t s_flash_len;
+static std::vector<size_t> s_writes;
+static uint32_t s_write_us;
+
+static ota_sack_t s_sack;
+static const ota_rx_ops_t s_ops = {ota_pipeline_write_at, ota_pipeline_commit, ota_pipeline_free};
+
+static size_t update_sink(const uint8_t *data, size_t len)
+{
+    if (s_flash_len + len > IMAGE_SIZE)
+        return 0;
+    if (s_write_us)
+        fake_rtos_sleep_us(s_write_us);
+    memcpy(s_flash + s_flash_len, data, len);
+    s_flash_len += len;
+    s_writes.push_back(len);
+    return len;
+}
+
+static uint32_t s_rng;
+
+static uint32_t next_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+typedef struct
+{
+    uint32_t offset;
+    uint16_t len;
+} chunk_t;
+
+// The client skips chunks the last ACK already listed as received
+static bool sacked(uint32_t offset)
+{
+    for (uint8_t i = 0; i < s_sack.count; i++)
+    {
+        if (offset >= s_sack.blocks[i].start && offset < s_sack.blocks[i].end)
+            return true;
+    }
+    return false;
+}
+
+static ota_rx_result_t deliver(const chunk_t &chunk)
+{
+    uint8_t packet[OTA_RX_HEADER_SIZE + PAYLOAD];
+    packet[0] = (uint8_t)chunk.offset;
+    packet[1] = (uint8_t)(chunk.offset >> 8);
+    packet[2] = (uint8_t)(chunk.offset >> 16);
+    packet[3] = (uint8_t)(chunk.offset >> 24);
+    memcpy(packet + OTA_RX_HEADER_SIZE, s_image + chunk.offset, chunk.len);
+    ota_rx_info_t info;
+    return ota_rx_packet(&s_sack, &s_ops, IMAGE_SIZE, packet, OTA_RX_HEADER_SIZE + chunk.len, &info);
+}
+
+// Replays a BLE chunk trace: every round sends the window past the committed offset
+// with some chunks lost, swapped or repeated; whatever did not land is resent next round.
+// Returns the number of rounds it took.
+static int replay(uint32_t loss_pct, uint32_t swap_pct, uint32_t dup_pct)
+{
+    int rounds = 0;
+    while (s_sack.cum < IMAGE_SIZE)
+    {
+        TEST_ASSERT_LESS_THAN(10000, ++rounds);
+        std::vector<chunk_t> trace;
+        uint32_t end = s_sack.cum + (uint32_t)ota_pipeline_free();
+        for (uint32_t off = s_sack.cum; off < end && off < IMAGE_SIZE; off += PAYLOAD)
+        {
+            if (sacked(off))
+                continue;
+            chunk_t chunk = {off, (uint16_t)(IMAGE_SIZE - off < PAYLOAD ? IMAGE_SIZE - off : PAYLOAD)};
+            if (next_rand() % 100 < loss_pct)
+                continue;
+            trace.push_back(chunk);
+            if (next_rand() % 100 < dup_pct)
+                trace.push_back(chunk);
+        }
+        for (size_t i = 1; i < trace.size(); i++)
+        {
+            if (next_rand() % 100 < swap_pct)
+                std::swap(trace[i - 1], trace[i]);
+        }
+
+        for (const chunk_t &chunk : trace)
+        {
+            ota_rx_result_t result = deliver(chunk);
+            TEST_ASSERT_TRUE(result == OTA_RX_ACCEPTED || result == OTA_RX_DUPLICATE ||
+                             result == OTA_RX_OUT_OF_WINDOW || result == OTA_RX_NO_ROOM);
+        }
+        fake_rtos_advance_us(7500); // One connection interval for the writer to drain
+    }
+    TEST_ASSERT_TRUE(ota_pipeline_flush(1000));
+    return rounds;
+}
+
+// Every sink call but the last is one whole flash batch
+static void assert_sector_batches(void)
+{
+    TEST_ASSERT_GREATER_THAN(0, s_writes.size());
+    for (size_t i = 0; i + 1 < s_writes.size(); i++)
+        TEST_ASSERT_EQUAL_size_t(OTA_FLASH_BATCH_SIZE, s_writes[i]);
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE % OTA_FLASH_BATCH_SIZE, s_writes.back());
+}
+
+void setUp(void)
+{
+    static bool started = false;
+    if (!started)
+    {
+        TEST_ASSERT_TRUE(ota_pipeline_init(update_sink, NULL));
+        started = true;
+    }
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+        s_image[i] = (uint8_t)(i * 5 + (i >> 10));
+    memset(s_flash, 0, sizeof(s_flash));
+    s_flash_len = 0;
+    s_writes.clear();
+    s_write_us = 0;
+    s_rng = 0x12345678;
+    ota_pipeline_reset();
+    ota_sack_reset(&s_sack, 0);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_in_order_trace(void)
+{
+    TEST_ASSERT_GREATER_THAN(0, replay(0, 0, 0));
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, ota_pipeline_written());
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_flash, IMAGE_SIZE);
+    assert_sector_batches();
+}
+
+static void test_lossy_reordered_trace(void)
+{
+    int rounds = replay(5, 10, 3);
+    TEST_ASSERT_GREATER_THAN(1, rounds);
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, s_flash_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_flash, IMAGE_SIZE);
+    assert_sector_batches();
+}
+
+// A slow sink fills the ring; the trace backs off on the advertised free space
+static void test_slow_sink_backpressure(void)
+{
+    s_write_us = 40000;
+    int rounds = replay(2, 5, 0);
+    TEST_ASSERT_GREATER_THAN(IMAGE_SIZE / OTA_RING_SIZE_PSRAM, rounds);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_flash, IMAGE_SIZE);
+    assert_sector_batches();
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_in_order_trace);
+    RUN_TEST(test_lossy_reordered_trace);
+    RUN_TEST(test_slow_sink_backpressure);
+    return UNITY_END();
+}
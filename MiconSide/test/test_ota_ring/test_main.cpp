@@ -0,0 +1,141 @@
+#include <unity.h>
+
+#include "ota_ring.h"
+
+#include <string.h>
+
+#define CAPACITY 100
+
+static uint8_t s_storage[CAPACITY];
+static ota_ring_t s_ring;
+static uint8_t s_data[3 * CAPACITY];
+
+void setUp(void)
+{
+    for (size_t i = 0; i < sizeof(s_data); i++)
+        s_data[i] = (uint8_t)(i * 13 + 1);
+    memset(s_storage, 0, sizeof(s_storage));
+    TEST_ASSERT_TRUE(ota_ring_init(&s_ring, s_storage, CAPACITY));
+}
+
+void tearDown(void)
+{
+}
+
+static void test_init_rejects_bad_arguments(void)
+{
+    ota_ring_t ring;
+    TEST_ASSERT_FALSE(ota_ring_init(NULL, s_storage, CAPACITY));
+    TEST_ASSERT_FALSE(ota_ring_init(&ring, NULL, CAPACITY));
+    TEST_ASSERT_FALSE(ota_ring_init(&ring, s_storage, 0));
+}
+
+static void test_write_read_accounting(void)
+{
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_used(&s_ring));
+    TEST_ASSERT_EQUAL_size_t(CAPACITY, ota_ring_free(&s_ring));
+
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, 30));
+    TEST_ASSERT_EQUAL_size_t(30, ota_ring_used(&s_ring));
+    TEST_ASSERT_EQUAL_size_t(70, ota_ring_free(&s_ring));
+
+    uint8_t out[CAPACITY];
+    TEST_ASSERT_EQUAL_size_t(20, ota_ring_read(&s_ring, out, 20));
+    TEST_ASSERT_EQUAL_MEMORY(s_data, out, 20);
+    TEST_ASSERT_EQUAL_size_t(10, ota_ring_read(&s_ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(s_data + 20, out, 10);
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_read(&s_ring, out, sizeof(out)));
+}
+
+// All or nothing: a write that does not fit leaves the ring untouched
+static void test_write_all_or_nothing(void)
+{
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, CAPACITY - 10));
+    TEST_ASSERT_FALSE(ota_ring_write(&s_ring, s_data, 11));
+    TEST_ASSERT_EQUAL_size_t(CAPACITY - 10, ota_ring_used(&s_ring));
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, 10));
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_free(&s_ring));
+    TEST_ASSERT_FALSE(ota_ring_write(&s_ring, s_data, 1));
+}
+
+// Reads and writes that straddle the end of the storage come out in order
+static void test_wraparound(void)
+{
+    uint8_t chunk[CAPACITY], out[CAPACITY];
+    size_t in = 0, got = 0;
+    for (int round = 0; round < 50; round++)
+    {
+        size_t n = 7 + (size_t)(round * 11) % 60;
+        if (n > ota_ring_free(&s_ring))
+            n = ota_ring_free(&s_ring);
+        for (size_t i = 0; i < n; i++)
+            chunk[i] = (uint8_t)((in + i) * 31);
+        TEST_ASSERT_TRUE(ota_ring_write(&s_ring, chunk, n));
+        in += n;
+
+        size_t r = ota_ring_read(&s_ring, out, 1 + (size_t)(round * 17) % 70);
+        for (size_t i = 0; i < r; i++)
+            TEST_ASSERT_EQUAL_UINT8((uint8_t)((got + i) * 31), out[i]);
+        got += r;
+        TEST_ASSERT_EQUAL_size_t(in - got, ota_ring_used(&s_ring));
+    }
+    TEST_ASSERT_GREATER_THAN(3 * CAPACITY, in); // Wrapped several times
+}
+
+static void test_wraparound_preserves_bytes(void)
+{
+    uint8_t out[CAPACITY];
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, 80));
+    TEST_ASSERT_EQUAL_size_t(80, ota_ring_read(&s_ring, out, 80));
+
+    // Head is at 80: the next 60 bytes wrap at 100
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data + 100, 60));
+    TEST_ASSERT_EQUAL_MEMORY(s_data + 100, s_storage + 80, 20);
+    TEST_ASSERT_EQUAL_MEMORY(s_data + 120, s_storage, 40);
+    TEST_ASSERT_EQUAL_size_t(60, ota_ring_read(&s_ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(s_data + 100, out, 60);
+}
+
+// Staged bytes stay invisible to the consumer until committed
+static void test_write_at_then_commit(void)
+{
+    uint8_t out[CAPACITY];
+    TEST_ASSERT_TRUE(ota_ring_write_at(&s_ring, 20, s_data + 20, 30));
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_used(&s_ring));
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_read(&s_ring, out, sizeof(out)));
+
+    TEST_ASSERT_TRUE(ota_ring_write_at(&s_ring, 0, s_data, 20));
+    ota_ring_commit(&s_ring, 50);
+    TEST_ASSERT_EQUAL_size_t(50, ota_ring_read(&s_ring, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_MEMORY(s_data, out, 50);
+}
+
+static void test_write_at_respects_free_space(void)
+{
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, 60));
+    TEST_ASSERT_TRUE(ota_ring_write_at(&s_ring, 30, s_data, 10));
+    TEST_ASSERT_FALSE(ota_ring_write_at(&s_ring, 31, s_data, 10));
+    TEST_ASSERT_FALSE(ota_ring_write_at(&s_ring, 41, s_data, 0));
+}
+
+static void test_reset_discards(void)
+{
+    TEST_ASSERT_TRUE(ota_ring_write(&s_ring, s_data, 50));
+    ota_ring_reset(&s_ring);
+    TEST_ASSERT_EQUAL_size_t(0, ota_ring_used(&s_ring));
+    TEST_ASSERT_EQUAL_size_t(CAPACITY, ota_ring_free(&s_ring));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_init_rejects_bad_arguments);
+    RUN_TEST(test_write_read_accounting);
+    RUN_TEST(test_write_all_or_nothing);
+    RUN_TEST(test_wraparound);
+    RUN_TEST(test_wraparound_preserves_bytes);
+    RUN_TEST(test_write_at_then_commit);
+    RUN_TEST(test_write_at_respects_free_space);
+    RUN_TEST(test_reset_discards);
+    return UNITY_END();
+}
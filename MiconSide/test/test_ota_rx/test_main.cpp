@@ -0,0 +1,178 @@
+#include <unity.h>
+
+#include "ota_rx.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+#define IMAGE_SIZE 6000
+#define WINDOW 2048
+
+// Staging buffer standing in for the OTA pipeline: committed bytes are appended to s_out
+static uint8_t s_image[IMAGE_SIZE + 512]; // Slack for the overflow packet
+static uint8_t s_out[IMAGE_SIZE];
+static size_t s_out_len;
+static uint8_t s_stage[WINDOW];
+static size_t s_window;
+static bool s_refuse;
+static ota_sack_t s_sack;
+
+static bool mem_write_at(size_t ahead, const uint8_t *data, size_t len)
+{
+    if (s_refuse || ahead + len > s_window)
+        return false;
+    memcpy(s_stage + ahead, data, len);
+    return true;
+}
+
+static void mem_commit(size_t len)
+{
+    memcpy(s_out + s_out_len, s_stage, len);
+    s_out_len += len;
+    memmove(s_stage, s_stage + len, s_window - len);
+}
+
+static size_t mem_free_space(void)
+{
+    return s_window;
+}
+
+static const ota_rx_ops_t s_ops = {mem_write_at, mem_commit, mem_free_space};
+
+static ota_rx_result_t send(uint32_t offset, size_t len, ota_rx_info_t *info)
+{
+    uint8_t packet[OTA_RX_HEADER_SIZE + 512];
+    packet[0] = (uint8_t)offset;
+    packet[1] = (uint8_t)(offset >> 8);
+    packet[2] = (uint8_t)(offset >> 16);
+    packet[3] = (uint8_t)(offset >> 24);
+    memcpy(packet + OTA_RX_HEADER_SIZE, s_image + offset, len);
+    return ota_rx_packet(&s_sack, &s_ops, IMAGE_SIZE, packet, OTA_RX_HEADER_SIZE + len, info);
+}
+
+void setUp(void)
+{
+    for (size_t i = 0; i < IMAGE_SIZE; i++)
+        s_image[i] = (uint8_t)(i * 7 + (i >> 8));
+    memset(s_out, 0, sizeof(s_out));
+    s_out_len = 0;
+    s_window = WINDOW;
+    s_refuse = false;
+    ota_sack_reset(&s_sack, 0);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_in_order_commits(void)
+{
+    ota_rx_info_t info;
+    TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(0, 500, &info));
+    TEST_ASSERT_EQUAL_UINT32(500, info.advance);
+    TEST_ASSERT_FALSE(info.new_gap);
+    TEST_ASSERT_EQUAL_size_t(500, s_out_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_out, 500);
+}
+
+static void test_short_and_overflow(void)
+{
+    ota_rx_info_t info;
+    uint8_t header[OTA_RX_HEADER_SIZE] = {0, 0, 0, 0};
+    TEST_ASSERT_EQUAL(OTA_RX_SHORT, ota_rx_packet(&s_sack, &s_ops, IMAGE_SIZE, header, sizeof(header), &info));
+    TEST_ASSERT_EQUAL(OTA_RX_OVERFLOW, send(IMAGE_SIZE - 100, 101, &info));
+}
+
+static void test_retransmit_skips_committed_part(void)
+{
+    ota_rx_info_t info;
+    send(0, 300, &info);
+    TEST_ASSERT_EQUAL(OTA_RX_DUPLICATE, send(100, 200, &info));
+    TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(200, 400, &info));
+    TEST_ASSERT_EQUAL_UINT32(300, info.advance);
+    TEST_ASSERT_EQUAL_size_t(600, s_out_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_out, 600);
+}
+
+static void test_gap_opens_then_fills(void)
+{
+    ota_rx_info_t info;
+    TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(400, 400, &info));
+    TEST_ASSERT_TRUE(info.new_gap);
+    TEST_ASSERT_EQUAL_UINT32(0, info.advance);
+    TEST_ASSERT_EQUAL_size_t(0, s_out_len);
+
+    TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(0, 400, &info));
+    TEST_ASSERT_EQUAL_UINT32(800, info.advance);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_out, 800);
+}
+
+static void test_beyond_window_is_dropped(void)
+{
+    ota_rx_info_t info;
+    TEST_ASSERT_EQUAL(OTA_RX_OUT_OF_WINDOW, send(WINDOW - 100, 200, &info));
+    TEST_ASSERT_EQUAL_UINT32(0, s_sack.cum);
+    TEST_ASSERT_EQUAL_UINT8(0, s_sack.count);
+}
+
+static void test_fifth_gap_has_no_room(void)
+{
+    ota_rx_info_t info;
+    for (uint32_t i = 1; i <= OTA_SACK_MAX_BLOCKS; i++)
+        TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(i * 200, 100, &info));
+    TEST_ASSERT_EQUAL(OTA_RX_NO_ROOM, send(1200, 100, &info));
+}
+
+static void test_refused_write_fails(void)
+{
+    ota_rx_info_t info;
+    s_refuse = true;
+    TEST_ASSERT_EQUAL(OTA_RX_WRITE_FAILED, send(0, 100, &info));
+}
+
+// Every packet shuffled within a window-sized span, with duplicates: the output is the image
+static void test_reordered_stream_is_byte_exact(void)
+{
+    const size_t mtu = 244;
+    uint32_t offsets[IMAGE_SIZE / 200 + 1];
+    size_t count = 0;
+    for (uint32_t ofs = 0; ofs < IMAGE_SIZE; ofs += mtu)
+        offsets[count++] = ofs;
+
+    srand(1);
+    for (size_t i = 0; i + 1 < count; i += 2)
+    {
+        if (rand() % 2)
+        {
+            uint32_t t = offsets[i];
+            offsets[i] = offsets[i + 1];
+            offsets[i + 1] = t;
+        }
+    }
+
+    ota_rx_info_t info;
+    for (size_t i = 0; i < count; i++)
+    {
+        size_t len = IMAGE_SIZE - offsets[i] < mtu ? IMAGE_SIZE - offsets[i] : mtu;
+        TEST_ASSERT_EQUAL(OTA_RX_ACCEPTED, send(offsets[i], len, &info));
+        if (i % 5 == 0)
+            send(offsets[i], len, &info); // Spurious retransmit
+    }
+    TEST_ASSERT_EQUAL_UINT32(IMAGE_SIZE, s_sack.cum);
+    TEST_ASSERT_EQUAL_size_t(IMAGE_SIZE, s_out_len);
+    TEST_ASSERT_EQUAL_MEMORY(s_image, s_out, IMAGE_SIZE);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_in_order_commits);
+    RUN_TEST(test_short_and_overflow);
+    RUN_TEST(test_retransmit_skips_committed_part);
+    RUN_TEST(test_gap_opens_then_fills);
+    RUN_TEST(test_beyond_window_is_dropped);
+    RUN_TEST(test_fifth_gap_has_no_room);
+    RUN_TEST(test_refused_write_fails);
+    RUN_TEST(test_reordered_stream_is_byte_exact);
+    return UNITY_END();
+}
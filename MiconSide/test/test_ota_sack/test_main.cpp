@@ -0,0 +1,92 @@
+#include <unity.h>
+
+#include "ota_sack.h"
+
+static ota_sack_t sack;
+static uint32_t advance;
+
+void setUp(void)
+{
+    ota_sack_reset(&sack, 0);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_in_order_advances_cum(void)
+{
+    TEST_ASSERT_EQUAL(OTA_SACK_ACCEPTED, ota_sack_add(&sack, 0, 100, &advance));
+    TEST_ASSERT_EQUAL_UINT32(100, advance);
+    TEST_ASSERT_EQUAL(OTA_SACK_ACCEPTED, ota_sack_add(&sack, 50, 180, &advance));
+    TEST_ASSERT_EQUAL_UINT32(80, advance);
+    TEST_ASSERT_EQUAL_UINT32(180, sack.cum);
+    TEST_ASSERT_EQUAL_UINT8(0, sack.count);
+}
+
+static void test_duplicate_below_cum(void)
+{
+    ota_sack_add(&sack, 0, 100, &advance);
+    TEST_ASSERT_EQUAL(OTA_SACK_DUPLICATE, ota_sack_add(&sack, 20, 100, &advance));
+    TEST_ASSERT_EQUAL_UINT32(0, advance);
+}
+
+static void test_gap_fill_absorbs_blocks(void)
+{
+    ota_sack_add(&sack, 200, 300, &advance);
+    ota_sack_add(&sack, 100, 200, &advance); // Adjacent: merges into one block
+    TEST_ASSERT_EQUAL_UINT8(1, sack.count);
+    TEST_ASSERT_EQUAL_UINT32(100, sack.blocks[0].start);
+    TEST_ASSERT_EQUAL_UINT32(300, sack.blocks[0].end);
+    TEST_ASSERT_EQUAL_UINT32(0, advance);
+
+    TEST_ASSERT_EQUAL(OTA_SACK_ACCEPTED, ota_sack_add(&sack, 0, 100, &advance));
+    TEST_ASSERT_EQUAL_UINT32(300, advance);
+    TEST_ASSERT_EQUAL_UINT32(300, sack.cum);
+    TEST_ASSERT_EQUAL_UINT8(0, sack.count);
+}
+
+static void test_overlap_bridges_blocks(void)
+{
+    ota_sack_add(&sack, 100, 200, &advance);
+    ota_sack_add(&sack, 300, 400, &advance);
+    ota_sack_add(&sack, 150, 350, &advance);
+    TEST_ASSERT_EQUAL_UINT8(1, sack.count);
+    TEST_ASSERT_EQUAL_UINT32(100, sack.blocks[0].start);
+    TEST_ASSERT_EQUAL_UINT32(400, sack.blocks[0].end);
+}
+
+static void test_fifth_block_has_no_room(void)
+{
+    for (uint32_t i = 1; i <= OTA_SACK_MAX_BLOCKS; i++)
+        TEST_ASSERT_EQUAL(OTA_SACK_ACCEPTED, ota_sack_add(&sack, i * 100, i * 100 + 10, &advance));
+    TEST_ASSERT_EQUAL(OTA_SACK_NO_ROOM, ota_sack_add(&sack, 1000, 1010, &advance));
+    // Extending an existing block still works
+    TEST_ASSERT_EQUAL(OTA_SACK_ACCEPTED, ota_sack_add(&sack, 110, 150, &advance));
+    TEST_ASSERT_EQUAL_UINT8(OTA_SACK_MAX_BLOCKS, sack.count);
+}
+
+static void test_format_lists_blocks(void)
+{
+    char out[64];
+    TEST_ASSERT_EQUAL_size_t(0, ota_sack_format(&sack, out, sizeof(out)));
+    TEST_ASSERT_EQUAL_STRING("", out);
+
+    ota_sack_add(&sack, 0, 10, &advance);
+    ota_sack_add(&sack, 20, 30, &advance);
+    ota_sack_add(&sack, 40, 55, &advance);
+    ota_sack_format(&sack, out, sizeof(out));
+    TEST_ASSERT_EQUAL_STRING("20-30,40-55", out);
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_in_order_advances_cum);
+    RUN_TEST(test_duplicate_below_cum);
+    RUN_TEST(test_gap_fill_absorbs_blocks);
+    RUN_TEST(test_overlap_bridges_blocks);
+    RUN_TEST(test_fifth_block_has_no_room);
+    RUN_TEST(test_format_lists_blocks);
+    return UNITY_END();
+}
@@ -0,0 +1,546 @@
+#include "ota_sim.h"
+
+#include "ota_flash.h"
+#include "ota_pipeline.h"
+#include "ota_rx.h"
+
+#include <esp_ota_ops.h>
+#include <fake_rtos.h>
+#include <mbedtls/sha256.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <algorithm>
+#include <deque>
+#include <map>
+#include <string>
+#include <vector>
+
+#define SIM_ATT_HEADER 3   // Opcode + handle in front of every write / notification
+#define SIM_L2CAP_HEADER 4 // Length + channel ID
+#define SIM_LL_OVERHEAD 9  // Access address, LL header, CRC (plus the preamble)
+#define SIM_IFS_US 150
+
+static ota_sim_config_t s_cfg;
+static ota_sim_result_t *s_res;
+static uint32_t s_rng;
+static int64_t s_t0;
+static std::deque<std::string> s_notify; // Device -> client, sent at the next connection event
+
+static uint32_t sim_rand(void)
+{
+    s_rng ^= s_rng << 13;
+    s_rng ^= s_rng >> 17;
+    s_rng ^= s_rng << 5;
+    return s_rng;
+}
+
+static bool sim_lost(uint32_t ppm)
+{
+    return ppm && sim_rand() % 1000000 < ppm;
+}
+
+static int64_t sim_now(void)
+{
+    return fake_rtos_now_us() - s_t0;
+}
+
+// ============================================================================
+// Link: airtime of a GATT write / notification split into LL PDUs
+// ============================================================================
+
+static int64_t sim_pdu_us(uint32_t octets)
+{
+    uint32_t preamble = s_cfg.phy == 2 ? 2 : 1;
+    return (int64_t)(preamble + SIM_LL_OVERHEAD + octets) * 8 / (s_cfg.phy == 2 ? 2 : 1);
+}
+
+typedef struct
+{
+    int64_t air_us; // Airtime left in the current connection event (may run into the next)
+    int32_t pdus;   // PDUs left under max_pdus_per_event
+} sim_budget_t;
+
+// Charge one ATT PDU of att_len bytes; each LL PDU is acknowledged by the peer
+static void sim_charge(sim_budget_t *budget, size_t att_len)
+{
+    size_t left = att_len + SIM_L2CAP_HEADER;
+    while (left > 0)
+    {
+        size_t n = std::min(left, (size_t)s_cfg.ll_octets);
+        budget->air_us -= sim_pdu_us(n) + SIM_IFS_US + sim_pdu_us(0) + SIM_IFS_US;
+        budget->pdus--;
+        left -= n;
+    }
+}
+
+static bool sim_has_room(const sim_budget_t *budget)
+{
+    return budget->air_us > 0 && (!s_cfg.max_pdus_per_event || budget->pdus > 0);
+}
+
+// ============================================================================
+// Device: the OtaData handler and ACK policy of main.cpp
+// ============================================================================
+
+static const ota_rx_ops_t s_rx_ops = {ota_pipeline_write_at, ota_pipeline_commit, ota_pipeline_free};
+
+static struct
+{
+    bool in_progress;
+    size_t expected;
+    ota_sack_t sack; // sack.cum mirrors the received size
+    size_t last_acked_size;
+    size_t last_acked_window;
+    bool ack_pending;
+    int64_t last_ack_us;
+} s_dev;
+
+static void device_notify(const char *status)
+{
+    s_notify.push_back(status);
+}
+
+static void device_fail(const char *status)
+{
+    s_dev.in_progress = false;
+    ota_pipeline_reset();
+    ota_flash_abort();
+    device_notify(status);
+}
+
+static void device_send_ack(void)
+{
+    char sack_str[OTA_SACK_MAX_BLOCKS * 24];
+    char ack[sizeof(sack_str) + 32];
+
+    size_t window = ota_pipeline_free();
+    size_t sack_len = ota_sack_format(&s_dev.sack, sack_str, sizeof(sack_str));
+    snprintf(ack, sizeof(ack), "ACK:%u:%u%s%s", (unsigned)s_dev.sack.cum, (unsigned)window, sack_len ? ":" : "",
+             sack_str);
+
+    s_dev.last_acked_size = s_dev.sack.cum;
+    s_dev.last_acked_window = window;
+    s_dev.ack_pending = false;
+    s_dev.last_ack_us = sim_now();
+    s_res->acks_sent++;
+    device_notify(ack);
+}
+
+static bool device_ack_owed(void)
+{
+    return s_dev.ack_pending || s_dev.sack.cum != s_dev.last_acked_size ||
+           ota_pipeline_free() >= s_dev.last_acked_window + OTA_FLASH_BATCH_SIZE;
+}
+
+static void device_start(size_t size)
+{
+    ota_sack_reset(&s_dev.sack, 0);
+    s_dev.expected = size;
+    s_dev.last_acked_size = 0;
+    s_dev.last_acked_window = 0;
+    s_dev.ack_pending = false;
+    s_dev.last_ack_us = sim_now();
+    ota_pipeline_reset();
+    if (!ota_flash_begin(size, 0))
+    {
+        device_notify("ERROR:BEGIN_FAILED");
+        return;
+    }
+    s_dev.in_progress = true;
+
+    char ready[48];
+    snprintf(ready, sizeof(ready), "READY:SEQ:%u:none", (unsigned)ota_pipeline_free());
+    device_notify(ready);
+}
+
+static void device_receive(const uint8_t *packet, size_t len)
+{
+    if (!s_dev.in_progress)
+        return;
+
+    ota_rx_info_t info;
+    switch (ota_rx_packet(&s_dev.sack, &s_rx_ops, s_dev.expected, packet, len, &info))
+    {
+    case OTA_RX_ACCEPTED:
+        break;
+    case OTA_RX_SHORT:
+        return;
+    case OTA_RX_OVERFLOW:
+        device_fail("ERROR:OVERFLOW");
+        return;
+    case OTA_RX_WRITE_FAILED:
+        device_fail("ERROR:BUFFER_FULL");
+        return;
+    default:
+        s_dev.ack_pending = true;
+        return;
+    }
+
+    if (info.new_gap || s_dev.sack.cum - s_dev.last_acked_size >= OTA_SIM_ACK_STRIDE_BYTES ||
+        s_dev.sack.cum == s_dev.expected)
+        device_send_ack();
+}
+
+// loop(): report write errors, and progress / reopened window at most every ACK interval
+static void device_loop(void)
+{
+    if (!s_dev.in_progress)
+        return;
+    if (ota_pipeline_failed())
+        device_fail("ERROR:WRITE_FAILED");
+    else if (sim_now() - s_dev.last_ack_us >= (int64_t)OTA_SIM_ACK_INTERVAL_MS * 1000 && device_ack_owed())
+        device_send_ack();
+}
+
+// ota_finalize(): drain the ring, check the digest, switch the boot slot
+static void device_end(const uint8_t *image, size_t size)
+{
+    if (!s_dev.in_progress || s_dev.sack.cum != s_dev.expected)
+    {
+        device_notify(s_dev.in_progress ? "ERROR:INCOMPLETE" : "ERROR:NOT_STARTED");
+        return;
+    }
+
+    uint8_t digest[32];
+    uint8_t expected[32];
+    mbedtls_sha256(image, size, expected, 0);
+    if (!ota_pipeline_flush(OTA_SIM_FLUSH_TIMEOUT_MS) || !ota_flash_finish(digest))
+    {
+        device_fail("ERROR:WRITE_FAILED");
+        return;
+    }
+    if (memcmp(digest, expected, sizeof(digest)) != 0)
+    {
+        device_fail("ERROR:HASH_MISMATCH");
+        return;
+    }
+    s_dev.in_progress = false;
+    device_notify(ota_flash_activate() ? "SUCCESS" : "ERROR:END_FAILED");
+}
+
+// ============================================================================
+// Client: sendSequenced() of ota-client.js
+// ============================================================================
+
+typedef enum
+{
+    CLIENT_STARTING = 0, // START sent, waiting for READY
+    CLIENT_SENDING,
+    CLIENT_ENDING,       // END sent, waiting for SUCCESS
+    CLIENT_DONE,
+} client_phase_t;
+
+static struct
+{
+    client_phase_t phase;
+    const uint8_t *image;
+    uint32_t size;
+    uint32_t payload;
+    uint32_t cum;
+    uint32_t window;
+    std::vector<std::pair<uint32_t, uint32_t>> sack;
+    uint32_t seq;
+    uint32_t last_ack_seq;
+    uint32_t next_offset;
+    std::map<uint32_t, int64_t> last_sent;
+    std::deque<uint32_t> retransmit;
+    uint32_t ack_timeouts; // Consecutive
+    int64_t wait_since;    // Waiting for an ACK since, -1 = not waiting
+} s_client;
+
+static void client_done(const char *status)
+{
+    s_client.phase = CLIENT_DONE;
+    snprintf(s_res->status, sizeof(s_res->status), "%s", status);
+}
+
+// ACK:<cum>:<window>[:<s>-<e>,...]
+static void client_handle_ack(const char *status)
+{
+    char *end;
+    unsigned long cum = strtoul(status + 4, &end, 10);
+    if (*end != ':')
+        return;
+    unsigned long window = strtoul(end + 1, &end, 10);
+
+    s_client.sack.clear();
+    while (*end == ':' || *end == ',')
+    {
+        unsigned long start = strtoul(end + 1, &end, 10);
+        if (*end != '-')
+            break;
+        unsigned long stop = strtoul(end + 1, &end, 10);
+        s_client.sack.push_back(std::make_pair((uint32_t)start, (uint32_t)stop));
+    }
+    s_client.cum = (uint32_t)cum;
+    s_client.window = (uint32_t)window;
+    s_client.seq++;
+}
+
+static void client_status(const char *status)
+{
+    if (strncmp(status, "ACK:", 4) == 0)
+    {
+        if (sim_lost(s_cfg.ack_loss_ppm))
+        {
+            s_res->acks_lost++;
+            return;
+        }
+        if (s_client.phase == CLIENT_SENDING)
+            client_handle_ack(status);
+    }
+    else if (strncmp(status, "READY:SEQ:", 10) == 0 && s_client.phase == CLIENT_STARTING)
+    {
+        s_client.window = (uint32_t)strtoul(status + 10, NULL, 10);
+        s_client.phase = CLIENT_SENDING;
+        s_res->ready_us = sim_now();
+    }
+    else if (strcmp(status, "SUCCESS") == 0 && s_client.phase == CLIENT_ENDING)
+    {
+        s_res->success_us = sim_now();
+        s_res->success = true;
+        client_done(status);
+    }
+    else if (strncmp(status, "ERROR:", 6) == 0)
+    {
+        client_done(status);
+    }
+}
+
+// Queue chunks below limit that are neither acknowledged nor held out of order
+static void client_queue_gaps(uint32_t limit)
+{
+    int64_t now = sim_now();
+    for (uint32_t offset = s_client.cum / s_client.payload * s_client.payload; offset < limit;
+         offset += s_client.payload)
+    {
+        uint32_t end = std::min(offset + s_client.payload, s_client.size);
+        bool held = end <= s_client.cum;
+        for (const auto &block : s_client.sack)
+            held = held || (offset >= block.first && end <= block.second);
+        if (held)
+            continue;
+        auto sent = s_client.last_sent.find(offset);
+        if (sent != s_client.last_sent.end() && now - sent->second < (int64_t)OTA_SIM_RETRANSMIT_TIMEOUT_MS * 1000)
+            continue;
+        if (std::find(s_client.retransmit.begin(), s_client.retransmit.end(), offset) == s_client.retransmit.end())
+            s_client.retransmit.push_back(offset);
+    }
+}
+
+static void client_write_chunk(uint32_t offset, sim_budget_t *budget)
+{
+    uint8_t packet[OTA_RX_HEADER_SIZE + OTA_SIM_CHUNK_SIZE];
+    uint32_t len = std::min(s_client.payload, s_client.size - offset);
+    packet[0] = (uint8_t)offset;
+    packet[1] = (uint8_t)(offset >> 8);
+    packet[2] = (uint8_t)(offset >> 16);
+    packet[3] = (uint8_t)(offset >> 24);
+    memcpy(packet + OTA_RX_HEADER_SIZE, s_client.image + offset, len);
+
+    sim_charge(budget, SIM_ATT_HEADER + OTA_RX_HEADER_SIZE + len);
+    s_client.last_sent[offset] = sim_now();
+    s_res->packets_sent++;
+    if (sim_lost(s_cfg.loss_ppm))
+        s_res->packets_lost++;
+    else
+        device_receive(packet, OTA_RX_HEADER_SIZE + len);
+}
+
+// One connection event: send while the link has room and the window allows
+static void client_send(sim_budget_t *budget)
+{
+    while (s_client.phase == CLIENT_SENDING && sim_has_room(budget))
+    {
+        // New ACK with SACK blocks: everything below the highest block that is missing was lost
+        if (s_client.seq != s_client.last_ack_seq)
+        {
+            s_client.last_ack_seq = s_client.seq;
+            s_client.ack_timeouts = 0;
+            s_client.wait_since = -1;
+            if (!s_client.sack.empty())
+                client_queue_gaps(s_client.sack.back().second);
+        }
+
+        if (s_client.cum >= s_client.size)
+        {
+            s_res->transferred_us = sim_now();
+            sim_charge(budget, SIM_ATT_HEADER + 3);
+            s_client.phase = CLIENT_ENDING;
+            device_end(s_client.image, s_client.size);
+            return;
+        }
+
+        // Gaps first, then new data while it fits in the advertised window
+        bool found = false;
+        uint32_t offset = 0;
+        while (!s_client.retransmit.empty() && !found)
+        {
+            offset = s_client.retransmit.front();
+            s_client.retransmit.pop_front();
+            found = offset + s_client.payload > s_client.cum;
+            if (found)
+                s_res->retransmits++;
+        }
+        if (!found && s_client.next_offset < s_client.size &&
+            std::min(s_client.next_offset + s_client.payload, s_client.size) <= s_client.cum + s_client.window)
+        {
+            offset = s_client.next_offset;
+            s_client.next_offset = std::min(s_client.next_offset + s_client.payload, s_client.size);
+            found = true;
+        }
+        if (found)
+        {
+            client_write_chunk(offset, budget);
+            continue;
+        }
+
+        // Window full or everything in flight: wait for the device
+        if (s_client.wait_since < 0)
+        {
+            s_client.wait_since = sim_now();
+            return;
+        }
+        if (sim_now() - s_client.wait_since < (int64_t)OTA_SIM_ACK_TIMEOUT_MS * 1000)
+            return;
+        s_res->ack_timeouts++;
+        if (++s_client.ack_timeouts > OTA_SIM_MAX_ACK_TIMEOUTS)
+        {
+            client_done("ERROR:NO_ACK");
+            return;
+        }
+        client_queue_gaps(s_client.next_offset);
+        s_client.wait_since = sim_now();
+    }
+}
+
+// ============================================================================
+// Run
+// ============================================================================
+
+void ota_sim_default_config(ota_sim_config_t *cfg)
+{
+    memset(cfg, 0, sizeof(*cfg));
+    cfg->mtu = 247;
+    cfg->interval_us = 15000;
+    cfg->phy = 2;
+    cfg->ll_octets = 251;
+    cfg->max_pdus_per_event = 6; // Phone centrals send a handful of writes per event
+    cfg->seed = 1;
+    cfg->flash.erase_sector_us = 45000; // 4 KB sector erase, typical SPI NOR
+    cfg->flash.program_kb_us = 2000;    // 256-byte page program ~0.5 ms
+    cfg->flash.read_kb_us = 25;
+}
+
+bool ota_sim_run(const ota_sim_config_t *cfg, const uint8_t *image, size_t size, ota_sim_result_t *out)
+{
+    static bool started = false;
+    if (!started)
+    {
+        if (!ota_pipeline_init(ota_flash_write, NULL))
+            return false;
+        started = true;
+    }
+
+    s_cfg = *cfg;
+    s_res = out;
+    memset(out, 0, sizeof(*out));
+    s_rng = cfg->seed ? cfg->seed : 1;
+    s_notify.clear();
+    fake_flash_reset();
+    fake_flash_set_timing(&cfg->flash);
+
+    uint32_t chunk = std::min<uint32_t>(OTA_SIM_CHUNK_SIZE, cfg->mtu - SIM_ATT_HEADER);
+    s_client.phase = CLIENT_STARTING;
+    s_client.image = image;
+    s_client.size = (uint32_t)size;
+    s_client.payload = chunk - OTA_RX_HEADER_SIZE;
+    s_client.cum = 0;
+    s_client.window = 0;
+    s_client.sack.clear();
+    s_client.seq = 0;
+    s_client.last_ack_seq = 0;
+    s_client.next_offset = 0;
+    s_client.last_sent.clear();
+    s_client.retransmit.clear();
+    s_client.ack_timeouts = 0;
+    s_client.wait_since = -1;
+
+    // START is written in the first connection event; loop() answers READY
+    s_t0 = fake_rtos_now_us();
+    device_start(size);
+
+    sim_budget_t budget = {0, 0};
+    int64_t next_event = s_t0 + cfg->interval_us;
+    while (s_client.phase != CLIENT_DONE)
+    {
+        if (sim_now() > (int64_t)OTA_SIM_TIMEOUT_MS * 1000)
+        {
+            client_done("TIMEOUT");
+            break;
+        }
+
+        // The writer task and the flash run in between; finalize may have taken several intervals
+        if (next_event > fake_rtos_now_us())
+            fake_rtos_advance_us(next_event - fake_rtos_now_us());
+        while (next_event <= fake_rtos_now_us())
+            next_event += cfg->interval_us;
+        out->events++;
+
+        budget.air_us = std::min<int64_t>(budget.air_us, 0) + cfg->interval_us;
+        budget.pdus = std::min<int32_t>(budget.pdus, 0) + cfg->max_pdus_per_event;
+
+        device_loop();
+        std::deque<std::string> notify;
+        notify.swap(s_notify);
+        for (const std::string &status : notify)
+        {
+            sim_charge(&budget, SIM_ATT_HEADER + status.size());
+            client_status(status.c_str());
+            if (s_client.phase == CLIENT_DONE)
+                break;
+        }
+        client_send(&budget);
+    }
+
+    if (!out->success)
+    {
+        ota_pipeline_reset();
+        ota_flash_abort();
+    }
+    fake_flash_stats_t stats;
+    fake_flash_get_stats(&stats);
+    out->sectors_erased = stats.sectors_erased;
+    return out->success;
+}
+
+static double sim_kbps(size_t bytes, int64_t us)
+{
+    return us > 0 ? bytes / 1024.0 / (us / 1e6) : 0;
+}
+
+size_t ota_sim_json(const ota_sim_config_t *cfg, size_t size, const ota_sim_result_t *res, char *out,
+                    size_t out_size)
+{
+    int64_t transfer_us = res->transferred_us - res->ready_us;
+    int n = snprintf(out, out_size,
+                     "{\"mtu\":%u,\"intervalUs\":%u,\"phy\":%u,\"llOctets\":%u,\"maxPdusPerEvent\":%u,"
+                     "\"lossPpm\":%u,\"ackLossPpm\":%u,\"eraseSectorUs\":%u,\"programKbUs\":%u,"
+                     "\"firmwareSize\":%u,\"result\":\"%s\",\"status\":\"%s\","
+                     "\"readyMs\":%.1f,\"transferMs\":%.1f,\"totalMs\":%.1f,"
+                     "\"transferKBps\":%.1f,\"effectiveKBps\":%.1f,"
+                     "\"retransmits\":%u,\"ackTimeouts\":%u,\"packetsSent\":%u,\"packetsLost\":%u,"
+                     "\"acksSent\":%u,\"acksLost\":%u,\"sectorsErased\":%u}",
+                     cfg->mtu, (unsigned)cfg->interval_us, cfg->phy, cfg->ll_octets, cfg->max_pdus_per_event,
+                     (unsigned)cfg->loss_ppm, (unsigned)cfg->ack_loss_ppm, (unsigned)cfg->flash.erase_sector_us,
+                     (unsigned)cfg->flash.program_kb_us, (unsigned)size, res->success ? "success" : "failed",
+                     res->status, res->ready_us / 1000.0, res->success ? transfer_us / 1000.0 : 0.0,
+                     res->success ? res->success_us / 1000.0 : 0.0,
+                     res->success ? sim_kbps(size, transfer_us) : 0.0,
+                     res->success ? sim_kbps(size, res->success_us) : 0.0, (unsigned)res->retransmits,
+                     (unsigned)res->ack_timeouts, (unsigned)res->packets_sent, (unsigned)res->packets_lost,
+                     (unsigned)res->acks_sent, (unsigned)res->acks_lost, (unsigned)res->sectors_erased);
+    return n < 0 ? 0 : (size_t)n;
+}
@@ -0,0 +1,72 @@
+/*
+  ============================================================================
+  OTA Transfer Simulator (host builds)
+
+  Runs one sequenced BLE OTA upload end to end on the fake RTOS clock:
+  START -> READY, windowed data with selective retransmit, END -> SUCCESS.
+  The device side is the real ota_rx / ota_sack / ota_pipeline /
+  ota_flash code with the ACK policy of main.cpp; the client is a port of
+  sendSequenced() in WebAppSide/ota-client.js. Between them sits a GATT
+  link model (ATT MTU, connection interval, LL payload size, PHY, packet
+  loss in both directions), and the flash has erase / program latency
+  (fake_flash timing), so the writer task stalls as it does on the device.
+  ============================================================================
+*/
+
+#pragma once
+
+#include <fake_flash.h>
+#include <stddef.h>
+#include <stdint.h>
+
+// WebAppSide/constants.js OTA_CONFIG
+#define OTA_SIM_CHUNK_SIZE 400
+#define OTA_SIM_ACK_TIMEOUT_MS 1000
+#define OTA_SIM_RETRANSMIT_TIMEOUT_MS 500
+#define OTA_SIM_MAX_ACK_TIMEOUTS 10
+#define OTA_SIM_TIMEOUT_MS 120000
+
+// main.cpp
+#define OTA_SIM_ACK_STRIDE_BYTES 8192
+#define OTA_SIM_ACK_INTERVAL_MS 50
+#define OTA_SIM_FLUSH_TIMEOUT_MS 5000
+
+typedef struct
+{
+    uint16_t mtu;                // ATT MTU; packets are min(CHUNK_SIZE, mtu - 3) bytes
+    uint32_t interval_us;        // Connection interval
+    uint8_t phy;                 // 1 or 2 (Mbit/s)
+    uint16_t ll_octets;          // LL payload per PDU (27 without DLE, 251 with)
+    uint16_t max_pdus_per_event; // Central's limit per connection event, 0 = airtime only
+    uint32_t loss_ppm;           // Data packets lost on the way to the device
+    uint32_t ack_loss_ppm;       // ACK notifications lost on the way to the client
+    uint32_t seed;
+    fake_flash_timing_t flash;
+} ota_sim_config_t;
+
+typedef struct
+{
+    bool success;
+    char status[32];          // Last status the client saw (SUCCESS, ERROR:..., or TIMEOUT)
+    int64_t ready_us;         // Phases, from START
+    int64_t transferred_us;   // Last byte acknowledged
+    int64_t success_us;       // SUCCESS received (time to SUCCESS)
+    uint32_t events;          // Connection events
+    uint32_t packets_sent;
+    uint32_t packets_lost;
+    uint32_t retransmits;     // Chunks sent again (ota-client.js retransmitCount)
+    uint32_t ack_timeouts;
+    uint32_t acks_sent;
+    uint32_t acks_lost;
+    uint32_t sectors_erased;
+} ota_sim_result_t;
+
+// 2M PHY, DLE, 247-byte MTU, 15 ms interval, 6 PDUs per event, no loss, typical SPI NOR timing
+void ota_sim_default_config(ota_sim_config_t *cfg);
+
+// Upload image (raw codec) and verify it; false if the upload did not end in SUCCESS
+bool ota_sim_run(const ota_sim_config_t *cfg, const uint8_t *image, size_t size, ota_sim_result_t *out);
+
+// One JSON object per run, field names as in the WebApp's OTA_METRICS reports
+size_t ota_sim_json(const ota_sim_config_t *cfg, size_t size, const ota_sim_result_t *res, char *out,
+                    size_t out_size);
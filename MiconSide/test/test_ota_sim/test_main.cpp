@@ -0,0 +1,232 @@
+#include <unity.h>
+
+#include "ota_sim.h"
+
+#include <esp_ota_ops.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+// Image: OTA_SIM_IMAGE names a .bin (e.g. .pio/build/esp32-s3-devkitc-1/firmware.bin),
+// otherwise 256 KB of pseudo-random bytes
+#define DEFAULT_IMAGE_SIZE (256 * 1024 + 77)
+
+typedef std::vector<uint8_t> bytes_t;
+
+static bytes_t s_image;
+static ota_sim_config_t s_cfg;
+static ota_sim_result_t s_res;
+
+static bool load_file(const char *path, bytes_t *out)
+{
+    FILE *f = path ? fopen(path, "rb") : NULL;
+    if (!f)
+        return false;
+    uint8_t buf[4096];
+    size_t n;
+    out->clear();
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        out->insert(out->end(), buf, buf + n);
+    fclose(f);
+    return !out->empty();
+}
+
+static void run(void)
+{
+    ota_sim_run(&s_cfg, s_image.data(), s_image.size(), &s_res);
+    char json[512];
+    ota_sim_json(&s_cfg, s_image.size(), &s_res, json, sizeof(json));
+    TEST_MESSAGE(json);
+}
+
+static void assert_success(void)
+{
+    TEST_ASSERT_TRUE_MESSAGE(s_res.success, s_res.status);
+    TEST_ASSERT_EQUAL_STRING("SUCCESS", s_res.status);
+    TEST_ASSERT_EQUAL_MEMORY(s_image.data(), fake_flash_data(esp_ota_get_next_update_partition(NULL)),
+                             s_image.size());
+    TEST_ASSERT_TRUE(s_res.ready_us < s_res.transferred_us && s_res.transferred_us < s_res.success_us);
+}
+
+static double kbps(const ota_sim_result_t *res)
+{
+    return s_image.size() / 1024.0 / (res->success_us / 1e6);
+}
+
+void setUp(void)
+{
+    ota_sim_default_config(&s_cfg);
+}
+
+void tearDown(void)
+{
+}
+
+static void test_clean_link_succeeds_without_retransmits(void)
+{
+    run();
+    assert_success();
+    TEST_ASSERT_EQUAL_UINT32(0, s_res.retransmits);
+    TEST_ASSERT_EQUAL_UINT32(0, s_res.ack_timeouts);
+    TEST_ASSERT_EQUAL_UINT32(0, s_res.packets_lost);
+    TEST_ASSERT_EQUAL_UINT32((s_image.size() + 4095) / 4096, s_res.sectors_erased);
+}
+
+static void test_data_loss_is_repaired_by_selective_retransmit(void)
+{
+    s_cfg.loss_ppm = 20000; // 2 %
+    run();
+    assert_success();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, s_res.packets_lost);
+    TEST_ASSERT_GREATER_OR_EQUAL_UINT32(s_res.packets_lost, s_res.retransmits);
+    // Gaps are reported by SACK, not found by waiting out the ACK timeout
+    TEST_ASSERT_TRUE(s_res.ack_timeouts * 4 < s_res.packets_lost);
+}
+
+static void test_lost_acks_are_covered_by_later_acks(void)
+{
+    s_cfg.ack_loss_ppm = 100000; // 10 %
+    run();
+    assert_success();
+    TEST_ASSERT_GREATER_THAN_UINT32(0, s_res.acks_lost);
+}
+
+static void test_heavy_loss_both_ways_still_completes(void)
+{
+    s_cfg.loss_ppm = 100000;
+    s_cfg.ack_loss_ppm = 100000;
+    s_cfg.seed = 7;
+    run();
+    assert_success();
+}
+
+static void test_small_mtu_is_slower(void)
+{
+    s_cfg.flash.erase_sector_us = 0; // Link-bound
+    s_cfg.flash.program_kb_us = 0;
+    run();
+    assert_success();
+    ota_sim_result_t big = s_res;
+
+    s_cfg.mtu = 23;
+    s_cfg.ll_octets = 27;
+    run();
+    assert_success();
+    TEST_ASSERT_TRUE(kbps(&s_res) * 3 < kbps(&big));
+}
+
+static void test_longer_interval_is_slower(void)
+{
+    s_cfg.flash.erase_sector_us = 0;
+    s_cfg.flash.program_kb_us = 0;
+    run();
+    assert_success();
+    ota_sim_result_t fast = s_res;
+
+    s_cfg.interval_us = 45000;
+    run();
+    assert_success();
+    TEST_ASSERT_TRUE(kbps(&s_res) * 2 < kbps(&fast));
+}
+
+// Erase time caps the rate; the advertised window holds the client back instead of an overflow
+static void test_slow_flash_limits_throughput(void)
+{
+    s_cfg.flash.erase_sector_us = 100000;
+    run();
+    assert_success();
+    TEST_ASSERT_TRUE(kbps(&s_res) <= 4.0 / 0.1);
+    TEST_ASSERT_EQUAL_UINT32(0, s_res.retransmits);
+}
+
+// ============================================================================
+// Sweep: one JSON line per point (OTA_SIM_JSON=<file> also writes them as an array).
+// OTA_SIM_MTU, OTA_SIM_INTERVAL_US, OTA_SIM_LOSS_PPM, OTA_SIM_ERASE_US override the axes.
+// ============================================================================
+
+// Comma-separated list from the environment, or the defaults
+static std::vector<uint32_t> sweep_values(const char *name, std::vector<uint32_t> defaults)
+{
+    const char *env = getenv(name);
+    if (!env || !*env)
+        return defaults;
+    std::vector<uint32_t> values;
+    for (const char *p = env; *p;)
+    {
+        char *end;
+        uint32_t value = (uint32_t)strtoul(p, &end, 10);
+        if (end == p)
+            break;
+        values.push_back(value);
+        p = *end == ',' ? end + 1 : end;
+    }
+    return values;
+}
+
+static void test_sweep(void)
+{
+    std::vector<uint32_t> mtus = sweep_values("OTA_SIM_MTU", {23, 185, 247, 517});
+    std::vector<uint32_t> intervals = sweep_values("OTA_SIM_INTERVAL_US", {7500, 15000, 30000});
+    std::vector<uint32_t> losses = sweep_values("OTA_SIM_LOSS_PPM", {0, 10000, 50000});
+    std::vector<uint32_t> erases = sweep_values("OTA_SIM_ERASE_US", {45000});
+
+    FILE *out = getenv("OTA_SIM_JSON") ? fopen(getenv("OTA_SIM_JSON"), "w") : NULL;
+    if (out)
+        fputs("[\n", out);
+    bool first = true;
+    for (uint32_t mtu : mtus)
+        for (uint32_t interval : intervals)
+            for (uint32_t loss : losses)
+                for (uint32_t erase : erases)
+                {
+                    ota_sim_default_config(&s_cfg);
+                    s_cfg.mtu = (uint16_t)mtu;
+                    s_cfg.ll_octets = mtu > 23 ? 251 : 27;
+                    s_cfg.interval_us = interval;
+                    s_cfg.loss_ppm = loss;
+                    s_cfg.ack_loss_ppm = loss;
+                    s_cfg.flash.erase_sector_us = erase;
+                    run(); // Points that do not finish are reported with "result":"failed"
+                    TEST_ASSERT_TRUE(s_res.status[0] != '\0');
+
+                    char json[512];
+                    ota_sim_json(&s_cfg, s_image.size(), &s_res, json, sizeof(json));
+                    if (out)
+                        fprintf(out, "%s  %s", first ? "" : ",\n", json);
+                    first = false;
+                }
+    if (out)
+    {
+        fputs("\n]\n", out);
+        fclose(out);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    if (!load_file(getenv("OTA_SIM_IMAGE"), &s_image))
+    {
+        uint32_t x = 0x2545F491;
+        s_image.resize(DEFAULT_IMAGE_SIZE);
+        for (uint8_t &b : s_image)
+        {
+            x ^= x << 13;
+            x ^= x >> 17;
+            x ^= x << 5;
+            b = (uint8_t)x;
+        }
+    }
+
+    UNITY_BEGIN();
+    RUN_TEST(test_clean_link_succeeds_without_retransmits);
+    RUN_TEST(test_data_loss_is_repaired_by_selective_retransmit);
+    RUN_TEST(test_lost_acks_are_covered_by_later_acks);
+    RUN_TEST(test_heavy_loss_both_ways_still_completes);
+    RUN_TEST(test_small_mtu_is_slower);
+    RUN_TEST(test_longer_interval_is_slower);
+    RUN_TEST(test_slow_flash_limits_throughput);
+    RUN_TEST(test_sweep);
+    return UNITY_END();
+}
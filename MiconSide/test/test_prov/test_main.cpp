@@ -0,0 +1,143 @@
+#include <unity.h>
+
+#include "prov.h"
+
+#include <string.h>
+
+#define OP_PROV 0x90
+
+static void on_prov(const ble_cmd_frame_t *frame)
+{
+}
+
+// Same table as the ProvWifiConfig characteristic in main.cpp
+static const ble_cmd_entry_t entries[] = {
+    {OP_PROV, NULL, 2, NULL, on_prov},
+};
+static const ble_cmd_table_t table = {entries, 1, '\n', false};
+
+static ble_cmd_frame_t s_frame;
+static prov_credentials_t s_creds;
+
+static prov_result_t prov_bytes(const uint8_t *data, size_t len)
+{
+    TEST_ASSERT_NOT_NULL(ble_cmd_parse(&table, data, len, &s_frame));
+    return prov_parse(&s_frame, &s_creds);
+}
+
+static prov_result_t prov_text(const char *text)
+{
+    return prov_bytes((const uint8_t *)text, strlen(text));
+}
+
+void setUp(void)
+{
+    memset(&s_creds, 0x55, sizeof(s_creds));
+}
+
+void tearDown(void)
+{
+}
+
+static void test_text_credentials(void)
+{
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text("HomeNet\nsecret pass"));
+    TEST_ASSERT_EQUAL_STRING("HomeNet", s_creds.ssid);
+    TEST_ASSERT_EQUAL_STRING("secret pass", s_creds.password);
+}
+
+// Used to be taken for a binary frame (first byte >= 0x80) and rejected
+static void test_non_ascii_ssid(void)
+{
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text("\xE3\x82\xA2Net\npassword"));
+    TEST_ASSERT_FALSE(s_frame.binary);
+    TEST_ASSERT_EQUAL_STRING("\xE3\x82\xA2Net", s_creds.ssid);
+    TEST_ASSERT_EQUAL_STRING("password", s_creds.password);
+}
+
+static void test_password_keeps_newlines(void)
+{
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text("Net\nline1\nline2"));
+    TEST_ASSERT_EQUAL_STRING("line1\nline2", s_creds.password);
+}
+
+static void test_open_network(void)
+{
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text("Cafe\n"));
+    TEST_ASSERT_EQUAL_STRING("Cafe", s_creds.ssid);
+    TEST_ASSERT_EQUAL_STRING("", s_creds.password);
+}
+
+static void test_missing_separator(void)
+{
+    TEST_ASSERT_EQUAL(PROV_NO_SEPARATOR, prov_text("JustSsid"));
+    TEST_ASSERT_EQUAL_STRING("", s_creds.ssid);
+}
+
+static void test_bad_ssid(void)
+{
+    TEST_ASSERT_EQUAL(PROV_BAD_SSID, prov_text("\npassword"));
+
+    char text[CONFIG_SSID_MAX + 8];
+    memset(text, 'S', CONFIG_SSID_MAX + 1);
+    strcpy(text + CONFIG_SSID_MAX + 1, "\npw");
+    TEST_ASSERT_EQUAL(PROV_BAD_SSID, prov_text(text));
+
+    text[CONFIG_SSID_MAX] = '\n'; // Exactly CONFIG_SSID_MAX
+    text[CONFIG_SSID_MAX + 1] = '\0';
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text(text));
+}
+
+static void test_password_too_long(void)
+{
+    char text[CONFIG_PASS_MAX + 16];
+    strcpy(text, "Net\n");
+    memset(text + 4, 'p', CONFIG_PASS_MAX + 1);
+    text[4 + CONFIG_PASS_MAX + 1] = '\0';
+    TEST_ASSERT_EQUAL(PROV_BAD_PASSWORD, prov_text(text));
+
+    text[4 + CONFIG_PASS_MAX] = '\0';
+    TEST_ASSERT_EQUAL(PROV_OK, prov_text(text));
+    TEST_ASSERT_EQUAL_size_t(CONFIG_PASS_MAX, strlen(s_creds.password));
+}
+
+static void test_embedded_nul_is_rejected(void)
+{
+    const uint8_t ssid_nul[] = {BLE_CMD_BINARY_V1, OP_PROV, 1, 3, 0, 'e', 't', 2, 2, 'p', 'w'};
+    TEST_ASSERT_EQUAL(PROV_BAD_SSID, prov_bytes(ssid_nul, sizeof(ssid_nul)));
+    TEST_ASSERT_EQUAL_STRING("", s_creds.ssid);
+
+    const uint8_t pass_nul[] = {BLE_CMD_BINARY_V1, OP_PROV, 1, 3, 'N', 'e', 't', 2, 2, 'p', 0};
+    TEST_ASSERT_EQUAL(PROV_BAD_PASSWORD, prov_bytes(pass_nul, sizeof(pass_nul)));
+}
+
+static void test_binary_fields(void)
+{
+    const uint8_t frame[] = {BLE_CMD_BINARY_V1, OP_PROV, 1, 3, 'N', 'e', 't', 2, 2, 'p', 'w'};
+    TEST_ASSERT_EQUAL(PROV_OK, prov_bytes(frame, sizeof(frame)));
+    TEST_ASSERT_TRUE(s_frame.binary);
+    TEST_ASSERT_EQUAL_STRING("Net", s_creds.ssid);
+    TEST_ASSERT_EQUAL_STRING("pw", s_creds.password);
+
+    const uint8_t open[] = {BLE_CMD_BINARY_V1, OP_PROV, 1, 3, 'N', 'e', 't'};
+    TEST_ASSERT_EQUAL(PROV_OK, prov_bytes(open, sizeof(open)));
+    TEST_ASSERT_EQUAL_STRING("", s_creds.password);
+
+    const uint8_t no_ssid[] = {BLE_CMD_BINARY_V1, OP_PROV, 2, 2, 'p', 'w'};
+    TEST_ASSERT_EQUAL(PROV_BAD_SSID, prov_bytes(no_ssid, sizeof(no_ssid)));
+}
+
+int main(int argc, char **argv)
+{
+    UNITY_BEGIN();
+    RUN_TEST(test_text_credentials);
+    RUN_TEST(test_non_ascii_ssid);
+    RUN_TEST(test_password_keeps_newlines);
+    RUN_TEST(test_open_network);
+    RUN_TEST(test_missing_separator);
+    RUN_TEST(test_bad_ssid);
+    RUN_TEST(test_password_too_long);
+    RUN_TEST(test_embedded_nul_is_rejected);
+    RUN_TEST(test_binary_fields);
+    return UNITY_END();
+}
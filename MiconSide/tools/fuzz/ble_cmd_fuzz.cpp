@@ -0,0 +1,104 @@
+/*
+  ============================================================================
+  ble_cmd / prov Fuzz Target
+
+  libFuzzer entry point that parses one input against tables shaped like
+  DebugCmdRx, ProvWifiConfig and OtaControl, runs every field accessor
+  and prov_parse, and checks the invariants the handlers rely on:
+  fields stay inside the write, only 0xF5.. starts a binary frame, and
+  accepted credentials fit their config_t buffers.
+
+    clang++ -g -O1 -fsanitize=fuzzer,address,undefined -Isrc \
+        tools/fuzz/ble_cmd_fuzz.cpp src/ble_cmd.cpp src/prov.cpp -o ble_cmd_fuzz
+    ./ble_cmd_fuzz -max_len=512
+
+  test/test_ble_cmd_fuzz includes this file and runs the same checks over
+  a pseudo-random corpus under `pio test -e native`.
+  ============================================================================
+*/
+
+#include "ble_cmd.h"
+#include "prov.h"
+
+#include <string.h>
+
+#ifndef FUZZ_CHECK
+#define FUZZ_CHECK(cond)        \
+    do                          \
+    {                           \
+        if (!(cond))            \
+            __builtin_trap();   \
+    } while (0)
+#endif
+
+static void fuzz_nop(const ble_cmd_frame_t *frame)
+{
+}
+
+static const char *const fuzz_start_keys[] = {"sha", "at", "bsize", "bsha", NULL};
+
+static const ble_cmd_entry_t fuzz_debug_entries[] = {
+    {0x80, "RESET_NVS", 0, NULL, fuzz_nop},
+    {0x83, "LVL", 1, NULL, fuzz_nop},
+    {0x88, "TELEM", 1, NULL, fuzz_nop},
+};
+static const ble_cmd_entry_t fuzz_prov_entries[] = {
+    {0x90, NULL, 2, NULL, fuzz_nop},
+};
+static const ble_cmd_entry_t fuzz_ota_entries[] = {
+    {0xA0, "START", 3, fuzz_start_keys, fuzz_nop},
+    {0xA1, "RESUME", 1, NULL, fuzz_nop},
+    {0xA3, "END", 0, NULL, fuzz_nop},
+};
+
+static const ble_cmd_table_t fuzz_tables[] = {
+    {fuzz_debug_entries, 3, ':', true},
+    {fuzz_prov_entries, 1, '\n', false},
+    {fuzz_ota_entries, 3, ':', true},
+};
+
+static void fuzz_check_frame(const ble_cmd_frame_t *frame, const uint8_t *data, size_t len)
+{
+    FUZZ_CHECK(frame->raw == data && frame->raw_len == len);
+    FUZZ_CHECK(frame->field_count <= BLE_CMD_MAX_FIELDS);
+    FUZZ_CHECK(frame->binary == (len > 0 && data[0] >= BLE_CMD_BINARY_MIN));
+
+    for (size_t i = 0; i < frame->field_count; i++)
+    {
+        const ble_cmd_field_t *field = &frame->fields[i];
+        FUZZ_CHECK(field->tag != 0);
+        FUZZ_CHECK(field->value >= data && field->value + field->len <= data + len);
+    }
+
+    for (uint8_t tag = 1; tag <= BLE_CMD_MAX_FIELDS; tag++)
+    {
+        uint8_t bytes[64];
+        char str[CONFIG_PASS_MAX + 1];
+        ble_cmd_u32(frame, tag, 0);
+        FUZZ_CHECK(ble_cmd_bytes(frame, tag, bytes, sizeof(bytes)) <= sizeof(bytes));
+        size_t n = ble_cmd_str(frame, tag, str, sizeof(str));
+        FUZZ_CHECK(n < sizeof(str) && strlen(str) <= n);
+        ble_cmd_equals(frame, tag, "deflate");
+    }
+}
+
+extern "C" int LLVMFuzzerTestOneInput(const uint8_t *data, size_t len)
+{
+    for (size_t t = 0; t < sizeof(fuzz_tables) / sizeof(fuzz_tables[0]); t++)
+    {
+        ble_cmd_frame_t frame;
+        const ble_cmd_entry_t *entry = ble_cmd_parse(&fuzz_tables[t], data, len, &frame);
+        fuzz_check_frame(&frame, data, len);
+        if (!entry)
+            continue;
+        FUZZ_CHECK(entry >= fuzz_tables[t].entries && entry < fuzz_tables[t].entries + fuzz_tables[t].count);
+
+        prov_credentials_t creds;
+        if (prov_parse(&frame, &creds) == PROV_OK)
+        {
+            FUZZ_CHECK(creds.ssid[0] != '\0' && strlen(creds.ssid) <= CONFIG_SSID_MAX);
+            FUZZ_CHECK(strlen(creds.password) <= CONFIG_PASS_MAX);
+        }
+    }
+    return 0;
+}
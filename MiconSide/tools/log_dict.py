@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+"""Generate the log format dictionary for dictionary-encoded BLE logs.
+
+  python3 tools/log_dict.py
+      Scan src/*.cpp for LOG_E/W/I/D("...") calls and write
+      ../WebAppSide/log-dictionary.json ({"formats": {"<id hex>": "<format>"}}).
+
+Also runs as a PlatformIO pre-build script (extra_scripts in platformio.ini),
+so the dictionary always matches the firmware being built. IDs are FNV-1a
+of the tagged format string, as computed by log_dict_id() in src/log_dict.h.
+"""
+
+import json
+import re
+import sys
+from pathlib import Path
+
+try:
+    Import("env")  # noqa: F821 - provided by PlatformIO (SCons has no __file__)
+    PROJECT_DIR = Path(env["PROJECT_DIR"])  # noqa: F821
+except NameError:
+    PROJECT_DIR = Path(__file__).resolve().parent.parent
+SOURCE_DIR = PROJECT_DIR / "src"
+DICTIONARY = PROJECT_DIR.parent / "WebAppSide" / "log-dictionary.json"
+
+LEVEL_TAGS = {"E": "[E] ", "W": "[W] ", "I": "[I] ", "D": "[D] "}
+LOG_CALL = re.compile(r'\bLOG_([EWID])\(\s*((?:"(?:[^"\\]|\\.)*"\s*)+)')
+STRING_PART = re.compile(r'"((?:[^"\\]|\\.)*)"')
+ESCAPES = {"n": "\n", "t": "\t", "r": "\r", "\\": "\\", '"': '"', "'": "'", "0": "\0"}
+
+
+def unescape(literal):
+    return re.sub(r"\\x([0-9a-fA-F]{2})|\\(.)",
+                  lambda m: chr(int(m.group(1), 16)) if m.group(1) else ESCAPES.get(m.group(2), m.group(2)),
+                  literal)
+
+
+def fnv1a(text):
+    h = 0x811C9DC5
+    for byte in text.encode("utf-8"):
+        h = ((h ^ byte) * 0x01000193) & 0xFFFFFFFF
+    return h
+
+
+def build():
+    formats = {}
+    for source in sorted(SOURCE_DIR.glob("*.cpp")):
+        for match in LOG_CALL.finditer(source.read_text(encoding="utf-8")):
+            fmt = LEVEL_TAGS[match.group(1)] + "".join(unescape(p) for p in STRING_PART.findall(match.group(2)))
+            key = f"{fnv1a(fmt):08x}"
+            if key == "00000000" or formats.get(key, fmt) != fmt:
+                sys.exit(f"log_dict: ID collision for {fmt!r} ({source.name}), reword the message")
+            formats[key] = fmt
+
+    text = json.dumps({"version": 1, "formats": dict(sorted(formats.items()))}, indent=2, ensure_ascii=False) + "\n"
+    if not DICTIONARY.exists() or DICTIONARY.read_text(encoding="utf-8") != text:
+        DICTIONARY.write_text(text, encoding="utf-8")
+    print(f"log_dict: {len(formats)} formats -> {DICTIONARY}")
+
+
+build()
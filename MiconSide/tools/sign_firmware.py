@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+"""Sign OTA images for firmware built with -DOTA_SIGNATURE_ENABLED=1.
+
+  python3 tools/sign_firmware.py keygen <private.pem>
+      Create a new ECDSA P-256 key pair (keep private.pem out of the repo).
+  python3 tools/sign_firmware.py header <private.pem>
+      Write src/ota_signing_key.h with the public key.
+  python3 tools/sign_firmware.py sign <private.pem> <firmware.bin> [<signed.bin>]
+      Append the signature: [image][DER signature][length: u16 LE]["OSIG"].
+      The WebApp strips the trailer and sends the signature with SIG: before END.
+
+Requires the openssl command line tool.
+"""
+
+import struct
+import subprocess
+import sys
+from pathlib import Path
+
+SIGNATURE_MAGIC = b"OSIG"
+KEY_HEADER = Path(__file__).resolve().parent.parent / "src" / "ota_signing_key.h"
+
+
+def openssl(*args, data=None):
+    return subprocess.run(["openssl", *args], input=data, check=True, capture_output=True).stdout
+
+
+def keygen(private_pem):
+    openssl("ecparam", "-name", "prime256v1", "-genkey", "-noout", "-out", private_pem)
+    print(f"Private key written to {private_pem}")
+
+
+def header(private_pem):
+    public_pem = openssl("ec", "-in", private_pem, "-pubout").decode()
+    lines = "".join(f'    "{line}\\n"\n' for line in public_pem.strip().splitlines())
+    KEY_HEADER.write_text(
+        "// Generated by tools/sign_firmware.py - OTA image signing public key\n"
+        "#pragma once\n\n"
+        "#define OTA_SIGNING_PUBKEY_PEM \\\n" + lines.rstrip("\n").replace("\n", " \\\n") + "\n"
+    )
+    print(f"Public key written to {KEY_HEADER}")
+
+
+def sign(private_pem, firmware, signed=None):
+    image = Path(firmware).read_bytes()
+    signature = openssl("dgst", "-sha256", "-sign", private_pem, data=image)
+    out = Path(signed) if signed else Path(firmware).with_suffix(".signed.bin")
+    out.write_bytes(image + signature + struct.pack("<H", len(signature)) + SIGNATURE_MAGIC)
+    print(f"Signed image written to {out} ({len(signature)} byte signature)")
+
+
+def main():
+    commands = {"keygen": (keygen, 1), "header": (header, 1), "sign": (sign, 2)}
+    if len(sys.argv) < 3 or sys.argv[1] not in commands:
+        print(__doc__)
+        return 1
+
+    func, required = commands[sys.argv[1]]
+    args = sys.argv[2:]
+    if len(args) < required:
+        print(__doc__)
+        return 1
+    func(*args)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -190,6 +190,7 @@ class ESP32RemoteApp {
         bleClient.onDisconnect = () => this.onBleDisconnect();
         bleClient.onLogReceived = (line) => this.onBleLogReceived(line);
         bleClient.onStatReceived = (stat) => this.onBleStatReceived(stat);
+        bleClient.onTelemetryReceived = (telemetry) => this.onBleTelemetryReceived(telemetry);
         
         console.log('[App] BLE callbacks configured');
         console.log('[App] bleClient.onLogReceived:', bleClient.onLogReceived);
@@ -343,6 +344,7 @@ class ESP32RemoteApp {
             
             uiManager.showSuccess('ble-error', SUCCESS_MESSAGES.BLE_CONNECTED);
             uiManager.updateDebugStatus('BLE Connected - Ready', 'success');
+            await this.showOtaHistory();
 
             // File input is always enabled for iPhone compatibility
             // Validation is done during upload
@@ -610,6 +612,12 @@ class ESP32RemoteApp {
             const result = await firmwareClient.uploadFirmware(binFile, progressCallback);
             
             this.logToUI('✅ [Firmware] ✓ Firmware uploaded successfully!');
+            if (result.report) {
+                const { report } = result;
+                this.logToUI(`📈 [OTA] ${report.transport}: ${report.transferKBps} KB/s, ` +
+                    `${(report.totalMs / 1000).toFixed(1)} s to SUCCESS, ${report.retransmits} retransmits ` +
+                    `(${OTA_METRICS_COMMAND} saves the reports)`);
+            }
             this.logToUI('🔄 [Firmware] Device is rebooting with new firmware...');
             this.logToUI('⏳ [Firmware] BLE connection will be lost during reboot');
             this.logToUI('📱 [Firmware] You can reconnect after ~5-10 seconds');
@@ -701,10 +709,31 @@ class ESP32RemoteApp {
                 throw new Error('Please enter a command');
             }
 
+            // Handled by the page: save the OTA throughput reports as JSON
+            if (command === OTA_METRICS_COMMAND) {
+                const count = otaMetrics.history().length;
+                if (count === 0) {
+                    throw new Error('No OTA reports recorded yet');
+                }
+                otaMetrics.download();
+                this.logToUI(`[OTA-Metrics] Saved ${count} report(s)`);
+                document.getElementById('debug-command').value = '';
+                return;
+            }
+
             if (!bleClient.isConnected) {
                 throw new Error('BLE not connected');
             }
 
+            // Handled by the page: print the device's OTA session history
+            if (command === OTA_HISTORY_COMMAND) {
+                if (!(await this.showOtaHistory())) {
+                    throw new Error('Device keeps no OTA history (older firmware)');
+                }
+                document.getElementById('debug-command').value = '';
+                return;
+            }
+
             this.logToUI(`[Debug Command] Sending: ${command}`);
             await bleClient.sendCommand(command);
             
@@ -718,6 +747,33 @@ class ESP32RemoteApp {
         }
     }
 
+    /**
+     * Print the OTA sessions recorded on the device (phase times, sizes, outcome).
+     * Returns false if the firmware keeps no history.
+     */
+    async showOtaHistory() {
+        let records;
+        try {
+            records = await bleClient.readOtaHistory();
+        } catch (error) {
+            console.warn('[App] OTA history read failed:', error);
+            return false;
+        }
+        if (!records) {
+            return false;
+        }
+
+        if (records.length === 0) {
+            this.logToUI('[OTA-History] No OTA sessions recorded on this device');
+            return true;
+        }
+        this.logToUI(`[OTA-History] Last ${records.length} OTA session(s) on this device:`);
+        for (const record of records) {
+            this.logToUI(`[OTA-History] ${formatOtaHistoryRecord(record)}`);
+        }
+        return true;
+    }
+
     /**
      * BLE disconnection callback
      */
@@ -732,6 +788,7 @@ class ESP32RemoteApp {
         uiManager.setFirmwareButtonState('disabled');
         uiManager.updateOTAProgress(0);
         uiManager.updateOTAStatus('IDLE');
+        telemetryHistory.clear();
     }
 
     /**
@@ -776,6 +833,28 @@ class ESP32RemoteApp {
         }
     }
 
+    /**
+     * BLE telemetry frame received (DebugStat, decoded by telemetry.js)
+     */
+    onBleTelemetryReceived(telemetry) {
+        // Frames can arrive several times a second (TELEM): log changes only
+        const previous = telemetryHistory.samples[telemetryHistory.samples.length - 1];
+        telemetryHistory.add(telemetry);
+        uiManager.updateTelemetry(telemetry, telemetryHistory);
+
+        // During a transfer the upload flow owns the OTA status
+        if ((!previous || previous.otaMode !== telemetry.otaMode) && !telemetry.otaActive) {
+            uiManager.updateOTAStatus(telemetry.otaMode ? 'OTA_MODE' : 'IDLE');
+            if (telemetry.otaMode) {
+                this.logToUI('[OTA] Device is in OTA mode');
+            }
+        }
+        if (telemetry.ip && (!previous || previous.ip !== telemetry.ip)) {
+            uiManager.updateDeviceIp(telemetry.ip);
+            this.logToUI(`[WiFi] Device IP: ${telemetry.ip}`);
+        }
+    }
+
     /**
      * Log message to UI
      */
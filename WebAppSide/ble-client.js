@@ -13,7 +13,9 @@ class BLEClient {
         this.isConnected = false;
         this.onDisconnect = null;
         this.onLogReceived = null;
-        this.onStatReceived = null;
+        this.bootReport = null; // DebugBoot text (BOOT:fw=...,<phase>=<us>,...)
+        this.onStatReceived = null;      // Text STATE:... line (older firmware)
+        this.onTelemetryReceived = null; // Decoded telemetry frame (telemetry.js)
     }
 
     /**
@@ -110,6 +112,7 @@ class BLEClient {
             try {
                 this.characteristics.logTx = await this.service.getCharacteristic(BLE_UUIDS.DEBUG_LOG_TX_UUID);
                 console.log('[BLE] DebugLogTx characteristic obtained');
+                await logDictionary.load(); // Needed to render dictionary-encoded lines
                 await this.characteristics.logTx.startNotifications();
                 console.log('[BLE] DebugLogTx notifications STARTED');
                 this.characteristics.logTx.addEventListener('characteristicvaluechanged', 
@@ -140,6 +143,27 @@ class BLEClient {
                 console.error('[BLE] DebugStat ERROR:', e.message);
             }
 
+            // Get DebugBoot (Read, optional on older firmware)
+            try {
+                const boot = await this.service.getCharacteristic(BLE_UUIDS.DEBUG_BOOT_UUID);
+                const value = await boot.readValue();
+                this.bootReport = new TextDecoder().decode(value);
+                console.log('[BLE] Boot timeline:', this.bootReport);
+                if (this.onLogReceived) {
+                    this.onLogReceived(this.bootReport);
+                }
+            } catch (e) {
+                console.log('[BLE] DebugBoot not available:', e.message);
+            }
+
+            // Get DebugOtaHist (Read, optional on older firmware)
+            try {
+                this.characteristics.otaHistory = await this.service.getCharacteristic(BLE_UUIDS.DEBUG_OTA_HIST_UUID);
+                console.log('[BLE] DebugOtaHist available');
+            } catch (e) {
+                console.log('[BLE] DebugOtaHist not available:', e.message);
+            }
+
         } catch (error) {
             console.error('[BLE] Debug service NOT found:', error.message);
             throw new Error(ERROR_MESSAGES.BLE_SERVICE_NOT_FOUND);
@@ -168,12 +192,15 @@ class BLEClient {
         const characteristic = event.target;
         const value = characteristic.value;
         
-        // Decode UTF-8
-        const decoder = new TextDecoder();
-        const logLine = decoder.decode(value);
+        // Dictionary-encoded batch (leading 0x00) or UTF-8 text
+        const bytes = new Uint8Array(value.buffer, value.byteOffset, value.byteLength);
+        const logLines = logDictionary.isEncoded(bytes)
+            ? logDictionary.decode(bytes)
+            : new TextDecoder().decode(bytes).split('\n');
+        const logLine = logLines.join('\n');
         
         console.log('[BLE] ===== NOTIFICATION RECEIVED =====');
-        console.log('[BLE] Raw bytes:', new Uint8Array(value.buffer));
+        console.log('[BLE] Raw bytes:', bytes);
         console.log('[BLE] Decoded message:', logLine);
         console.log('[BLE] onLogReceived exists?', this.onLogReceived !== null && this.onLogReceived !== undefined);
         console.log('[BLE] onLogReceived type:', typeof this.onLogReceived);
@@ -186,7 +213,10 @@ class BLEClient {
         if (this.onLogReceived) {
             console.log('[BLE] ✓ Calling onLogReceived callback...');
             try {
-                this.onLogReceived(logLine);
+                // The device packs several lines into one notification
+                for (const line of logLines) {
+                    this.onLogReceived(line);
+                }
                 console.log('[BLE] ✓ Callback executed successfully');
             } catch (error) {
                 console.error('[BLE] ✗ Callback execution error:', error);
@@ -212,6 +242,15 @@ class BLEClient {
     _onStatNotify(event) {
         const characteristic = event.target;
         const value = characteristic.value;
+
+        // Binary telemetry frame, or the text line of older firmware
+        const telemetry = decodeTelemetry(value);
+        if (telemetry) {
+            if (this.onTelemetryReceived) {
+                this.onTelemetryReceived(telemetry);
+            }
+            return;
+        }
         
         // Decode UTF-8
         const decoder = new TextDecoder();
@@ -259,7 +298,7 @@ class BLEClient {
     }
 
     /**
-     * Read device status
+     * Read device status: a fresh telemetry frame (decoded), or the text line of older firmware
      */
     async readStatus() {
         try {
@@ -268,6 +307,10 @@ class BLEClient {
             }
 
             const value = await this.characteristics.stat.readValue();
+            const telemetry = decodeTelemetry(value);
+            if (telemetry) {
+                return telemetry;
+            }
             const decoder = new TextDecoder();
             const statStr = decoder.decode(value);
             
@@ -280,6 +323,18 @@ class BLEClient {
         }
     }
 
+    /**
+     * Read the device's OTA session history (ota-history.js records, oldest first);
+     * null if the firmware does not keep one
+     */
+    async readOtaHistory() {
+        if (!this.isConnected || !this.characteristics.otaHistory) {
+            return null;
+        }
+        const value = await this.characteristics.otaHistory.readValue();
+        return decodeOtaHistory(value);
+    }
+
     /**
      * Get provisioning service and characteristics
      */
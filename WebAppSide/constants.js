@@ -9,6 +9,8 @@ const BLE_UUIDS = {
     DEBUG_LOG_TX_UUID: '7f3f0002-6b7c-4f2e-9b8a-1a2b3c4d5e6f',
     DEBUG_CMD_RX_UUID: '7f3f0003-6b7c-4f2e-9b8a-1a2b3c4d5e6f',
     DEBUG_STAT_UUID: '7f3f0005-6b7c-4f2e-9b8a-1a2b3c4d5e6f',
+    DEBUG_BOOT_UUID: '7f3f0006-6b7c-4f2e-9b8a-1a2b3c4d5e6f',
+    DEBUG_OTA_HIST_UUID: '7f3f0007-6b7c-4f2e-9b8a-1a2b3c4d5e6f',
     
     // Provisioning Service
     PROV_SERVICE_UUID: '8f4f0001-7c8d-5f3e-ac9b-2b3c4d5e6f70',
@@ -40,11 +42,47 @@ const OTA_CONFIG = {
     TIMEOUT_MS: 120000,           // 2 minutes
     CHUNK_RETRY_COUNT: 5,         // retry count per chunk on transient BLE errors
     WRITE_TIMEOUT_MS: 1000,       // timeout for one write operation
+    SEQ_HEADER_SIZE: 4,           // [offset:u32 LE] prefix on each OTA data packet (sequenced transfer)
+    ACK_TIMEOUT_MS: 1000,         // resend unacknowledged data if no ACK arrives within this time
+    RETRANSMIT_TIMEOUT_MS: 500,   // minimum time before the same chunk is resent
+    MAX_ACK_TIMEOUTS: 10,         // consecutive ACK timeouts before giving up
+    COMPRESSION_ENABLED: true,    // deflate the image before transfer (device inflates while writing)
+    COMPRESSION_MIN_RATIO: 0.95,  // send raw if compressed size is above this fraction of the original
+    PATCH_ENABLED: true,          // send a delta against the last image uploaded to the device
+    PATCH_MAX_RATIO: 0.5,         // send the full image if the patch is larger than this fraction of it
+    RESUME_QUERY_TIMEOUT_MS: 1000, // wait for RESUME:<offset> (older firmware does not answer)
+    SIGNATURE_MAGIC: 'OSIG',      // trailer of signed images (MiconSide/tools/sign_firmware.py)
+    WIFI_ENABLED: true,           // send the data over the device's Wi-Fi (HTTP) when the page can reach it
+    WIFI_QUERY_TIMEOUT_MS: 2000,  // wait for WIFI:<ip>:<port>:<token>:<offset> (older firmware does not answer)
+    WIFI_UPLOAD_TIMEOUT_MS: 60000, // whole HTTP upload; BLE takes over after a failure
+    // Legacy firmware (plain READY, no sequenced transfer) only:
     INTER_CHUNK_DELAY_MS: 0,      // no delay for writeWithoutResponse (max speed)
     RELIABILITY_CHECK_INTERVAL: 20, // send write-with-response every N chunks for reliability (reduced from 50 to minimize packet loss)
     END_COMMAND_DELAY_MS: 300,    // delay before sending END command to ensure all data written (increased from 120)
 };
 
+// START rejections that make the client retry with a simpler transfer mode
+const OTA_START_FALLBACK_ERRORS = [
+    'ERROR:UNSUPPORTED_CODEC',
+    'ERROR:BASE_MISMATCH',
+    'ERROR:NO_MEMORY',
+    'ERROR:RESUME_MISMATCH',
+];
+
+// First byte of a binary command frame: 0xF5 never occurs in UTF-8, so the device cannot mistake text for it
+const BLE_CMD_BINARY_V1 = 0xF5;
+
+// OtaControl commands. Binary frame: 0xF5 <opcode> { <tag> <len> <value> }*
+// (positional fields are tags 1..n, then keys in order); text form is NAME:field:key=value
+const OTA_COMMANDS = {
+    START: { opcode: 0xA0, positional: 3, keys: ['sha', 'at', 'bsize', 'bsha'] },
+    RESUME: { opcode: 0xA1, positional: 1, keys: [] },
+    SIG: { opcode: 0xA2, positional: 1, keys: [] },
+    END: { opcode: 0xA3, positional: 0, keys: [] },
+    ABORT: { opcode: 0xA4, positional: 0, keys: [] },
+    WIFI: { opcode: 0xA5, positional: 0, keys: [] },
+};
+
 // Debug commands
 const DEBUG_COMMANDS = {
     SET_LEVEL_ERROR: 'LVL:0',
@@ -52,6 +90,11 @@ const DEBUG_COMMANDS = {
     SET_LEVEL_INFO: 'LVL:2',
     SET_LEVEL_DEBUG: 'LVL:3',
     CLEAR_BUFFER: 'CLR',
+    SCHED_STATS: 'SCHED',
+    FAST_BOOT_ON: 'FAST_BOOT:1',
+    FAST_BOOT_OFF: 'FAST_BOOT:0',
+    WIFI_STATIC_ON: 'WIFI_STATIC:1',
+    WIFI_STATIC_OFF: 'WIFI_STATIC:0',
     PING: 'PING',
 };
 
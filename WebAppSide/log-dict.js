@@ -0,0 +1,187 @@
+// ============================================================================
+// Dictionary Log Decoder
+// Renders dictionary-encoded DebugLogTx notifications (format ID + packed
+// arguments) with log-dictionary.json, generated by MiconSide/tools/log_dict.py
+// ============================================================================
+
+const LOG_DICT = {
+    MARKER: 0x00,                    // First byte of a binary log notification
+    TEXT_ID: 0,                      // Record carries a plain text line
+    URL: 'log-dictionary.json',
+};
+
+class LogDictionary {
+    constructor() {
+        this.formats = new Map();
+        this.loading = null;
+    }
+
+    load() {
+        if (!this.loading) {
+            this.loading = fetch(LOG_DICT.URL)
+                .then(response => response.ok ? response.json() : { formats: {} })
+                .then(json => {
+                    for (const [id, format] of Object.entries(json.formats || {})) {
+                        this.formats.set(parseInt(id, 16), format);
+                    }
+                    console.log(`[LogDict] ${this.formats.size} formats loaded`);
+                })
+                .catch(error => console.warn('[LogDict] Dictionary unavailable:', error));
+        }
+        return this.loading;
+    }
+
+    /**
+     * True if the notification is a binary batch rather than text lines
+     */
+    isEncoded(bytes) {
+        return bytes.length > 0 && bytes[0] === LOG_DICT.MARKER;
+    }
+
+    /**
+     * Binary batch to text lines: <marker> { <len u8> <id u32> <args> }*
+     */
+    decode(bytes) {
+        const lines = [];
+        const view = new DataView(bytes.buffer, bytes.byteOffset, bytes.byteLength);
+        let offset = 1;
+        while (offset < bytes.length) {
+            const len = bytes[offset];
+            const end = Math.min(offset + 1 + len, bytes.length);
+            if (len < 4 || offset + 5 > end) {
+                break;
+            }
+            const id = view.getUint32(offset + 1, true);
+            const args = bytes.subarray(offset + 5, end);
+            lines.push(id === LOG_DICT.TEXT_ID ? new TextDecoder().decode(args) : this.render(id, args));
+            offset = end;
+        }
+        return lines;
+    }
+
+    render(id, args) {
+        const format = this.formats.get(id);
+        if (format === undefined) {
+            return `[dict:${id.toString(16).padStart(8, '0')}] ` +
+                Array.from(args, byte => byte.toString(16).padStart(2, '0')).join('');
+        }
+        return logDictFormat(format, args);
+    }
+}
+
+/**
+ * printf subset matching log_dict_format() on the device; missing arguments print '?'
+ */
+function logDictFormat(format, args) {
+    const view = new DataView(args.buffer, args.byteOffset, args.byteLength);
+    let p = 0;
+    const take = (n) => {
+        if (p + n > args.length) {
+            return null;
+        }
+        p += n;
+        return p - n;
+    };
+
+    return format.replace(/%([-+ #0]*)(\*|\d+)?(?:\.(\*|\d+))?(hh|h|ll|l|j|z|t)?([diuxXocfFeEgGps%])/g,
+        (match, flags, width, precision, length, conv) => {
+            if (conv === '%') {
+                return '%';
+            }
+            const star = (value) => {
+                if (value !== '*') {
+                    return value === undefined ? undefined : parseInt(value, 10);
+                }
+                const at = take(4);
+                return at === null ? undefined : view.getInt32(at, true);
+            };
+            let w = star(width);
+            const prec = star(precision);
+            let left = flags.includes('-');
+            if (w < 0) {
+                left = true;
+                w = -w;
+            }
+
+            let text;
+            if ('diuxXoc'.includes(conv)) {
+                const wide = length === 'll' || length === 'j';
+                const at = take(wide ? 8 : 4);
+                if (at === null) {
+                    return '?';
+                }
+                let v = wide ? view.getBigInt64(at, true) : BigInt(view.getInt32(at, true));
+                if (conv !== 'd' && conv !== 'i' && v < 0n) {
+                    v += wide ? (1n << 64n) : (1n << 32n);
+                }
+                if (conv === 'c') {
+                    text = String.fromCharCode(Number(v & 0xffn));
+                } else {
+                    const radix = conv === 'o' ? 8 : ('xX'.includes(conv) ? 16 : 10);
+                    const negative = v < 0n;
+                    text = (negative ? -v : v).toString(radix);
+                    if (conv === 'X') {
+                        text = text.toUpperCase();
+                    }
+                    if (prec !== undefined) {
+                        text = text.padStart(prec, '0');
+                    }
+                    if (flags.includes('#') && v !== 0n && radix !== 10) {
+                        text = (radix === 8 ? '0' : (conv === 'X' ? '0X' : '0x')) + text;
+                    }
+                    const sign = negative ? '-' : (flags.includes('+') ? '+' : (flags.includes(' ') ? ' ' : ''));
+                    if (flags.includes('0') && !left && prec === undefined && w !== undefined) {
+                        text = text.padStart(w - sign.length, '0');
+                    }
+                    text = sign + text;
+                }
+            } else if ('fFeEgG'.includes(conv)) {
+                const at = take(8);
+                if (at === null) {
+                    return '?';
+                }
+                const v = view.getFloat64(at, true);
+                const digits = prec === undefined ? 6 : prec;
+                if ('fF'.includes(conv)) {
+                    text = v.toFixed(digits);
+                } else if ('eE'.includes(conv)) {
+                    text = v.toExponential(digits).replace(/e([+-])(\d)$/, 'e$10$2');
+                } else {
+                    text = String(Number(v.toPrecision(digits || 1)));
+                }
+                if (conv === conv.toUpperCase()) {
+                    text = text.toUpperCase();
+                }
+                if (v >= 0 && flags.includes('+')) {
+                    text = '+' + text;
+                }
+                if (flags.includes('0') && !left && w !== undefined) {
+                    const sign = /^[+-]/.test(text) ? text[0] : '';
+                    text = sign + text.slice(sign.length).padStart(w - sign.length, '0');
+                }
+            } else if (conv === 'p') {
+                const at = take(4);
+                if (at === null) {
+                    return '?';
+                }
+                text = '0x' + view.getUint32(at, true).toString(16).padStart(8, '0');
+            } else {
+                const at = take(1);
+                if (at === null || take(args[at]) === null) {
+                    return '?';
+                }
+                text = new TextDecoder().decode(args.subarray(at + 1, at + 1 + args[at]));
+                if (prec !== undefined) {
+                    text = text.slice(0, prec);
+                }
+            }
+
+            if (w !== undefined && text.length < w) {
+                text = left ? text.padEnd(w) : text.padStart(w);
+            }
+            return text;
+        });
+}
+
+// Global instance
+const logDictionary = new LogDictionary();
@@ -14,6 +14,14 @@ class BleOtaClient {
         this.lastStatus = '';
         this.otaCompletionInProgress = false;
         this.disconnectListener = null;
+        this.ackState = null;
+        this.ackWaiter = null;
+        this.transferError = null;
+        this.retransmitCount = 0;
+        this.ackTimeoutCount = 0;
+        this.completionStatus = null;
+        this.binaryCommands = false; // Device answered a binary RESUME frame
+        this.link = null;            // Last LINK: report (negotiated connection parameters)
     }
 
     /**
@@ -22,6 +30,7 @@ class BleOtaClient {
     async connect(bleDevice) {
         try {
             this.device = bleDevice;
+            this.link = null;
             
             if (!this.device || !this.device.gatt.connected) {
                 throw new Error('BLE device not connected');
@@ -41,6 +50,17 @@ class BleOtaClient {
                 const status = new TextDecoder().decode(event.target.value);
                 this.lastStatus = status;
                 console.log('[BLE-OTA] Status update:', status);
+
+                // Sequenced transfer: ACK:<cum>:<window>[:<start>-<end>,...]
+                if (status.startsWith('ACK:')) {
+                    this.handleAck(status);
+                } else if (status.startsWith('LINK:')) {
+                    this.handleLink(status);
+                } else if (status.startsWith('ERROR:') && this.ackState) {
+                    this.transferError = status;
+                    this.wakeAckWaiter(false);
+                }
+
                 if (this.onStatusCallback) {
                     this.onStatusCallback(status);
                 }
@@ -58,152 +78,696 @@ class BleOtaClient {
     /**
      * Upload firmware via BLE OTA
      */
-    async uploadFirmware(firmwareData) {
+    async uploadFirmware(signedData) {
         try {
             if (!this.otaControlChar || !this.otaDataChar || !this.otaStatusChar) {
                 throw new Error('OTA service not connected');
             }
 
+            const { image: firmwareData, signature } = this.splitSignature(signedData);
             const firmwareSize = firmwareData.byteLength;
             console.log(`[BLE-OTA] Starting firmware upload: ${firmwareSize} bytes`);
-
-            // Step 1: Send START command
-            const startCommand = `START:${firmwareSize}`;
-            console.log('[BLE-OTA] Sending START command:', startCommand);
-            await this.otaControlChar.writeValue(new TextEncoder().encode(startCommand));
-
-            // Wait for READY status
-            await this.waitForStatus('READY', 5000);
-            console.log('[BLE-OTA] Device ready to receive firmware');
-
-            // Step 2: Send firmware data in chunks
-            const CHUNK_SIZE = OTA_CONFIG.CHUNK_SIZE;
-            const CHUNK_RETRY_COUNT = OTA_CONFIG.CHUNK_RETRY_COUNT;
-            const WRITE_TIMEOUT_MS = OTA_CONFIG.WRITE_TIMEOUT_MS;
-            const INTER_CHUNK_DELAY_MS = OTA_CONFIG.INTER_CHUNK_DELAY_MS;
-            const RELIABILITY_CHECK_INTERVAL = OTA_CONFIG.RELIABILITY_CHECK_INTERVAL;
-            const totalChunks = Math.ceil(firmwareSize / CHUNK_SIZE);
-            let sentBytes = 0;
-            let lastProgressNotified = -1;
-
+            otaMetrics.begin(firmwareSize);
+            otaMetrics.set({ link: this.link }); // BULK parameters replace it once negotiated
+            this.retransmitCount = 0;
+            this.ackTimeoutCount = 0;
+            this.completionStatus = null;
+
+            // Step 1: Send START command. Preference: resume an interrupted upload of this image,
+            // then delta patch, then compressed, then raw (as supported by the device)
+            const imageSha = await otaSha256Hex(firmwareData);
+            const resumeOffset = await this.queryResume(imageSha);
+            let session = null;
+            if (resumeOffset > 0) {
+                console.log(`[BLE-OTA] Resuming interrupted upload at ${resumeOffset}/${firmwareSize} bytes`);
+                session = await this.tryStartSession(firmwareSize, firmwareData.slice(resumeOffset),
+                    { sha: imageSha, at: resumeOffset });
+            }
+            const resumedAt = session ? resumeOffset : 0;
+            const patch = session ? null : await this.buildPatch(firmwareData);
+            if (!session && patch) {
+                session = await this.tryStartSession(firmwareSize, patch.data,
+                    { sha: imageSha, bsize: patch.baseSize, bsha: patch.baseSha });
+            }
+            if (!session) {
+                session = await this.tryStartSession(firmwareSize, firmwareData, { sha: imageSha });
+            }
+            if (!session) {
+                session = {
+                    payload: firmwareData,
+                    readyStatus: await this.startSession(firmwareSize, firmwareSize, 'none', { sha: imageSha })
+                };
+            }
+            const { payload, readyStatus } = session;
+
+            const transferSize = payload.byteLength;
+            const readyFields = readyStatus.split(':');
+            otaMetrics.mark('ready');
+            otaMetrics.set({
+                transferSize,
+                codec: readyFields[3] || 'none',
+                patch: readyFields[4] === 'patch',
+                resumeOffset: resumedAt,
+            });
             if (this.onProgressCallback) {
-                this.onProgressCallback(0, firmwareSize, 0);
+                this.onProgressCallback(0, transferSize, 0);
             }
 
-            console.log(`[BLE-OTA] Sending firmware in ${totalChunks} chunks (${CHUNK_SIZE} bytes each)...`);
-
-            for (let i = 0; i < totalChunks; i++) {
-                const start = i * CHUNK_SIZE;
-                const end = Math.min(start + CHUNK_SIZE, firmwareSize);
-                const chunk = firmwareData.slice(start, end);
-
-                // Use write-with-response periodically for reliability check, and always for the last chunk
-                const isLastChunk = (i === totalChunks - 1);
-                const useReliabilityCheck = (i % RELIABILITY_CHECK_INTERVAL === 0) || isLastChunk;
-
-                try {
-                    let chunkSent = false;
-                    let lastChunkError = null;
-
-                    for (let retry = 0; retry < CHUNK_RETRY_COUNT; retry++) {
-                        try {
-                            if (useReliabilityCheck) {
-                                // Periodic reliability check with write-with-response
-                                const writeWithResponse = this.otaDataChar.writeValue(chunk);
-                                const timeoutPromise = new Promise((_, reject) => {
-                                    setTimeout(() => reject(new Error('write timeout')), WRITE_TIMEOUT_MS);
-                                });
-                                await Promise.race([writeWithResponse, timeoutPromise]);
-                            } else {
-                                // Fast path: writeWithoutResponse
-                                if (this.otaDataChar.writeValueWithoutResponse) {
-                                    await this.otaDataChar.writeValueWithoutResponse(chunk);
-                                } else {
-                                    await this.otaDataChar.writeValue(chunk);
-                                }
-                            }
-                            chunkSent = true;
-                            break;
-                        } catch (retryError) {
-                            lastChunkError = retryError;
-                            
-                            // On error, try write-with-response as fallback
-                            if (retry >= 2) {
-                                try {
-                                    const writeWithResponse = this.otaDataChar.writeValue(chunk);
-                                    const timeoutPromise = new Promise((_, reject) => {
-                                        setTimeout(() => reject(new Error('write timeout')), WRITE_TIMEOUT_MS);
-                                    });
-                                    await Promise.race([writeWithResponse, timeoutPromise]);
-                                    chunkSent = true;
-                                    break;
-                                } catch (fallbackError) {
-                                    lastChunkError = fallbackError;
-                                }
-                            }
-
-                            await new Promise(resolve => setTimeout(resolve, 15));
-                        }
-                    }
-
-                    if (!chunkSent) {
-                        throw new Error(lastChunkError ? lastChunkError.message : 'Unknown chunk write error');
-                    }
-
-                    sentBytes += chunk.byteLength;
-
-                    const progress = Math.round((sentBytes / firmwareSize) * 100);
-                    if (progress >= lastProgressNotified + 10 || i === totalChunks - 1) {
-                        lastProgressNotified = progress;
-                        console.log(`[BLE-OTA] Progress: ${sentBytes}/${firmwareSize} bytes (${progress}%) - Chunk ${i+1}/${totalChunks}`);
-                    }
-
-                    if (this.onProgressCallback && (i % 10 === 0 || i === totalChunks - 1)) {
-                        this.onProgressCallback(sentBytes, firmwareSize, progress);
-                    }
-
-                    if (INTER_CHUNK_DELAY_MS > 0) {
-                        await new Promise(resolve => setTimeout(resolve, INTER_CHUNK_DELAY_MS));
-                    }
-
-                } catch (error) {
-                    console.error(`[BLE-OTA] Error sending chunk ${i+1}/${totalChunks}:`, error);
-                    throw new Error(`Failed to send chunk ${i+1}: ${error.message}`);
+            // Step 2: Send firmware data (over Wi-Fi if the device offers it, BLE for whatever is left)
+            if (readyStatus.startsWith('READY:SEQ:')) {
+                const windowBytes = parseInt(readyStatus.split(':')[2], 10);
+                if (await this.sendOverWifi(payload)) {
+                    otaMetrics.set({ transport: 'wifi' });
+                } else {
+                    otaMetrics.set({ transport: 'ble' });
+                    await this.sendSequenced(payload, windowBytes);
                 }
+                otaMetrics.mark('transferred');
+                console.log('[BLE-OTA] All data acknowledged, sending END command...');
+            } else {
+                otaMetrics.set({ transport: 'ble-legacy' });
+                await this.sendLegacy(payload);
+                otaMetrics.mark('transferred');
+                console.log('[BLE-OTA] All data sent, sending END command...');
+
+                // Give the device time to process the final chunk(s) before END (increased delay for reliability)
+                await new Promise(resolve => setTimeout(resolve, OTA_CONFIG.END_COMMAND_DELAY_MS));
             }
 
-            console.log('[BLE-OTA] All data sent, sending END command...');
-
-            // Give the device time to process the final chunk(s) before END (increased delay for reliability)
-            await new Promise(resolve => setTimeout(resolve, OTA_CONFIG.END_COMMAND_DELAY_MS));
+            // Signed image: the device checks the signature against the streamed SHA-256 at END
+            if (signature) {
+                await this.sendControl('SIG', [signature]);
+            }
 
             // Step 3: Send END command
             this.otaCompletionInProgress = true;
-            await this.otaControlChar.writeValue(new TextEncoder().encode('END'));
+            await this.sendControl('END');
 
             // Wait for SUCCESS status or expected reboot disconnect
             await this.waitForCompletion(10000);
             console.log('[BLE-OTA] Firmware upload successful!');
+            otaMetrics.mark('success');
+            otaMetrics.set({
+                retransmits: this.retransmitCount,
+                ackTimeouts: this.ackTimeoutCount,
+                flash: this.completionStatus,
+            });
+            const report = otaMetrics.finish(null);
+
+            // The device now runs this image: use it as the base for the next delta
+            if (OTA_CONFIG.PATCH_ENABLED) {
+                await otaBaseCache.save(this.getDeviceKey(), firmwareData);
+            }
 
             return {
                 success: true,
-                message: 'Firmware uploaded successfully. Device will reboot.'
+                message: 'Firmware uploaded successfully. Device will reboot.',
+                report
             };
 
         } catch (error) {
             console.error('[BLE-OTA] Upload error:', error);
+            otaMetrics.set({ retransmits: this.retransmitCount, ackTimeouts: this.ackTimeoutCount });
+            otaMetrics.finish(error);
             
             // Try to abort OTA on error
             try {
                 if (this.otaControlChar) {
-                    await this.otaControlChar.writeValue(new TextEncoder().encode('ABORT'));
+                    await this.sendControl('ABORT');
                 }
             } catch (abortError) {
                 console.error('[BLE-OTA] Abort error:', abortError);
             }
 
             throw error;
+        } finally {
+            this.ackState = null;
+            this.ackWaiter = null;
+            this.transferError = null;
+        }
+    }
+
+    /**
+     * Send START and wait for READY.
+     * Format: START:<size>:<transfer_size>:<codec>[:<key>=<value>...]
+     *   sha=<image sha256>  session id for RESUME
+     *   at=<offset>         resume: the transfer is the image from offset
+     *   bsize=<n>, bsha=<sha256>  the transfer is a delta patch against this base
+     * Replies READY:SEQ:<window>:<codec>[:patch] (READY / READY:SEQ:<window> on older firmware)
+     */
+    async startSession(firmwareSize, transferSize, codec, options) {
+        const fields = {};
+        for (const [key, value] of Object.entries(options)) {
+            fields[key] = (key === 'sha' || key === 'bsha') ? otaHexToBytes(value) : value;
+        }
+        console.log('[BLE-OTA] Sending START command:', firmwareSize, transferSize, codec, options);
+        await this.sendControl('START', [firmwareSize, transferSize, codec], fields);
+
+        const readyStatus = await this.waitForStatus('READY', 5000);
+        console.log('[BLE-OTA] Device ready to receive firmware:', readyStatus);
+        return readyStatus;
+    }
+
+    /**
+     * Start a compressed, delta and/or resumed session for image (the firmware, a patch or the remainder).
+     * Returns null if there is nothing to negotiate or the device does not support it.
+     */
+    async tryStartSession(firmwareSize, image, options) {
+        const patch = options.bsize !== undefined;
+        const compressed = await this.compressFirmware(image);
+        if (!compressed && !patch && !options.at) {
+            return null;
+        }
+
+        const payload = compressed || image;
+        const codec = compressed ? 'deflate' : 'none';
+        let readyStatus;
+        try {
+            readyStatus = await this.startSession(firmwareSize, payload.byteLength, codec, options);
+        } catch (error) {
+            if (error.message === 'ERROR:BASE_MISMATCH') {
+                // Device was updated from elsewhere: the cached base is stale
+                await otaBaseCache.remove(this.getDeviceKey());
+            }
+            if (OTA_START_FALLBACK_ERRORS.includes(error.message)) {
+                console.warn(`[BLE-OTA] ${error.message}, falling back`);
+                return null;
+            }
+            throw error;
+        }
+
+        const fields = readyStatus.split(':');
+        if (fields[3] === codec && (!patch || fields[4] === 'patch')) {
+            return { payload, readyStatus };
+        }
+
+        // Older firmware ignores the extra START fields: abort and fall back
+        console.warn('[BLE-OTA] Device does not support', patch ? 'delta OTA' : (compressed ? 'compressed OTA' : 'resume'));
+        await this.sendControl('ABORT');
+        await this.waitForStatus('ABORTED', 5000);
+        return null;
+    }
+
+    /**
+     * Signed images end with [DER signature][length: u16 LE]["OSIG"]
+     * (MiconSide/tools/sign_firmware.py). Returns the image without the trailer.
+     */
+    splitSignature(firmwareData) {
+        const bytes = new Uint8Array(firmwareData);
+        const magic = OTA_CONFIG.SIGNATURE_MAGIC;
+        const trailerSize = magic.length + 2;
+
+        if (bytes.length > trailerSize &&
+            new TextDecoder().decode(bytes.subarray(bytes.length - magic.length)) === magic) {
+            const signatureSize = bytes[bytes.length - trailerSize] | (bytes[bytes.length - trailerSize + 1] << 8);
+            const imageSize = bytes.length - trailerSize - signatureSize;
+            if (signatureSize > 0 && imageSize > 0) {
+                console.log(`[BLE-OTA] Signed image: ${imageSize} bytes + ${signatureSize} byte signature`);
+                return {
+                    image: firmwareData.slice(0, imageSize),
+                    signature: bytes.slice(imageSize, imageSize + signatureSize)
+                };
+            }
+        }
+
+        return { image: firmwareData, signature: null };
+    }
+
+    /**
+     * Ask the device how much of this image is already in flash from an interrupted upload.
+     * RESUME:<sha256> -> RESUME:<offset>. Older firmware does not answer (= 0).
+     */
+    async queryResume(imageSha) {
+        // Sent as a binary frame: an answer also means the device takes binary commands
+        this.binaryCommands = true;
+        try {
+            await this.sendControl('RESUME', [otaHexToBytes(imageSha)]);
+            const status = await this.waitForStatus('RESUME', OTA_CONFIG.RESUME_QUERY_TIMEOUT_MS);
+            return parseInt(status.split(':')[1], 10) || 0;
+        } catch (error) {
+            console.log('[BLE-OTA] No resumable session, using text commands:', error.message);
+            this.binaryCommands = false;
+            return 0;
+        }
+    }
+
+    /**
+     * Write an OtaControl command (OTA_COMMANDS): a binary frame if the device takes them, text otherwise.
+     * Numbers are u32 LE / decimal, Uint8Array raw bytes / hex, strings UTF-8 as is.
+     */
+    async sendControl(name, positional = [], options = {}) {
+        const command = OTA_COMMANDS[name];
+        const fields = positional.map((value, i) => [i + 1, value]);
+        for (const [key, value] of Object.entries(options)) {
+            fields.push([command.positional + 1 + command.keys.indexOf(key), value]);
+        }
+
+        if (!this.binaryCommands) {
+            const toText = value => value instanceof Uint8Array
+                ? Array.from(value, byte => byte.toString(16).padStart(2, '0')).join('')
+                : String(value);
+            const parts = [name, ...fields.map(([tag, value]) => tag > command.positional
+                ? `${command.keys[tag - command.positional - 1]}=${toText(value)}`
+                : toText(value))];
+            await this.otaControlChar.writeValue(new TextEncoder().encode(parts.join(':')));
+            return;
+        }
+
+        const encoded = fields.map(([tag, value]) => {
+            let bytes;
+            if (value instanceof Uint8Array) {
+                bytes = value;
+            } else if (typeof value === 'number') {
+                bytes = new Uint8Array(4);
+                new DataView(bytes.buffer).setUint32(0, value, true);
+            } else {
+                bytes = new TextEncoder().encode(value);
+            }
+            return [tag, bytes];
+        });
+        const frame = new Uint8Array(2 + encoded.reduce((size, [, bytes]) => size + 2 + bytes.length, 0));
+        frame[0] = BLE_CMD_BINARY_V1;
+        frame[1] = command.opcode;
+        let offset = 2;
+        for (const [tag, bytes] of encoded) {
+            frame[offset] = tag;
+            frame[offset + 1] = bytes.length;
+            frame.set(bytes, offset + 2);
+            offset += 2 + bytes.length;
+        }
+        await this.otaControlChar.writeValue(frame);
+    }
+
+    /**
+     * Build a delta patch against the image last uploaded to this device.
+     * Returns null if there is no cached base or the patch is not worth it.
+     */
+    async buildPatch(firmwareData) {
+        if (!OTA_CONFIG.PATCH_ENABLED) {
+            return null;
+        }
+
+        const base = await otaBaseCache.load(this.getDeviceKey());
+        if (!base) {
+            return null;
+        }
+
+        const data = generateOtaPatch(base, firmwareData);
+        console.log(`[BLE-OTA] Delta patch: ${data.byteLength} bytes (base ${base.byteLength}, image ${firmwareData.byteLength})`);
+        if (data.byteLength > firmwareData.byteLength * OTA_CONFIG.PATCH_MAX_RATIO) {
+            return null;
+        }
+
+        return { data, baseSize: base.byteLength, baseSha: await otaSha256Hex(base) };
+    }
+
+    /**
+     * Key for per-device state (cached base image)
+     */
+    getDeviceKey() {
+        return this.device ? (this.device.id || this.device.name) : 'unknown';
+    }
+
+    /**
+     * zlib-compress the image (CompressionStream 'deflate' = RFC 1950).
+     * Returns null if compression is unavailable or does not help.
+     */
+    async compressFirmware(firmwareData) {
+        if (!OTA_CONFIG.COMPRESSION_ENABLED || typeof CompressionStream === 'undefined') {
+            return null;
+        }
+
+        try {
+            const stream = new Blob([firmwareData]).stream().pipeThrough(new CompressionStream('deflate'));
+            const compressed = await new Response(stream).arrayBuffer();
+
+            const ratio = compressed.byteLength / firmwareData.byteLength;
+            console.log(`[BLE-OTA] Compressed ${firmwareData.byteLength} -> ${compressed.byteLength} bytes (${Math.round(ratio * 100)}%)`);
+            return ratio <= OTA_CONFIG.COMPRESSION_MIN_RATIO ? compressed : null;
+        } catch (error) {
+            console.warn('[BLE-OTA] Compression failed, sending raw image:', error);
+            return null;
+        }
+    }
+
+    /**
+     * Wi-Fi transport: WIFI -> WIFI:<ip>:<port>:<token>:<offset>, then POST the transfer from offset
+     * to http://<ip>:<port>/ota. Returns false (BLE then sends the rest) if the device has no Wi-Fi,
+     * does not support it, or the upload fails.
+     * An https page cannot fetch http://<device> (mixed content), so this only runs on http pages
+     * (e.g. served from localhost).
+     */
+    async sendOverWifi(payload) {
+        if (!OTA_CONFIG.WIFI_ENABLED || location.protocol !== 'http:') {
+            return false;
+        }
+
+        let status;
+        try {
+            await this.sendControl('WIFI');
+            status = await this.waitForStatus('WIFI', OTA_CONFIG.WIFI_QUERY_TIMEOUT_MS);
+        } catch (error) {
+            console.log('[BLE-OTA] Wi-Fi transport unavailable, using BLE:', error.message);
+            return false;
+        }
+
+        const [, ip, port, token, offsetField] = status.split(':');
+        const offset = parseInt(offsetField, 10) || 0;
+        const body = payload.slice(offset);
+        const total = payload.byteLength;
+        console.log(`[BLE-OTA] Wi-Fi upload to ${ip}:${port}: ${body.byteLength} bytes from offset ${offset}`);
+        const startedAt = Date.now();
+
+        try {
+            await new Promise((resolve, reject) => {
+                const xhr = new XMLHttpRequest();
+                xhr.open('POST', `http://${ip}:${port}/ota`);
+                xhr.setRequestHeader('Content-Type', 'application/octet-stream');
+                xhr.setRequestHeader('X-OTA-Token', token);
+                xhr.timeout = OTA_CONFIG.WIFI_UPLOAD_TIMEOUT_MS;
+                xhr.upload.onprogress = (event) => {
+                    if (this.onProgressCallback) {
+                        const sent = offset + event.loaded;
+                        this.onProgressCallback(sent, total, Math.round((sent / total) * 100));
+                    }
+                };
+                xhr.onload = () => xhr.status === 200
+                    ? resolve()
+                    : reject(new Error(`HTTP ${xhr.status} ${xhr.responseText}`));
+                xhr.onerror = () => reject(new Error('network error'));
+                xhr.ontimeout = () => reject(new Error('timeout'));
+                xhr.send(body);
+            });
+        } catch (error) {
+            console.warn('[BLE-OTA] Wi-Fi upload failed, continuing over BLE:', error.message);
+            return false;
+        }
+
+        const seconds = (Date.now() - startedAt) / 1000;
+        console.log(`[BLE-OTA] Wi-Fi upload done in ${seconds.toFixed(1)} s (${Math.round(body.byteLength / 1024 / seconds)} KB/s)`);
+        if (this.onProgressCallback) {
+            this.onProgressCallback(total, total, 100);
+        }
+        return true;
+    }
+
+    /**
+     * LINK:<interval us>:<latency>:<timeout ms>:<LL octets>:<phy>:<mtu>
+     * Sent by the device whenever the negotiated connection parameters change
+     */
+    handleLink(status) {
+        const [intervalUs, latency, timeoutMs, llOctets, phy, mtu] = status.split(':').slice(1).map(v => parseInt(v, 10));
+        this.link = { intervalUs, latency, timeoutMs, llOctets, phy, mtu };
+        otaMetrics.set({ link: this.link });
+        console.log(`[BLE-OTA] Link: interval ${(intervalUs / 1000).toFixed(2)}ms, latency ${latency}, ` +
+            `LL ${llOctets}B, ${phy === 2 ? '2M' : phy === 3 ? 'Coded' : '1M'} PHY, MTU ${mtu}`);
+    }
+
+    /**
+     * Data packet size: CHUNK_SIZE, or less if the negotiated ATT MTU cannot carry it in one write
+     */
+    chunkSize() {
+        const mtu = this.link && this.link.mtu;
+        return mtu > OTA_CONFIG.SEQ_HEADER_SIZE + 3 ? Math.min(OTA_CONFIG.CHUNK_SIZE, mtu - 3) : OTA_CONFIG.CHUNK_SIZE;
+    }
+
+    /**
+     * Send firmware as offset-tagged packets inside the device's receive window.
+     * Only the gaps reported by the device (or unacknowledged data after a timeout) are resent.
+     */
+    async sendSequenced(firmwareData, initialWindow) {
+        const firmwareSize = firmwareData.byteLength;
+        const payloadSize = this.chunkSize() - OTA_CONFIG.SEQ_HEADER_SIZE;
+        const lastSentAt = new Map(); // chunk offset -> time of last send
+        const retransmitQueue = [];
+        let nextOffset = 0;
+        let lastAckSeq = 0;
+        let ackTimeouts = 0;
+        let lastProgressNotified = -1;
+
+        this.ackState = { cum: 0, window: initialWindow, sack: [], seq: 0 };
+        this.transferError = null;
+        this.retransmitCount = 0;
+        this.ackTimeoutCount = 0;
+
+        console.log(`[BLE-OTA] Sequenced transfer: ${payloadSize} bytes/packet, window ${initialWindow} bytes`);
+
+        // Queue chunks below `limit` that are neither acknowledged nor held out of order
+        const queueGaps = (limit) => {
+            const { cum, sack } = this.ackState;
+            const now = Date.now();
+            for (let offset = Math.floor(cum / payloadSize) * payloadSize; offset < limit; offset += payloadSize) {
+                const end = Math.min(offset + payloadSize, firmwareSize);
+                if (end <= cum || sack.some(([start, stop]) => offset >= start && end <= stop)) {
+                    continue;
+                }
+                const sentAt = lastSentAt.get(offset);
+                if (sentAt !== undefined && now - sentAt < OTA_CONFIG.RETRANSMIT_TIMEOUT_MS) {
+                    continue;
+                }
+                if (!retransmitQueue.includes(offset)) {
+                    retransmitQueue.push(offset);
+                }
+            }
+        };
+
+        while (this.ackState.cum < firmwareSize) {
+            if (this.transferError) {
+                throw new Error(this.transferError);
+            }
+
+            // New ACK with SACK blocks: everything below the highest block that is missing was lost
+            if (this.ackState.seq !== lastAckSeq) {
+                lastAckSeq = this.ackState.seq;
+                ackTimeouts = 0;
+                const { sack } = this.ackState;
+                if (sack.length > 0) {
+                    queueGaps(sack[sack.length - 1][1]);
+                }
+
+                const progress = Math.round((this.ackState.cum / firmwareSize) * 100);
+                if (progress !== lastProgressNotified) {
+                    lastProgressNotified = progress;
+                    if (this.onProgressCallback) {
+                        this.onProgressCallback(this.ackState.cum, firmwareSize, progress);
+                    }
+                }
+            }
+
+            const { cum, window } = this.ackState;
+            let offset = null;
+
+            // Gaps first, then new data while it fits in the advertised window
+            while (retransmitQueue.length > 0 && offset === null) {
+                const candidate = retransmitQueue.shift();
+                if (candidate + payloadSize > cum) {
+                    offset = candidate;
+                    this.retransmitCount++;
+                }
+            }
+            if (offset === null && nextOffset < firmwareSize &&
+                Math.min(nextOffset + payloadSize, firmwareSize) <= cum + window) {
+                offset = nextOffset;
+                nextOffset = Math.min(nextOffset + payloadSize, firmwareSize);
+            }
+
+            if (offset !== null) {
+                await this.writeSequencedChunk(firmwareData, offset, payloadSize);
+                lastSentAt.set(offset, Date.now());
+                continue;
+            }
+
+            // Window full or everything in flight: wait for the device
+            const acked = await this.waitForAck(OTA_CONFIG.ACK_TIMEOUT_MS);
+            if (!acked && !this.transferError) {
+                ackTimeouts++;
+                this.ackTimeoutCount++;
+                if (ackTimeouts > OTA_CONFIG.MAX_ACK_TIMEOUTS) {
+                    throw new Error(`No ACK from device (acknowledged ${this.ackState.cum}/${firmwareSize} bytes)`);
+                }
+                console.warn(`[BLE-OTA] ACK timeout at ${this.ackState.cum}/${firmwareSize}, resending unacknowledged data`);
+                queueGaps(nextOffset);
+            }
+        }
+
+        if (this.onProgressCallback) {
+            this.onProgressCallback(firmwareSize, firmwareSize, 100);
+        }
+        console.log(`[BLE-OTA] Transfer complete (${this.retransmitCount} chunks retransmitted)`);
+    }
+
+    /**
+     * Write one [offset:u32 LE][payload] packet (write-without-response, retried on transient errors)
+     */
+    async writeSequencedChunk(firmwareData, offset, payloadSize) {
+        const end = Math.min(offset + payloadSize, firmwareData.byteLength);
+        const packet = new Uint8Array(OTA_CONFIG.SEQ_HEADER_SIZE + (end - offset));
+        new DataView(packet.buffer).setUint32(0, offset, true);
+        packet.set(new Uint8Array(firmwareData, offset, end - offset), OTA_CONFIG.SEQ_HEADER_SIZE);
+
+        let lastError = null;
+        for (let retry = 0; retry < OTA_CONFIG.CHUNK_RETRY_COUNT; retry++) {
+            try {
+                if (this.otaDataChar.writeValueWithoutResponse) {
+                    await this.otaDataChar.writeValueWithoutResponse(packet);
+                } else {
+                    await this.otaDataChar.writeValue(packet);
+                }
+                return;
+            } catch (error) {
+                lastError = error;
+                await new Promise(resolve => setTimeout(resolve, 15));
+            }
         }
+        throw new Error(`Failed to send packet at offset ${offset}: ${lastError ? lastError.message : 'Unknown error'}`);
+    }
+
+    /**
+     * Parse ACK:<cum>:<window>[:<start>-<end>,...] from the device
+     */
+    handleAck(status) {
+        if (!this.ackState) {
+            return;
+        }
+
+        const parts = status.split(':');
+        const cum = parseInt(parts[1], 10);
+        const window = parseInt(parts[2], 10);
+        if (isNaN(cum) || isNaN(window)) {
+            return;
+        }
+
+        const sack = [];
+        if (parts[3]) {
+            for (const block of parts[3].split(',')) {
+                const [start, end] = block.split('-').map(v => parseInt(v, 10));
+                if (!isNaN(start) && !isNaN(end)) {
+                    sack.push([start, end]);
+                }
+            }
+        }
+
+        this.ackState = { cum, window, sack, seq: this.ackState.seq + 1 };
+        this.wakeAckWaiter(true);
+    }
+
+    /**
+     * Resolve with true on the next ACK, false on timeout or transfer error
+     */
+    waitForAck(timeoutMs) {
+        return new Promise((resolve) => {
+            const timeout = setTimeout(() => this.wakeAckWaiter(false), timeoutMs);
+            this.ackWaiter = (acked) => {
+                clearTimeout(timeout);
+                resolve(acked);
+            };
+        });
+    }
+
+    wakeAckWaiter(acked) {
+        const waiter = this.ackWaiter;
+        this.ackWaiter = null;
+        if (waiter) {
+            waiter(acked);
+        }
+    }
+
+    /**
+     * Send firmware as raw chunks (firmware without sequenced transfer support)
+     */
+    async sendLegacy(firmwareData) {
+        const firmwareSize = firmwareData.byteLength;
+        const CHUNK_SIZE = OTA_CONFIG.CHUNK_SIZE;
+        const CHUNK_RETRY_COUNT = OTA_CONFIG.CHUNK_RETRY_COUNT;
+        const WRITE_TIMEOUT_MS = OTA_CONFIG.WRITE_TIMEOUT_MS;
+        const INTER_CHUNK_DELAY_MS = OTA_CONFIG.INTER_CHUNK_DELAY_MS;
+        const RELIABILITY_CHECK_INTERVAL = OTA_CONFIG.RELIABILITY_CHECK_INTERVAL;
+        const totalChunks = Math.ceil(firmwareSize / CHUNK_SIZE);
+        let sentBytes = 0;
+        let lastProgressNotified = -1;
+
+        console.log(`[BLE-OTA] Sending firmware in ${totalChunks} chunks (${CHUNK_SIZE} bytes each)...`);
+
+        for (let i = 0; i < totalChunks; i++) {
+            const start = i * CHUNK_SIZE;
+            const end = Math.min(start + CHUNK_SIZE, firmwareSize);
+            const chunk = firmwareData.slice(start, end);
+
+            // Use write-with-response periodically for reliability check, and always for the last chunk
+            const isLastChunk = (i === totalChunks - 1);
+            const useReliabilityCheck = (i % RELIABILITY_CHECK_INTERVAL === 0) || isLastChunk;
+
+            try {
+                let chunkSent = false;
+                let lastChunkError = null;
+
+                for (let retry = 0; retry < CHUNK_RETRY_COUNT; retry++) {
+                    try {
+                        if (useReliabilityCheck) {
+                            // Periodic reliability check with write-with-response
+                            const writeWithResponse = this.otaDataChar.writeValue(chunk);
+                            const timeoutPromise = new Promise((_, reject) => {
+                                setTimeout(() => reject(new Error('write timeout')), WRITE_TIMEOUT_MS);
+                            });
+                            await Promise.race([writeWithResponse, timeoutPromise]);
+                        } else {
+                            // Fast path: writeWithoutResponse
+                            if (this.otaDataChar.writeValueWithoutResponse) {
+                                await this.otaDataChar.writeValueWithoutResponse(chunk);
+                            } else {
+                                await this.otaDataChar.writeValue(chunk);
+                            }
+                        }
+                        chunkSent = true;
+                        break;
+                    } catch (retryError) {
+                        lastChunkError = retryError;
+                        
+                        // On error, try write-with-response as fallback
+                        if (retry >= 2) {
+                            try {
+                                const writeWithResponse = this.otaDataChar.writeValue(chunk);
+                                const timeoutPromise = new Promise((_, reject) => {
+                                    setTimeout(() => reject(new Error('write timeout')), WRITE_TIMEOUT_MS);
+                                });
+                                await Promise.race([writeWithResponse, timeoutPromise]);
+                                chunkSent = true;
+                                break;
+                            } catch (fallbackError) {
+                                lastChunkError = fallbackError;
+                            }
+                        }
+
+                        await new Promise(resolve => setTimeout(resolve, 15));
+                    }
+                }
+
+                if (!chunkSent) {
+                    throw new Error(lastChunkError ? lastChunkError.message : 'Unknown chunk write error');
+                }
+
+                sentBytes += chunk.byteLength;
+
+                const progress = Math.round((sentBytes / firmwareSize) * 100);
+                if (progress >= lastProgressNotified + 10 || i === totalChunks - 1) {
+                    lastProgressNotified = progress;
+                    console.log(`[BLE-OTA] Progress: ${sentBytes}/${firmwareSize} bytes (${progress}%) - Chunk ${i+1}/${totalChunks}`);
+                }
+
+                if (this.onProgressCallback && (i % 10 === 0 || i === totalChunks - 1)) {
+                    this.onProgressCallback(sentBytes, firmwareSize, progress);
+                }
+
+                if (INTER_CHUNK_DELAY_MS > 0) {
+                    await new Promise(resolve => setTimeout(resolve, INTER_CHUNK_DELAY_MS));
+                }
+
+            } catch (error) {
+                console.error(`[BLE-OTA] Error sending chunk ${i+1}/${totalChunks}:`, error);
+                throw new Error(`Failed to send chunk ${i+1}: ${error.message}`);
+            }
+        }
+
     }
 
     /**
@@ -217,10 +781,10 @@ class BleOtaClient {
             }, timeoutMs);
 
             const statusHandler = (status) => {
-                if (status === expectedStatus) {
+                if (status === expectedStatus || status.startsWith(`${expectedStatus}:`)) {
                     clearTimeout(timeout);
                     this.onStatusCallback = null;
-                    resolve();
+                    resolve(status);
                 } else if (status.startsWith('ERROR:')) {
                     clearTimeout(timeout);
                     this.onStatusCallback = null;
@@ -266,7 +830,12 @@ class BleOtaClient {
             }
 
             this.onStatusCallback = (status) => {
-                if (status === 'SUCCESS') {
+                // SUCCESS or SUCCESS:SKIP=<n>,WRITE=<m> (sectors left unchanged / rewritten)
+                if (status === 'SUCCESS' || status.startsWith('SUCCESS:')) {
+                    if (status !== 'SUCCESS') {
+                        this.completionStatus = status.substring(8);
+                        console.log(`[BLE-OTA] Flash sectors: ${this.completionStatus.replace(',', ', ')}`);
+                    }
                     clearTimeout(timeout);
                     cleanup();
                     resolve();
@@ -302,6 +871,9 @@ class BleOtaClient {
         this.lastStatus = '';
         this.otaCompletionInProgress = false;
         this.disconnectListener = null;
+        this.ackState = null;
+        this.ackWaiter = null;
+        this.transferError = null;
     }
 }
 
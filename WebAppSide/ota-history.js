@@ -0,0 +1,95 @@
+// ============================================================================
+// OTA Session History Module
+// Decodes the per-session OTA records the device keeps in NVS and serves on
+// DebugOtaHist (MiconSide/src/ota_history.h): phase times, sizes, outcome
+// ============================================================================
+
+const OTA_HISTORY = {
+    VERSION: 1,
+    HEADER_SIZE: 8,
+    RECORD_SIZE: 44,          // Version 1 record; newer firmware may append fields
+    NOT_REACHED: 0xFFFFFFFF,  // Phase the session never got to
+    PHASES: ['ready', 'firstByte', 'lastByte', 'end', 'done'],
+    // Indexed by the result byte (ota_history_result_t)
+    RESULTS: ['RUNNING', 'SUCCESS', 'ABORTED', 'SUSPENDED', 'INTERRUPTED', 'FAILED',
+        'BEGIN_FAILED', 'OVERFLOW', 'BUFFER_FULL', 'WRITE_FAILED', 'DECOMPRESS_FAILED',
+        'PATCH_FAILED', 'HASH_MISMATCH', 'SIGNATURE_INVALID', 'END_FAILED',
+        'BAD_MAGIC', 'WRONG_CHIP', 'FLASH_SIZE', 'TOO_LARGE', 'BAD_SEGMENT'],
+    FLAG_DEFLATE: 0x01,
+    FLAG_PATCH: 0x02,
+    FLAG_RESUMED: 0x04,
+    FLAG_WIFI: 0x08,
+};
+
+// Debug command handled by the page itself: re-read and print the device's OTA history
+const OTA_HISTORY_COMMAND = 'OTA_HISTORY';
+
+/**
+ * DebugOtaHist value -> records (oldest first), or null if the layout is unknown
+ */
+function decodeOtaHistory(value) {
+    if (value.byteLength < OTA_HISTORY.HEADER_SIZE || value.getUint8(0) !== OTA_HISTORY.VERSION) {
+        return null;
+    }
+    const count = value.getUint8(1);
+    const recordSize = value.getUint16(2, true);
+    if (recordSize < OTA_HISTORY.RECORD_SIZE ||
+        value.byteLength < OTA_HISTORY.HEADER_SIZE + count * recordSize) {
+        console.warn(`[OTA-History] Unexpected layout: ${count} x ${recordSize} bytes in ${value.byteLength}`);
+        return null;
+    }
+
+    const records = [];
+    for (let i = 0; i < count; i++) {
+        let offset = OTA_HISTORY.HEADER_SIZE + i * recordSize;
+        const u32 = () => { const v = value.getUint32(offset, true); offset += 4; return v; };
+
+        const r = {};
+        r.seq = u32();
+        r.imageSize = u32();
+        r.transferSize = u32();
+        r.offset = u32();
+        r.received = u32();
+        r.phases = {};
+        for (const phase of OTA_HISTORY.PHASES) {
+            const ms = u32();
+            r.phases[phase] = ms === OTA_HISTORY.NOT_REACHED ? null : ms;
+        }
+        const result = value.getUint8(offset);
+        const flags = value.getUint8(offset + 1);
+        r.result = OTA_HISTORY.RESULTS[result] || String(result);
+        r.compressed = (flags & OTA_HISTORY.FLAG_DEFLATE) !== 0;
+        r.patch = (flags & OTA_HISTORY.FLAG_PATCH) !== 0;
+        r.resumed = (flags & OTA_HISTORY.FLAG_RESUMED) !== 0;
+        r.wifi = (flags & OTA_HISTORY.FLAG_WIFI) !== 0;
+        records.push(r);
+    }
+    return records;
+}
+
+/**
+ * Durations of the phases in ms (null where the session did not get that far)
+ */
+function otaHistoryDurations(r) {
+    const span = (from, to) => (from !== null && to !== null) ? to - from : null;
+    const { ready, firstByte, lastByte, end, done } = r.phases;
+    return {
+        setup: ready,                        // START -> READY (checks, flash setup)
+        transfer: span(firstByte, lastByte), // First -> last transfer byte
+        finalize: span(end, done),           // END -> image verified and activated
+        total: done !== null ? done : end,
+    };
+}
+
+/**
+ * One line per record for the debug log
+ */
+function formatOtaHistoryRecord(r) {
+    const d = otaHistoryDurations(r);
+    const ms = v => (v === null ? '-' : `${v}ms`);
+    const kbps = d.transfer > 0 ? ` ${((r.received / 1024) / (d.transfer / 1000)).toFixed(1)}KB/s` : '';
+    const kind = [r.compressed && 'deflate', r.patch && 'patch', r.resumed && `resume@${r.offset}`, r.wifi && 'wifi']
+        .filter(Boolean).join(',');
+    return `#${r.seq} ${r.result} ${r.received}/${r.transferSize}B (image ${r.imageSize}B${kind ? `, ${kind}` : ''}) ` +
+        `setup ${ms(d.setup)} transfer ${ms(d.transfer)}${kbps} finalize ${ms(d.finalize)}`;
+}
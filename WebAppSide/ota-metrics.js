@@ -0,0 +1,184 @@
+// ============================================================================
+// OTA Metrics Module
+// Records a throughput report (JSON) for every firmware upload, and lets
+// OTA_CONFIG values be overridden from the page URL so parameter sweeps can
+// be run on real phones: ?ota.CHUNK_SIZE=244&ota.ACK_TIMEOUT_MS=800
+// ============================================================================
+
+const OTA_METRICS = {
+    REPORT_VERSION: 1,
+    STORAGE_KEY: 'ota-metrics',   // localStorage: reports of past uploads, oldest first
+    MAX_REPORTS: 50,
+    OVERRIDE_PREFIX: 'ota.',      // query parameter prefix for OTA_CONFIG overrides
+};
+
+// Debug command handled by the page itself: download the stored reports
+const OTA_METRICS_COMMAND = 'OTA_METRICS';
+
+/**
+ * Apply ota.<KEY>=<value> query parameters to OTA_CONFIG (existing keys only, same type).
+ * Returns the applied overrides.
+ */
+function otaApplyConfigOverrides(search) {
+    const applied = {};
+    for (const [name, raw] of new URLSearchParams(search)) {
+        if (!name.startsWith(OTA_METRICS.OVERRIDE_PREFIX)) {
+            continue;
+        }
+        const key = name.substring(OTA_METRICS.OVERRIDE_PREFIX.length);
+        if (!(key in OTA_CONFIG)) {
+            console.warn(`[OTA-Metrics] Unknown OTA_CONFIG key: ${key}`);
+            continue;
+        }
+
+        let value;
+        switch (typeof OTA_CONFIG[key]) {
+            case 'number':
+                value = Number(raw);
+                if (raw === '' || isNaN(value)) {
+                    console.warn(`[OTA-Metrics] Not a number: ${name}=${raw}`);
+                    continue;
+                }
+                break;
+            case 'boolean':
+                value = raw === 'true' || raw === '1';
+                break;
+            default:
+                value = raw;
+        }
+        OTA_CONFIG[key] = value;
+        applied[key] = value;
+    }
+
+    if (Object.keys(applied).length > 0) {
+        console.log('[OTA-Metrics] OTA_CONFIG overrides:', applied);
+    }
+    return applied;
+}
+
+class OtaMetrics {
+    constructor() {
+        this.overrides = {};
+        this.run = null;
+        this.startedAt = 0;
+        this.lastReport = null;
+    }
+
+    /**
+     * Start a report for an upload of firmwareSize bytes
+     */
+    begin(firmwareSize) {
+        this.startedAt = performance.now();
+        this.run = {
+            version: OTA_METRICS.REPORT_VERSION,
+            startedAt: new Date().toISOString(),
+            userAgent: navigator.userAgent,
+            config: { ...OTA_CONFIG },
+            overrides: { ...this.overrides },
+            firmwareSize,
+            transferSize: null,
+            codec: null,
+            patch: false,
+            resumeOffset: 0,
+            transport: null,   // 'wifi', 'ble' (sequenced) or 'ble-legacy'
+            link: null,        // Last LINK: report (interval, latency, LL octets, PHY, MTU)
+            phases: {},        // ms from begin(): ready, transferred, success
+            retransmits: 0,
+            ackTimeouts: 0,
+            flash: null,       // SKIP=<n>,WRITE=<m> from the device's SUCCESS
+            result: null,
+            error: null,
+        };
+    }
+
+    /**
+     * Merge fields into the running report
+     */
+    set(fields) {
+        if (this.run) {
+            Object.assign(this.run, fields);
+        }
+    }
+
+    /**
+     * Record the time of a phase (ms since begin())
+     */
+    mark(phase) {
+        if (this.run) {
+            this.run.phases[phase] = Math.round(performance.now() - this.startedAt);
+        }
+    }
+
+    /**
+     * Close the report (error = null on success), store it and return it
+     */
+    finish(error) {
+        const report = this.run;
+        if (!report) {
+            return null;
+        }
+        this.run = null;
+
+        report.result = error ? 'failed' : 'success';
+        report.error = error ? error.message : null;
+        report.totalMs = Math.round(performance.now() - this.startedAt);
+
+        // Data phase only (READY -> last byte acknowledged), and image bytes per second end to end
+        const { ready, transferred } = report.phases;
+        report.transferMs = (ready !== undefined && transferred !== undefined) ? transferred - ready : null;
+        report.transferKBps = report.transferMs > 0 && report.transferSize !== null
+            ? +(report.transferSize / 1024 / (report.transferMs / 1000)).toFixed(1)
+            : null;
+        report.effectiveKBps = !error && report.totalMs > 0
+            ? +(report.firmwareSize / 1024 / (report.totalMs / 1000)).toFixed(1)
+            : null;
+
+        this.lastReport = report;
+        this.store(report);
+        console.log('[OTA-Metrics] Report:', JSON.stringify(report));
+        return report;
+    }
+
+    /**
+     * Reports of past uploads (oldest first)
+     */
+    history() {
+        try {
+            return JSON.parse(localStorage.getItem(OTA_METRICS.STORAGE_KEY)) || [];
+        } catch (error) {
+            return [];
+        }
+    }
+
+    store(report) {
+        try {
+            const reports = this.history();
+            reports.push(report);
+            localStorage.setItem(OTA_METRICS.STORAGE_KEY,
+                JSON.stringify(reports.slice(-OTA_METRICS.MAX_REPORTS)));
+        } catch (error) {
+            console.warn('[OTA-Metrics] Failed to store report:', error);
+        }
+    }
+
+    clear() {
+        localStorage.removeItem(OTA_METRICS.STORAGE_KEY);
+    }
+
+    /**
+     * Save the stored reports as ota-metrics-<timestamp>.json
+     */
+    download() {
+        const json = JSON.stringify(this.history(), null, 2);
+        const url = URL.createObjectURL(new Blob([json], { type: 'application/json' }));
+        const link = document.createElement('a');
+        link.href = url;
+        link.download = `ota-metrics-${new Date().toISOString().replace(/[:.]/g, '-')}.json`;
+        link.click();
+        URL.revokeObjectURL(url);
+    }
+}
+
+// Global instance
+const otaMetrics = new OtaMetrics();
+otaMetrics.overrides = otaApplyConfigOverrides(location.search);
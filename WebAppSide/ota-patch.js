@@ -0,0 +1,257 @@
+// ============================================================================
+// OTA Delta Patch Module
+// Builds delta patches against the image the device is running, and keeps
+// the last uploaded image per device (IndexedDB) to use as the next base
+// ============================================================================
+
+const OTA_PATCH = {
+    MAGIC: [0x4f, 0x44, 0x50, 0x31], // "ODP1"
+    OP_COPY: 0x01,                   // <base_offset> <len>
+    OP_ADD: 0x02,                    // <base_offset> <len> <len bytes added to base>
+    OP_INSERT: 0x03,                 // <len> <len bytes>
+    BLOCK_SIZE: 32,                  // exact match needed to anchor a region
+    INDEX_STRIDE: 8,                 // base offsets indexed every N bytes
+    MAX_MISMATCH_RUN: 64,            // stop extending a region after this many bytes without gain
+};
+
+/**
+ * Hash of BLOCK_SIZE bytes at offset (FNV-1a over 32-bit words)
+ */
+function otaPatchBlockHash(data, offset) {
+    let hash = 0x811c9dc5;
+    for (let i = 0; i < OTA_PATCH.BLOCK_SIZE; i += 4) {
+        const word = data[offset + i] | (data[offset + i + 1] << 8) |
+            (data[offset + i + 2] << 16) | (data[offset + i + 3] << 24);
+        hash = Math.imul(hash ^ word, 0x01000193);
+    }
+    return hash >>> 0;
+}
+
+function otaPatchBlockEquals(a, aOffset, b, bOffset) {
+    if (aOffset < 0 || bOffset < 0 ||
+        aOffset + OTA_PATCH.BLOCK_SIZE > a.length || bOffset + OTA_PATCH.BLOCK_SIZE > b.length) {
+        return false;
+    }
+    for (let i = 0; i < OTA_PATCH.BLOCK_SIZE; i++) {
+        if (a[aOffset + i] !== b[bOffset + i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class OtaPatchWriter {
+    constructor(targetSize) {
+        this.parts = [];
+        this.size = 0;
+        this.push(new Uint8Array(OTA_PATCH.MAGIC));
+        this.pushFields([targetSize]);
+    }
+
+    push(bytes) {
+        this.parts.push(bytes);
+        this.size += bytes.byteLength;
+    }
+
+    pushFields(values, op) {
+        const prefix = op === undefined ? 0 : 1;
+        const bytes = new Uint8Array(prefix + values.length * 4);
+        const view = new DataView(bytes.buffer);
+        if (prefix) {
+            bytes[0] = op;
+        }
+        values.forEach((value, i) => view.setUint32(prefix + i * 4, value, true));
+        this.push(bytes);
+    }
+
+    insert(target, start, end) {
+        if (end > start) {
+            this.pushFields([end - start], OTA_PATCH.OP_INSERT);
+            this.push(target.subarray(start, end));
+        }
+    }
+
+    region(base, baseOffset, target, targetOffset, length) {
+        const diff = new Uint8Array(length);
+        for (let i = 0; i < length; i++) {
+            diff[i] = (target[targetOffset + i] - base[baseOffset + i]) & 0xff;
+        }
+
+        // Exact runs become COPY, the rest ADD (mostly zeros, e.g. shifted addresses)
+        let addStart = 0;
+        let i = 0;
+        while (i < length) {
+            let run = 0;
+            while (i + run < length && diff[i + run] === 0) {
+                run++;
+            }
+            if (run >= OTA_PATCH.BLOCK_SIZE || i + run === length) {
+                this.add(baseOffset, diff, addStart, i);
+                if (run > 0) {
+                    this.pushFields([baseOffset + i, run], OTA_PATCH.OP_COPY);
+                }
+                addStart = i + run;
+            }
+            i += run + 1;
+        }
+        this.add(baseOffset, diff, addStart, Math.min(i, length));
+    }
+
+    add(baseOffset, diff, start, end) {
+        if (end > start) {
+            this.pushFields([baseOffset + start, end - start], OTA_PATCH.OP_ADD);
+            this.push(diff.subarray(start, end));
+        }
+    }
+
+    toArrayBuffer() {
+        const out = new Uint8Array(this.size);
+        let offset = 0;
+        for (const part of this.parts) {
+            out.set(part, offset);
+            offset += part.byteLength;
+        }
+        return out.buffer;
+    }
+}
+
+/**
+ * Build a patch that turns base into target (both ArrayBuffer).
+ * Regions of the target that mostly match the base become COPY/ADD ops
+ * (bsdiff-style), everything else is sent as INSERT.
+ */
+function generateOtaPatch(baseBuffer, targetBuffer) {
+    const base = new Uint8Array(baseBuffer);
+    const target = new Uint8Array(targetBuffer);
+    const block = OTA_PATCH.BLOCK_SIZE;
+
+    const index = new Map();
+    for (let b = 0; b + block <= base.length; b += OTA_PATCH.INDEX_STRIDE) {
+        const hash = otaPatchBlockHash(base, b);
+        if (!index.has(hash)) {
+            index.set(hash, b);
+        }
+    }
+
+    const writer = new OtaPatchWriter(target.length);
+    let t = 0;
+    let pending = 0;   // start of target bytes not yet covered by an op
+    let lastDelta = 0; // base - target offset of the previous region
+
+    while (t + block <= target.length) {
+        // Prefer continuing the previous alignment, then look the block up
+        let b = t + lastDelta;
+        if (!otaPatchBlockEquals(base, b, target, t)) {
+            b = index.get(otaPatchBlockHash(target, t));
+            if (b === undefined || !otaPatchBlockEquals(base, b, target, t)) {
+                t++;
+                continue;
+            }
+        }
+
+        // Pull the start back over matching bytes that are still pending
+        while (t > pending && b > 0 && target[t - 1] === base[b - 1]) {
+            t--;
+            b--;
+        }
+        writer.insert(target, pending, t);
+
+        // Extend while matches outweigh mismatches
+        let score = 0;
+        let bestScore = 0;
+        let length = 0;
+        for (let i = 0; t + i < target.length && b + i < base.length && i - length < OTA_PATCH.MAX_MISMATCH_RUN; i++) {
+            score += target[t + i] === base[b + i] ? 1 : -1;
+            if (score > bestScore) {
+                bestScore = score;
+                length = i + 1;
+            }
+        }
+
+        writer.region(base, b, target, t, length);
+        lastDelta = b - t;
+        t += length;
+        pending = t;
+    }
+
+    writer.insert(target, pending, target.length);
+    return writer.toArrayBuffer();
+}
+
+/**
+ * SHA-256 as lowercase hex (matches the device-side base check)
+ */
+async function otaSha256Hex(buffer) {
+    const digest = new Uint8Array(await crypto.subtle.digest('SHA-256', buffer));
+    return Array.from(digest, byte => byte.toString(16).padStart(2, '0')).join('');
+}
+
+/**
+ * Hex string to bytes (digests travel raw in binary OtaControl frames)
+ */
+function otaHexToBytes(hex) {
+    const bytes = new Uint8Array(hex.length / 2);
+    for (let i = 0; i < bytes.length; i++) {
+        bytes[i] = parseInt(hex.substr(i * 2, 2), 16);
+    }
+    return bytes;
+}
+
+// ============================================================================
+// Base image cache (last image successfully uploaded to each device)
+// ============================================================================
+
+class OtaBaseCache {
+    constructor() {
+        this.dbPromise = null;
+    }
+
+    open() {
+        if (!this.dbPromise) {
+            this.dbPromise = new Promise((resolve, reject) => {
+                const request = indexedDB.open('ota-base-cache', 1);
+                request.onupgradeneeded = () => request.result.createObjectStore('images');
+                request.onsuccess = () => resolve(request.result);
+                request.onerror = () => reject(request.error);
+            });
+        }
+        return this.dbPromise;
+    }
+
+    async request(mode, action) {
+        const db = await this.open();
+        return new Promise((resolve, reject) => {
+            const request = action(db.transaction('images', mode).objectStore('images'));
+            request.onsuccess = () => resolve(request.result);
+            request.onerror = () => reject(request.error);
+        });
+    }
+
+    async load(deviceKey) {
+        try {
+            return (await this.request('readonly', store => store.get(deviceKey))) || null;
+        } catch (error) {
+            console.warn('[OTA-Patch] Base cache unavailable:', error);
+            return null;
+        }
+    }
+
+    async save(deviceKey, image) {
+        try {
+            await this.request('readwrite', store => store.put(image, deviceKey));
+        } catch (error) {
+            console.warn('[OTA-Patch] Failed to store base image:', error);
+        }
+    }
+
+    async remove(deviceKey) {
+        try {
+            await this.request('readwrite', store => store.delete(deviceKey));
+        } catch (error) {
+            console.warn('[OTA-Patch] Failed to remove base image:', error);
+        }
+    }
+}
+
+// Global instance
+const otaBaseCache = new OtaBaseCache();
@@ -0,0 +1,123 @@
+// ============================================================================
+// DebugStat Telemetry Module
+// Decodes the binary telemetry frame the device publishes on DebugStat
+// (MiconSide/src/telemetry.h) and keeps a short history for the charts
+// ============================================================================
+
+const TELEMETRY = {
+    MAGIC: 0xD7,            // First byte; older firmware sends text "STATE:..."
+    VERSION: 1,
+    MIN_SIZE: 116,          // Version 1 frame; newer firmware may append fields
+    HIST_BUCKETS: 8,        // Flash write latency: bucket i < 2^i ms, the last one the rest
+    TASKS: ['loopTask', 'BTC_TASK', 'esp_timer', 'log_drain', 'ota_writer', 'ota_net'],
+    STACK_UNKNOWN: 0xFFFF,  // Task not running
+    HISTORY_SIZE: 60,       // Samples kept for the charts
+    FLAG_BLE: 0x01,
+    FLAG_OTA_MODE: 0x02,
+    FLAG_OTA_ACTIVE: 0x04,
+    FLAG_OTA_WIFI: 0x08,
+    WIFI_STATES: ['IDLE', 'CONNECTING', 'CONNECTED', 'BACKOFF'],
+};
+
+/**
+ * Telemetry frame -> object, or null if value is not one (text from older firmware)
+ */
+function decodeTelemetry(value) {
+    if (value.byteLength < 4 || value.getUint8(0) !== TELEMETRY.MAGIC) {
+        return null;
+    }
+    const version = value.getUint8(1);
+    const size = value.getUint16(2, true);
+    if (size < TELEMETRY.MIN_SIZE || value.byteLength < TELEMETRY.MIN_SIZE) {
+        console.warn(`[Telemetry] Short frame: ${value.byteLength} bytes (v${version})`);
+        return null;
+    }
+
+    let offset = 4;
+    const u8 = () => value.getUint8(offset++);
+    const i8 = () => value.getInt8(offset++);
+    const u16 = () => { const v = value.getUint16(offset, true); offset += 2; return v; };
+    const u32 = () => { const v = value.getUint32(offset, true); offset += 4; return v; };
+
+    const t = { version, size };
+    t.uptimeMs = u32();
+    t.flags = u8();
+    t.wifiState = u8();
+    t.rssi = i8();
+    t.wifiReason = u8();
+    const ip = [u8(), u8(), u8(), u8()];
+    t.ip = ip.some(b => b !== 0) ? ip.join('.') : null;
+    t.wifiAttempts = u32();
+    t.wifiConnects = u32();
+    t.wifiDisconnects = u32();
+    t.otaReceived = u32();
+    t.otaExpected = u32();
+    t.otaBytesPerSecond = u32();
+    t.writeCount = u32();
+    t.writeHist = Array.from({ length: TELEMETRY.HIST_BUCKETS }, u32);
+    t.writeMaxUs = u32();
+    t.notifyFailures = u32();
+    t.logDropped = u32();
+    t.heapFree = u32();
+    t.heapMin = u32();
+    t.psramFree = u32();
+    t.psramMin = u32();
+    t.stackFree = {};
+    for (const name of TELEMETRY.TASKS) {
+        const free = u16();
+        t.stackFree[name] = free === TELEMETRY.STACK_UNKNOWN ? null : free;
+    }
+
+    t.bleConnected = (t.flags & TELEMETRY.FLAG_BLE) !== 0;
+    t.otaMode = (t.flags & TELEMETRY.FLAG_OTA_MODE) !== 0;
+    t.otaActive = (t.flags & TELEMETRY.FLAG_OTA_ACTIVE) !== 0;
+    t.otaWifi = (t.flags & TELEMETRY.FLAG_OTA_WIFI) !== 0;
+    t.wifiStateName = TELEMETRY.WIFI_STATES[t.wifiState] || String(t.wifiState);
+    return t;
+}
+
+/**
+ * Upper bound (ms) of the write-latency bucket that contains the given fraction of writes
+ * (Infinity for the last bucket), null if nothing was written yet
+ */
+function telemetryWritePercentileMs(t, fraction) {
+    const total = t.writeHist.reduce((sum, n) => sum + n, 0);
+    if (total === 0) {
+        return null;
+    }
+    let seen = 0;
+    for (let i = 0; i < t.writeHist.length; i++) {
+        seen += t.writeHist[i];
+        if (seen >= total * fraction) {
+            return i < t.writeHist.length - 1 ? (1 << i) : Infinity;
+        }
+    }
+    return Infinity;
+}
+
+class TelemetryHistory {
+    constructor() {
+        this.samples = [];
+    }
+
+    add(t) {
+        this.samples.push({ at: Date.now(), ...t });
+        if (this.samples.length > TELEMETRY.HISTORY_SIZE) {
+            this.samples.shift();
+        }
+    }
+
+    clear() {
+        this.samples = [];
+    }
+
+    /**
+     * Values of one field, oldest first
+     */
+    series(field) {
+        return this.samples.map(sample => sample[field]);
+    }
+}
+
+// Global instance
+const telemetryHistory = new TelemetryHistory();
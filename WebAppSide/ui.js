@@ -134,6 +134,80 @@ class UIManager {
         otaIpEl.textContent = ip || '---';
     }
 
+    /**
+     * Show the latest telemetry frame and chart the recent history
+     */
+    updateTelemetry(t, history) {
+        const summaryEl = document.getElementById('telemetry-summary');
+        if (summaryEl) {
+            const kb = bytes => `${Math.round(bytes / 1024)}K`;
+            const p90 = telemetryWritePercentileMs(t, 0.9);
+            const parts = [
+                t.otaActive ? `OTA ${(t.otaBytesPerSecond / 1024).toFixed(1)}KB/s${t.otaWifi ? ' (Wi-Fi)' : ''}` : null,
+                `HEAP ${kb(t.heapFree)}/${kb(t.heapMin)}`,
+                t.psramFree > 0 ? `PSRAM ${kb(t.psramFree)}` : null,
+                `WIFI ${t.wifiStateName}${t.rssi ? ` ${t.rssi}dBm` : ''} ${t.wifiConnects}/${t.wifiDisconnects}`,
+                `DROP ${t.notifyFailures}/${t.logDropped}`,
+                p90 !== null ? `FLASH p90 ${p90 === Infinity ? '>64' : `<${p90}`}ms max ${(t.writeMaxUs / 1000).toFixed(1)}ms` : null,
+            ];
+            summaryEl.textContent = parts.filter(Boolean).join(' | ');
+            summaryEl.className = 'truncate flex-grow text-[var(--hdd-cyan)]';
+
+            // Details on hover: stack headroom per task and the full latency histogram
+            const stacks = Object.entries(t.stackFree)
+                .map(([name, free]) => `${name}: ${free === null ? '-' : `${free} B`}`);
+            const buckets = t.writeHist.map((n, i) => `${i < t.writeHist.length - 1 ? `<${1 << i}` : `>=${1 << (i - 1)}`}ms: ${n}`);
+            summaryEl.title = [
+                `uptime ${Math.round(t.uptimeMs / 1000)} s, telemetry v${t.version}`,
+                `heap free/min ${t.heapFree}/${t.heapMin} B, PSRAM free/min ${t.psramFree}/${t.psramMin} B`,
+                `Wi-Fi attempts ${t.wifiAttempts}, last reason ${t.wifiReason}`,
+                `BLE notify failures ${t.notifyFailures}, log lines dropped ${t.logDropped}`,
+                'Stack free:', ...stacks,
+                `Flash writes ${t.writeCount}:`, ...buckets,
+            ].join('\n');
+        }
+
+        this.drawTelemetryChart(history);
+    }
+
+    /**
+     * Two sparklines in #telemetry-chart: OTA KB/s and free internal heap, each scaled to its own range
+     */
+    drawTelemetryChart(history) {
+        const canvas = document.getElementById('telemetry-chart');
+        if (!canvas || !canvas.getContext) {
+            return;
+        }
+        const ctx = canvas.getContext('2d');
+        ctx.clearRect(0, 0, canvas.width, canvas.height);
+
+        const plot = (values, color) => {
+            if (values.length < 2) {
+                return;
+            }
+            const max = Math.max(...values);
+            const min = Math.min(...values);
+            const range = max - min || 1;
+            const step = canvas.width / (TELEMETRY.HISTORY_SIZE - 1);
+            const x0 = canvas.width - (values.length - 1) * step;
+            ctx.strokeStyle = color;
+            ctx.lineWidth = 1;
+            ctx.beginPath();
+            values.forEach((value, i) => {
+                const y = canvas.height - 1 - ((value - min) / range) * (canvas.height - 2);
+                if (i === 0) {
+                    ctx.moveTo(x0 + i * step, y);
+                } else {
+                    ctx.lineTo(x0 + i * step, y);
+                }
+            });
+            ctx.stroke();
+        };
+
+        plot(history.series('heapFree'), '#22d3ee');
+        plot(history.series('otaBytesPerSecond').map(bps => bps / 1024), '#facc15');
+    }
+
     /**
      * Enable Wi-Fi form
      */